@@ -1245,7 +1245,7 @@ void BufferViewer::OnEventChanged(uint32_t eventID)
       }
       else
       {
-        r->GetTextureData(m_BufferID, m_TexArrayIdx, m_TexMip, &data);
+        r->GetTextureData(m_BufferID, m_TexArrayIdx, m_TexMip, NULL, &data);
       }
 
       buf->data = new byte[data.count];
@@ -2744,7 +2744,7 @@ void BufferViewer::debugVertex()
         r->DebugVertex(vertid, m_Config.curInstance, index, m_Ctx.CurDrawcall()->instanceOffset,
                        m_Ctx.CurDrawcall()->vertexOffset, trace);
 
-    if(!success || trace->states.count == 0)
+    if(!success || trace->steps.count == 0)
     {
       delete trace;
 
@@ -646,7 +646,7 @@ void PixelHistoryView::startDebug(EventTag tag)
         r->DebugPixel((uint32_t)m_Pixel.x(), (uint32_t)m_Pixel.y(), m_Display.sampleIdx, ~0U, trace);
   });
 
-  if(!success || trace->states.count == 0)
+  if(!success || trace->steps.count == 0)
   {
     RDDialog::critical(this, tr("Debug Error"), tr("Error debugging pixel."));
     delete trace;
@@ -616,7 +616,7 @@ bool ShaderViewer::stepNext()
   if(!m_Trace)
     return false;
 
-  if(currentStep() + 1 >= m_Trace->states.count)
+  if(currentStep() + 1 >= m_Trace->steps.count)
     return false;
 
   setCurrentStep(currentStep() + 1);
@@ -693,20 +693,20 @@ void ShaderViewer::runTo(int runToInstruction, bool forward, ShaderDebugStateFla
 
   bool firstStep = true;
 
-  while(step < m_Trace->states.count)
+  while(step < m_Trace->steps.count)
   {
-    if(runToInstruction >= 0 && m_Trace->states[step].nextInstruction == (uint32_t)runToInstruction)
+    if(runToInstruction >= 0 && m_Trace->steps[step].nextInstruction == (uint32_t)runToInstruction)
       break;
 
-    if(!firstStep && (m_Trace->states[step + inc].flags & condition))
+    if(!firstStep && (m_Trace->steps[step + inc].flags & condition))
       break;
 
-    if(!firstStep && m_Breakpoints.contains((int)m_Trace->states[step].nextInstruction))
+    if(!firstStep && m_Breakpoints.contains((int)m_Trace->steps[step].nextInstruction))
       break;
 
     firstStep = false;
 
-    if(step + inc < 0 || step + inc >= m_Trace->states.count)
+    if(step + inc < 0 || step + inc >= m_Trace->steps.count)
       break;
 
     step += inc;
@@ -800,15 +800,16 @@ void ShaderViewer::addFileList()
 
 void ShaderViewer::updateDebugging()
 {
-  if(!m_Trace || m_CurrentStep < 0 || m_CurrentStep >= m_Trace->states.count)
+  if(!m_Trace || m_CurrentStep < 0 || m_CurrentStep >= m_Trace->steps.count)
     return;
 
-  const ShaderDebugState &state = m_Trace->states[m_CurrentStep];
+  ShaderDebugState state;
+  ShaderDebug_GetState(m_Trace, (uint32_t)m_CurrentStep, &state);
 
   uint32_t nextInst = state.nextInstruction;
   bool done = false;
 
-  if(m_CurrentStep == m_Trace->states.count - 1)
+  if(m_CurrentStep == m_Trace->steps.count - 1)
   {
     nextInst--;
     done = true;
@@ -1016,8 +1017,8 @@ int ShaderViewer::currentStep()
 
 void ShaderViewer::setCurrentStep(int step)
 {
-  if(m_Trace && !m_Trace->states.empty())
-    m_CurrentStep = qBound(0, step, m_Trace->states.count - 1);
+  if(m_Trace && !m_Trace->steps.empty())
+    m_CurrentStep = qBound(0, step, m_Trace->steps.count - 1);
   else
     m_CurrentStep = 0;
 
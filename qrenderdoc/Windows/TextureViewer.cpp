@@ -3310,7 +3310,7 @@ void TextureViewer::on_debugPixelContext_clicked()
 
     bool success = r->DebugPixel((uint32_t)x, (uint32_t)y, m_TexDisplay.sampleIdx, ~0U, trace);
 
-    if(!success || trace->states.count == 0)
+    if(!success || trace->steps.count == 0)
     {
       delete trace;
 
@@ -270,12 +270,25 @@ struct IReplayRenderer
                                           rdctype::array<ShaderVariable> *vars) = 0;
 
   virtual bool SaveTexture(const TextureSave &saveData, const char *path) = 0;
+  // saves count textures, each to the corresponding path. The readbacks happen in order, but
+  // encoding and writing files is spread across threads. Returns true if every texture saved
+  // successfully, and if results is non-NULL it receives whether each individual save succeeded.
+  virtual bool SaveTextures(uint32_t count, const TextureSave *saveData, const char *const *paths,
+                            bool32 *results) = 0;
 
   virtual bool GetPostVSData(uint32_t instID, MeshDataStage stage, MeshFormat *data) = 0;
+  // fetches post-transform data for count events, which can be anywhere in the frame. They are all
+  // captured together in as few replays as possible, instead of one replay per event. vsData and
+  // gsData receive count entries each and either can be NULL. Events that aren't drawcalls get an
+  // empty MeshFormat, and instID is clamped to each drawcall's instance count.
+  virtual bool GetPostVSDataForEvents(uint32_t count, const uint32_t *eventIDs, uint32_t instID,
+                                      MeshFormat *vsData, MeshFormat *gsData) = 0;
 
   virtual bool GetBufferData(ResourceId buff, uint64_t offset, uint64_t len,
                              rdctype::array<byte> *data) = 0;
-  virtual bool GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+  // if progress is non-NULL it's updated from 0 to 1 while the data is fetched, so that another
+  // thread can poll it during long transfers from a remote replay.
+  virtual bool GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip, float *progress,
                               rdctype::array<byte> *data) = 0;
 };
 
@@ -374,18 +387,25 @@ extern "C" RENDERDOC_API bool32 RENDERDOC_CC ReplayRenderer_GetCBufferVariableCo
 extern "C" RENDERDOC_API bool32 RENDERDOC_CC ReplayRenderer_SaveTexture(IReplayRenderer *rend,
                                                                         const TextureSave &saveData,
                                                                         const char *path);
+extern "C" RENDERDOC_API bool32 RENDERDOC_CC
+ReplayRenderer_SaveTextures(IReplayRenderer *rend, uint32_t count, const TextureSave *saveData,
+                            const char *const *paths, bool32 *results);
 
 extern "C" RENDERDOC_API bool32 RENDERDOC_CC ReplayRenderer_GetPostVSData(IReplayRenderer *rend,
                                                                           uint32_t instID,
                                                                           MeshDataStage stage,
                                                                           MeshFormat *data);
+extern "C" RENDERDOC_API bool32 RENDERDOC_CC
+ReplayRenderer_GetPostVSDataForEvents(IReplayRenderer *rend, uint32_t count,
+                                      const uint32_t *eventIDs, uint32_t instID,
+                                      MeshFormat *vsData, MeshFormat *gsData);
 
 extern "C" RENDERDOC_API bool32 RENDERDOC_CC
 ReplayRenderer_GetBufferData(IReplayRenderer *rend, ResourceId buff, uint64_t offset, uint64_t len,
                              rdctype::array<byte> *data);
 extern "C" RENDERDOC_API bool32 RENDERDOC_CC
 ReplayRenderer_GetTextureData(IReplayRenderer *rend, ResourceId tex, uint32_t arrayIdx,
-                              uint32_t mip, rdctype::array<byte> *data);
+                              uint32_t mip, float *progress, rdctype::array<byte> *data);
 
 struct ITargetControl
 {
@@ -526,6 +546,12 @@ Topology_NumVerticesPerPrimitive(PrimitiveTopology topology);
 extern "C" RENDERDOC_API uint32_t RENDERDOC_CC Topology_VertexOffset(PrimitiveTopology topology,
                                                                      uint32_t primitive);
 
+// reconstructs the full shader debugging state at the given step of a trace. Returns false if the
+// step is out of range.
+extern "C" RENDERDOC_API bool32 RENDERDOC_CC ShaderDebug_GetState(const ShaderDebugTrace *trace,
+                                                                  uint32_t step,
+                                                                  ShaderDebugState *state);
+
 //////////////////////////////////////////////////////////////////////////
 // Create a replay renderer, for playback and analysis.
 //
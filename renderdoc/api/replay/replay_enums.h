@@ -353,6 +353,13 @@ enum ShaderDebugStateFlags
   eShaderDbg_GeneratedNanOrInf = 0x2,
 };
 
+enum ShaderDebugVariableSet
+{
+  eShaderDebugVar_Register = 0,
+  eShaderDebugVar_Output,
+  eShaderDebugVar_IndexableTemp,
+};
+
 enum DebugMessageCategory
 {
   eDbgCategory_Application_Defined = 0,
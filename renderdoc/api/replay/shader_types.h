@@ -136,12 +136,42 @@ struct ShaderDebugState
   uint32_t flags;
 };
 
+// a single component of a variable that was modified by one step of a shader debug trace
+struct ShaderVariableChange
+{
+  ShaderDebugVariableSet set;
+  // for indexable temps, which array the variable is in. Unused otherwise
+  uint32_t arrayIndex;
+  // the index of the variable in its set
+  uint32_t index;
+  uint32_t component;
+  uint32_t value;
+};
+
+struct ShaderDebugStep
+{
+  uint32_t nextInstruction;
+  uint32_t flags;
+
+  // the components that changed since the previous step. Empty for the first step.
+  rdctype::array<ShaderVariableChange> changes;
+};
+
 struct ShaderDebugTrace
 {
   rdctype::array<ShaderVariable> inputs;
   rdctype::array<rdctype::array<ShaderVariable> > cbuffers;
 
-  rdctype::array<ShaderDebugState> states;
+  // the full state before the first instruction is executed
+  ShaderDebugState initialState;
+
+  // each step only lists its changes relative to the last, use ShaderDebug_GetState to
+  // reconstruct the full state at any step.
+  rdctype::array<ShaderDebugStep> steps;
+
+  // full copies of the state at regular intervals to speed up reconstruction. These are generated
+  // locally once a trace is fetched and are never sent over the network.
+  rdctype::array<ShaderDebugState> keyframes;
 };
 
 struct SigParameter
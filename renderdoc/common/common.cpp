@@ -84,143 +84,482 @@ void rdcassert(const char *msg, const char *file, unsigned int line, const char
   rdclog_int(RDCLog_Error, RDCLOG_PROJECT, file, line, "Assertion failed: %s", msg);
 }
 
-#if 0
-static __m128 zero = {0};
-#endif
+// the diff kernels find the first or last differing byte between two buffers. They're selected
+// at runtime depending on what the CPU supports, see GetDiffKernels()
+typedef size_t (*DiffKernel)(const byte *a, const byte *b, size_t len);
+
+struct DiffKernels
+{
+  DiffKernel firstDiff;
+  DiffKernel lastDiff;
+};
+
+// returns the offset of the first differing byte, or len if the buffers are identical
+static size_t FirstDiffScalar(const byte *a, const byte *b, size_t len)
+{
+  size_t offs = 0;
+
+  for(; offs + sizeof(uint64_t) <= len; offs += sizeof(uint64_t))
+  {
+    uint64_t a64, b64;
+    memcpy(&a64, a + offs, sizeof(a64));
+    memcpy(&b64, b + offs, sizeof(b64));
+
+    if(a64 != b64)
+      break;
+  }
+
+  while(offs < len && a[offs] == b[offs])
+    offs++;
+
+  return offs;
+}
+
+// returns one past the offset of the last differing byte, or 0 if the buffers are identical
+static size_t LastDiffScalar(const byte *a, const byte *b, size_t len)
+{
+  size_t end = len;
+
+  for(; end >= sizeof(uint64_t); end -= sizeof(uint64_t))
+  {
+    uint64_t a64, b64;
+    memcpy(&a64, a + end - sizeof(uint64_t), sizeof(a64));
+    memcpy(&b64, b + end - sizeof(uint64_t), sizeof(b64));
+
+    if(a64 != b64)
+      break;
+  }
+
+  while(end > 0 && a[end - 1] == b[end - 1])
+    end--;
+
+  return end;
+}
+
+#if ENABLED(RDOC_X86)
+
+#if ENABLED(RDOC_MSVS)
+
+#include <intrin.h>
+
+// MSVC allows AVX2 intrinsics anywhere, regardless of the target architecture
+#define AVX2_FUNCTION
+
+static bool CPUHasAVX2()
+{
+  int info[4];
+
+  __cpuid(info, 0);
+  if(info[0] < 7)
+    return false;
+
+  // we need AVX and for the OS to save the YMM registers, not just the AVX2 feature bit
+  __cpuid(info, 1);
+  if((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+    return false;
+
+  if((_xgetbv(0) & 0x6) != 0x6)
+    return false;
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+}
+
+static uint32_t CountTrailingZeroes(uint32_t mask)
+{
+  unsigned long idx = 0;
+  _BitScanForward(&idx, mask);
+  return idx;
+}
+
+static uint32_t CountLeadingZeroes(uint32_t mask)
+{
+  unsigned long idx = 0;
+  _BitScanReverse(&idx, mask);
+  return 31 - idx;
+}
 
-// assumes a and b both point to 16-byte aligned 16-byte chunks of memory.
-// Returns if they're equal or different
-bool Vec16NotEqual(void *a, void *b)
-{
-// disabled SSE version as it's acting dodgy
-#if 0
-	__m128 avec = _mm_load_ps(aflt);
-	__m128 bvec = _mm_load_ps(bflt);
-
-	__m128 diff = _mm_xor_ps(avec, bvec);
-
-	__m128 eq = _mm_cmpeq_ps(diff, zero);
-	int mask = _mm_movemask_ps(eq);
-	int signMask = _mm_movemask_ps(diff);
-
-	// first check ensures that diff is floatequal to zero (ie. avec bitwise equal to bvec).
-	// HOWEVER -0 is floatequal to 0, so we ensure no sign bits are set on diff
-	if((mask^0xf) || signMask != 0)
-	{
-		return true;
-	}
-	
-	return false;
-#elif ENABLED(RDOC_X64)
-  uint64_t *a64 = (uint64_t *)a;
-  uint64_t *b64 = (uint64_t *)b;
-
-  return a64[0] != b64[0] || a64[1] != b64[1];
 #else
-  uint32_t *a32 = (uint32_t *)a;
-  uint32_t *b32 = (uint32_t *)b;
 
-  return a32[0] != b32[0] || a32[1] != b32[1] || a32[2] != b32[2] || a32[3] != b32[3];
-#endif
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+
+static bool CPUHasAVX2()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
 }
 
-bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd)
+static uint32_t CountTrailingZeroes(uint32_t mask)
 {
-  RDCASSERT(uintptr_t(a) % 16 == 0);
-  RDCASSERT(uintptr_t(b) % 16 == 0);
+  return __builtin_ctz(mask);
+}
 
-  diffStart = bufSize + 1;
-  diffEnd = 0;
+static uint32_t CountLeadingZeroes(uint32_t mask)
+{
+  return __builtin_clz(mask);
+}
+
+#endif
 
-  size_t alignedSize = bufSize & (~0xf);
-  size_t numVecs = alignedSize / 16;
+#include <immintrin.h>
+
+AVX2_FUNCTION static bool AnyDiff128AVX2(const byte *a, const byte *b)
+{
+  const __m256i *a256 = (const __m256i *)a;
+  const __m256i *b256 = (const __m256i *)b;
 
+  __m256i d0 = _mm256_xor_si256(_mm256_loadu_si256(a256 + 0), _mm256_loadu_si256(b256 + 0));
+  __m256i d1 = _mm256_xor_si256(_mm256_loadu_si256(a256 + 1), _mm256_loadu_si256(b256 + 1));
+  __m256i d2 = _mm256_xor_si256(_mm256_loadu_si256(a256 + 2), _mm256_loadu_si256(b256 + 2));
+  __m256i d3 = _mm256_xor_si256(_mm256_loadu_si256(a256 + 3), _mm256_loadu_si256(b256 + 3));
+
+  __m256i any = _mm256_or_si256(_mm256_or_si256(d0, d1), _mm256_or_si256(d2, d3));
+
+  return _mm256_testz_si256(any, any) == 0;
+}
+
+// returns a bitmask with a bit set for every byte that differs in the 32 bytes at a and b
+AVX2_FUNCTION static uint32_t DiffMask32AVX2(const byte *a, const byte *b)
+{
+  __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)a),
+                                 _mm256_loadu_si256((const __m256i *)b));
+
+  return ~(uint32_t)_mm256_movemask_epi8(eq);
+}
+
+AVX2_FUNCTION static size_t FirstDiffAVX2(const byte *a, const byte *b, size_t len)
+{
   size_t offs = 0;
 
-  float *aflt = (float *)a;
-  float *bflt = (float *)b;
+  // sweep 128 bytes at a time, until we find a difference
+  for(; offs + 128 <= len; offs += 128)
+  {
+    if(AnyDiff128AVX2(a + offs, b + offs))
+      break;
+  }
+
+  // then narrow down to the byte
+  for(; offs + 32 <= len; offs += 32)
+  {
+    uint32_t mask = DiffMask32AVX2(a + offs, b + offs);
+
+    if(mask)
+      return offs + CountTrailingZeroes(mask);
+  }
 
-  // sweep to find the start of differences
-  for(size_t v = 0; v < numVecs; v++)
+  return offs + FirstDiffScalar(a + offs, b + offs, len - offs);
+}
+
+AVX2_FUNCTION static size_t LastDiffAVX2(const byte *a, const byte *b, size_t len)
+{
+  size_t end = len;
+
+  for(; end >= 128; end -= 128)
   {
-    if(Vec16NotEqual(aflt, bflt))
-    {
-      diffStart = offs;
+    if(AnyDiff128AVX2(a + end - 128, b + end - 128))
       break;
-    }
+  }
 
-    aflt += 4;
-    bflt += 4;
-    offs += 4 * sizeof(float);
+  for(; end >= 32; end -= 32)
+  {
+    uint32_t mask = DiffMask32AVX2(a + end - 32, b + end - 32);
+
+    if(mask)
+      return end - CountLeadingZeroes(mask);
   }
 
-  // make sure we're byte-accurate, to comply with WRITE_NO_OVERWRITE
-  while(diffStart < bufSize && *((byte *)a + diffStart) == *((byte *)b + diffStart))
-    diffStart++;
+  return LastDiffScalar(a, b, end);
+}
+
+#endif
 
-  // do we have some unaligned bytes at the end of the buffer?
-  if(bufSize > alignedSize)
+static DiffKernels GetDiffKernels()
+{
+  static DiffKernels kernels = {NULL, NULL};
+
+  // racing threads will all select the same kernels, so no locking needed
+  if(kernels.firstDiff == NULL)
   {
-    size_t numBytes = bufSize - alignedSize;
+    DiffKernels selected = {&FirstDiffScalar, &LastDiffScalar};
 
-    // if we haven't even found a start, check in these bytes
-    if(diffStart > bufSize)
+#if ENABLED(RDOC_X86)
+    if(CPUHasAVX2())
     {
-      offs = bufSize;
-
-      for(size_t by = 0; by < numBytes; by++)
-      {
-        if(*((byte *)a + alignedSize + by) != *((byte *)b + alignedSize + by))
-        {
-          diffStart = offs;
-          break;
-        }
-
-        offs++;
-      }
+      selected.firstDiff = &FirstDiffAVX2;
+      selected.lastDiff = &LastDiffAVX2;
     }
+#endif
 
-    // sweep from the last byte to find the end
-    for(size_t by = 0; by < numBytes; by++)
+    kernels = selected;
+  }
+
+  return kernels;
+}
+
+bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd)
+{
+  DiffKernels kernels = GetDiffKernels();
+
+  const byte *abyte = (const byte *)a;
+  const byte *bbyte = (const byte *)b;
+
+  diffStart = kernels.firstDiff(abyte, bbyte, bufSize);
+
+  // no differences at all
+  if(diffStart >= bufSize)
+  {
+    diffStart = bufSize + 1;
+    diffEnd = 0;
+    return false;
+  }
+
+  // the end can't be before the start, so only search from there
+  diffEnd = diffStart + kernels.lastDiff(abyte + diffStart, bbyte + diffStart, bufSize - diffStart);
+
+  return true;
+}
+
+bool FindDiffRanges(const void *a, const void *b, size_t bufSize, size_t granularity,
+                    std::vector<DiffRange> &ranges)
+{
+  DiffKernels kernels = GetDiffKernels();
+
+  const byte *abyte = (const byte *)a;
+  const byte *bbyte = (const byte *)b;
+
+  ranges.clear();
+
+  if(granularity == 0)
+    granularity = 1;
+
+  size_t offs = 0;
+
+  while(offs < bufSize)
+  {
+    DiffRange range;
+
+    // make sure we're byte-accurate, to comply with WRITE_NO_OVERWRITE
+    range.start = offs + kernels.firstDiff(abyte + offs, bbyte + offs, bufSize - offs);
+
+    if(range.start >= bufSize)
+      break;
+
+    // extend the range block by block until we find a block with no differences
+    size_t block = range.start - (range.start % granularity) + granularity;
+
+    while(block < bufSize)
     {
-      if(*((byte *)a + bufSize - 1 - by) != *((byte *)b + bufSize - 1 - by))
-      {
-        diffEnd = bufSize - by;
+      size_t blockSize = RDCMIN(granularity, bufSize - block);
+
+      if(kernels.firstDiff(abyte + block, bbyte + block, blockSize) >= blockSize)
         break;
-      }
+
+      block += blockSize;
+    }
+
+    // the last block with differences is the one before the identical block (or the end of the
+    // buffer), trim the end back to the last differing byte in it
+    size_t dirtyEnd = RDCMIN(block, bufSize);
+    size_t lastBlock = RDCMAX(range.start, dirtyEnd - RDCMIN(dirtyEnd, granularity));
+
+    range.end =
+        lastBlock + kernels.lastDiff(abyte + lastBlock, bbyte + lastBlock, dirtyEnd - lastBlock);
+
+    ranges.push_back(range);
+
+    // the block we stopped at is identical, so continue after it
+    offs = block + granularity;
+  }
+
+  return !ranges.empty();
+}
+
+// SHA-256, as specified in FIPS 180-4
+struct SHA256
+{
+  SHA256()
+  {
+    static const uint32_t init[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                     0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    memcpy(state, init, sizeof(state));
+    length = 0;
+    used = 0;
+  }
+
+  void Update(const byte *data, size_t len)
+  {
+    length += len;
+
+    if(used > 0)
+    {
+      size_t copy = RDCMIN(len, sizeof(block) - used);
+      memcpy(block + used, data, copy);
+      used += copy;
+      data += copy;
+      len -= copy;
+
+      if(used < sizeof(block))
+        return;
+
+      Transform(block);
+      used = 0;
     }
+
+    for(; len >= sizeof(block); data += sizeof(block), len -= sizeof(block))
+      Transform(data);
+
+    memcpy(block, data, len);
+    used = len;
   }
 
-  // if we haven't found a start, or we've found a start AND and end,
-  // then we're done.
-  if(diffStart > bufSize || diffEnd > 0)
-    return diffStart < bufSize;
+  void Final(byte digest[32])
+  {
+    uint64_t bits = length * 8;
 
-  offs = alignedSize;
+    byte pad[sizeof(block) + 8] = {0x80};
+    size_t padLen = (used < 56 ? 56 : 120) - used;
 
-  // sweep from the last __m128
-  aflt = (float *)a + offs / sizeof(float) - 4;
-  bflt = (float *)b + offs / sizeof(float) - 4;
+    for(int i = 0; i < 8; i++)
+      pad[padLen + i] = byte(bits >> (56 - i * 8));
 
-  for(size_t v = 0; v < numVecs; v++)
+    Update(pad, padLen + 8);
+
+    for(int i = 0; i < 8; i++)
+    {
+      digest[i * 4 + 0] = byte(state[i] >> 24);
+      digest[i * 4 + 1] = byte(state[i] >> 16);
+      digest[i * 4 + 2] = byte(state[i] >> 8);
+      digest[i * 4 + 3] = byte(state[i]);
+    }
+  }
+
+private:
+  static inline uint32_t rotr(uint32_t x, int r) { return (x >> r) | (x << (32 - r)); }
+  void Transform(const byte *data)
   {
-    if(Vec16NotEqual(aflt, bflt))
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+        0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+        0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+        0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+        0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+        0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+        0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+        0xc67178f2,
+    };
+
+    uint32_t w[64];
+
+    for(int i = 0; i < 16; i++)
+      w[i] = (uint32_t(data[i * 4]) << 24) | (uint32_t(data[i * 4 + 1]) << 16) |
+             (uint32_t(data[i * 4 + 2]) << 8) | uint32_t(data[i * 4 + 3]);
+
+    for(int i = 16; i < 64; i++)
     {
-      diffEnd = offs;
-      break;
+      uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for(int i = 0; i < 64; i++)
+    {
+      uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+      uint32_t ch = (e & f) ^ (~e & g);
+      uint32_t t1 = h + S1 + ch + k[i] + w[i];
+      uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+      uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+      uint32_t t2 = S0 + maj;
+
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
     }
 
-    aflt -= 4;
-    bflt -= 4;
-    offs -= 16;
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
   }
 
-  // make sure we're byte-accurate, to comply with WRITE_NO_OVERWRITE
-  while(diffEnd > 0 && *((byte *)a + diffEnd - 1) == *((byte *)b + diffEnd - 1))
-    diffEnd--;
+  uint32_t state[8];
+  uint64_t length;
+  byte block[64];
+  size_t used;
+};
+
+void SHA256Hash(const void *data, size_t len, uint8_t digest[32])
+{
+  SHA256 sha;
+  sha.Update((const byte *)data, len);
+  sha.Final(digest);
+}
+
+// large blobs are hashed in independent chunks, so that all cores can share the work
+static const size_t ContentHashChunkSize = 1024 * 1024;
+
+struct ContentHashJob
+{
+  const byte *data;
+  size_t len;
+  byte *digests;
+};
+
+static void HashContentChunk(void *userData, uint32_t idx)
+{
+  ContentHashJob *job = (ContentHashJob *)userData;
+
+  size_t offs = size_t(idx) * ContentHashChunkSize;
+
+  SHA256Hash(job->data + offs, RDCMIN(ContentHashChunkSize, job->len - offs),
+             job->digests + idx * 32);
+}
 
-  // if we found a start then we necessarily found an end
-  return diffStart < bufSize;
+ContentHash HashContent(const void *data, size_t len)
+{
+  uint32_t numChunks = uint32_t((len + ContentHashChunkSize - 1) / ContentHashChunkSize);
+
+  vector<byte> digests(RDCMAX(numChunks, 1U) * 32);
+
+  ContentHashJob job = {(const byte *)data, len, &digests[0]};
+
+  if(numChunks == 0)
+    SHA256Hash(data, 0, &digests[0]);
+  else
+    Threading::ParallelFor(numChunks, &HashContentChunk, &job);
+
+  // the final hash is over the total length and every chunk's digest, in order
+  byte lenBytes[8];
+  for(int i = 0; i < 8; i++)
+    lenBytes[i] = byte(uint64_t(len) >> (i * 8));
+
+  SHA256 sha;
+  sha.Update(lenBytes, sizeof(lenBytes));
+  sha.Update(&digests[0], digests.size());
+
+  byte digest[32];
+  sha.Final(digest);
+
+  ContentHash ret = {0, 0};
+  for(int i = 0; i < 8; i++)
+  {
+    ret.hi = (ret.hi << 8) | digest[i];
+    ret.lo = (ret.lo << 8) | digest[i + 8];
+  }
+  return ret;
 }
 
 uint32_t CalcNumMips(int w, int h, int d)
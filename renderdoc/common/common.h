@@ -28,6 +28,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <vector>
 #include "globalconfig.h"
 
 /////////////////////////////////////////////////
@@ -154,7 +155,48 @@ inline T AlignUpPtr(T x, A a)
 #define MAKE_FOURCC(a, b, c, d) \
   (((uint32_t)(d) << 24) | ((uint32_t)(c) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(a))
 
+// finds the single range [diffStart, diffEnd) that covers every byte that differs between a and b
 bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd);
+
+struct DiffRange
+{
+  size_t start;
+  size_t end;
+};
+
+// the default granularity for FindDiffRanges, below which it's not worth splitting a range.
+static const size_t DiffRangeGranularity = 4096;
+
+// finds every separate range [start, end) of bytes that differ between a and b. The buffers are
+// compared in blocks of granularity bytes, and any run of modified blocks is returned as one range,
+// so granularity is the smallest identical gap that will split two ranges. The start and end of
+// each range are still byte-accurate.
+bool FindDiffRanges(const void *a, const void *b, size_t bufSize, size_t granularity,
+                    std::vector<DiffRange> &ranges);
+
+// a 128-bit hash of some data, used to identify blobs by their contents without comparing the
+// bytes themselves, including across sessions in an on-disk cache. It's based on SHA-256 so
+// collisions aren't a practical concern.
+struct ContentHash
+{
+  uint64_t hi;
+  uint64_t lo;
+
+  bool operator==(const ContentHash &o) const { return hi == o.hi && lo == o.lo; }
+  bool operator!=(const ContentHash &o) const { return !(*this == o); }
+  bool operator<(const ContentHash &o) const
+  {
+    if(hi != o.hi)
+      return hi < o.hi;
+    return lo < o.lo;
+  }
+};
+
+// the data is split into 1MB chunks that are each hashed with SHA-256 in parallel. The result is
+// the first 128 bits of the SHA-256 of the data length and all of those chunk digests.
+ContentHash HashContent(const void *data, size_t len);
+void SHA256Hash(const void *data, size_t len, uint8_t digest[32]);
+
 uint32_t CalcNumMips(int Width, int Height, int Depth);
 
 uint32_t Log2Floor(uint32_t value);
@@ -49,23 +49,40 @@ public:
 };
 
 // allocate each class in its own pool so we can identify the type by the pointer
+//
+// Allocating and freeing is lock-free. Each pool keeps its free slots in several lock-free stacks
+// and a thread starts from the stack picked by its thread ID, so threads creating and destroying
+// objects at the same time mostly stay out of each other's way. The lock is only taken to add a
+// new pool when all the existing ones are full.
 template <typename WrapType, int PoolCount = 8192, int MaxPoolByteSize = 1024 * 1024, bool DebugClear = true>
 class WrappingPool
 {
 public:
   void *Allocate()
   {
-    SCOPED_LOCK(m_Lock);
-
     // try and allocate from immediate pool
     void *ret = m_ImmediatePool.Allocate();
     if(ret != NULL)
       return ret;
 
     // fall back to additional pools, if there are any
-    for(size_t i = 0; i < m_AdditionalPools.size(); i++)
+    PoolIndex *index = CurrentPoolIndex();
+    int32_t numPools = index ? index->count : 0;
+    for(int32_t i = 0; i < numPools; i++)
+    {
+      ret = index->pools[i]->Allocate();
+      if(ret != NULL)
+        return ret;
+    }
+
+    SCOPED_LOCK(m_Lock);
+
+    // another thread may have added a pool while we were looking. Pools keep their position when
+    // the index grows, so only the new ones need checking.
+    index = CurrentPoolIndex();
+    for(int32_t i = numPools; index && i < index->count; i++)
     {
-      ret = m_AdditionalPools[i]->Allocate();
+      ret = index->pools[i]->Allocate();
       if(ret != NULL)
         return ret;
     }
@@ -77,59 +94,50 @@ public:
     RDCWARN("Ran out of free slots in pool 0x%p!", &m_ImmediatePool.items[0]);
 #endif
 
+    if(index == NULL || index->count == (int32_t)index->capacity)
+      index = GrowPoolIndex();
+
     // allocate a new additional pool and use that to allocate from
-    m_AdditionalPools.push_back(new ItemPool());
+    ItemPool *pool = new ItemPool(m_AdditionalAlign);
+
+    AddPoolLookup(index, pool);
+
+    // the count is only incremented once the pool is ready, so lock-free readers never see a
+    // partially set up pool
+    index->pools[index->count] = pool;
+    Atomic::Inc32(&index->count);
 
 #if ENABLED(INCLUDE_TYPE_NAMES)
-    RDCDEBUG("WrappingPool[%d]<%s>: %p -> %p", (uint32_t)m_AdditionalPools.size() - 1,
-             GetTypeName<WrapType>::Name(), &m_AdditionalPools.back()->items[0],
-             &m_AdditionalPools.back()->items[AllocCount - 1]);
+    RDCDEBUG("WrappingPool[%d]<%s>: %p -> %p", index->count - 1, GetTypeName<WrapType>::Name(),
+             &pool->items[0], &pool->items[AllocCount - 1]);
 #endif
 
-    return m_AdditionalPools.back()->Allocate();
+    return pool->Allocate();
   }
 
   bool IsAlloc(const void *p)
   {
-    // we can check the immediate pool without locking
     if(m_ImmediatePool.IsAlloc(p))
       return true;
 
-    // if we have additional pools, lock and check them.
-    // TODO: Check for additional pools in a lock-free manner,
-    // to prevent the cost of locking if there are no more pools.
-    {
-      SCOPED_LOCK(m_Lock);
-
-      for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-        if(m_AdditionalPools[i]->IsAlloc(p))
-          return true;
-    }
-
-    return false;
+    return FindAdditionalPool(p) != NULL;
   }
 
   void Deallocate(void *p)
   {
-    SCOPED_LOCK(m_Lock);
-
     // try immediate pool
     if(m_ImmediatePool.IsAlloc(p))
     {
       m_ImmediatePool.Deallocate(p);
       return;
     }
-    else if(!m_AdditionalPools.empty())
+
+    // fall back and try additional pools
+    ItemPool *pool = FindAdditionalPool(p);
+    if(pool)
     {
-      // fall back and try additional pools
-      for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-      {
-        if(m_AdditionalPools[i]->IsAlloc(p))
-        {
-          m_AdditionalPools[i]->Deallocate(p);
-          return;
-        }
-      }
+      pool->Deallocate(p);
+      return;
     }
 
 // this is an error - deleting an object that we don't recognise
@@ -147,8 +155,19 @@ public:
   static const size_t AllocByteSize;
 
 private:
-  WrappingPool()
+  struct ItemPool;
+
+  WrappingPool() : m_ImmediatePool(ImmediateAlign)
   {
+    // additional pools are aligned to a power of two at least as big as the pool, so the pool
+    // owning a pointer can be found by rounding the pointer down.
+    m_AdditionalAlign = ImmediateAlign;
+    while(m_AdditionalAlign < AllocCount * AllocByteSize)
+      m_AdditionalAlign <<= 1;
+
+    m_NumPoolIndices = 0;
+    RDCEraseEl(m_PoolIndices);
+
 #if ENABLED(INCLUDE_TYPE_NAMES)
     // hack - print in kB because float printing relies on statics that might not be initialised
     // yet in loading order. Ugly :(
@@ -159,53 +178,189 @@ private:
   }
   ~WrappingPool()
   {
-    for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-      delete m_AdditionalPools[i];
+    PoolIndex *index = CurrentPoolIndex();
+
+    for(int32_t i = 0; index && i < index->count; i++)
+      delete index->pools[i];
+
+    for(int32_t i = 0; i < m_NumPoolIndices; i++)
+      delete m_PoolIndices[i];
+
+    m_NumPoolIndices = 0;
+  }
+
+  enum
+  {
+    ImmediateAlign = 64,
+    InitialPoolIndexCapacity = 256,
+    // each index has twice the capacity of the one before, so this is never reached in practice
+    MaxPoolIndices = 24,
+  };
+
+  // the additional pools, along with an open-addressed table from each one's aligned base address
+  // to the pool. These are read without locking, so when an index fills up it's replaced by a copy
+  // with twice the capacity rather than being resized in place. Older indices are kept alive until
+  // destruction for any readers still looking at them.
+  struct PoolIndex
+  {
+    PoolIndex(uint32_t cap)
+    {
+      capacity = cap;
+      count = 0;
+      pools = new ItemPool *[capacity];
+
+      tableSize = capacity * 2;
+      tableBases = new int64_t[tableSize];
+      tablePools = new ItemPool *[tableSize];
+
+      for(uint32_t i = 0; i < tableSize; i++)
+        tableBases[i] = 0;
+    }
+    ~PoolIndex()
+    {
+      delete[] pools;
+      delete[](int64_t *) tableBases;
+      delete[] tablePools;
+    }
+
+    uint32_t capacity;
+    volatile int32_t count;
+    ItemPool **pools;
+
+    uint32_t tableSize;
+    volatile int64_t *tableBases;
+    ItemPool **tablePools;
+  };
+
+  PoolIndex *CurrentPoolIndex()
+  {
+    int32_t num = m_NumPoolIndices;
+    return num > 0 ? m_PoolIndices[num - 1] : NULL;
+  }
+
+  // must be called with m_Lock held
+  PoolIndex *GrowPoolIndex()
+  {
+    if(m_NumPoolIndices >= MaxPoolIndices)
+      RDCFATAL("Too many additional pools");
+
+    PoolIndex *prev = CurrentPoolIndex();
+    uint32_t capacity = prev ? prev->capacity * 2 : (uint32_t)InitialPoolIndexCapacity;
+    PoolIndex *index = new PoolIndex(capacity);
+
+    for(int32_t i = 0; prev && i < prev->count; i++)
+    {
+      index->pools[i] = prev->pools[i];
+      AddPoolLookup(index, prev->pools[i]);
+    }
+
+    index->count = prev ? prev->count : 0;
+
+    // the new index is complete before it becomes visible
+    m_PoolIndices[m_NumPoolIndices] = index;
+    Atomic::Inc32(&m_NumPoolIndices);
+
+    return index;
+  }
+
+  uint32_t PoolTableIndex(const PoolIndex *index, uint64_t base) const
+  {
+    return uint32_t(((base / m_AdditionalAlign) * 0x9E3779B97F4A7C15ULL) >> 32) % index->tableSize;
+  }
+
+  // must be called with m_Lock held
+  void AddPoolLookup(PoolIndex *index, ItemPool *pool)
+  {
+    uint64_t base = (uint64_t)(uintptr_t)pool->items;
+    uint32_t idx = PoolTableIndex(index, base);
+
+    while(index->tableBases[idx] != 0)
+      idx = (idx + 1) % index->tableSize;
 
-    m_AdditionalPools.clear();
+    // the base is written last, with a full barrier, so lookups only ever find complete entries
+    index->tablePools[idx] = pool;
+    Atomic::CmpExch64(&index->tableBases[idx], 0, (int64_t)base);
+  }
+
+  ItemPool *FindAdditionalPool(const void *p)
+  {
+    PoolIndex *index = CurrentPoolIndex();
+
+    if(index == NULL || index->count == 0)
+      return NULL;
+
+    uint64_t base = (uint64_t)(uintptr_t)p & ~(uint64_t)(m_AdditionalAlign - 1);
+    uint32_t idx = PoolTableIndex(index, base);
+
+    while(index->tableBases[idx] != 0)
+    {
+      if((uint64_t)index->tableBases[idx] == base)
+      {
+        ItemPool *pool = index->tablePools[idx];
+        return pool->IsAlloc(p) ? pool : NULL;
+      }
+
+      idx = (idx + 1) % index->tableSize;
+    }
+
+    return NULL;
   }
 
   Threading::CriticalSection m_Lock;
 
   struct ItemPool
   {
-    ItemPool()
+    ItemPool(size_t alignment)
     {
-      lastAllocIdx = 0;
-      RDCEraseEl(allocated);
+      items = (WrapType *)OSUtility::AlignedAlloc(AllocCount * AllocByteSize, alignment);
+
+      if(items == NULL)
+        RDCFATAL("Allocation for %llu byte pool failed", (uint64_t)(AllocCount * AllocByteSize));
+
+      // split the slots between the free lists. Each list is linked in ascending order so a
+      // single thread allocates contiguously through its range, like a fresh pool always did.
+      const uint32_t perList = (PoolCount + NumFreeLists - 1) / NumFreeLists;
+
+      for(uint32_t l = 0; l < NumFreeLists; l++)
+      {
+        uint32_t first = RDCMIN(l * perList, (uint32_t)PoolCount);
+        uint32_t last = RDCMIN(first + perList, (uint32_t)PoolCount);
 
-      items = (WrapType *)(new uint8_t[AllocCount * AllocByteSize]);
+        for(uint32_t i = first; i < last; i++)
+          next[i] = i + 1 < last ? i + 1 : EmptyIndex;
+
+        freeLists[l].head = MakeHead(0, first < last ? first : EmptyIndex);
+      }
+
+#if ENABLED(RDOC_DEVEL)
+      for(size_t i = 0; i < ARRAY_COUNT(allocatedBits); i++)
+        allocatedBits[i] = 0;
+#endif
     }
-    ~ItemPool() { delete[](uint8_t *) items; }
+    ~ItemPool() { OSUtility::AlignedFree(items); }
     void *Allocate()
     {
-      int lastAlloc = lastAllocIdx;
+      uint32_t start = ThreadFreeList();
 
-      if(allocated[lastAlloc])
+      // steal from other threads' lists before giving up
+      for(uint32_t l = 0; l < NumFreeLists; l++)
       {
-        int end = lastAlloc;
+        uint32_t idx = Pop(freeLists[(start + l) % NumFreeLists].head);
 
-        do
+        if(idx != EmptyIndex)
         {
-          lastAlloc = (lastAlloc + 1) % PoolCount;
-        } while(allocated[lastAlloc] && lastAlloc != end);
-
-        if(allocated[lastAlloc])
-        {
-          return NULL;
-        }
-      }
-
-      void *ret = (void *)&items[lastAlloc];
-      allocated[lastAlloc] = true;
+          void *ret = (void *)&items[idx];
 
 #if ENABLED(RDOC_DEVEL)
-      memset(ret, 0xb0, AllocByteSize);
+          SetAllocated(idx, true);
+          memset(ret, 0xb0, AllocByteSize);
 #endif
 
-      lastAllocIdx = lastAlloc;
+          return ret;
+        }
+      }
 
-      return ret;
+      return NULL;
     }
 
     void Deallocate(void *p)
@@ -220,32 +375,130 @@ private:
       }
 #endif
 
-      size_t idx = (WrapType *)p - &items[0];
-
-      allocated[idx] = false;
+      uint32_t idx = uint32_t((WrapType *)p - &items[0]);
 
 #if ENABLED(RDOC_DEVEL)
+      // pushing a slot that's already free would link it into the free lists twice
+      if(!SetAllocated(idx, false))
+      {
+        RDCERR("Resource 0x%p being deleted twice in pool 0x%p", p, &items[0]);
+        return;
+      }
+
       memset(p, 0xfe, DebugClear ? AllocByteSize : 0);
 #endif
+
+      // freed slots go on this thread's list, so a thread that repeatedly creates and destroys
+      // objects gets the same element straight back.
+      Push(freeLists[ThreadFreeList()].head, idx);
     }
 
     bool IsAlloc(const void *p) const { return p >= &items[0] && p < &items[PoolCount]; }
     WrapType *items;
 
-    // could possibly make this uint32s and check via bitmasks, but
-    // we'll see if it shows up in profiling
-    bool allocated[PoolCount];
+  private:
+    enum
+    {
+      NumFreeLists = 16,
+    };
 
-    // store the last allocations index. Good place to start from and we
-    // go through the pool in a ring. Good performance when the pool is empty
-    // or contiguously allocated, poorer performance when the pool gets filled up.
-    // It also has the bonus of handling repeated new/free well by reallocating the
-    // same element.
-    int lastAllocIdx;
+    enum
+    {
+      EmptyIndex = 0xFFFFFFFFU,
+    };
+
+    static uint32_t ThreadFreeList()
+    {
+      return uint32_t((Threading::GetCurrentID() * 0x9E3779B97F4A7C15ULL) >> 32) % NumFreeLists;
+    }
+
+    // the head of a list is the top slot index in the low 32 bits and a tag in the high 32 bits.
+    // The tag changes on every update, so a compare-exchange fails if the head slot was popped and
+    // pushed back by another thread in between, rather than linking in a stale next index.
+    static int64_t MakeHead(int64_t prevHead, uint32_t idx)
+    {
+      return int64_t((((uint64_t)prevHead >> 32) + 1) << 32 | idx);
+    }
+
+    uint32_t Pop(volatile int64_t &head)
+    {
+      int64_t oldHead = head;
+
+      for(;;)
+      {
+        uint32_t idx = uint32_t(oldHead & 0xffffffff);
+        if(idx == EmptyIndex)
+          return EmptyIndex;
+
+        int64_t prev = Atomic::CmpExch64(&head, oldHead, MakeHead(oldHead, next[idx]));
+        if(prev == oldHead)
+          return idx;
+
+        oldHead = prev;
+      }
+    }
+
+    void Push(volatile int64_t &head, uint32_t idx)
+    {
+      int64_t oldHead = head;
+
+      for(;;)
+      {
+        next[idx] = uint32_t(oldHead & 0xffffffff);
+
+        int64_t prev = Atomic::CmpExch64(&head, oldHead, MakeHead(oldHead, idx));
+        if(prev == oldHead)
+          return;
+
+        oldHead = prev;
+      }
+    }
+
+#if ENABLED(RDOC_DEVEL)
+    // one bit per slot, set while it's allocated, to catch double frees
+    volatile int32_t allocatedBits[(PoolCount + 31) / 32];
+
+    // returns whether the slot was previously allocated
+    bool SetAllocated(uint32_t idx, bool allocated)
+    {
+      volatile int32_t *word = &allocatedBits[idx / 32];
+      const int32_t mask = int32_t(1U << (idx % 32));
+
+      int32_t oldVal = *word;
+
+      for(;;)
+      {
+        int32_t newVal = allocated ? (oldVal | mask) : (oldVal & ~mask);
+
+        int32_t prev = Atomic::CmpExch32(word, oldVal, newVal);
+        if(prev == oldVal)
+          return (oldVal & mask) != 0;
+
+        oldVal = prev;
+      }
+    }
+#endif
+
+    // padded so that threads on different lists don't share a cache line
+    struct FreeList
+    {
+      volatile int64_t head;
+      uint8_t padding[64 - sizeof(int64_t)];
+    };
+
+    FreeList freeLists[NumFreeLists];
+
+    // next free slot after each free slot, or EmptyIndex
+    uint32_t next[PoolCount];
   };
 
   ItemPool m_ImmediatePool;
-  std::vector<ItemPool *> m_AdditionalPools;
+
+  size_t m_AdditionalAlign;
+
+  PoolIndex *m_PoolIndices[MaxPoolIndices];
+  // the last of m_PoolIndices is the current one
+  volatile int32_t m_NumPoolIndices;
 
   friend typename FriendMaker<WrapType>::Type;
 };
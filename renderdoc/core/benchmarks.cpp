@@ -0,0 +1,336 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ * Copyright (c) 2014 Crytek
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "core/benchmarks.h"
+#include "common/timing.h"
+#include "core/resource_manager.h"
+#include "os/os_specific.h"
+#include "serialise/string_utils.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ResourceManager
+
+struct BenchmarkResourceRecord : public ResourceRecord
+{
+  enum
+  {
+    NullResource = 0
+  };
+
+  BenchmarkResourceRecord(ResourceId id) : ResourceRecord(id, true) {}
+};
+
+// a manager with no real resources behind it, only the tracking tables are exercised
+class BenchmarkResourceManager : public ResourceManager<void *, void *, BenchmarkResourceRecord>
+{
+public:
+  BenchmarkResourceManager() : ResourceManager(WRITING_IDLE, NULL) {}
+private:
+  bool SerialisableResource(ResourceId id, BenchmarkResourceRecord *record) { return true; }
+  ResourceId GetID(void *res) { return ResourceId(); }
+  bool ResourceTypeRelease(void *res) { return true; }
+  bool Force_InitialState(void *res, bool prepare) { return false; }
+  bool Need_InitialStateChunk(void *res) { return false; }
+  bool Prepare_InitialState(void *res) { return true; }
+  bool Serialise_InitialState(ResourceId id, void *res) { return true; }
+  void Create_InitialState(ResourceId id, void *live, bool hasData) {}
+  void Apply_InitialState(void *live, InitialContentData initial) {}
+};
+
+struct BenchmarkResource
+{
+  ResourceId id;
+  void *real;
+  void *wrapped;
+};
+
+struct ResourceManagerBenchmarkThread
+{
+  BenchmarkResourceManager *manager;
+  const std::vector<BenchmarkResource> *resources;
+  uint32_t iterations;
+  uint32_t seed;
+
+  double milliseconds;
+  uint32_t failures;
+};
+
+static void ResourceManagerBenchmarkThreadEntry(void *userData)
+{
+  ResourceManagerBenchmarkThread *data = (ResourceManagerBenchmarkThread *)userData;
+
+  BenchmarkResourceManager *manager = data->manager;
+  const std::vector<BenchmarkResource> &resources = *data->resources;
+  uint32_t seed = data->seed;
+  uint32_t failures = 0;
+
+  PerformanceTimer timer;
+
+  for(uint32_t i = 0; i < data->iterations; i++)
+  {
+    seed = seed * 1664525 + 1013904223;
+    const BenchmarkResource &res = resources[(seed >> 8) % resources.size()];
+
+    // what a wrapped API call binding a resource does: find the wrapper for the real handle
+    // coming back from the API or the record for a wrapped parameter, then mark it referenced.
+    if(manager->GetWrapper(res.real) != res.wrapped)
+      failures++;
+
+    BenchmarkResourceRecord *record = manager->GetResourceRecord(res.id);
+    if(record == NULL)
+      failures++;
+
+    manager->MarkResourceFrameReferenced(res.id, (i & 3) == 0 ? eFrameRef_Write : eFrameRef_Read);
+
+    if((i & 15) == 0)
+      manager->MarkDirtyResource(res.id);
+  }
+
+  data->milliseconds = timer.GetMilliseconds();
+  data->failures = failures;
+}
+
+std::string Benchmark_ResourceManager(uint32_t numThreads, uint32_t iterations)
+{
+  const uint32_t numResources = 16384;
+
+  numThreads = RDCMAX(numThreads, 1U);
+
+  BenchmarkResourceManager manager;
+
+  std::vector<BenchmarkResource> resources(numResources);
+
+  PerformanceTimer timer;
+
+  for(uint32_t i = 0; i < numResources; i++)
+  {
+    BenchmarkResource &res = resources[i];
+
+    // fake handles, spaced like heap allocations would be
+    res.id = ResourceIDGen::GetNewUniqueID();
+    res.real = (void *)(uintptr_t)(0x100000 + i * 64);
+    res.wrapped = (void *)(uintptr_t)(0x80000000 + i * 64);
+
+    manager.AddResourceRecord(res.id);
+    manager.AddCurrentResource(res.id, res.wrapped);
+    manager.AddWrapper(res.wrapped, res.real);
+  }
+
+  double createTime = timer.GetMilliseconds();
+
+  std::vector<ResourceManagerBenchmarkThread> threads(numThreads);
+  std::vector<Threading::ThreadHandle> handles(numThreads);
+
+  timer.Restart();
+
+  for(uint32_t t = 0; t < numThreads; t++)
+  {
+    threads[t].manager = &manager;
+    threads[t].resources = &resources;
+    threads[t].iterations = iterations;
+    threads[t].seed = 0x9e3779b9U * (t + 1);
+    threads[t].milliseconds = 0.0;
+    threads[t].failures = 0;
+
+    handles[t] = Threading::CreateThread(&ResourceManagerBenchmarkThreadEntry, &threads[t]);
+  }
+
+  for(uint32_t t = 0; t < numThreads; t++)
+  {
+    Threading::JoinThread(handles[t]);
+    Threading::CloseThread(handles[t]);
+  }
+
+  double wallTime = timer.GetMilliseconds();
+
+  double threadTime = 0.0;
+  uint32_t failures = 0;
+  for(uint32_t t = 0; t < numThreads; t++)
+  {
+    threadTime += threads[t].milliseconds;
+    failures += threads[t].failures;
+  }
+
+  // end of frame
+  timer.Restart();
+
+  manager.FlushPendingDirty();
+  manager.MarkUnwrittenResources();
+  manager.ClearReferencedResources();
+
+  double endFrameTime = timer.GetMilliseconds();
+
+  for(uint32_t i = 0; i < numResources; i++)
+  {
+    manager.RemoveWrapper(resources[i].real);
+    manager.ReleaseCurrentResource(resources[i].id);
+
+    BenchmarkResourceRecord *record = manager.GetResourceRecord(resources[i].id);
+    if(record)
+      record->Delete(&manager);
+  }
+
+  manager.Shutdown();
+
+  double totalCalls = double(numThreads) * double(iterations);
+
+  std::string ret;
+
+  ret += StringFormat::Fmt("ResourceManager: %u threads x %u calls, %u resources\n", numThreads,
+                           iterations, numResources);
+  ret += StringFormat::Fmt("  create:       %.3lf ms\n", createTime);
+  ret += StringFormat::Fmt("  per call:     %.1lf ns (wrapper lookup, record lookup, mark)\n",
+                           totalCalls > 0.0 ? threadTime * 1000000.0 / totalCalls : 0.0);
+  ret += StringFormat::Fmt("  throughput:   %.2lf M calls/s over %.3lf ms\n",
+                           wallTime > 0.0 ? totalCalls / (wallTime * 1000.0) : 0.0, wallTime);
+  ret += StringFormat::Fmt("  end of frame: %.3lf ms\n", endFrameTime);
+
+  if(failures > 0)
+    ret += StringFormat::Fmt("  %u lookups FAILED\n", failures);
+
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Network
+
+struct NetworkBenchmarkEcho
+{
+  Network::Socket *server;
+  bool sleepPoll;
+  uint32_t iterations;
+};
+
+// the 'remote' end, echoes back every packet it receives
+static void NetworkBenchmarkEchoEntry(void *userData)
+{
+  NetworkBenchmarkEcho *data = (NetworkBenchmarkEcho *)userData;
+
+  Network::Socket *client = data->server->AcceptClient(5000);
+
+  if(client == NULL)
+    return;
+
+  for(uint32_t i = 0; i < data->iterations && client->Connected(); i++)
+  {
+    if(data->sleepPoll)
+    {
+      while(client->Connected() && !client->IsRecvDataWaiting())
+        Threading::Sleep(4);
+    }
+    else
+    {
+      while(client->Connected() && !client->WaitForRecvData(1000))
+      {
+      }
+    }
+
+    uint32_t packet = 0;
+    if(!client->RecvDataBlocking(&packet, sizeof(packet)) ||
+       !client->SendDataBlocking(&packet, sizeof(packet)))
+      break;
+  }
+
+  SAFE_DELETE(client);
+}
+
+static bool NetworkBenchmarkRun(Network::Socket *server, uint16_t port, bool sleepPoll,
+                                uint32_t iterations, double &totalMS, double &maxMS)
+{
+  NetworkBenchmarkEcho echo = {server, sleepPoll, iterations};
+
+  Threading::ThreadHandle thread = Threading::CreateThread(&NetworkBenchmarkEchoEntry, &echo);
+
+  Network::Socket *sock = Network::CreateClientSocket("127.0.0.1", port, 3000);
+
+  bool success = (sock != NULL);
+
+  totalMS = maxMS = 0.0;
+
+  PerformanceTimer timer;
+
+  for(uint32_t i = 0; success && i < iterations; i++)
+  {
+    timer.Restart();
+
+    uint32_t packet = i;
+    success = sock->SendDataBlocking(&packet, sizeof(packet)) &&
+              sock->RecvDataBlocking(&packet, sizeof(packet)) && packet == i;
+
+    double ms = timer.GetMilliseconds();
+    totalMS += ms;
+    maxMS = RDCMAX(maxMS, ms);
+  }
+
+  SAFE_DELETE(sock);
+
+  Threading::JoinThread(thread);
+  Threading::CloseThread(thread);
+
+  return success;
+}
+
+std::string Benchmark_NetworkLatency(uint32_t iterations)
+{
+  // the sleep-polling mode takes several ms per round trip, don't let it run forever
+  iterations = RDCCLAMP(iterations, 1U, 2000U);
+
+  // a few ports past the target control range
+  uint16_t port = 38950;
+  Network::Socket *server = NULL;
+
+  for(; server == NULL && port < 38960; port++)
+    server = Network::CreateServerSocket("127.0.0.1", port, 1);
+
+  if(server == NULL)
+    return "NetworkLatency: couldn't create a loopback server socket\n";
+
+  port--;
+
+  std::string ret;
+
+  ret += StringFormat::Fmt("NetworkLatency: %u round trips over loopback\n", iterations);
+
+  const char *modeNames[] = {"readiness wait", "sleep poll"};
+
+  for(int mode = 0; mode < 2; mode++)
+  {
+    double totalMS = 0.0, maxMS = 0.0;
+
+    if(!NetworkBenchmarkRun(server, port, mode == 1, iterations, totalMS, maxMS))
+    {
+      ret += StringFormat::Fmt("  %-15s FAILED\n", modeNames[mode]);
+      continue;
+    }
+
+    ret += StringFormat::Fmt("  %-15s %.1lf us avg, %.1lf us max per round trip\n",
+                             modeNames[mode], totalMS * 1000.0 / double(iterations),
+                             maxMS * 1000.0);
+  }
+
+  SAFE_DELETE(server);
+
+  return ret;
+}
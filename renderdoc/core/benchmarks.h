@@ -0,0 +1,48 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ * Copyright (c) 2014 Crytek
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "api/replay/renderdoc_replay.h"
+
+// internal microbenchmarks, run with RENDERDOC_RunBenchmark (or 'renderdoccmd benchmark'). Each
+// returns a human readable summary of its timings.
+
+// not part of the public replay API, this is only declared here for renderdoccmd's benchmark
+// command. Returns false if the named benchmark doesn't exist.
+extern "C" RENDERDOC_API bool32 RENDERDOC_CC RENDERDOC_RunBenchmark(const char *name,
+                                                                    uint32_t numThreads,
+                                                                    uint32_t iterations,
+                                                                    rdctype::str *results);
+
+// capture-time ResourceManager traffic: wrapper lookups, record lookups and frame references from
+// numThreads threads, iterations calls each, plus the end-of-frame work.
+std::string Benchmark_ResourceManager(uint32_t numThreads, uint32_t iterations);
+
+// round-trip latency of a small packet over a loopback socket, with the remote end waiting for data
+// the way the remote server and target control do, compared to the old sleep-and-peek polling.
+std::string Benchmark_NetworkLatency(uint32_t iterations);
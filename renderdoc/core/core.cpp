@@ -30,6 +30,7 @@
 #include "common/common.h"
 #include "common/dds_readwrite.h"
 #include "hooks/hooks.h"
+#include "jpeg-compressor/jpge.h"
 #include "replay/replay_driver.h"
 #include "serialise/serialiser.h"
 #include "serialise/string_utils.h"
@@ -242,6 +243,9 @@ RenderDoc::RenderDoc()
 
   m_TargetControlThreadShutdown = false;
   m_ControlClientThreadShutdown = false;
+
+  m_CaptureWriterThread = 0;
+  m_CaptureWriterRunning = false;
 }
 
 void RenderDoc::Initialise()
@@ -349,6 +353,19 @@ RenderDoc::~RenderDoc()
   for(auto it = m_ShutdownFunctions.begin(); it != m_ShutdownFunctions.end(); ++it)
     (*it)();
 
+  if(m_CaptureWriterThread)
+  {
+    // give any capture that's still being written a chance to finish. For the same reason as the
+    // target control thread below we can't join here, so instead wait for the writer to signal
+    // that it's gone idle, with a timeout in case the thread has already been killed from under
+    // us. Wakes left over from earlier writer threads that already exited are skipped past.
+    while(m_CaptureWriterRunning && m_CaptureWriterIdle.WaitForWake(60 * 1000))
+      continue;
+
+    Threading::CloseThread(m_CaptureWriterThread);
+    m_CaptureWriterThread = 0;
+  }
+
   for(size_t i = 0; i < m_Captures.size(); i++)
   {
     if(m_Captures[i].retrieved)
@@ -401,6 +418,11 @@ void RenderDoc::Shutdown()
     Threading::CloseThread(m_RemoteThread);
     m_RemoteThread = 0;
   }
+
+  FlushCaptureWrites();
+
+  // the capture writer uses ParallelFor, so its workers can only go once that's done
+  Threading::ShutdownParallelFor();
 }
 
 bool RenderDoc::MatchClosestWindow(void *&dev, void *&wnd)
@@ -475,6 +497,9 @@ void RenderDoc::StartFrameCapture(void *dev, void *wnd)
   IFrameCapturer *frameCap = MatchFrameCapturer(dev, wnd);
   if(frameCap)
   {
+    if(m_CapturesActive == 0)
+      Serialiser::ResetCallstacks();
+
     frameCap->StartFrameCapture(dev, wnd);
     m_CapturesActive++;
   }
@@ -691,8 +716,7 @@ bool RenderDoc::ShouldTriggerCapture(uint32_t frameNumber)
   return ret;
 }
 
-Serialiser *RenderDoc::OpenWriteSerialiser(uint32_t frameNum, RDCInitParams *params, void *thpixels,
-                                           size_t thlen, uint32_t thwidth, uint32_t thheight)
+Serialiser *RenderDoc::OpenWriteSerialiser(uint32_t frameNum, RDCInitParams *params)
 {
   RDCASSERT(m_CurrentDriver != RDC_Unknown);
 
@@ -709,22 +733,8 @@ Serialiser *RenderDoc::OpenWriteSerialiser(uint32_t frameNum, RDCInitParams *par
 
   Serialiser *chunkSerialiser = new Serialiser(NULL, Serialiser::WRITING, debugSerialiser);
 
-  {
-    ScopedContext scope(chunkSerialiser, "Thumbnail", THUMBNAIL_DATA, false);
-
-    bool HasThumbnail = (thpixels != NULL && thwidth > 0 && thheight > 0);
-    chunkSerialiser->Serialise("HasThumbnail", HasThumbnail);
-
-    if(HasThumbnail)
-    {
-      byte *buf = (byte *)thpixels;
-      chunkSerialiser->Serialise("ThumbWidth", thwidth);
-      chunkSerialiser->Serialise("ThumbHeight", thheight);
-      chunkSerialiser->SerialiseBuffer("ThumbnailPixels", buf, thlen);
-    }
-
-    fileSerialiser->Insert(scope.Get(true));
-  }
+  // the thumbnail chunk that starts the file is inserted by the capture writer thread, once it's
+  // been compressed.
 
   {
     ScopedContext scope(chunkSerialiser, "Capture Create Parameters", CREATE_PARAMS, false);
@@ -1017,11 +1027,151 @@ void RenderDoc::SetProgress(LoadProgressSection section, float delta)
   *m_ProgressPtr = progress;
 }
 
-void RenderDoc::SuccessfullyWrittenLog(uint32_t frameNumber)
+void RenderDoc::QueueCaptureWrite(Serialiser *fileSerialiser, uint32_t frameNumber,
+                                  byte *thpixels, uint32_t thwidth, uint32_t thheight)
+{
+  // the chunks may belong to resource records that are modified or deleted as soon as the
+  // application continues, so the serialiser needs its own references before we hand it over.
+  // Likewise the callstack table is reset by the next capture, possibly before this is written.
+  fileSerialiser->OwnChunks();
+  fileSerialiser->SnapshotCallstacks();
+
+  PendingCaptureWrite write = {fileSerialiser, frameNumber, thpixels, thwidth, thheight};
+
+  SCOPED_LOCK(m_CaptureWriteLock);
+
+  m_PendingCaptureWrites.push_back(write);
+
+  if(!m_CaptureWriterRunning)
+  {
+    // any previous thread has run out of work and is only exiting, so this join is short
+    if(m_CaptureWriterThread)
+    {
+      Threading::JoinThread(m_CaptureWriterThread);
+      Threading::CloseThread(m_CaptureWriterThread);
+    }
+
+    m_CaptureWriterRunning = true;
+    m_CaptureWriterThread = Threading::CreateThread(CaptureWriterThread, (void *)this);
+  }
+}
+
+void RenderDoc::FlushCaptureWrites()
+{
+  for(;;)
+  {
+    Threading::ThreadHandle writer = 0;
+
+    {
+      SCOPED_LOCK(m_CaptureWriteLock);
+      writer = m_CaptureWriterThread;
+      m_CaptureWriterThread = 0;
+    }
+
+    // no thread means nothing is queued or in flight
+    if(writer == 0)
+      return;
+
+    Threading::JoinThread(writer);
+    Threading::CloseThread(writer);
+  }
+}
+
+static Chunk *MakeThumbnailChunk(byte *thpixels, uint32_t thwidth, uint32_t thheight)
+{
+#if ENABLED(RDOC_RELEASE)
+  const bool debugSerialiser = false;
+#else
+  const bool debugSerialiser = true;
+#endif
+
+  byte *jpgbuf = NULL;
+  size_t len = thwidth * thheight;
+
+  if(thpixels && len > 0)
+  {
+    jpgbuf = new byte[len];
+
+    jpge::params p;
+    p.m_quality = 80;
+
+    int jpglen = (int)len;
+
+    bool success = jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, jpglen, thwidth, thheight,
+                                                               3, thpixels, p);
+
+    if(success)
+    {
+      len = (size_t)jpglen;
+    }
+    else
+    {
+      RDCERR("Failed to compress to jpg");
+      SAFE_DELETE_ARRAY(jpgbuf);
+    }
+  }
+
+  Serialiser chunkSerialiser(NULL, Serialiser::WRITING, debugSerialiser);
+
+  ScopedContext scope(&chunkSerialiser, "Thumbnail", THUMBNAIL_DATA, false);
+
+  bool HasThumbnail = (jpgbuf != NULL);
+  chunkSerialiser.Serialise("HasThumbnail", HasThumbnail);
+
+  if(HasThumbnail)
+  {
+    chunkSerialiser.Serialise("ThumbWidth", thwidth);
+    chunkSerialiser.Serialise("ThumbHeight", thheight);
+    chunkSerialiser.SerialiseBuffer("ThumbnailPixels", jpgbuf, len);
+  }
+
+  Chunk *chunk = scope.Get(true);
+
+  SAFE_DELETE_ARRAY(jpgbuf);
+
+  return chunk;
+}
+
+void RenderDoc::CaptureWriterThread(void *s)
+{
+  RenderDoc *rdoc = (RenderDoc *)s;
+
+  for(;;)
+  {
+    PendingCaptureWrite write;
+
+    {
+      SCOPED_LOCK(rdoc->m_CaptureWriteLock);
+
+      if(rdoc->m_PendingCaptureWrites.empty())
+      {
+        rdoc->m_CaptureWriterRunning = false;
+        rdoc->m_CaptureWriterIdle.Wake();
+        return;
+      }
+
+      write = rdoc->m_PendingCaptureWrites.front();
+      rdoc->m_PendingCaptureWrites.erase(rdoc->m_PendingCaptureWrites.begin());
+    }
+
+    write.serialiser->InsertFirst(
+        MakeThumbnailChunk(write.thpixels, write.thwidth, write.thheight));
+    SAFE_DELETE_ARRAY(write.thpixels);
+
+    write.serialiser->FlushToDisk();
+
+    if(!write.serialiser->HasError())
+      rdoc->SuccessfullyWrittenLog(write.serialiser->GetFilename(), write.frameNumber);
+
+    SAFE_DELETE(write.serialiser);
+  }
+}
+
+void RenderDoc::SuccessfullyWrittenLog(const string &logfile, uint32_t frameNumber)
 {
-  RDCLOG("Written to disk: %s", m_CurrentLogFile.c_str());
+  RDCLOG("Written to disk: %s", logfile.c_str());
 
-  CaptureData cap(m_CurrentLogFile, Timing::GetUnixTimestamp(), frameNumber);
+  CaptureData cap(logfile, Timing::GetUnixTimestamp(), frameNumber);
   {
     SCOPED_LOCK(m_CaptureLock);
     m_Captures.push_back(cap);
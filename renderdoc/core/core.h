@@ -208,9 +208,17 @@ public:
   void RecreateCrashHandler();
   void UnloadCrashHandler();
   ICrashHandler *GetCrashHandler() const { return m_ExHandler; }
-  Serialiser *OpenWriteSerialiser(uint32_t frameNum, RDCInitParams *params, void *thpixels,
-                                  size_t thlen, uint32_t thwidth, uint32_t thheight);
-  void SuccessfullyWrittenLog(uint32_t frameNumber);
+  Serialiser *OpenWriteSerialiser(uint32_t frameNum, RDCInitParams *params);
+
+  // hands over a file serialiser with all of a frame's chunks inserted. The compression and disk
+  // writing happens on the capture writer thread, which deletes the serialiser once the capture
+  // has been written.
+  // thpixels is an optional tightly packed 8-bit RGB thumbnail allocated with new[], which is
+  // taken over and JPEG compressed on the writer thread too.
+  void QueueCaptureWrite(Serialiser *fileSerialiser, uint32_t frameNumber, byte *thpixels,
+                         uint32_t thwidth, uint32_t thheight);
+  // blocks until every capture queued so far has been written to disk
+  void FlushCaptureWrites();
 
   void AddChildProcess(uint32_t pid, uint32_t ident)
   {
@@ -431,6 +439,27 @@ private:
   static void TargetControlServerThread(void *s);
   static void TargetControlClientThread(void *s);
 
+  struct PendingCaptureWrite
+  {
+    Serialiser *serialiser;
+    uint32_t frameNumber;
+    byte *thpixels;
+    uint32_t thwidth;
+    uint32_t thheight;
+  };
+
+  // the writer thread only lives while there are captures to write, and exits once the queue
+  // is empty.
+  Threading::CriticalSection m_CaptureWriteLock;
+  vector<PendingCaptureWrite> m_PendingCaptureWrites;
+  Threading::ThreadHandle m_CaptureWriterThread;
+  volatile bool m_CaptureWriterRunning;
+  // woken each time the writer thread runs out of work and exits
+  Threading::Semaphore m_CaptureWriterIdle;
+
+  static void CaptureWriterThread(void *s);
+  void SuccessfullyWrittenLog(const string &logfile, uint32_t frameNumber);
+
   ICrashHandler *m_ExHandler;
 };
 
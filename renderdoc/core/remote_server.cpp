@@ -69,7 +69,14 @@ void Serialiser::Serialise(const char *name, Process::EnvironmentModification &e
   Serialise("value", el.value);
 }
 
-static const uint32_t RemoteServerProtocolVersion = 1;
+// bump whenever the layout of remote server or replay proxy packets changes, so that mismatched
+// builds are rejected at handshake rather than going out of sync.
+// 2 - texture data streamed as separately compressed blocks after the reply
+// 3 - content hash packets, and HashContent changed to SHA-256
+// 4 - texture delta packets
+// 5 - shader debug traces sent as an initial state and per-step deltas
+// 6 - batched post-transform data streamed with its geometry
+static const uint32_t RemoteServerProtocolVersion = 6;
 
 enum RemoteServerPacket
 {
@@ -234,9 +241,8 @@ static void ActiveRemoteClientThread(void *data)
     RemoteServerPacket sendType = eRemoteServer_Noop;
     sendSer.Rewind();
 
-    Threading::Sleep(4);
-
-    if(client->IsRecvDataWaiting())
+    // wake as soon as a packet arrives, timing out occasionally to check if we've been killed
+    if(client->WaitForRecvData(50))
     {
       type = eRemoteServer_Noop;
       Serialiser *recvser = NULL;
@@ -593,7 +599,7 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port, volati
 
   while(!killReplay)
   {
-    Network::Socket *client = sock->AcceptClient(false);
+    Network::Socket *client = sock->AcceptClient(50);
 
     if(activeClientData && activeClientData->killServer)
       break;
@@ -631,8 +637,6 @@ void RenderDoc::BecomeRemoteServer(const char *listenhost, uint16_t port, volati
         return;
       }
 
-      Threading::Sleep(5);
-
       continue;
     }
 
@@ -1085,6 +1089,12 @@ public:
     ReplayRenderer *ret = new ReplayRenderer();
 
     ReplayProxy *proxy = new ReplayProxy(m_Socket, proxyDriver);
+
+    // contents fetched from the remote are only kept on disk across sessions if the user has
+    // opted in by creating the cache folder.
+    string cacheFolder = FileIO::GetAppFolderFilename("proxycache");
+    if(FileIO::GetModifiedTimestamp(cacheFolder) != 0)
+      proxy->SetContentCacheFolder(cacheFolder);
     status = ret->SetDevice(proxy);
 
     if(status != eReplayCreate_Success)
@@ -23,6 +23,7 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <algorithm>
 #include "replay_proxy.h"
 #include "lz4/lz4.h"
 
@@ -276,6 +277,16 @@ void Serialiser::Serialise(const char *name, ShaderDebugState &el)
   SIZE_CHECK(56);
 }
 
+template <>
+void Serialiser::Serialise(const char *name, ShaderDebugStep &el)
+{
+  Serialise("", el.nextInstruction);
+  Serialise("", el.flags);
+  Serialise("", el.changes);
+
+  SIZE_CHECK(24);
+}
+
 template <>
 void Serialiser::Serialise(const char *name, ShaderDebugTrace &el)
 {
@@ -290,9 +301,12 @@ void Serialiser::Serialise(const char *name, ShaderDebugTrace &el)
   for(int32_t i = 0; i < numcbuffers; i++)
     Serialise("", el.cbuffers[i]);
 
-  Serialise("", el.states);
+  Serialise("", el.initialState);
+  Serialise("", el.steps);
 
-  SIZE_CHECK(48);
+  // keyframes are regenerated locally from the steps, no need to send them
+
+  SIZE_CHECK(120);
 }
 
 #pragma endregion General Shader / State
@@ -1727,6 +1741,11 @@ string ToStrHelper<false, VarType>::Get(const VarType &el)
   return "<...>";
 }
 template <>
+string ToStrHelper<false, ShaderDebugVariableSet>::Get(const ShaderDebugVariableSet &el)
+{
+  return "<...>";
+}
+template <>
 string ToStrHelper<false, MeshDataStage>::Get(const MeshDataStage &el)
 {
   return "<...>";
@@ -1748,6 +1767,11 @@ string ToStrHelper<false, GraphicsAPI>::Get(const GraphicsAPI &el)
 
 // these structures we can just serialise as a blob, since they're POD.
 template <>
+string ToStrHelper<false, ShaderVariableChange>::Get(const ShaderVariableChange &el)
+{
+  return "<...>";
+}
+template <>
 string ToStrHelper<false, D3D11PipelineState::InputAssembler::VertexBuffer>::Get(
     const D3D11PipelineState::InputAssembler::VertexBuffer &el)
 {
@@ -1944,6 +1968,9 @@ ReplayProxy::~ReplayProxy()
   SAFE_DELETE(m_FromReplaySerialiser);
   m_ToReplaySerialiser = NULL;    // we don't own this
 
+  SAFE_DELETE_ARRAY(m_StreamData);
+  SAFE_DELETE_ARRAY(m_HashedTexture.data);
+
   if(m_Proxy)
     m_Proxy->Shutdown();
   m_Proxy = NULL;
@@ -2069,13 +2096,70 @@ void ReplayProxy::EnsureTexCached(ResourceId texid, uint32_t arrayIdx, uint32_t
 
     const ProxyTextureProperties &proxy = m_ProxyTextures[texid];
 
-    size_t size;
-    byte *data = GetTextureData(texid, arrayIdx, mip, proxy.params, size);
+    // ask for the hash of the contents first, and only transfer the data itself if we don't
+    // have it already.
+    ContentHash hash;
+    bool hashed = GetTextureDataHash(texid, arrayIdx, mip, proxy.params, hash);
 
-    if(data)
-      m_Proxy->SetProxyTextureData(proxy.id, arrayIdx, mip, data, size);
+    auto it = m_TextureProxyHashes.find(entry);
 
-    delete[] data;
+    if(hashed && it != m_TextureProxyHashes.end() && it->second == hash)
+    {
+      // the proxy texture already contains this data
+    }
+    else
+    {
+      bool uploaded = false;
+
+      const vector<byte> *cached = hashed ? FindCachedContent(hash) : NULL;
+
+      if(cached)
+      {
+        m_Proxy->SetProxyTextureData(proxy.id, arrayIdx, mip, (byte *)&(*cached)[0],
+                                     cached->size());
+        uploaded = true;
+      }
+      else
+      {
+        size_t size = 0;
+        byte *data = NULL;
+
+        if(hashed)
+        {
+          // if we still have the version currently in the proxy, the remote only needs to send
+          // what changed since then.
+          ContentHash baseHash;
+          RDCEraseEl(baseHash);
+
+          const vector<byte> *base = NULL;
+          if(it != m_TextureProxyHashes.end())
+            base = FindCachedContent(it->second);
+          if(base)
+            baseHash = it->second;
+
+          data = GetTextureDataDelta(texid, arrayIdx, mip, proxy.params, hash, baseHash, base, size);
+        }
+
+        if(data == NULL)
+          data = GetTextureData(texid, arrayIdx, mip, proxy.params, size);
+
+        if(data)
+        {
+          m_Proxy->SetProxyTextureData(proxy.id, arrayIdx, mip, data, size);
+          uploaded = true;
+
+          if(hashed)
+            AddCachedContent(hash, data, size, true);
+        }
+
+        delete[] data;
+      }
+
+      if(hashed && uploaded)
+        m_TextureProxyHashes[entry] = hash;
+      else
+        m_TextureProxyHashes.erase(entry);
+    }
 
     m_TextureProxyCache.insert(entry);
   }
@@ -2096,16 +2180,213 @@ void ReplayProxy::EnsureBufCached(ResourceId bufid)
 
     ResourceId proxyid = m_ProxyBufferIds[bufid];
 
-    vector<byte> data;
-    GetBufferData(bufid, 0, 0, data);
+    ContentHash hash;
+    bool hashed = GetBufferDataHash(bufid, hash);
+
+    auto it = m_BufferProxyHashes.find(bufid);
 
-    if(!data.empty())
-      m_Proxy->SetProxyBufferData(proxyid, &data[0], data.size());
+    if(hashed && it != m_BufferProxyHashes.end() && it->second == hash)
+    {
+      // the proxy buffer already contains this data
+    }
+    else
+    {
+      bool uploaded = false;
+
+      const vector<byte> *cached = hashed ? FindCachedContent(hash) : NULL;
+
+      if(cached)
+      {
+        m_Proxy->SetProxyBufferData(proxyid, (byte *)&(*cached)[0], cached->size());
+        uploaded = true;
+      }
+      else
+      {
+        vector<byte> data;
+        GetBufferData(bufid, 0, 0, data);
+
+        if(!data.empty())
+        {
+          m_Proxy->SetProxyBufferData(proxyid, &data[0], data.size());
+          uploaded = true;
+
+          if(hashed)
+            AddCachedContent(hash, &data[0], data.size(), true);
+        }
+      }
+
+      if(hashed && uploaded)
+        m_BufferProxyHashes[bufid] = hash;
+      else
+        m_BufferProxyHashes.erase(bufid);
+    }
 
     m_BufferProxyCache.insert(bufid);
   }
 }
 
+static string ContentCacheFilename(const string &folder, const ContentHash &hash)
+{
+  return StringFormat::Fmt("%s/%016llx%016llx.bin", folder.c_str(), (unsigned long long)hash.hi,
+                           (unsigned long long)hash.lo);
+}
+
+// only files we could have written are considered part of the cache
+static bool IsContentCacheFile(const FileIO::FoundFile &file)
+{
+  const uint32_t skipFlags = FileIO::eFileProp_Directory | FileIO::eFileProp_ErrorUnknown |
+                             FileIO::eFileProp_ErrorAccessDenied |
+                             FileIO::eFileProp_ErrorInvalidPath;
+
+  return (file.flags & skipFlags) == 0 && file.filename.length() == 36 &&
+         file.filename.substr(32) == ".bin";
+}
+
+static bool LeastRecentlyUsed(const FileIO::FoundFile &a, const FileIO::FoundFile &b)
+{
+  return a.lastmod < b.lastmod;
+}
+
+void ReplayProxy::SetContentCacheFolder(const string &folder)
+{
+  m_ContentCacheFolder = folder;
+  m_ContentCacheDiskSize = 0;
+
+  vector<FileIO::FoundFile> files = FileIO::GetFilesInDirectory(folder.c_str());
+
+  for(size_t i = 0; i < files.size(); i++)
+    if(IsContentCacheFile(files[i]))
+      m_ContentCacheDiskSize += files[i].size;
+
+  if(m_ContentCacheDiskSize > MaxDiskContentCacheSize)
+    TrimContentCacheFolder();
+}
+
+void ReplayProxy::TrimContentCacheFolder()
+{
+  vector<FileIO::FoundFile> files = FileIO::GetFilesInDirectory(m_ContentCacheFolder.c_str());
+
+  vector<FileIO::FoundFile> cacheFiles;
+  uint64_t total = 0;
+
+  for(size_t i = 0; i < files.size(); i++)
+  {
+    if(IsContentCacheFile(files[i]))
+    {
+      cacheFiles.push_back(files[i]);
+      total += files[i].size;
+    }
+  }
+
+  std::sort(cacheFiles.begin(), cacheFiles.end(), LeastRecentlyUsed);
+
+  // trim well below the limit, so we aren't rescanning the folder on every new file
+  const uint64_t target = MaxDiskContentCacheSize / 4 * 3;
+
+  size_t deleted = 0;
+  for(; deleted < cacheFiles.size() && total > target; deleted++)
+  {
+    string path = m_ContentCacheFolder + "/" + cacheFiles[deleted].filename;
+    FileIO::Delete(path.c_str());
+    total -= cacheFiles[deleted].size;
+  }
+
+  RDCDEBUG("Evicted %u files from proxy cache folder, %llu bytes remain", (uint32_t)deleted, total);
+
+  m_ContentCacheDiskSize = total;
+}
+
+const vector<byte> *ReplayProxy::FindCachedContent(const ContentHash &hash)
+{
+  auto it = m_ContentCache.find(hash);
+  if(it != m_ContentCache.end())
+    return &it->second;
+
+  if(m_ContentCacheFolder.empty())
+    return NULL;
+
+  string filename = ContentCacheFilename(m_ContentCacheFolder, hash);
+
+  FILE *f = FileIO::fopen(filename.c_str(), "rb");
+
+  if(f == NULL)
+    return NULL;
+
+  FileIO::fseek64(f, 0, SEEK_END);
+  uint64_t size = FileIO::ftell64(f);
+  FileIO::fseek64(f, 0, SEEK_SET);
+
+  vector<byte> data;
+  data.resize((size_t)size);
+
+  bool success = size > 0 && FileIO::fread(&data[0], 1, (size_t)size, f) == (size_t)size;
+
+  FileIO::fclose(f);
+
+  // don't trust a truncated or corrupted file
+  if(!success || HashContent(&data[0], data.size()) != hash)
+  {
+    RDCWARN("Ignoring invalid proxy cache file for %016llx%016llx", (unsigned long long)hash.hi,
+            (unsigned long long)hash.lo);
+    return NULL;
+  }
+
+  // mark as recently used, so it's one of the last files to be evicted
+  FileIO::Touch(filename);
+
+  AddCachedContent(hash, &data[0], data.size(), false);
+
+  it = m_ContentCache.find(hash);
+  if(it != m_ContentCache.end())
+    return &it->second;
+
+  // too large to keep in memory, so we can't return it.
+  return NULL;
+}
+
+void ReplayProxy::AddCachedContent(const ContentHash &hash, const byte *data, size_t size,
+                                   bool writeToDisk)
+{
+  if(writeToDisk && !m_ContentCacheFolder.empty())
+  {
+    string filename = ContentCacheFilename(m_ContentCacheFolder, hash);
+
+    FileIO::CreateParentDirectory(filename);
+
+    FILE *f = FileIO::fopen(filename.c_str(), "wb");
+
+    if(f)
+    {
+      FileIO::fwrite(data, 1, size, f);
+      FileIO::fclose(f);
+
+      m_ContentCacheDiskSize += size;
+
+      if(m_ContentCacheDiskSize > MaxDiskContentCacheSize)
+        TrimContentCacheFolder();
+    }
+    else
+    {
+      RDCWARN("Couldn't write proxy cache file '%s'", filename.c_str());
+    }
+  }
+
+  if(size > MaxContentCacheSize || m_ContentCache.find(hash) != m_ContentCache.end())
+    return;
+
+  while(m_ContentCacheSize + size > MaxContentCacheSize && !m_ContentCacheOrder.empty())
+  {
+    auto it = m_ContentCache.find(m_ContentCacheOrder.front());
+    m_ContentCacheSize -= it->second.size();
+    m_ContentCache.erase(it);
+    m_ContentCacheOrder.pop_front();
+  }
+
+  m_ContentCache[hash].assign(data, data + size);
+  m_ContentCacheOrder.push_back(hash);
+  m_ContentCacheSize += size;
+}
+
 bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
 {
   if(!m_RemoteServer)
@@ -2171,6 +2452,27 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
       GetTextureData(ResourceId(), 0, 0, GetTextureDataParams(), dummy);
       break;
     }
+    case eReplayProxy_GetTextureDataHash:
+    {
+      ContentHash dummy;
+      GetTextureDataHash(ResourceId(), 0, 0, GetTextureDataParams(), dummy);
+      break;
+    }
+    case eReplayProxy_GetBufferDataHash:
+    {
+      ContentHash dummy;
+      GetBufferDataHash(ResourceId(), dummy);
+      break;
+    }
+    case eReplayProxy_GetTextureDataDelta:
+    {
+      ContentHash dummyHash;
+      RDCEraseEl(dummyHash);
+      size_t dummySize;
+      GetTextureDataDelta(ResourceId(), 0, 0, GetTextureDataParams(), dummyHash, dummyHash, NULL,
+                          dummySize);
+      break;
+    }
     case eReplayProxy_InitPostVS: InitPostVSBuffers(0); break;
     case eReplayProxy_InitPostVSVec:
     {
@@ -2179,6 +2481,12 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
       break;
     }
     case eReplayProxy_GetPostVS: GetPostVSBuffers(0, 0, eMeshDataStage_Unknown); break;
+    case eReplayProxy_GetPostVSForEvents:
+    {
+      vector<uint32_t> dummyEvents, dummyInsts;
+      GetPostVSBuffersForEvents(dummyEvents, dummyInsts, eMeshDataStage_Unknown);
+      break;
+    }
     case eReplayProxy_BuildTargetShader:
       BuildTargetShader("", "", 0, eShaderStage_Vertex, NULL, NULL);
       break;
@@ -2205,6 +2513,10 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
   if(!SendPacket(m_Socket, type, *m_FromReplaySerialiser))
     return false;
 
+  if((type == eReplayProxy_GetTextureData || type == eReplayProxy_GetTextureDataDelta) &&
+     !StreamTextureData())
+    return false;
+
   return true;
 }
 
@@ -2611,7 +2923,13 @@ void ReplayProxy::GetBufferData(ResourceId buff, uint64_t offset, uint64_t len,
 
   if(m_RemoteServer)
   {
-    m_Remote->GetBufferData(buff, offset, len, retData);
+    if(offset == 0 && len == 0 && buff == m_HashedBuffer)
+      retData.swap(m_HashedBufferData);
+    else
+      m_Remote->GetBufferData(buff, offset, len, retData);
+
+    m_HashedBuffer = ResourceId();
+    m_HashedBufferData.clear();
 
     uint64_t sz = retData.size();
     m_FromReplaySerialiser->Serialise("", sz);
@@ -2629,6 +2947,114 @@ void ReplayProxy::GetBufferData(ResourceId buff, uint64_t offset, uint64_t len,
   }
 }
 
+static bool SameTextureDataParams(const GetTextureDataParams &a, const GetTextureDataParams &b)
+{
+  return a.forDiskSave == b.forDiskSave && a.typeHint == b.typeHint && a.resolve == b.resolve &&
+         a.remap == b.remap && a.blackPoint == b.blackPoint && a.whitePoint == b.whitePoint;
+}
+
+byte *ReplayProxy::FetchRemoteTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                                          const GetTextureDataParams &params, size_t &dataSize)
+{
+  byte *data = NULL;
+
+  if(m_HashedTexture.data && m_HashedTexture.tex == tex && m_HashedTexture.arrayIdx == arrayIdx &&
+     m_HashedTexture.mip == mip && SameTextureDataParams(m_HashedTexture.params, params))
+  {
+    data = m_HashedTexture.data;
+    dataSize = m_HashedTexture.size;
+    m_HashedTexture.data = NULL;
+  }
+  else
+  {
+    data = m_Remote->GetTextureData(tex, arrayIdx, mip, params, dataSize);
+  }
+
+  SAFE_DELETE_ARRAY(m_HashedTexture.data);
+
+  if(data == NULL)
+    dataSize = 0;
+
+  return data;
+}
+
+void ReplayProxy::QueueTextureStream(byte *data, size_t dataSize)
+{
+  uint32_t uncompressedSize = (uint32_t)dataSize;
+  uint32_t numBlocks = (uint32_t)((dataSize + TextureStreamBlockSize - 1) / TextureStreamBlockSize);
+
+  m_FromReplaySerialiser->Serialise("", uncompressedSize);
+  m_FromReplaySerialiser->Serialise("", numBlocks);
+
+  // the blocks themselves are compressed and sent after the reply packet, in
+  // StreamTextureData()
+  SAFE_DELETE_ARRAY(m_StreamData);
+  m_StreamData = data;
+  m_StreamDataSize = dataSize;
+}
+
+byte *ReplayProxy::RecvTextureStream(size_t &dataSize, float *progress)
+{
+  uint32_t uncompressedSize = 0;
+  uint32_t numBlocks = 0;
+
+  m_FromReplaySerialiser->Serialise("", uncompressedSize);
+  m_FromReplaySerialiser->Serialise("", numBlocks);
+
+  dataSize = (size_t)uncompressedSize;
+
+  byte *ret = uncompressedSize > 0 ? new byte[dataSize + 512] : NULL;
+
+  // each block arrives as its own packet, and is decompressed straight into place while the
+  // remote side is still compressing and sending the following blocks.
+  vector<byte> payload;
+  bool success = true;
+
+  for(uint32_t i = 0; i < numBlocks; i++)
+  {
+    ReplayProxyPacket type = eReplayProxy_GetTextureData;
+
+    payload.clear();
+    if(!RecvPacket(m_Socket, type, payload) || type != eReplayProxy_GetTextureData)
+    {
+      RDCERR("Failed to receive texture data block %u of %u", i, numBlocks);
+      success = false;
+      break;
+    }
+
+    size_t offset = (size_t)i * TextureStreamBlockSize;
+
+    if(!success || ret == NULL || payload.empty() || offset >= dataSize)
+    {
+      success = false;
+      continue;
+    }
+
+    int blockSize = (int)RDCMIN(TextureStreamBlockSize, dataSize - offset);
+
+    int decompSize = LZ4_decompress_safe((const char *)&payload[0], (char *)ret + offset,
+                                         (int)payload.size(), blockSize);
+
+    if(decompSize != blockSize)
+    {
+      RDCERR("Failed to decompress texture data block %u of %u", i, numBlocks);
+      // keep receiving so the stream stays in sync, but discard the result.
+      success = false;
+    }
+
+    if(progress)
+      *progress = float(i + 1) / float(numBlocks);
+  }
+
+  if(!success || numBlocks == 0)
+  {
+    SAFE_DELETE_ARRAY(ret);
+    dataSize = 0;
+  }
+
+  return ret;
+}
+
 byte *ReplayProxy::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                                   const GetTextureDataParams &_params, size_t &dataSize)
 {
@@ -2646,55 +3072,398 @@ byte *ReplayProxy::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
 
   if(m_RemoteServer)
   {
-    byte *data = m_Remote->GetTextureData(tex, arrayIdx, mip, params, dataSize);
+    byte *data = FetchRemoteTextureData(tex, arrayIdx, mip, params, dataSize);
 
-    byte *compressed = new byte[LZ4_COMPRESSBOUND(dataSize)];
+    QueueTextureStream(data, dataSize);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_GetTextureData))
+    {
+      dataSize = 0;
+      return NULL;
+    }
 
-    uint32_t uncompressedSize = (uint32_t)dataSize;
-    uint32_t compressedSize =
-        (uint32_t)LZ4_compress((const char *)data, (char *)compressed, (int)uncompressedSize);
+    return RecvTextureStream(dataSize, _params.progress);
+  }
 
-    m_FromReplaySerialiser->Serialise("", uncompressedSize);
-    m_FromReplaySerialiser->Serialise("", compressedSize);
-    m_FromReplaySerialiser->RawWriteBytes(compressed, (size_t)compressedSize);
+  return NULL;
+}
+
+byte *ReplayProxy::GetTextureDataDelta(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                                       const GetTextureDataParams &_params, const ContentHash &hash,
+                                       ContentHash baseHash, const vector<byte> *baseData,
+                                       size_t &dataSize)
+{
+  GetTextureDataParams params = _params;    // Serialiser is non-const
 
-    delete[] data;
-    delete[] compressed;
+  m_ToReplaySerialiser->Serialise("", tex);
+  m_ToReplaySerialiser->Serialise("", arrayIdx);
+  m_ToReplaySerialiser->Serialise("", mip);
+  m_ToReplaySerialiser->Serialise("", params.forDiskSave);
+  m_ToReplaySerialiser->Serialise("", params.typeHint);
+  m_ToReplaySerialiser->Serialise("", params.resolve);
+  m_ToReplaySerialiser->Serialise("", params.remap);
+  m_ToReplaySerialiser->Serialise("", params.blackPoint);
+  m_ToReplaySerialiser->Serialise("", params.whitePoint);
+  m_ToReplaySerialiser->Serialise("", baseHash.hi);
+  m_ToReplaySerialiser->Serialise("", baseHash.lo);
+
+  if(m_RemoteServer)
+  {
+    byte *data = FetchRemoteTextureData(tex, arrayIdx, mip, params, dataSize);
+
+    vector<DiffRange> ranges;
+    bool isDelta = false;
+    size_t deltaSize = 0;
+
+    if(data)
+    {
+      // we can only send a delta if we still have the version the client has
+      const vector<byte> *base = NULL;
+      if(baseHash != ContentHash())
+        base = FindCachedContent(baseHash);
+
+      if(base && base->size() == dataSize)
+      {
+        FindDiffRanges(&(*base)[0], data, dataSize, TextureDeltaGranularity, ranges);
+
+        for(size_t i = 0; i < ranges.size(); i++)
+          deltaSize += ranges[i].end - ranges[i].start;
+
+        // if most of the data changed, it's cheaper to just send it all
+        isDelta = deltaSize < dataSize / 2;
+      }
+
+      // remember this version so the next request can be a delta against it
+      AddCachedContent(HashContent(data, dataSize), data, dataSize, false);
+    }
+
+    uint64_t fullSize = dataSize;
+    uint32_t numRanges = isDelta ? (uint32_t)ranges.size() : 0;
+
+    m_FromReplaySerialiser->Serialise("", isDelta);
+    m_FromReplaySerialiser->Serialise("", fullSize);
+    m_FromReplaySerialiser->Serialise("", numRanges);
+
+    if(isDelta)
+    {
+      // pack only the changed bytes together to stream
+      byte *delta = deltaSize > 0 ? new byte[deltaSize] : NULL;
+      size_t offs = 0;
+
+      for(uint32_t i = 0; i < numRanges; i++)
+      {
+        uint64_t start = ranges[i].start;
+        uint64_t end = ranges[i].end;
+
+        m_FromReplaySerialiser->Serialise("", start);
+        m_FromReplaySerialiser->Serialise("", end);
+
+        memcpy(delta + offs, data + start, (size_t)(end - start));
+        offs += (size_t)(end - start);
+      }
+
+      SAFE_DELETE_ARRAY(data);
+
+      QueueTextureStream(delta, deltaSize);
+    }
+    else
+    {
+      QueueTextureStream(data, dataSize);
+    }
   }
   else
   {
-    if(!SendReplayCommand(eReplayProxy_GetTextureData))
+    if(!SendReplayCommand(eReplayProxy_GetTextureDataDelta))
     {
       dataSize = 0;
       return NULL;
     }
 
-    uint32_t uncompressedSize = 0;
-    uint32_t compressedSize = 0;
+    bool isDelta = false;
+    uint64_t fullSize = 0;
+    uint32_t numRanges = 0;
+
+    m_FromReplaySerialiser->Serialise("", isDelta);
+    m_FromReplaySerialiser->Serialise("", fullSize);
+    m_FromReplaySerialiser->Serialise("", numRanges);
 
-    m_FromReplaySerialiser->Serialise("", uncompressedSize);
-    m_FromReplaySerialiser->Serialise("", compressedSize);
+    vector<DiffRange> ranges;
+    ranges.resize(numRanges);
 
-    if(uncompressedSize == 0 || compressedSize == 0)
+    for(uint32_t i = 0; i < numRanges; i++)
     {
-      dataSize = 0;
+      uint64_t start = 0, end = 0;
+
+      m_FromReplaySerialiser->Serialise("", start);
+      m_FromReplaySerialiser->Serialise("", end);
+
+      ranges[i].start = (size_t)start;
+      ranges[i].end = (size_t)end;
+    }
+
+    size_t payloadSize = 0;
+    byte *payload = RecvTextureStream(payloadSize, _params.progress);
+
+    if(!isDelta)
+    {
+      dataSize = payloadSize;
+      return payload;
+    }
+
+    dataSize = 0;
+
+    if(baseData == NULL || baseData->size() != fullSize || fullSize == 0)
+    {
+      RDCERR("Received texture delta without matching base data");
+      SAFE_DELETE_ARRAY(payload);
       return NULL;
     }
 
-    dataSize = (size_t)uncompressedSize;
+    // patch the changed ranges over a copy of the version we already have
+    byte *ret = new byte[(size_t)fullSize + 512];
+    memcpy(ret, &(*baseData)[0], (size_t)fullSize);
 
-    byte *ret = new byte[dataSize + 512];
+    size_t offs = 0;
+    bool success = true;
 
-    byte *compressed = (byte *)m_FromReplaySerialiser->RawReadBytes((size_t)compressedSize);
+    for(uint32_t i = 0; i < numRanges; i++)
+    {
+      size_t len = ranges[i].end - ranges[i].start;
+
+      if(ranges[i].end < ranges[i].start || ranges[i].end > fullSize || offs + len > payloadSize)
+      {
+        success = false;
+        break;
+      }
+
+      memcpy(ret + ranges[i].start, payload + offs, len);
+      offs += len;
+    }
+
+    SAFE_DELETE_ARRAY(payload);
 
-    LZ4_decompress_fast((const char *)compressed, (char *)ret, (int)dataSize);
+    // the hash of the patched data must match what the remote said it has, otherwise we'd leave
+    // the proxy subtly wrong.
+    if(!success || offs != payloadSize || HashContent(ret, (size_t)fullSize) != hash)
+    {
+      RDCERR("Texture delta didn't produce the expected data");
+      SAFE_DELETE_ARRAY(ret);
+      return NULL;
+    }
 
+    dataSize = (size_t)fullSize;
     return ret;
   }
 
   return NULL;
 }
 
+bool ReplayProxy::GetTextureDataHash(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                                     const GetTextureDataParams &_params, ContentHash &hash)
+{
+  GetTextureDataParams params = _params;    // Serialiser is non-const
+
+  m_ToReplaySerialiser->Serialise("", tex);
+  m_ToReplaySerialiser->Serialise("", arrayIdx);
+  m_ToReplaySerialiser->Serialise("", mip);
+  m_ToReplaySerialiser->Serialise("", params.forDiskSave);
+  m_ToReplaySerialiser->Serialise("", params.typeHint);
+  m_ToReplaySerialiser->Serialise("", params.resolve);
+  m_ToReplaySerialiser->Serialise("", params.remap);
+  m_ToReplaySerialiser->Serialise("", params.blackPoint);
+  m_ToReplaySerialiser->Serialise("", params.whitePoint);
+
+  RDCEraseEl(hash);
+  bool valid = false;
+
+  if(m_RemoteServer)
+  {
+    SAFE_DELETE_ARRAY(m_HashedTexture.data);
+
+    m_HashedTexture.tex = tex;
+    m_HashedTexture.arrayIdx = arrayIdx;
+    m_HashedTexture.mip = mip;
+    m_HashedTexture.params = params;
+    m_HashedTexture.size = 0;
+    m_HashedTexture.data = m_Remote->GetTextureData(tex, arrayIdx, mip, params, m_HashedTexture.size);
+
+    if(m_HashedTexture.data && m_HashedTexture.size > 0)
+    {
+      hash = HashContent(m_HashedTexture.data, m_HashedTexture.size);
+      valid = true;
+    }
+
+    m_FromReplaySerialiser->Serialise("", valid);
+    m_FromReplaySerialiser->Serialise("", hash.hi);
+    m_FromReplaySerialiser->Serialise("", hash.lo);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_GetTextureDataHash))
+      return false;
+
+    m_FromReplaySerialiser->Serialise("", valid);
+    m_FromReplaySerialiser->Serialise("", hash.hi);
+    m_FromReplaySerialiser->Serialise("", hash.lo);
+  }
+
+  return valid;
+}
+
+bool ReplayProxy::GetBufferDataHash(ResourceId buff, ContentHash &hash)
+{
+  m_ToReplaySerialiser->Serialise("", buff);
+
+  RDCEraseEl(hash);
+  bool valid = false;
+
+  if(m_RemoteServer)
+  {
+    m_HashedBuffer = buff;
+    m_HashedBufferData.clear();
+    m_Remote->GetBufferData(buff, 0, 0, m_HashedBufferData);
+
+    if(!m_HashedBufferData.empty())
+    {
+      hash = HashContent(&m_HashedBufferData[0], m_HashedBufferData.size());
+      valid = true;
+    }
+
+    m_FromReplaySerialiser->Serialise("", valid);
+    m_FromReplaySerialiser->Serialise("", hash.hi);
+    m_FromReplaySerialiser->Serialise("", hash.lo);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_GetBufferDataHash))
+      return false;
+
+    m_FromReplaySerialiser->Serialise("", valid);
+    m_FromReplaySerialiser->Serialise("", hash.hi);
+    m_FromReplaySerialiser->Serialise("", hash.lo);
+  }
+
+  return valid;
+}
+
+const size_t ReplayProxy::TextureStreamBlockSize;
+const size_t ReplayProxy::TextureDeltaGranularity;
+
+struct TextureStreamData
+{
+  const byte *data;
+  size_t dataSize;
+
+  vector<byte *> blocks;
+  vector<uint32_t> blockSizes;
+  vector<int32_t> ready;
+  int32_t failed;
+
+  // woken once for each block that finishes, in whatever order they complete
+  Threading::Semaphore blockDone;
+};
+
+static void CompressTextureStreamBlock(void *userData, uint32_t idx)
+{
+  TextureStreamData *stream = (TextureStreamData *)userData;
+
+  size_t offset = (size_t)idx * ReplayProxy::TextureStreamBlockSize;
+  int srcSize = (int)RDCMIN(ReplayProxy::TextureStreamBlockSize, stream->dataSize - offset);
+
+  byte *compressed = new byte[LZ4_COMPRESSBOUND(srcSize)];
+
+  int compSize = LZ4_compress((const char *)stream->data + offset, (char *)compressed, srcSize);
+
+  if(compSize <= 0)
+  {
+    SAFE_DELETE_ARRAY(compressed);
+    Atomic::Inc32(&stream->failed);
+    compSize = 0;
+  }
+
+  stream->blocks[idx] = compressed;
+  stream->blockSizes[idx] = (uint32_t)compSize;
+
+  // publish the block to the sending thread
+  Atomic::CmpExch32(&stream->ready[idx], 0, 1);
+  stream->blockDone.Wake();
+}
+
+static void CompressTextureStream(void *userData)
+{
+  TextureStreamData *stream = (TextureStreamData *)userData;
+
+  // ParallelFor hands out indices in increasing order, so the earliest blocks are generally
+  // ready first and the sender can start immediately.
+  Threading::ParallelFor((uint32_t)stream->ready.size(), &CompressTextureStreamBlock, stream);
+}
+
+bool ReplayProxy::StreamTextureData()
+{
+  TextureStreamData stream;
+  stream.data = m_StreamData;
+  stream.dataSize = m_StreamDataSize;
+  stream.failed = 0;
+
+  uint32_t numBlocks =
+      (uint32_t)((m_StreamDataSize + TextureStreamBlockSize - 1) / TextureStreamBlockSize);
+
+  stream.blocks.resize(numBlocks);
+  stream.blockSizes.resize(numBlocks);
+  stream.ready.resize(numBlocks);
+
+  Threading::ThreadHandle compressThread = 0;
+
+  if(numBlocks > 0)
+    compressThread = Threading::CreateThread(&CompressTextureStream, &stream);
+
+  // if we couldn't spawn a thread, compress everything up front
+  if(numBlocks > 0 && compressThread == 0)
+    CompressTextureStream(&stream);
+
+  bool success = true;
+  uint32_t t = (uint32_t)eReplayProxy_GetTextureData;
+
+  for(uint32_t i = 0; i < numBlocks; i++)
+  {
+    // every wait consumes one finished block, so while block i isn't ready there's always another
+    // wake still to come.
+    while(Atomic::CmpExch32(&stream.ready[i], 1, 1) == 0)
+      stream.blockDone.WaitForWake();
+
+    // once the socket fails we still need to wait for all blocks so they can be freed, but we
+    // don't try to send anything else.
+    if(success)
+    {
+      // a failed block is sent empty, the client will detect this and discard the texture
+      // without losing sync with the stream.
+      uint32_t payloadLength = stream.blockSizes[i];
+
+      success = m_Socket->SendDataBlocking(&t, sizeof(t)) &&
+                m_Socket->SendDataBlocking(&payloadLength, sizeof(payloadLength)) &&
+                (payloadLength == 0 || m_Socket->SendDataBlocking(stream.blocks[i], payloadLength));
+    }
+
+    SAFE_DELETE_ARRAY(stream.blocks[i]);
+  }
+
+  if(compressThread)
+  {
+    Threading::JoinThread(compressThread);
+    Threading::CloseThread(compressThread);
+  }
+
+  if(stream.failed)
+    RDCERR("Failed to compress %d texture data blocks", stream.failed);
+
+  SAFE_DELETE_ARRAY(m_StreamData);
+  m_StreamDataSize = 0;
+
+  return success;
+}
+
 void ReplayProxy::InitPostVSBuffers(uint32_t eventID)
 {
   m_ToReplaySerialiser->Serialise("", eventID);
@@ -2748,6 +3517,85 @@ MeshFormat ReplayProxy::GetPostVSBuffers(uint32_t eventID, uint32_t instID, Mesh
   return ret;
 }
 
+vector<MeshFormat> ReplayProxy::GetPostVSBuffersForEvents(const vector<uint32_t> &events,
+                                                          const vector<uint32_t> &instIDs,
+                                                          MeshDataStage stage)
+{
+  vector<MeshFormat> ret;
+
+  // all events go in one round trip, rather than one per event
+  m_ToReplaySerialiser->Serialise("", (vector<uint32_t> &)events);
+  m_ToReplaySerialiser->Serialise("", (vector<uint32_t> &)instIDs);
+  m_ToReplaySerialiser->Serialise("", stage);
+
+  if(m_RemoteServer)
+  {
+    ret = m_Remote->GetPostVSBuffersForEvents(events, instIDs, stage);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_GetPostVSForEvents))
+      return ret;
+  }
+
+  m_FromReplaySerialiser->Serialise("", ret);
+
+  // the geometry is streamed back in the same reply, so displaying the meshes afterwards only
+  // needs to check hashes instead of fetching every buffer with its own round trip.
+  vector<ResourceId> bufs;
+  for(size_t i = 0; i < ret.size(); i++)
+  {
+    if(ret[i].buf != ResourceId())
+      bufs.push_back(ret[i].buf);
+    if(ret[i].idxbuf != ResourceId())
+      bufs.push_back(ret[i].idxbuf);
+  }
+
+  std::sort(bufs.begin(), bufs.end());
+  bufs.erase(std::unique(bufs.begin(), bufs.end()), bufs.end());
+
+  for(size_t i = 0; i < bufs.size(); i++)
+  {
+    FetchBuffer buf = {};
+    vector<byte> data;
+
+    if(m_RemoteServer)
+    {
+      buf = m_Remote->GetBuffer(bufs[i]);
+      m_Remote->GetBufferData(bufs[i], 0, 0, data);
+    }
+
+    m_FromReplaySerialiser->Serialise("", buf);
+
+    uint64_t sz = data.size();
+    m_FromReplaySerialiser->Serialise("", sz);
+
+    if(m_RemoteServer)
+    {
+      if(sz > 0)
+        m_FromReplaySerialiser->RawWriteBytes(&data[0], (size_t)sz);
+      continue;
+    }
+
+    if(sz == 0)
+      continue;
+
+    const byte *bytes = (const byte *)m_FromReplaySerialiser->RawReadBytes((size_t)sz);
+
+    if(m_ProxyBufferIds.find(bufs[i]) == m_ProxyBufferIds.end())
+      m_ProxyBufferIds[bufs[i]] = m_Proxy->CreateProxyBuffer(buf);
+
+    m_Proxy->SetProxyBufferData(m_ProxyBufferIds[bufs[i]], (byte *)bytes, (size_t)sz);
+
+    ContentHash hash = HashContent(bytes, (size_t)sz);
+    AddCachedContent(hash, bytes, (size_t)sz, false);
+    m_BufferProxyHashes[bufs[i]] = hash;
+    m_BufferProxyCache.insert(bufs[i]);
+  }
+
+  return ret;
+}
+
 ResourceId ReplayProxy::RenderOverlay(ResourceId texid, FormatComponentType typeHint,
                                       TextureDisplayOverlay overlay, uint32_t eventID,
                                       const vector<uint32_t> &passEvents)
@@ -85,6 +85,11 @@ enum ReplayProxyPacket
   eReplayProxy_GetAPIProperties,
 
   eReplayProxy_PixelHistory,
+
+  eReplayProxy_GetTextureDataHash,
+  eReplayProxy_GetBufferDataHash,
+  eReplayProxy_GetTextureDataDelta,
+  eReplayProxy_GetPostVSForEvents,
 };
 
 // This class implements IReplayDriver and StackResolver. On the local machine where the UI
@@ -102,6 +107,12 @@ public:
     m_FromReplaySerialiser = NULL;
     m_ToReplaySerialiser = new Serialiser(NULL, Serialiser::WRITING, false);
     m_RemoteHasResolver = false;
+    m_StreamData = NULL;
+    m_StreamDataSize = 0;
+    m_HashedTexture.data = NULL;
+    m_HashedTexture.size = 0;
+    m_ContentCacheSize = 0;
+    m_ContentCacheDiskSize = 0;
 
     GetAPIProperties();
   }
@@ -112,13 +123,31 @@ public:
     m_ToReplaySerialiser = NULL;
     m_FromReplaySerialiser = new Serialiser(NULL, Serialiser::WRITING, false);
     m_RemoteHasResolver = false;
+    m_StreamData = NULL;
+    m_StreamDataSize = 0;
+    m_HashedTexture.data = NULL;
+    m_HashedTexture.size = 0;
+    m_ContentCacheSize = 0;
+    m_ContentCacheDiskSize = 0;
 
     RDCEraseEl(m_APIProps);
   }
 
   virtual ~ReplayProxy();
 
+  // texture data is compressed and streamed in blocks of this size, so that compression,
+  // transmission and decompression can overlap.
+  static const size_t TextureStreamBlockSize = 1024 * 1024;
+
+  // when sending texture data as a delta against a previous version, unchanged runs shorter than
+  // this are sent anyway rather than splitting the delta into more ranges.
+  static const size_t TextureDeltaGranularity = 4096;
+
   bool IsRemoteProxy() { return !m_RemoteServer; }
+  // if set, texture and buffer contents fetched from the remote are also stored in this folder,
+  // keyed by their hash, so they don't need to be transferred again in later sessions. The folder
+  // is kept under MaxDiskContentCacheSize by deleting the least recently used files.
+  void SetContentCacheFolder(const string &folder);
   void Shutdown() { delete this; }
   void ReadLogInitialisation() {}
   vector<WindowingSystem> GetSupportedWindowSystems()
@@ -423,9 +452,22 @@ public:
   byte *GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
                        const GetTextureDataParams &params, size_t &dataSize);
 
+  bool GetTextureDataHash(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                          const GetTextureDataParams &params, ContentHash &hash);
+  bool GetBufferDataHash(ResourceId buff, ContentHash &hash);
+
+  // fetches texture data whose contents have the given hash. If baseData is the contents of
+  // the same subresource with hash baseHash, the remote can send only the bytes that changed.
+  byte *GetTextureDataDelta(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                            const GetTextureDataParams &params, const ContentHash &hash,
+                            ContentHash baseHash, const vector<byte> *baseData, size_t &dataSize);
+
   void InitPostVSBuffers(uint32_t eventID);
   void InitPostVSBuffers(const vector<uint32_t> &passEvents);
   MeshFormat GetPostVSBuffers(uint32_t eventID, uint32_t instID, MeshDataStage stage);
+  vector<MeshFormat> GetPostVSBuffersForEvents(const vector<uint32_t> &events,
+                                               const vector<uint32_t> &instIDs,
+                                               MeshDataStage stage);
 
   ResourceId RenderOverlay(ResourceId texid, FormatComponentType typeHint,
                            TextureDisplayOverlay overlay, uint32_t eventID,
@@ -483,6 +525,14 @@ public:
 
 private:
   bool SendReplayCommand(ReplayProxyPacket type);
+  byte *FetchRemoteTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
+                               const GetTextureDataParams &params, size_t &dataSize);
+  void QueueTextureStream(byte *data, size_t dataSize);
+  byte *RecvTextureStream(size_t &dataSize, float *progress);
+  bool StreamTextureData();
+
+  const vector<byte> *FindCachedContent(const ContentHash &hash);
+  void AddCachedContent(const ContentHash &hash, const byte *data, size_t size, bool writeToDisk);
 
   void EnsureTexCached(ResourceId texid, uint32_t arrayIdx, uint32_t mip);
   void RemapProxyTextureIfNeeded(ResourceFormat &format, GetTextureDataParams &params);
@@ -506,6 +556,27 @@ private:
   set<TextureCacheEntry> m_TextureProxyCache;
   set<ResourceId> m_LocalTextures;
 
+  // the hash of the contents last uploaded to each proxy texture subresource and buffer. Unlike
+  // the caches above these persist across events, since most resources don't change between
+  // events and don't need to be uploaded again.
+  map<TextureCacheEntry, ContentHash> m_TextureProxyHashes;
+  map<ResourceId, ContentHash> m_BufferProxyHashes;
+
+  // contents fetched from the remote, keyed by hash. Bounded by MaxContentCacheSize, with the
+  // oldest entries evicted first. On the remote server this holds the versions of each texture
+  // sent to the client, so later versions can be sent as deltas against them.
+  static const uint64_t MaxContentCacheSize = 512 * 1024 * 1024;
+  map<ContentHash, vector<byte> > m_ContentCache;
+  std::list<ContentHash> m_ContentCacheOrder;
+  uint64_t m_ContentCacheSize;
+  string m_ContentCacheFolder;
+
+  // files in the cache folder have their modified time updated whenever they're used, and the
+  // oldest are deleted once the folder grows past this size.
+  static const uint64_t MaxDiskContentCacheSize = 4ULL * 1024 * 1024 * 1024;
+  uint64_t m_ContentCacheDiskSize;
+  void TrimContentCacheFolder();
+
   struct ProxyTextureProperties
   {
     ResourceId id;
@@ -550,6 +621,26 @@ private:
 
   bool m_RemoteHasResolver;
 
+  // texture data waiting to be streamed after the reply to eReplayProxy_GetTextureData
+  byte *m_StreamData;
+  size_t m_StreamDataSize;
+
+  // on the remote server, the data read back to answer the last hash request. If the client
+  // doesn't already have it, the next request is for the same data so it's kept here to avoid
+  // reading it back twice.
+  struct HashedTextureData
+  {
+    ResourceId tex;
+    uint32_t arrayIdx;
+    uint32_t mip;
+    GetTextureDataParams params;
+    byte *data;
+    size_t size;
+  } m_HashedTexture;
+
+  ResourceId m_HashedBuffer;
+  vector<byte> m_HashedBufferData;
+
   APIProperties m_APIProps;
 
   D3D11PipelineState m_D3D11PipelineState;
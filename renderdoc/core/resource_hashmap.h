@@ -0,0 +1,455 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ * Copyright (c) 2014 Crytek
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include "api/replay/renderdoc_replay.h"
+#include "common/common.h"
+#include "common/threading.h"
+
+// 64-bit finaliser (from murmurhash3). Resource IDs are sequential and real handles are usually
+// aligned pointers, so neither is usable as a hash directly.
+inline uint64_t ResourceHashMix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// key types used in the resource tables need a ResourceHash overload. Drivers with their own
+// handle types declare one next to the type, so it's found when the tables are instantiated.
+inline uint64_t ResourceHash(ResourceId id)
+{
+  return ResourceHashMix(id.id);
+}
+
+template <typename T>
+inline uint64_t ResourceHash(T *ptr)
+{
+  return ResourceHashMix((uint64_t)(uintptr_t)ptr);
+}
+
+// open-addressing hash table with linear probing. Erased entries leave a tombstone, so erasing
+// doesn't move any other entry and iterators stay valid - only insertion can invalidate them.
+// Iteration order is arbitrary.
+//
+// The interface is a subset of std::map's so it can be dropped in where only lookups and unordered
+// iteration are needed. It is not thread-safe.
+template <typename K, typename V>
+class ResourceHashMap
+{
+  enum SlotState
+  {
+    eSlot_Empty = 0,
+    eSlot_Used,
+    eSlot_Deleted,
+  };
+
+public:
+  struct Entry
+  {
+    K first;
+    V second;
+  };
+
+  class iterator
+  {
+  public:
+    iterator() : m_Map(NULL), m_Idx(0) {}
+    iterator(ResourceHashMap *map, size_t idx) : m_Map(map), m_Idx(idx) { SkipUnused(); }
+    Entry &operator*() const { return m_Map->m_Entries[m_Idx]; }
+    Entry *operator->() const { return &m_Map->m_Entries[m_Idx]; }
+    iterator &operator++()
+    {
+      m_Idx++;
+      SkipUnused();
+      return *this;
+    }
+    bool operator==(const iterator &o) const { return m_Map == o.m_Map && m_Idx == o.m_Idx; }
+    bool operator!=(const iterator &o) const { return !(*this == o); }
+  private:
+    friend class ResourceHashMap;
+
+    void SkipUnused()
+    {
+      while(m_Idx < m_Map->m_State.size() && m_Map->m_State[m_Idx] != eSlot_Used)
+        m_Idx++;
+    }
+
+    ResourceHashMap *m_Map;
+    size_t m_Idx;
+  };
+
+  ResourceHashMap() : m_Count(0), m_Deleted(0) {}
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, m_State.size()); }
+  size_t size() const { return m_Count; }
+  bool empty() const { return m_Count == 0; }
+  void clear()
+  {
+    // keep the storage, tables like the frame references are refilled to a similar size
+    if(m_Count + m_Deleted > 0)
+    {
+      for(size_t i = 0; i < m_State.size(); i++)
+      {
+        if(m_State[i] == eSlot_Used)
+          m_Entries[i] = Entry();
+        m_State[i] = eSlot_Empty;
+      }
+    }
+    m_Count = m_Deleted = 0;
+  }
+
+  void reserve(size_t count)
+  {
+    size_t cap = MinCapacity;
+    while(cap * 3 < count * 4)
+      cap *= 2;
+
+    if(cap > m_State.size())
+      Rehash(cap);
+  }
+
+  iterator find(const K &key)
+  {
+    size_t idx = FindSlot(key);
+    return iterator(this, idx == NoSlot ? m_State.size() : idx);
+  }
+
+  size_t count(const K &key) const { return FindSlot(key) == NoSlot ? 0 : 1; }
+  // inserts a default-constructed value if the key isn't present, like std::map
+  V &operator[](const K &key) { return m_Entries[FindOrInsertSlot(key)].second; }
+  // returns false and leaves the existing value if the key is already present
+  bool insert(const K &key, const V &value)
+  {
+    size_t prevCount = m_Count;
+    size_t idx = FindOrInsertSlot(key);
+    if(m_Count == prevCount)
+      return false;
+
+    m_Entries[idx].second = value;
+    return true;
+  }
+
+  void erase(iterator it)
+  {
+    RDCASSERT(it.m_Map == this && it.m_Idx < m_State.size() && m_State[it.m_Idx] == eSlot_Used);
+
+    m_Entries[it.m_Idx] = Entry();
+    m_State[it.m_Idx] = eSlot_Deleted;
+    m_Count--;
+    m_Deleted++;
+  }
+
+  size_t erase(const K &key)
+  {
+    iterator it = find(key);
+    if(it == end())
+      return 0;
+
+    erase(it);
+    return 1;
+  }
+
+private:
+  enum
+  {
+    MinCapacity = 16,
+  };
+
+  static const size_t NoSlot = ~(size_t)0;
+
+  size_t FindSlot(const K &key) const
+  {
+    if(m_Count == 0)
+      return NoSlot;
+
+    const size_t mask = m_State.size() - 1;
+    size_t idx = (size_t)ResourceHash(key) & mask;
+
+    // the load factor guarantees at least one empty slot, so this always terminates
+    while(m_State[idx] != eSlot_Empty)
+    {
+      if(m_State[idx] == eSlot_Used && m_Entries[idx].first == key)
+        return idx;
+
+      idx = (idx + 1) & mask;
+    }
+
+    return NoSlot;
+  }
+
+  size_t FindOrInsertSlot(const K &key)
+  {
+    // keep used + deleted slots under 3/4 of the table
+    if((m_Count + m_Deleted + 1) * 4 > m_State.size() * 3)
+    {
+      // only grow if the table is really full, otherwise we're just clearing out tombstones
+      size_t cap = m_State.size();
+      if(cap == 0)
+        cap = MinCapacity;
+      else if((m_Count + 1) * 2 > cap)
+        cap *= 2;
+      Rehash(cap);
+    }
+
+    const size_t mask = m_State.size() - 1;
+    size_t idx = (size_t)ResourceHash(key) & mask;
+    size_t tombstone = NoSlot;
+
+    while(m_State[idx] != eSlot_Empty)
+    {
+      if(m_State[idx] == eSlot_Used)
+      {
+        if(m_Entries[idx].first == key)
+          return idx;
+      }
+      else if(tombstone == NoSlot)
+      {
+        tombstone = idx;
+      }
+
+      idx = (idx + 1) & mask;
+    }
+
+    if(tombstone != NoSlot)
+    {
+      idx = tombstone;
+      m_Deleted--;
+    }
+
+    m_State[idx] = eSlot_Used;
+    m_Entries[idx].first = key;
+    m_Entries[idx].second = V();
+    m_Count++;
+
+    return idx;
+  }
+
+  void Rehash(size_t capacity)
+  {
+    std::vector<Entry> entries(capacity);
+    std::vector<byte> state(capacity, (byte)eSlot_Empty);
+
+    const size_t mask = capacity - 1;
+
+    for(size_t i = 0; i < m_State.size(); i++)
+    {
+      if(m_State[i] != eSlot_Used)
+        continue;
+
+      size_t idx = (size_t)ResourceHash(m_Entries[i].first) & mask;
+      while(state[idx] != eSlot_Empty)
+        idx = (idx + 1) & mask;
+
+      state[idx] = eSlot_Used;
+      entries[idx] = m_Entries[i];
+    }
+
+    m_Entries.swap(entries);
+    m_State.swap(state);
+    m_Deleted = 0;
+  }
+
+  std::vector<Entry> m_Entries;
+  std::vector<byte> m_State;
+  size_t m_Count;
+  size_t m_Deleted;
+};
+
+// set of locks for a sharded table, split out so the scoped lock below doesn't need to know the
+// table's key and value types.
+class ResourceShardLocks
+{
+public:
+  static const uint32_t NumShards = 16;
+
+  Threading::CriticalSection &ShardLock(uint32_t shard) { return m_Locks[shard]; }
+  // always locks in the same order, so two threads locking all shards can't deadlock
+  void LockAll()
+  {
+    for(uint32_t i = 0; i < NumShards; i++)
+      m_Locks[i].Lock();
+  }
+
+  void UnlockAll()
+  {
+    for(uint32_t i = NumShards; i > 0; i--)
+      m_Locks[i - 1].Unlock();
+  }
+
+protected:
+  Threading::CriticalSection m_Locks[NumShards];
+};
+
+class ScopedShardsLock
+{
+public:
+  ScopedShardsLock(ResourceShardLocks &locks) : m_Locks(&locks) { m_Locks->LockAll(); }
+  ~ScopedShardsLock() { m_Locks->UnlockAll(); }
+private:
+  ResourceShardLocks *m_Locks;
+};
+
+#define SCOPED_SHARDS_LOCK(shards) ScopedShardsLock CONCAT(scopedshardslock, __LINE__)(shards);
+
+// hash table split into independently locked shards by key hash. Operations on a single key only
+// take that key's shard lock, so threads working on different resources rarely contend.
+//
+// Iterating, or anything else that touches the whole table, must hold every shard lock via
+// SCOPED_SHARDS_LOCK for the duration.
+template <typename K, typename V>
+class ShardedResourceHashMap : public ResourceShardLocks
+{
+public:
+  typedef ResourceHashMap<K, V> Shard;
+  typedef typename Shard::Entry Entry;
+
+  class iterator
+  {
+  public:
+    iterator() : m_Map(NULL), m_Shard(0) {}
+    iterator(ShardedResourceHashMap *map, uint32_t shard) : m_Map(map), m_Shard(shard)
+    {
+      if(m_Shard < NumShards)
+      {
+        m_It = m_Map->m_Shards[m_Shard].begin();
+        SkipEmptyShards();
+      }
+    }
+    Entry &operator*() const { return *m_It; }
+    Entry *operator->() const { return &*m_It; }
+    iterator &operator++()
+    {
+      ++m_It;
+      SkipEmptyShards();
+      return *this;
+    }
+    bool operator==(const iterator &o) const
+    {
+      return m_Map == o.m_Map && m_Shard == o.m_Shard && (m_Shard == NumShards || m_It == o.m_It);
+    }
+    bool operator!=(const iterator &o) const { return !(*this == o); }
+  private:
+    void SkipEmptyShards()
+    {
+      while(m_It == m_Map->m_Shards[m_Shard].end())
+      {
+        m_Shard++;
+        if(m_Shard == NumShards)
+          return;
+        m_It = m_Map->m_Shards[m_Shard].begin();
+      }
+    }
+
+    ShardedResourceHashMap *m_Map;
+    uint32_t m_Shard;
+    typename Shard::iterator m_It;
+  };
+
+  // use the top bits for the shard, the tables index with the bottom bits
+  static uint32_t ShardIndex(const K &key)
+  {
+    return uint32_t(ResourceHash(key) >> 56) % NumShards;
+  }
+
+  // for read-modify-write of an entry, ShardLock(ShardIndex(key)) must be held.
+  Shard &GetShard(uint32_t shard) { return m_Shards[shard]; }
+  bool Lookup(const K &key, V &value)
+  {
+    uint32_t s = ShardIndex(key);
+    SCOPED_LOCK(m_Locks[s]);
+
+    typename Shard::iterator it = m_Shards[s].find(key);
+    if(it == m_Shards[s].end())
+      return false;
+
+    value = it->second;
+    return true;
+  }
+
+  bool Contains(const K &key)
+  {
+    uint32_t s = ShardIndex(key);
+    SCOPED_LOCK(m_Locks[s]);
+
+    return m_Shards[s].count(key) != 0;
+  }
+
+  bool Insert(const K &key, const V &value)
+  {
+    uint32_t s = ShardIndex(key);
+    SCOPED_LOCK(m_Locks[s]);
+
+    return m_Shards[s].insert(key, value);
+  }
+
+  void Set(const K &key, const V &value)
+  {
+    uint32_t s = ShardIndex(key);
+    SCOPED_LOCK(m_Locks[s]);
+
+    m_Shards[s][key] = value;
+  }
+
+  bool Erase(const K &key)
+  {
+    uint32_t s = ShardIndex(key);
+    SCOPED_LOCK(m_Locks[s]);
+
+    return m_Shards[s].erase(key) != 0;
+  }
+
+  size_t size()
+  {
+    size_t ret = 0;
+    for(uint32_t i = 0; i < NumShards; i++)
+    {
+      SCOPED_LOCK(m_Locks[i]);
+      ret += m_Shards[i].size();
+    }
+    return ret;
+  }
+
+  bool empty() { return size() == 0; }
+  void clear()
+  {
+    for(uint32_t i = 0; i < NumShards; i++)
+    {
+      SCOPED_LOCK(m_Locks[i]);
+      m_Shards[i].clear();
+    }
+  }
+
+  // iteration requires all shards to be locked
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, NumShards); }
+private:
+  Shard m_Shards[NumShards];
+};
@@ -30,6 +30,7 @@
 #include "api/replay/renderdoc_replay.h"
 #include "common/threading.h"
 #include "core/core.h"
+#include "core/resource_hashmap.h"
 #include "os/os_specific.h"
 #include "serialise/serialiser.h"
 
@@ -243,6 +244,12 @@ struct ResourceRecord
   bool HasDataPtr() { return DataPtr != NULL; }
   void SetDataOffset(uint64_t offs) { DataOffset = offs; }
   void SetDataPtr(byte *ptr) { DataPtr = ptr; }
+  // the data is kept in, and updated directly within, the chunk's own storage
+  void SetDataPtr(Chunk *chunk)
+  {
+    chunk->MarkDataMutable();
+    DataPtr = chunk->GetData();
+  }
   void MarkResourceFrameReferenced(ResourceId id, FrameRefType refType);
   void AddResourceReferences(ResourceRecordHandler *mgr);
   void AddReferencedIDs(std::set<ResourceId> &ids)
@@ -333,6 +340,7 @@ public:
 
   void MarkInFrame(bool inFrame) { m_InFrame = inFrame; }
   void ReleaseInFrameResources();
+  bool HasInFrameResources();
 
   // insert the chunks for the resources referenced in the frame
   void InsertReferencedChunks(Serialiser *fileSer);
@@ -376,8 +384,8 @@ public:
   void Serialise_InitialContentsNeeded();
 
   // handle marking a resource referenced for read or write and storing RAW access etc.
-  static bool MarkReferenced(map<ResourceId, FrameRefType> &refs, ResourceId id,
-                             FrameRefType refType);
+  template <typename RefMap>
+  static bool MarkReferenced(RefMap &refs, ResourceId id, FrameRefType refType);
 
   // mark resource referenced somewhere in the main frame-affecting calls.
   // That means this resource should be included in the final serialise out
@@ -441,52 +449,50 @@ protected:
   Serialiser *GetSerialiser() { return m_pSerialiser; }
   bool m_InFrame;
 
-  // very coarse lock, protects EVERYTHING. This could certainly be improved and it may be a
-  // bottleneck
-  // for performance. Given that the main use cases are write-rarely read-often the lock should be
-  // optimised
-  // for that as we only want to make sure we're not modifying the objects together, by far the most
-  // common
-  // operation is looking up data.
+  // protects the unsharded tables below, and is held by anything that walks whole tables.
+  //
+  // The tables hit on every API call while capturing are sharded, and single-resource operations
+  // on them only take the lock for that resource's shard. Anything iterating a sharded table holds
+  // all of its shard locks with SCOPED_SHARDS_LOCK. To avoid deadlocks, locks are always taken in
+  // this order:
+  //   m_Lock, m_DirtyResources, m_PendingDirtyResources, m_CurrentResourceMap,
+  //   m_FrameReferencedResources, m_ResourceRecords, m_WrapperMap
   Threading::CriticalSection m_Lock;
 
-  // easy optimisation win - don't use maps everywhere. It's convenient but not optimal, and
-  // profiling will
-  // likely prove that some or all of these could be a problem
-
   // used during capture - map from real resource to its wrapper (other way can be done just with an
   // Unwrap)
-  map<RealResourceType, WrappedResourceType> m_WrapperMap;
+  ShardedResourceHashMap<RealResourceType, WrappedResourceType> m_WrapperMap;
 
   // used during capture - holds resources referenced in current frame (and how they're referenced)
-  map<ResourceId, FrameRefType> m_FrameReferencedResources;
+  ShardedResourceHashMap<ResourceId, FrameRefType> m_FrameReferencedResources;
 
-  // used during capture - holds resources marked as dirty, needing initial contents
-  set<ResourceId> m_DirtyResources;
-  set<ResourceId> m_PendingDirtyResources;
+  // used during capture - holds resources marked as dirty, needing initial contents. These are
+  // sets, the value is unused.
+  ShardedResourceHashMap<ResourceId, bool> m_DirtyResources;
+  ShardedResourceHashMap<ResourceId, bool> m_PendingDirtyResources;
 
   // used during capture or replay - holds initial contents
-  map<ResourceId, InitialContentData> m_InitialContents;
+  ResourceHashMap<ResourceId, InitialContentData> m_InitialContents;
   // on capture, if a chunk was prepared in Prepare_InitialContents and added, don't re-serialise.
   // Some initial contents may not need the delayed readback.
-  map<ResourceId, Chunk *> m_InitialChunks;
+  ResourceHashMap<ResourceId, Chunk *> m_InitialChunks;
 
   // used during capture or replay - map of resources currently alive with their real IDs, used in
   // capture and replay.
-  map<ResourceId, WrappedResourceType> m_CurrentResourceMap;
+  ShardedResourceHashMap<ResourceId, WrappedResourceType> m_CurrentResourceMap;
 
   // used during replay - maps back and forth from original id to live id and vice-versa
-  map<ResourceId, ResourceId> m_OriginalIDs, m_LiveIDs;
+  ResourceHashMap<ResourceId, ResourceId> m_OriginalIDs, m_LiveIDs;
 
   // used during replay - holds resources allocated and the original id that they represent
   // for a) in-frame creations and b) pre-frame creations respectively.
-  map<ResourceId, WrappedResourceType> m_InframeResourceMap, m_LiveResourceMap;
+  ResourceHashMap<ResourceId, WrappedResourceType> m_InframeResourceMap, m_LiveResourceMap;
 
   // used during capture - holds resource records by id.
-  map<ResourceId, RecordType *> m_ResourceRecords;
+  ShardedResourceHashMap<ResourceId, RecordType *> m_ResourceRecords;
 
   // used during replay - holds current resource replacements
-  map<ResourceId, ResourceId> m_Replacements;
+  ResourceHashMap<ResourceId, ResourceId> m_Replacements;
 };
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -545,10 +551,13 @@ ResourceManager<WrappedResourceType, RealResourceType, RecordType>::~ResourceMan
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+template <typename RefMap>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkReferenced(
-    map<ResourceId, FrameRefType> &refs, ResourceId id, FrameRefType refType)
+    RefMap &refs, ResourceId id, FrameRefType refType)
 {
-  if(refs.find(id) == refs.end())
+  auto it = refs.find(id);
+
+  if(it == refs.end())
   {
     if(refType == eFrameRef_Read)
       refs[id] = eFrameRef_ReadOnly;
@@ -561,6 +570,8 @@ bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkRef
   }
   else
   {
+    FrameRefType &ref = it->second;
+
     if(refType == eFrameRef_Unknown)
     {
       // nothing
@@ -569,18 +580,18 @@ bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkRef
     {
       // special case, explicitly set to ReadBeforeWrite for when
       // we know that this use will likely be a partial-write
-      refs[id] = eFrameRef_ReadBeforeWrite;
+      ref = eFrameRef_ReadBeforeWrite;
     }
-    else if(refs[id] == eFrameRef_Unknown)
+    else if(ref == eFrameRef_Unknown)
     {
       if(refType == eFrameRef_Read || refType == eFrameRef_ReadOnly)
-        refs[id] = eFrameRef_ReadOnly;
+        ref = eFrameRef_ReadOnly;
       else
-        refs[id] = eFrameRef_ReadAndWrite;
+        ref = eFrameRef_ReadAndWrite;
     }
-    else if(refs[id] == eFrameRef_ReadOnly && refType == eFrameRef_Write)
+    else if(ref == eFrameRef_ReadOnly && refType == eFrameRef_Write)
     {
-      refs[id] = eFrameRef_ReadBeforeWrite;
+      ref = eFrameRef_ReadBeforeWrite;
     }
   }
 
@@ -591,12 +602,15 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkResourceFrameReferenced(
     ResourceId id, FrameRefType refType)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(id == ResourceId())
     return;
 
-  bool newRef = MarkReferenced(m_FrameReferencedResources, id, refType);
+  // the shard stays locked while the record is referenced, so that ClearReferencedResources can't
+  // see the new reference without the matching AddRef.
+  uint32_t shard = m_FrameReferencedResources.ShardIndex(id);
+  SCOPED_LOCK(m_FrameReferencedResources.ShardLock(shard));
+
+  bool newRef = MarkReferenced(m_FrameReferencedResources.GetShard(shard), id, refType);
 
   if(newRef)
   {
@@ -610,9 +624,10 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkRes
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ReadBeforeWrite(ResourceId id)
 {
-  if(m_FrameReferencedResources.find(id) != m_FrameReferencedResources.end())
-    return m_FrameReferencedResources[id] == eFrameRef_ReadBeforeWrite ||
-           m_FrameReferencedResources[id] == eFrameRef_ReadOnly;
+  FrameRefType ref = eFrameRef_Unknown;
+
+  if(m_FrameReferencedResources.Lookup(id, ref))
+    return ref == eFrameRef_ReadBeforeWrite || ref == eFrameRef_ReadOnly;
 
   return false;
 }
@@ -620,57 +635,56 @@ bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ReadBef
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkDirtyResource(ResourceId res)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(res == ResourceId())
     return;
 
-  m_DirtyResources.insert(res);
+  m_DirtyResources.Insert(res, true);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkPendingDirty(ResourceId res)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(res == ResourceId())
     return;
 
-  m_PendingDirtyResources.insert(res);
+  m_PendingDirtyResources.Insert(res, true);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::FlushPendingDirty()
 {
-  SCOPED_LOCK(m_Lock);
+  // both tables shard by the same hash, so this can be done one shard at a time
+  for(uint32_t s = 0; s < ResourceShardLocks::NumShards; s++)
+  {
+    SCOPED_LOCK(m_DirtyResources.ShardLock(s));
+    SCOPED_LOCK(m_PendingDirtyResources.ShardLock(s));
+
+    ResourceHashMap<ResourceId, bool> &dirty = m_DirtyResources.GetShard(s);
+    ResourceHashMap<ResourceId, bool> &pending = m_PendingDirtyResources.GetShard(s);
+
+    for(auto it = pending.begin(); it != pending.end(); ++it)
+      dirty.insert(it->first, true);
 
-  m_DirtyResources.insert(m_PendingDirtyResources.begin(), m_PendingDirtyResources.end());
-  m_PendingDirtyResources.clear();
+    pending.clear();
+  }
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::IsResourceDirty(ResourceId res)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(res == ResourceId())
     return false;
 
-  return m_DirtyResources.find(res) != m_DirtyResources.end();
+  return m_DirtyResources.Contains(res);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkCleanResource(ResourceId res)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(res == ResourceId())
     return;
 
-  if(IsResourceDirty(res))
-  {
-    m_DirtyResources.erase(res);
-  }
+  m_DirtyResources.Erase(res);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -724,8 +738,10 @@ typename ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Ini
   if(id == ResourceId())
     return InitialContentData();
 
-  if(m_InitialContents.find(id) != m_InitialContents.end())
-    return m_InitialContents[id];
+  auto it = m_InitialContents.find(id);
+
+  if(it != m_InitialContents.end())
+    return it->second;
 
   return InitialContentData();
 }
@@ -734,6 +750,8 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Serialise_InitialContentsNeeded()
 {
   SCOPED_LOCK(m_Lock);
+  SCOPED_SHARDS_LOCK(m_DirtyResources);
+  SCOPED_SHARDS_LOCK(m_FrameReferencedResources);
 
   struct WrittenRecord
   {
@@ -759,9 +777,9 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Seriali
 
   for(auto it = m_DirtyResources.begin(); it != m_DirtyResources.end(); ++it)
   {
-    ResourceId id = *it;
-    auto ref = m_FrameReferencedResources.find(id);
-    if(ref == m_FrameReferencedResources.end() || ref->second == eFrameRef_ReadOnly)
+    ResourceId id = it->first;
+    FrameRefType ref = eFrameRef_Unknown;
+    if(!m_FrameReferencedResources.Lookup(id, ref) || ref == eFrameRef_ReadOnly)
     {
       WrittenRecord wr = {id, true};
 
@@ -857,6 +875,7 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkUnwrittenResources()
 {
   SCOPED_LOCK(m_Lock);
+  SCOPED_SHARDS_LOCK(m_ResourceRecords);
 
   for(auto it = m_ResourceRecords.begin(); it != m_ResourceRecords.end(); ++it)
   {
@@ -876,6 +895,8 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertR
 
   if(RenderDoc::Inst().GetCaptureOptions().RefAllResources)
   {
+    SCOPED_SHARDS_LOCK(m_ResourceRecords);
+
     for(auto it = m_ResourceRecords.begin(); it != m_ResourceRecords.end(); ++it)
     {
       if(!SerialisableResource(it->first, it->second))
@@ -886,6 +907,8 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertR
   }
   else
   {
+    SCOPED_SHARDS_LOCK(m_FrameReferencedResources);
+
     for(auto it = m_FrameReferencedResources.begin(); it != m_FrameReferencedResources.end(); ++it)
     {
       RecordType *record = GetResourceRecord(it->first);
@@ -908,13 +931,15 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::PrepareInitialContents()
 {
   SCOPED_LOCK(m_Lock);
+  SCOPED_SHARDS_LOCK(m_DirtyResources);
+  SCOPED_SHARDS_LOCK(m_CurrentResourceMap);
 
   RDCDEBUG("Preparing up to %u potentially dirty resources", (uint32_t)m_DirtyResources.size());
   uint32_t prepared = 0;
 
   for(auto it = m_DirtyResources.begin(); it != m_DirtyResources.end(); ++it)
   {
-    ResourceId id = *it;
+    ResourceId id = it->first;
 
     if(!HasCurrentResource(id))
       continue;
@@ -958,6 +983,8 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertI
     Serialiser *fileSerialiser)
 {
   SCOPED_LOCK(m_Lock);
+  SCOPED_SHARDS_LOCK(m_DirtyResources);
+  SCOPED_SHARDS_LOCK(m_CurrentResourceMap);
 
   uint32_t dirty = 0;
   uint32_t skipped = 0;
@@ -966,9 +993,9 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::InsertI
 
   for(auto it = m_DirtyResources.begin(); it != m_DirtyResources.end(); ++it)
   {
-    ResourceId id = *it;
+    ResourceId id = it->first;
 
-    if(m_FrameReferencedResources.find(id) == m_FrameReferencedResources.end() &&
+    if(!m_FrameReferencedResources.Contains(id) &&
        !RenderDoc::Inst().GetCaptureOptions().RefAllResources)
     {
 #if ENABLED(VERBOSE_DIRTY_RESOURCES)
@@ -1096,20 +1123,42 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Release
   m_InframeResourceMap.clear();
 }
 
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::HasInFrameResources()
+{
+  SCOPED_LOCK(m_Lock);
+
+  return !m_InframeResourceMap.empty();
+}
+
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ClearReferencedResources()
 {
   SCOPED_LOCK(m_Lock);
 
-  for(auto it = m_FrameReferencedResources.begin(); it != m_FrameReferencedResources.end(); ++it)
+  vector<RecordType *> records;
+
   {
-    RecordType *record = GetResourceRecord(it->first);
+    SCOPED_SHARDS_LOCK(m_FrameReferencedResources);
 
-    if(record)
-      record->Delete(this);
+    records.reserve(m_FrameReferencedResources.size());
+
+    for(auto it = m_FrameReferencedResources.begin(); it != m_FrameReferencedResources.end(); ++it)
+    {
+      RecordType *record = GetResourceRecord(it->first);
+
+      if(record)
+        records.push_back(record);
+    }
+
+    m_FrameReferencedResources.clear();
   }
 
-  m_FrameReferencedResources.clear();
+  // the references we're dropping keep these records alive until now. Deleting them takes the
+  // dirty and record shard locks, the first of which is ordered before the frame reference shards,
+  // so they must be released first.
+  for(size_t i = 0; i < records.size(); i++)
+    records[i]->Delete(this);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -1147,49 +1196,39 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 RecordType *ResourceManager<WrappedResourceType, RealResourceType, RecordType>::GetResourceRecord(
     ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
-
-  auto it = m_ResourceRecords.find(id);
+  RecordType *ret = NULL;
 
-  if(it == m_ResourceRecords.end())
-    return NULL;
+  m_ResourceRecords.Lookup(id, ret);
 
-  return it->second;
+  return ret;
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::HasResourceRecord(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
-
-  auto it = m_ResourceRecords.find(id);
-
-  if(it == m_ResourceRecords.end())
-    return false;
-
-  return true;
+  return m_ResourceRecords.Contains(id);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 RecordType *ResourceManager<WrappedResourceType, RealResourceType, RecordType>::AddResourceRecord(
     ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  RDCASSERT(!m_ResourceRecords.Contains(id), id);
+
+  RecordType *ret = new RecordType(id);
 
-  RDCASSERT(m_ResourceRecords.find(id) == m_ResourceRecords.end(), id);
+  m_ResourceRecords.Set(id, ret);
 
-  return (m_ResourceRecords[id] = new RecordType(id));
+  return ret;
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::RemoveResourceRecord(
     ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
-
-  RDCASSERT(m_ResourceRecords.find(id) != m_ResourceRecords.end(), id);
+  RDCASSERT(m_ResourceRecords.Contains(id), id);
 
-  m_ResourceRecords.erase(id);
+  m_ResourceRecords.Erase(id);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -1203,8 +1242,6 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::AddWrapper(
     WrappedResourceType wrap, RealResourceType real)
 {
-  SCOPED_LOCK(m_Lock);
-
   bool ret = true;
 
   if(wrap == (WrappedResourceType)RecordType::NullResource ||
@@ -1214,13 +1251,18 @@ bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::AddWrap
     ret = false;
   }
 
-  if(m_WrapperMap[real] != (WrappedResourceType)RecordType::NullResource)
+  uint32_t shard = m_WrapperMap.ShardIndex(real);
+  SCOPED_LOCK(m_WrapperMap.ShardLock(shard));
+
+  WrappedResourceType &entry = m_WrapperMap.GetShard(shard)[real];
+
+  if(entry != (WrappedResourceType)RecordType::NullResource)
   {
     RDCERR("Overriding wrapper for resource");
     ret = false;
   }
 
-  m_WrapperMap[real] = wrap;
+  entry = wrap;
 
   return ret;
 }
@@ -1229,46 +1271,39 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::RemoveWrapper(
     RealResourceType real)
 {
-  SCOPED_LOCK(m_Lock);
-
-  if(real == (RealResourceType)RecordType::NullResource || !HasWrapper(real))
+  if(real == (RealResourceType)RecordType::NullResource || !m_WrapperMap.Erase(real))
   {
     RDCERR(
         "Invalid state removing resource wrapper - real resource is NULL or doesn't have wrapper");
-    return;
   }
-
-  m_WrapperMap.erase(m_WrapperMap.find(real));
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::HasWrapper(RealResourceType real)
 {
-  SCOPED_LOCK(m_Lock);
-
   if(real == (RealResourceType)RecordType::NullResource)
     return false;
 
-  return (m_WrapperMap.find(real) != m_WrapperMap.end());
+  return m_WrapperMap.Contains(real);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 WrappedResourceType ResourceManager<WrappedResourceType, RealResourceType, RecordType>::GetWrapper(
     RealResourceType real)
 {
-  SCOPED_LOCK(m_Lock);
+  WrappedResourceType ret = (WrappedResourceType)RecordType::NullResource;
 
   if(real == (RealResourceType)RecordType::NullResource)
-    return (WrappedResourceType)RecordType::NullResource;
+    return ret;
 
-  if(real != (RealResourceType)RecordType::NullResource && !HasWrapper(real))
+  if(!m_WrapperMap.Lookup(real, ret))
   {
     RDCERR(
         "Invalid state removing resource wrapper - real resource isn't NULL and doesn't have "
         "wrapper");
   }
 
-  return m_WrapperMap[real];
+  return ret;
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -1361,41 +1396,44 @@ template <typename WrappedResourceType, typename RealResourceType, typename Reco
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::AddCurrentResource(
     ResourceId id, WrappedResourceType res)
 {
-  SCOPED_LOCK(m_Lock);
-
-  RDCASSERT(m_CurrentResourceMap.find(id) == m_CurrentResourceMap.end(), id);
-  m_CurrentResourceMap[id] = res;
+  RDCASSERT(!m_CurrentResourceMap.Contains(id), id);
+  m_CurrentResourceMap.Set(id, res);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::HasCurrentResource(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
-
-  return m_CurrentResourceMap.find(id) != m_CurrentResourceMap.end();
+  return m_CurrentResourceMap.Contains(id);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 WrappedResourceType ResourceManager<WrappedResourceType, RealResourceType,
                                     RecordType>::GetCurrentResource(ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
+  // replacements only happen on replay, so don't take the global lock for them while capturing
+  if(IsReading())
+  {
+    SCOPED_LOCK(m_Lock);
 
-  if(m_Replacements.find(id) != m_Replacements.end())
-    return GetCurrentResource(m_Replacements[id]);
+    auto it = m_Replacements.find(id);
+    if(it != m_Replacements.end())
+      return GetCurrentResource(it->second);
+  }
 
-  RDCASSERT(m_CurrentResourceMap.find(id) != m_CurrentResourceMap.end(), id);
-  return m_CurrentResourceMap[id];
+  WrappedResourceType ret = (WrappedResourceType)RecordType::NullResource;
+
+  if(!m_CurrentResourceMap.Lookup(id, ret))
+    RDCERR("Getting current resource for unknown ID %llu", id);
+
+  return ret;
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ReleaseCurrentResource(
     ResourceId id)
 {
-  SCOPED_LOCK(m_Lock);
-
-  RDCASSERT(m_CurrentResourceMap.find(id) != m_CurrentResourceMap.end(), id);
-  m_CurrentResourceMap.erase(id);
+  RDCASSERT(m_CurrentResourceMap.Contains(id), id);
+  m_CurrentResourceMap.Erase(id);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -79,7 +79,10 @@ void RenderDoc::TargetControlClientThread(void *s)
 
   const int pingtime = 1000;    // ping every 1000ms
   const int ticktime = 10;      // tick every 10ms
-  int curtime = 0;
+
+  // time since the last packet we sent. WaitForRecvData returns early when data arrives, so the
+  // ticks can't just be counted.
+  PerformanceTimer pingTimer;
 
   vector<CaptureData> captures;
   vector<pair<uint32_t, uint32_t> > children;
@@ -94,8 +97,8 @@ void RenderDoc::TargetControlClientThread(void *s)
 
     ser.Rewind();
 
-    Threading::Sleep(ticktime);
-    curtime += ticktime;
+    // wait out the tick, but handle any incoming packet immediately
+    bool recvDataWaiting = client->WaitForRecvData(ticktime);
 
     PacketType packetType = ePacket_Noop;
 
@@ -146,9 +149,9 @@ void RenderDoc::TargetControlClientThread(void *s)
       ser.Serialise("", children.back().second);
     }
 
-    if(curtime < pingtime && packetType == ePacket_Noop)
+    if(pingTimer.GetMilliseconds() < pingtime && packetType == ePacket_Noop)
     {
-      if(client->IsRecvDataWaiting())
+      if(recvDataWaiting)
       {
         PacketType type;
         Serialiser *recvser = NULL;
@@ -218,7 +221,7 @@ void RenderDoc::TargetControlClientThread(void *s)
       continue;
     }
 
-    curtime = 0;
+    pingTimer.Restart();
 
     if(!SendPacket(client, packetType, ser))
     {
@@ -250,7 +253,7 @@ void RenderDoc::TargetControlServerThread(void *s)
 
   while(!RenderDoc::Inst().m_TargetControlThreadShutdown)
   {
-    Network::Socket *client = sock->AcceptClient(false);
+    Network::Socket *client = sock->AcceptClient(50);
 
     if(client == NULL)
     {
@@ -263,8 +266,6 @@ void RenderDoc::TargetControlServerThread(void *s)
         return;
       }
 
-      Threading::Sleep(5);
-
       continue;
     }
 
@@ -492,7 +493,7 @@ public:
       return;
     }
 
-    if(!m_Socket->IsRecvDataWaiting())
+    if(!m_Socket->WaitForRecvData(2))
     {
       if(!m_Socket->Connected())
       {
@@ -501,7 +502,6 @@ public:
       }
       else
       {
-        Threading::Sleep(2);
         msg->Type = eTargetControlMsg_Noop;
       }
 
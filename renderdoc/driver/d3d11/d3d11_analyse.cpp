@@ -31,6 +31,7 @@
 #include "maths/formatpacking.h"
 #include "maths/matrix.h"
 #include "maths/vec.h"
+#include "replay/replay_driver.h"
 #include "serialise/serialiser.h"
 #include "serialise/string_utils.h"
 #include "d3d11_context.h"
@@ -914,6 +915,24 @@ struct DebugHit
   uint32_t rawdata;    // arbitrary, depending on shader
 };
 
+// record the difference between the last recorded state and the current one as a new step, and
+// update the last state to match.
+static void AddDebugStep(vector<ShaderDebugStep> &steps, ShaderDebugState &last,
+                         const ShaderDebugState &cur)
+{
+  vector<ShaderVariableChange> changes;
+  DiffShaderDebugState(last, cur, changes);
+
+  ShaderDebugStep step;
+  step.nextInstruction = cur.nextInstruction;
+  step.flags = cur.flags;
+  step.changes = changes;
+
+  ApplyShaderDebugStep(last, step);
+
+  steps.push_back(step);
+}
+
 ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t vertid, uint32_t instid,
                                                 uint32_t idx, uint32_t instOffset,
                                                 uint32_t vertOffset)
@@ -1258,11 +1277,13 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
 
   delete[] instData;
 
-  State last;
+  ShaderDebugState last = initialState;
 
-  vector<ShaderDebugState> states;
+  ret.initialState = last;
 
-  states.push_back((State)initialState);
+  vector<ShaderDebugStep> steps;
+
+  AddDebugStep(steps, last, initialState);
 
   D3D11MarkerRegion simloop("Simulation Loop");
 
@@ -1273,7 +1294,7 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
 
     initialState = initialState.GetNext(global, NULL);
 
-    states.push_back((State)initialState);
+    AddDebugStep(steps, last, initialState);
 
     if(cycleCounter == SHADER_DEBUG_WARN_THRESHOLD)
     {
@@ -1282,7 +1303,7 @@ ShaderDebugTrace D3D11DebugManager::DebugVertex(uint32_t eventID, uint32_t verti
     }
   }
 
-  ret.states = states;
+  ret.steps = steps;
 
   return ret;
 }
@@ -2101,9 +2122,13 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
 
   SAFE_DELETE_ARRAY(initialData);
 
-  vector<ShaderDebugState> states;
+  ShaderDebugState last = quad[destIdx];
+
+  traces[destIdx].initialState = last;
+
+  vector<ShaderDebugStep> steps;
 
-  states.push_back((State)quad[destIdx]);
+  AddDebugStep(steps, last, quad[destIdx]);
 
   // ping pong between so that we can have 'current' quad to update into new one
   State quad2[4];
@@ -2136,7 +2161,7 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
 
     // if our destination quad is paused don't record multiple identical states.
     if(activeMask[destIdx])
-      states.push_back((State)curquad[destIdx]);
+      AddDebugStep(steps, last, curquad[destIdx]);
 
     // we need to make sure that control flow which converges stays in lockstep so that
     // derivatives are still valid. While diverged, we don't have to keep threads in lockstep
@@ -2226,7 +2251,7 @@ ShaderDebugTrace D3D11DebugManager::DebugPixel(uint32_t eventID, uint32_t x, uin
     }
   } while(!finished);
 
-  traces[destIdx].states = states;
+  traces[destIdx].steps = steps;
 
   return traces[destIdx];
 }
@@ -2281,9 +2306,13 @@ ShaderDebugTrace D3D11DebugManager::DebugThread(uint32_t eventID, uint32_t group
     initialState.semantics.ThreadID[i] = threadid[i];
   }
 
-  vector<ShaderDebugState> states;
+  ShaderDebugState last = initialState;
+
+  ret.initialState = last;
+
+  vector<ShaderDebugStep> steps;
 
-  states.push_back((State)initialState);
+  AddDebugStep(steps, last, initialState);
 
   for(int cycleCounter = 0;; cycleCounter++)
   {
@@ -2292,7 +2321,7 @@ ShaderDebugTrace D3D11DebugManager::DebugThread(uint32_t eventID, uint32_t group
 
     initialState = initialState.GetNext(global, NULL);
 
-    states.push_back((State)initialState);
+    AddDebugStep(steps, last, initialState);
 
     if(cycleCounter == SHADER_DEBUG_WARN_THRESHOLD)
     {
@@ -2301,11 +2330,70 @@ ShaderDebugTrace D3D11DebugManager::DebugThread(uint32_t eventID, uint32_t group
     }
   }
 
-  ret.states = states;
+  ret.steps = steps;
 
   return ret;
 }
 
+void D3D11DebugManager::GetMeshPickData(const MeshDisplay &cfg, vector<FloatVector> &positions,
+                                        vector<uint32_t> &idxs)
+{
+  idxs.clear();
+  positions.clear();
+
+  if(cfg.position.idxByteWidth && cfg.position.idxbuf != ResourceId())
+  {
+    vector<byte> idxdata;
+    GetBufferData(cfg.position.idxbuf, cfg.position.idxoffs,
+                  cfg.position.numVerts * cfg.position.idxByteWidth, idxdata);
+
+    // upcast indices so we only have to deal with one type
+    idxs.resize(cfg.position.numVerts, 0);
+
+    if(cfg.position.idxByteWidth == 2)
+    {
+      uint16_t *idxs16 = idxdata.empty() ? NULL : (uint16_t *)&idxdata[0];
+
+      for(size_t i = 0; i < idxdata.size() / 2 && i < idxs.size(); i++)
+        idxs[i] = idxs16[i];
+    }
+    else if(!idxdata.empty() && !idxs.empty())
+    {
+      memcpy(&idxs[0], &idxdata[0], RDCMIN(idxdata.size(), idxs.size() * sizeof(uint32_t)));
+    }
+  }
+
+  // unpack and linearise the data
+  vector<byte> oldData;
+  GetBufferData(cfg.position.buf, cfg.position.offset, 0, oldData);
+
+  positions.resize(cfg.position.numVerts);
+
+  byte *data = oldData.empty() ? NULL : &oldData[0];
+  byte *dataEnd = data + oldData.size();
+
+  bool valid;
+
+  uint32_t idxclamp = 0;
+  if(cfg.position.baseVertex < 0)
+    idxclamp = uint32_t(-cfg.position.baseVertex);
+
+  for(uint32_t i = 0; i < cfg.position.numVerts; i++)
+  {
+    uint32_t idx = i;
+
+    // apply baseVertex but clamp to 0 (don't allow index to become negative)
+    if(idx < idxclamp)
+      idx = 0;
+    else if(cfg.position.baseVertex < 0)
+      idx -= idxclamp;
+    else if(cfg.position.baseVertex > 0)
+      idx += cfg.position.baseVertex;
+
+    positions[i] = InterpretVertex(data, idx, cfg, dataEnd, false, valid);
+  }
+}
+
 uint32_t D3D11DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x,
                                        uint32_t y)
 {
@@ -2422,6 +2510,23 @@ uint32_t D3D11DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg,
     }
   }
 
+  // triangle meshes are picked on the CPU against a BVH that's built the first time the mesh is
+  // picked, and kept until a different mesh or event is picked.
+  if(MeshPickBVH::SupportsTopology(cfg.position.topo))
+  {
+    if(!m_MeshPickBVH.Matches(eventID, cfg.position))
+    {
+      vector<uint32_t> idxs;
+      vector<FloatVector> positions;
+
+      GetMeshPickData(cfg, positions, idxs);
+
+      m_MeshPickBVH.Build(eventID, cfg.position, positions, idxs, false);
+    }
+
+    return m_MeshPickBVH.Pick(rayPos, rayDir);
+  }
+
   cbuf.RayPos = rayPos;
   cbuf.RayDir = rayDir;
 
@@ -5735,7 +5735,7 @@ void WrappedID3D11DeviceContext::UpdateSubresource(ID3D11Resource *pDstResource,
         Chunk *chunk = scope.Get();
 
         record->AddChunk(chunk);
-        record->SubResources[DstSubresource]->SetDataPtr(chunk->GetData());
+        record->SubResources[DstSubresource]->SetDataPtr(chunk);
 
         record->SubResources[DstSubresource]->DataInSerialiser = true;
       }
@@ -7993,7 +7993,7 @@ void WrappedID3D11DeviceContext::Unmap(ID3D11Resource *pResource, UINT Subresour
           Chunk *chunk = scope.Get();
 
           baserecord->AddChunk(chunk);
-          record->SetDataPtr(chunk->GetData());
+          record->SetDataPtr(chunk);
 
           record->DataInSerialiser = true;
         }
@@ -31,6 +31,7 @@
 #include "api/replay/renderdoc_replay.h"
 #include "driver/dx/official/d3d11_4.h"
 #include "driver/shaders/dxbc/dxbc_debug.h"
+#include "replay/mesh_pick.h"
 #include "d3d11_renderstate.h"
 
 using std::map;
@@ -195,6 +196,8 @@ public:
   void PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace, uint32_t mip,
                  uint32_t sample, FormatComponentType typeHint, float pixel[4]);
   uint32_t PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x, uint32_t y);
+  // must be called whenever the mesh data for an event could change, e.g. shader replacement
+  void ClearMeshPickCache() { m_MeshPickBVH.Clear(); }
 
   ResourceId RenderOverlay(ResourceId texid, FormatComponentType typeHint,
                            TextureDisplayOverlay overlay, uint32_t eventID,
@@ -385,6 +388,11 @@ private:
   FloatVector InterpretVertex(byte *data, uint32_t vert, const MeshDisplay &cfg, byte *end,
                               bool useidx, bool &valid);
 
+  void GetMeshPickData(const MeshDisplay &cfg, vector<FloatVector> &positions,
+                       vector<uint32_t> &idxs);
+
+  MeshPickBVH m_MeshPickBVH;
+
   bool InitStreamOut();
   void ShutdownStreamOut();
 
@@ -29,7 +29,6 @@
 #include "driver/d3d11/d3d11_renderstate.h"
 #include "driver/d3d11/d3d11_resources.h"
 #include "driver/dxgi/dxgi_wrapped.h"
-#include "jpeg-compressor/jpge.h"
 #include "maths/formatpacking.h"
 #include "serialise/string_utils.h"
 
@@ -2979,33 +2978,8 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
       }
     }
 
-    byte *jpgbuf = NULL;
-    int len = thwidth * thheight;
-
-    if(wnd)
-    {
-      jpgbuf = new byte[len];
-
-      jpge::params p;
-      p.m_quality = 80;
-
-      bool success = jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thwidth, thheight, 3,
-                                                                 thpixels, p);
-
-      if(!success)
-      {
-        RDCERR("Failed to compress to jpg");
-        SAFE_DELETE_ARRAY(jpgbuf);
-        thwidth = 0;
-        thheight = 0;
-      }
-    }
-
-    Serialiser *m_pFileSerialiser = RenderDoc::Inst().OpenWriteSerialiser(
-        m_FrameCounter, &m_InitParams, jpgbuf, len, thwidth, thheight);
-
-    SAFE_DELETE_ARRAY(jpgbuf);
-    SAFE_DELETE(thpixels);
+    Serialiser *m_pFileSerialiser =
+        RenderDoc::Inst().OpenWriteSerialiser(m_FrameCounter, &m_InitParams);
 
     {
       SCOPED_SERIALISE_CONTEXT(DEVICE_INIT);
@@ -3052,14 +3026,16 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
       RDCDEBUG("Done");
     }
 
-    m_pFileSerialiser->FlushToDisk();
+    // compression and disk writes happen on the capture writer thread, which takes ownership of
+    // the serialiser and its own references to any chunks it doesn't already own.
+    // The thumbnail pixels are handed over too, to be JPEG compressed there.
+    RenderDoc::Inst().QueueCaptureWrite(m_pFileSerialiser, m_FrameCounter, thpixels, thwidth,
+                                        thheight);
+    m_pFileSerialiser = NULL;
+    thpixels = NULL;
 
     UnlockForChunkFlushing();
 
-    SAFE_DELETE(m_pFileSerialiser);
-
-    RenderDoc::Inst().SuccessfullyWrittenLog(m_FrameCounter);
-
     m_State = WRITING_IDLE;
 
     m_pImmediateContext->CleanupCapture();
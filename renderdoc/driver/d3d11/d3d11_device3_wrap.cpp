@@ -121,7 +121,7 @@ HRESULT WrappedID3D11Device::CreateTexture2D1(const D3D11_TEXTURE2D_DESC1 *pDesc
       RDCASSERT(record);
 
       record->AddChunk(chunk);
-      record->SetDataPtr(chunk->GetData());
+      record->SetDataPtr(chunk);
     }
     else
     {
@@ -228,7 +228,7 @@ HRESULT WrappedID3D11Device::CreateTexture3D1(const D3D11_TEXTURE3D_DESC1 *pDesc
       RDCASSERT(record);
 
       record->AddChunk(chunk);
-      record->SetDataPtr(chunk->GetData());
+      record->SetDataPtr(chunk);
     }
     else
     {
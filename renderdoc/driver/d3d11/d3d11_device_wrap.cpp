@@ -179,7 +179,7 @@ HRESULT WrappedID3D11Device::CreateBuffer(const D3D11_BUFFER_DESC *pDesc,
           GetResourceManager()->GetResourceRecord(GetIDForResource(wrapped));
       RDCASSERT(record);
       record->AddChunk(chunk);
-      record->SetDataPtr(chunk->GetData());
+      record->SetDataPtr(chunk);
     }
     else
     {
@@ -387,7 +387,7 @@ HRESULT WrappedID3D11Device::CreateTexture1D(const D3D11_TEXTURE1D_DESC *pDesc,
       RDCASSERT(record);
 
       record->AddChunk(chunk);
-      record->SetDataPtr(chunk->GetData());
+      record->SetDataPtr(chunk);
     }
     else
     {
@@ -484,7 +484,7 @@ HRESULT WrappedID3D11Device::CreateTexture2D(const D3D11_TEXTURE2D_DESC *pDesc,
       RDCASSERT(record);
 
       record->AddChunk(chunk);
-      record->SetDataPtr(chunk->GetData());
+      record->SetDataPtr(chunk);
     }
     else
     {
@@ -581,7 +581,7 @@ HRESULT WrappedID3D11Device::CreateTexture3D(const D3D11_TEXTURE3D_DESC *pDesc,
       RDCASSERT(record);
 
       record->AddChunk(chunk);
-      record->SetDataPtr(chunk->GetData());
+      record->SetDataPtr(chunk);
     }
     else
     {
@@ -2860,7 +2860,7 @@ HRESULT WrappedID3D11Device::OpenSharedResource(HANDLE hResource, REFIID Returne
       RDCASSERT(record);
 
       record->AddChunk(chunk);
-      record->SetDataPtr(chunk->GetData());
+      record->SetDataPtr(chunk);
     }
 
     return S_OK;
@@ -131,6 +131,13 @@ struct D3D11ResourceRecord : public ResourceRecord
       SubResources[i]->SetDataPtr(ptr);
   }
 
+  // the data is kept in, and updated directly within, the chunk's own storage
+  void SetDataPtr(Chunk *chunk)
+  {
+    chunk->MarkDataMutable();
+    SetDataPtr(chunk->GetData());
+  }
+
   void Insert(map<int32_t, Chunk *> &recordlist)
   {
     bool dataWritten = DataWritten;
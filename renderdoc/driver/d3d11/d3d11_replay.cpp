@@ -1449,11 +1449,13 @@ byte *D3D11Replay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mi
 void D3D11Replay::ReplaceResource(ResourceId from, ResourceId to)
 {
   m_pDevice->GetResourceManager()->ReplaceResource(from, to);
+  m_pDevice->GetDebugManager()->ClearMeshPickCache();
 }
 
 void D3D11Replay::RemoveReplacement(ResourceId id)
 {
   m_pDevice->GetResourceManager()->RemoveReplacement(id);
+  m_pDevice->GetDebugManager()->ClearMeshPickCache();
 }
 
 vector<uint32_t> D3D11Replay::EnumerateCounters()
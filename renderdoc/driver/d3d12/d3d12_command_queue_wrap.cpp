@@ -539,25 +539,27 @@ void STDMETHODCALLTYPE WrappedID3D12CommandQueue::ExecuteCommandLists(
           continue;
         }
 
-        size_t diffStart = 0, diffEnd = 0;
+        vector<DiffRange> ranges;
         bool found = true;
 
         byte *ref = res->GetShadow(subres);
         byte *data = res->GetMap(subres);
 
         if(ref)
-          found = FindDiffRange(data, ref, size, diffStart, diffEnd);
+        {
+          found = FindDiffRanges(data, ref, size, DiffRangeGranularity, ranges);
+        }
         else
-          diffEnd = size;
+        {
+          DiffRange all = {0, size};
+          ranges.push_back(all);
+        }
 
         if(found)
         {
-          RDCLOG("Persistent map flush forced for %llu (%llu -> %llu)", res->GetResourceID(),
-                 (uint64_t)diffStart, (uint64_t)diffEnd);
-
-          D3D12_RANGE range = {diffStart, diffEnd};
-
-          m_pDevice->MapDataWrite(res, subres, data, range);
+          RDCLOG("Persistent map flush forced for %llu (%llu -> %llu in %u ranges)",
+                 res->GetResourceID(), (uint64_t)ranges.front().start,
+                 (uint64_t)ranges.back().end, (uint32_t)ranges.size());
 
           if(ref == NULL)
           {
@@ -566,8 +568,15 @@ void STDMETHODCALLTYPE WrappedID3D12CommandQueue::ExecuteCommandLists(
             ref = res->GetShadow(subres);
           }
 
-          // update comparison shadow for next time
-          memcpy(ref, res->GetMap(subres), size);
+          for(size_t r = 0; r < ranges.size(); r++)
+          {
+            D3D12_RANGE range = {ranges[r].start, ranges[r].end};
+
+            m_pDevice->MapDataWrite(res, subres, data, range);
+
+            // update comparison shadow for next time
+            memcpy(ref + range.Begin, data + range.Begin, range.End - range.Begin);
+          }
 
           GetResourceManager()->MarkPendingDirty(res->GetResourceID());
         }
@@ -2384,6 +2384,65 @@ void D3D12DebugManager::PickPixel(ResourceId texture, uint32_t x, uint32_t y, ui
     m_ReadbackBuffer->Unmap(0, &range);
 }
 
+void D3D12DebugManager::GetMeshPickData(const MeshDisplay &cfg, vector<FloatVector> &positions,
+                                        vector<uint32_t> &idxs)
+{
+  idxs.clear();
+  positions.clear();
+
+  if(cfg.position.idxByteWidth && cfg.position.idxbuf != ResourceId())
+  {
+    vector<byte> idxdata;
+    GetBufferData(cfg.position.idxbuf, cfg.position.idxoffs,
+                  cfg.position.numVerts * cfg.position.idxByteWidth, idxdata);
+
+    // upcast indices so we only have to deal with one type
+    idxs.resize(cfg.position.numVerts, 0);
+
+    if(cfg.position.idxByteWidth == 2)
+    {
+      uint16_t *idxs16 = idxdata.empty() ? NULL : (uint16_t *)&idxdata[0];
+
+      for(size_t i = 0; i < idxdata.size() / 2 && i < idxs.size(); i++)
+        idxs[i] = idxs16[i];
+    }
+    else if(!idxdata.empty() && !idxs.empty())
+    {
+      memcpy(&idxs[0], &idxdata[0], RDCMIN(idxdata.size(), idxs.size() * sizeof(uint32_t)));
+    }
+  }
+
+  // unpack and linearise the data
+  vector<byte> oldData;
+  GetBufferData(cfg.position.buf, cfg.position.offset, 0, oldData);
+
+  positions.resize(cfg.position.numVerts);
+
+  byte *data = oldData.empty() ? NULL : &oldData[0];
+  byte *dataEnd = data + oldData.size();
+
+  bool valid = true;
+
+  uint32_t idxclamp = 0;
+  if(cfg.position.baseVertex < 0)
+    idxclamp = uint32_t(-cfg.position.baseVertex);
+
+  for(uint32_t i = 0; i < cfg.position.numVerts; i++)
+  {
+    uint32_t idx = i;
+
+    // apply baseVertex but clamp to 0 (don't allow index to become negative)
+    if(idx < idxclamp)
+      idx = 0;
+    else if(cfg.position.baseVertex < 0)
+      idx -= idxclamp;
+    else if(cfg.position.baseVertex > 0)
+      idx += cfg.position.baseVertex;
+
+    positions[i] = InterpretVertex(data, idx, cfg, dataEnd, false, valid);
+  }
+}
+
 uint32_t D3D12DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x,
                                        uint32_t y)
 {
@@ -2498,6 +2557,23 @@ uint32_t D3D12DebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg,
     }
   }
 
+  // triangle meshes are picked on the CPU against a BVH that's built the first time the mesh is
+  // picked, and kept until a different mesh or event is picked.
+  if(MeshPickBVH::SupportsTopology(cfg.position.topo))
+  {
+    if(!m_MeshPickBVH.Matches(eventID, cfg.position))
+    {
+      vector<uint32_t> idxs;
+      vector<FloatVector> positions;
+
+      GetMeshPickData(cfg, positions, idxs);
+
+      m_MeshPickBVH.Build(eventID, cfg.position, positions, idxs, false);
+    }
+
+    return m_MeshPickBVH.Pick(rayPos, rayDir);
+  }
+
   cbuf.RayPos = rayPos;
   cbuf.RayDir = rayDir;
 
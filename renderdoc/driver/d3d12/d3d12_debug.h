@@ -27,6 +27,7 @@
 #include "api/replay/renderdoc_replay.h"
 #include "core/core.h"
 #include "driver/shaders/dxbc/dxbc_debug.h"
+#include "replay/mesh_pick.h"
 #include "replay/replay_driver.h"
 #include "d3d12_common.h"
 
@@ -92,6 +93,8 @@ public:
   void PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace, uint32_t mip,
                  uint32_t sample, FormatComponentType typeHint, float pixel[4]);
   uint32_t PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x, uint32_t y);
+  // must be called whenever the mesh data for an event could change, e.g. shader replacement
+  void ClearMeshPickCache() { m_MeshPickBVH.Clear(); }
 
   void FillCBufferVariables(const vector<DXBC::CBufferVariable> &invars,
                             vector<ShaderVariable> &outvars, bool flattenVec4s,
@@ -427,6 +430,11 @@ private:
   FloatVector InterpretVertex(byte *data, uint32_t vert, const MeshDisplay &cfg, byte *end,
                               bool useidx, bool &valid);
 
+  void GetMeshPickData(const MeshDisplay &cfg, vector<FloatVector> &positions,
+                       vector<uint32_t> &idxs);
+
+  MeshPickBVH m_MeshPickBVH;
+
   int m_width, m_height;
 
   uint64_t m_OutputWindowID;
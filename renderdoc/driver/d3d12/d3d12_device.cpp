@@ -26,7 +26,6 @@
 #include "core/core.h"
 #include "driver/dxgi/dxgi_common.h"
 #include "driver/dxgi/dxgi_wrapped.h"
-#include "jpeg-compressor/jpge.h"
 #include "maths/formatpacking.h"
 #include "serialise/string_utils.h"
 #include "d3d12_command_list.h"
@@ -1384,6 +1383,10 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
   Serialiser *m_pFileSerialiser = NULL;
   std::vector<WrappedID3D12CommandQueue *> queues;
 
+  byte *thpixels = NULL;
+  uint32_t thwidth = 0;
+  uint32_t thheight = 0;
+
   // transition back to IDLE and readback initial states atomically
   {
     SCOPED_LOCK(m_CapTransitionLock);
@@ -1399,10 +1402,6 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
         it->res->FreeShadow();
     }
 
-    byte *thpixels = NULL;
-    uint32_t thwidth = 0;
-    uint32_t thheight = 0;
-
     const uint32_t maxSize = 2048;
 
     // gather backbuffer screenshot
@@ -1582,30 +1581,7 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
       }
     }
 
-    byte *jpgbuf = NULL;
-    int len = thwidth * thheight;
-
-    if(wnd && thpixels)
-    {
-      jpgbuf = new byte[len];
-
-      jpge::params p;
-      p.m_quality = 80;
-
-      bool success = jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thwidth, thheight, 3,
-                                                                 thpixels, p);
-
-      if(!success)
-      {
-        RDCERR("Failed to compress to jpg");
-        SAFE_DELETE_ARRAY(jpgbuf);
-        thwidth = 0;
-        thheight = 0;
-      }
-    }
-
-    m_pFileSerialiser = RenderDoc::Inst().OpenWriteSerialiser(m_FrameCounter, &m_InitParams, jpgbuf,
-                                                              len, thwidth, thheight);
+    m_pFileSerialiser = RenderDoc::Inst().OpenWriteSerialiser(m_FrameCounter, &m_InitParams);
 
     queues = m_Queues;
 
@@ -1684,11 +1660,14 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
     RDCDEBUG("Done");
   }
 
-  m_pFileSerialiser->FlushToDisk();
-
-  RenderDoc::Inst().SuccessfullyWrittenLog(m_FrameCounter);
+  // compression and disk writes happen on the capture writer thread, which takes ownership of
+  // the serialiser and its own references to any chunks it doesn't already own.
+  // The thumbnail pixels are handed over too, to be JPEG compressed there.
+  RenderDoc::Inst().QueueCaptureWrite(m_pFileSerialiser, m_FrameCounter, thpixels, thwidth,
+                                      thheight);
+  m_pFileSerialiser = NULL;
+  thpixels = NULL;
 
-  SAFE_DELETE(m_pFileSerialiser);
   SAFE_DELETE(m_HeaderChunk);
 
   m_State = WRITING_IDLE;
@@ -2011,7 +1990,11 @@ Serialiser *WrappedID3D12Device::GetThreadSerialiser()
 {
   Serialiser *ser = (Serialiser *)Threading::GetTLSValue(threadSerialiserTLSSlot);
   if(ser)
+  {
+    // only chunks recorded during a frame capture are short-lived enough to come from the arena
+    ser->SetChunkArenaActive(m_State == WRITING_CAPFRAME);
     return ser;
+  }
 
 // slow path, but rare
 
@@ -2028,6 +2011,11 @@ Serialiser *WrappedID3D12Device::GetThreadSerialiser()
 
   ser->SetChunkNameLookup(&GetChunkName);
 
+  // thread serialisers are only used from their own thread, and create the bulk of the chunks
+  // during capture, so allocate those out of an arena
+  ser->EnableChunkArena();
+  ser->SetChunkArenaActive(m_State == WRITING_CAPFRAME);
+
   Threading::SetTLSValue(threadSerialiserTLSSlot, (void *)ser);
 
   {
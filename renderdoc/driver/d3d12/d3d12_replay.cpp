@@ -1428,7 +1428,7 @@ struct D3D12InitPostVSCallback : public D3D12DrawcallCallback
   ~D3D12InitPostVSCallback() { m_pDevice->GetQueue()->GetCommandData()->m_DrawcallCallback = NULL; }
   void PreDraw(uint32_t eid, ID3D12GraphicsCommandList *cmd)
   {
-    if(std::find(m_Events.begin(), m_Events.end(), eid) != m_Events.end())
+    if(std::binary_search(m_Events.begin(), m_Events.end(), eid))
       m_pDevice->GetDebugManager()->InitPostVSBuffers(eid);
   }
 
@@ -1438,30 +1438,29 @@ struct D3D12InitPostVSCallback : public D3D12DrawcallCallback
   void PreDispatch(uint32_t eid, ID3D12GraphicsCommandList *cmd) {}
   bool PostDispatch(uint32_t eid, ID3D12GraphicsCommandList *cmd) { return false; }
   void PostRedispatch(uint32_t eid, ID3D12GraphicsCommandList *cmd) {}
-  bool RecordAllCmds() { return false; }
+  bool RecordAllCmds() { return true; }
   void AliasEvent(uint32_t primary, uint32_t alias)
   {
-    if(std::find(m_Events.begin(), m_Events.end(), primary) != m_Events.end())
+    if(std::binary_search(m_Events.begin(), m_Events.end(), primary))
       m_pDevice->GetDebugManager()->AliasPostVSBuffers(primary, alias);
   }
 
   WrappedID3D12Device *m_pDevice;
+  // sorted, so draws can be looked up quickly even when fetching a whole frame's worth
   const vector<uint32_t> &m_Events;
 };
 
 void D3D12Replay::InitPostVSBuffers(const vector<uint32_t> &events)
 {
-  // first we must replay up to the first event without replaying it. This ensures any
-  // non-command buffer calls like memory unmaps etc all happen correctly before this
-  // command buffer
-  m_pDevice->ReplayLog(0, events.front(), eReplay_WithoutDraw);
+  if(events.empty())
+    return;
 
+  // the events can come from any number of command lists and executes, so rather than replaying
+  // up to each one in turn we re-record every command list and fetch the data for all of them in
+  // a single replay of the frame.
   D3D12InitPostVSCallback cb(m_pDevice, events);
 
-  // now we replay the events, which are guaranteed (because we generated them in
-  // GetPassEvents above) to come from the same command buffer, so the event IDs are
-  // still locally continuous, even if we jump into replaying.
-  m_pDevice->ReplayLog(events.front(), events.back(), eReplay_Full);
+  m_pDevice->ReplayLog(0, events.back(), eReplay_Full);
 }
 
 MeshFormat D3D12Replay::GetPostVSBuffers(uint32_t eventID, uint32_t instID, MeshDataStage stage)
@@ -1618,6 +1617,9 @@ void D3D12Replay::RemoveReplacement(ResourceId id)
 {
   D3D12ResourceManager *rm = m_pDevice->GetResourceManager();
 
+  // ReplaceResource calls this first, so this covers new replacements as well
+  m_pDevice->GetDebugManager()->ClearMeshPickCache();
+
   rm->RemoveReplacement(id);
 
   if(rm->HasLiveResource(id))
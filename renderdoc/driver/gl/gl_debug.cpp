@@ -1148,16 +1148,91 @@ bool GLReplay::GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t mip,
   return true;
 }
 
-uint32_t GLReplay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x, uint32_t y)
+void GLReplay::GetMeshPickData(const MeshDisplay &cfg, vector<FloatVector> &positions,
+                               vector<uint32_t> &idxs)
 {
   WrappedOpenGL &gl = *m_pDriver;
 
-  if(!HasExt[ARB_compute_shader])
-    return ~0U;
+  idxs.clear();
+  positions.clear();
 
-  MakeCurrentReplayContext(m_DebugCtx);
+  GLuint ib = 0;
 
-  gl.glUseProgram(DebugData.meshPickProgram);
+  if(cfg.position.idxByteWidth && cfg.position.idxbuf != ResourceId())
+    ib = m_pDriver->GetResourceManager()->GetCurrentResource(cfg.position.idxbuf).name;
+
+  if(ib)
+  {
+    vector<byte> idxdata(cfg.position.numVerts * cfg.position.idxByteWidth, 0);
+
+    gl.glBindBuffer(eGL_COPY_READ_BUFFER, ib);
+
+    GLint bufsize = 0;
+    gl.glGetBufferParameteriv(eGL_COPY_READ_BUFFER, eGL_BUFFER_SIZE, &bufsize);
+
+    if(!idxdata.empty())
+      gl.glGetBufferSubData(eGL_COPY_READ_BUFFER, (GLintptr)cfg.position.idxoffs,
+                            RDCMIN(uint32_t(bufsize) - uint32_t(cfg.position.idxoffs),
+                                   cfg.position.numVerts * cfg.position.idxByteWidth),
+                            &idxdata[0]);
+
+    // upcast indices so we only have to deal with one type
+    idxs.resize(cfg.position.numVerts);
+
+    if(cfg.position.idxByteWidth == 1)
+    {
+      for(uint32_t i = 0; i < cfg.position.numVerts; i++)
+        idxs[i] = idxdata[i];
+    }
+    else if(cfg.position.idxByteWidth == 2)
+    {
+      uint16_t *idxs16 = (uint16_t *)&idxdata[0];
+
+      for(uint32_t i = 0; i < cfg.position.numVerts; i++)
+        idxs[i] = idxs16[i];
+    }
+    else if(!idxs.empty())
+    {
+      memcpy(&idxs[0], &idxdata[0], cfg.position.numVerts * sizeof(uint32_t));
+    }
+  }
+
+  // unpack and linearise the data
+  vector<byte> oldData;
+  GetBufferData(cfg.position.buf, cfg.position.offset, 0, oldData);
+
+  positions.resize(cfg.position.numVerts);
+
+  byte *data = oldData.empty() ? NULL : &oldData[0];
+  byte *dataEnd = data + oldData.size();
+
+  bool valid;
+
+  uint32_t idxclamp = 0;
+  if(cfg.position.baseVertex < 0)
+    idxclamp = uint32_t(-cfg.position.baseVertex);
+
+  for(uint32_t i = 0; i < cfg.position.numVerts; i++)
+  {
+    uint32_t idx = i;
+
+    // apply baseVertex but clamp to 0 (don't allow index to become negative)
+    if(idx < idxclamp)
+      idx = 0;
+    else if(cfg.position.baseVertex < 0)
+      idx -= idxclamp;
+    else if(cfg.position.baseVertex > 0)
+      idx += cfg.position.baseVertex;
+
+    positions[i] = InterpretVertex(data, idx, cfg, dataEnd, false, valid);
+  }
+}
+
+uint32_t GLReplay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x, uint32_t y)
+{
+  WrappedOpenGL &gl = *m_pDriver;
+
+  MakeCurrentReplayContext(m_DebugCtx);
 
   Matrix4f projMat =
       Matrix4f::Perspective(90.0f, 0.1f, 100000.0f, DebugData.outWidth / DebugData.outHeight);
@@ -1243,6 +1318,28 @@ uint32_t GLReplay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t
     }
   }
 
+  // triangle meshes are picked on the CPU against a BVH that's built the first time the mesh is
+  // picked, and kept until a different mesh or event is picked.
+  if(MeshPickBVH::SupportsTopology(cfg.position.topo))
+  {
+    if(!m_MeshPickBVH.Matches(eventID, cfg.position))
+    {
+      vector<uint32_t> idxs;
+      vector<FloatVector> positions;
+
+      GetMeshPickData(cfg, positions, idxs);
+
+      m_MeshPickBVH.Build(eventID, cfg.position, positions, idxs, false);
+    }
+
+    return m_MeshPickBVH.Pick(rayPos, rayDir);
+  }
+
+  if(!HasExt[ARB_compute_shader])
+    return ~0U;
+
+  gl.glUseProgram(DebugData.meshPickProgram);
+
   gl.glBindBufferBase(eGL_UNIFORM_BUFFER, 0, DebugData.UBOs[0]);
   MeshPickUBOData *cdata =
       (MeshPickUBOData *)gl.glMapBufferRange(eGL_UNIFORM_BUFFER, 0, sizeof(MeshPickUBOData),
@@ -1295,15 +1392,15 @@ uint32_t GLReplay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t
 
   gl.glUnmapBuffer(eGL_UNIFORM_BUFFER);
 
-  GLuint ib = 0;
+  vector<uint32_t> idxs;
+  vector<FloatVector> positions;
 
-  if(cfg.position.idxByteWidth && cfg.position.idxbuf != ResourceId())
-    ib = m_pDriver->GetResourceManager()->GetCurrentResource(cfg.position.idxbuf).name;
+  GetMeshPickData(cfg, positions, idxs);
 
   // We copy into our own buffers to promote to the target type (uint32) that the
   // shader expects. Most IBs will be 16-bit indices, most VBs will not be float4.
 
-  if(ib)
+  if(!idxs.empty())
   {
     // resize up on demand
     if(DebugData.pickIBBuf == 0 || DebugData.pickIBSize < cfg.position.numVerts * sizeof(uint32_t))
@@ -1318,51 +1415,9 @@ uint32_t GLReplay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t
       DebugData.pickIBSize = cfg.position.numVerts * sizeof(uint32_t);
     }
 
-    byte *idxs = new byte[cfg.position.numVerts * cfg.position.idxByteWidth];
-    memset(idxs, 0, cfg.position.numVerts * cfg.position.idxByteWidth);
-    uint32_t *outidxs = NULL;
-
-    if(cfg.position.idxByteWidth < 4)
-      outidxs = new uint32_t[cfg.position.numVerts];
-
-    gl.glBindBuffer(eGL_COPY_READ_BUFFER, ib);
-
-    GLint bufsize = 0;
-    gl.glGetBufferParameteriv(eGL_COPY_READ_BUFFER, eGL_BUFFER_SIZE, &bufsize);
-
-    gl.glGetBufferSubData(eGL_COPY_READ_BUFFER, (GLintptr)cfg.position.idxoffs,
-                          RDCMIN(uint32_t(bufsize) - uint32_t(cfg.position.idxoffs),
-                                 cfg.position.numVerts * cfg.position.idxByteWidth),
-                          idxs);
-
-    uint16_t *idxs16 = (uint16_t *)idxs;
-
-    if(cfg.position.idxByteWidth == 1)
-    {
-      for(uint32_t i = 0; i < cfg.position.numVerts; i++)
-        outidxs[i] = idxs[i];
-
-      gl.glBindBuffer(eGL_SHADER_STORAGE_BUFFER, DebugData.pickIBBuf);
-      gl.glBufferSubData(eGL_SHADER_STORAGE_BUFFER, 0, cfg.position.numVerts * sizeof(uint32_t),
-                         outidxs);
-    }
-    else if(cfg.position.idxByteWidth == 2)
-    {
-      for(uint32_t i = 0; i < cfg.position.numVerts; i++)
-        outidxs[i] = idxs16[i];
-
-      gl.glBindBuffer(eGL_SHADER_STORAGE_BUFFER, DebugData.pickIBBuf);
-      gl.glBufferSubData(eGL_SHADER_STORAGE_BUFFER, 0, cfg.position.numVerts * sizeof(uint32_t),
-                         outidxs);
-    }
-    else
-    {
-      gl.glBindBuffer(eGL_SHADER_STORAGE_BUFFER, DebugData.pickIBBuf);
-      gl.glBufferSubData(eGL_SHADER_STORAGE_BUFFER, 0, cfg.position.numVerts * sizeof(uint32_t),
-                         idxs);
-    }
-
-    SAFE_DELETE_ARRAY(outidxs);
+    gl.glBindBuffer(eGL_SHADER_STORAGE_BUFFER, DebugData.pickIBBuf);
+    gl.glBufferSubData(eGL_SHADER_STORAGE_BUFFER, 0, cfg.position.numVerts * sizeof(uint32_t),
+                       &idxs[0]);
   }
 
   if(DebugData.pickVBBuf == 0 || DebugData.pickVBSize < cfg.position.numVerts * sizeof(Vec4f))
@@ -1377,42 +1432,9 @@ uint32_t GLReplay::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t
     DebugData.pickVBSize = cfg.position.numVerts * sizeof(Vec4f);
   }
 
-  // unpack and linearise the data
-  {
-    FloatVector *vbData = new FloatVector[cfg.position.numVerts];
-
-    vector<byte> oldData;
-    GetBufferData(cfg.position.buf, cfg.position.offset, 0, oldData);
-
-    byte *data = &oldData[0];
-    byte *dataEnd = data + oldData.size();
-
-    bool valid;
-
-    uint32_t idxclamp = 0;
-    if(cfg.position.baseVertex < 0)
-      idxclamp = uint32_t(-cfg.position.baseVertex);
-
-    for(uint32_t i = 0; i < cfg.position.numVerts; i++)
-    {
-      uint32_t idx = i;
-
-      // apply baseVertex but clamp to 0 (don't allow index to become negative)
-      if(idx < idxclamp)
-        idx = 0;
-      else if(cfg.position.baseVertex < 0)
-        idx -= idxclamp;
-      else if(cfg.position.baseVertex > 0)
-        idx += cfg.position.baseVertex;
-
-      vbData[i] = InterpretVertex(data, idx, cfg, dataEnd, false, valid);
-    }
-
-    gl.glBindBuffer(eGL_SHADER_STORAGE_BUFFER, DebugData.pickVBBuf);
-    gl.glBufferSubData(eGL_SHADER_STORAGE_BUFFER, 0, cfg.position.numVerts * sizeof(Vec4f), vbData);
-
-    delete[] vbData;
-  }
+  gl.glBindBuffer(eGL_SHADER_STORAGE_BUFFER, DebugData.pickVBBuf);
+  gl.glBufferSubData(eGL_SHADER_STORAGE_BUFFER, 0, cfg.position.numVerts * sizeof(Vec4f),
+                     &positions[0]);
 
   uint32_t reset[4] = {};
   gl.glBindBufferBase(eGL_SHADER_STORAGE_BUFFER, 0, DebugData.pickResultBuf);
@@ -28,7 +28,6 @@
 #include "common/common.h"
 #include "data/glsl_shaders.h"
 #include "driver/shaders/spirv/spirv_common.h"
-#include "jpeg-compressor/jpge.h"
 #include "maths/matrix.h"
 #include "maths/vec.h"
 #include "replay/type_helpers.h"
@@ -751,9 +750,25 @@ WrappedOpenGL::WrappedOpenGL(const char *logfile, const GLHookSet &funcs, GLPlat
   m_ActiveConditional = false;
   m_ActiveFeedback = false;
 
+  m_CheckpointBytes = 0;
+  m_CheckpointBudget = 0;
+  m_CheckpointSize = 0;
+  m_CheckpointInterval = 0;
+  m_CheckpointsAllowed = false;
+
   if(RenderDoc::Inst().IsReplayApp())
   {
     m_State = READING;
+
+    // checkpoints are opt-in, since they can use a lot of memory holding resource contents
+    m_CheckpointBudget =
+        uint64_t(atoi(RenderDoc::Inst().GetConfigSetting("replay.checkpoint.budgetMB").c_str()));
+    m_CheckpointBudget *= 1024 * 1024;
+
+    m_CheckpointInterval =
+        (uint32_t)atoi(RenderDoc::Inst().GetConfigSetting("replay.checkpoint.interval").c_str());
+    if(m_CheckpointInterval == 0)
+      m_CheckpointInterval = 1000;
     if(logfile)
     {
       m_pSerialiser = new Serialiser(logfile, Serialiser::READING, false);
@@ -1000,6 +1015,8 @@ string ToStrHelper<false, GLChunkType>::Get(const GLChunkType &el)
 
 WrappedOpenGL::~WrappedOpenGL()
 {
+  ClearCheckpoints();
+
   if(m_FakeIdxBuf)
     m_Real.glDeleteBuffers(1, &m_FakeIdxBuf);
   if(m_FakeVAO)
@@ -2201,6 +2218,10 @@ void WrappedOpenGL::ReplaceResource(ResourceId from, ResourceId to)
 
 void WrappedOpenGL::RemoveReplacement(ResourceId id)
 {
+  // anything replayed since the checkpoints were taken could be different with or without the
+  // replacement
+  ClearCheckpoints();
+
   // do actual removal
   GetResourceManager()->RemoveReplacement(id);
 
@@ -2537,9 +2558,14 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
     if(bbim == NULL)
       bbim = SaveBackbufferImage();
 
-    Serialiser *m_pFileSerialiser = RenderDoc::Inst().OpenWriteSerialiser(
-        m_FrameCounter, &m_InitParams, bbim->jpgbuf, bbim->len, bbim->thwidth, bbim->thheight);
+    Serialiser *m_pFileSerialiser =
+        RenderDoc::Inst().OpenWriteSerialiser(m_FrameCounter, &m_InitParams);
 
+    byte *thpixels = bbim->thpixels;
+    uint32_t thwidth = bbim->thwidth;
+    uint32_t thheight = bbim->thheight;
+
+    bbim->thpixels = NULL;
     SAFE_DELETE(bbim);
 
     for(auto it = m_BackbufferImages.begin(); it != m_BackbufferImages.end(); ++it)
@@ -2589,11 +2615,13 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
       RDCDEBUG("Done");
     }
 
-    m_pFileSerialiser->FlushToDisk();
-
-    RenderDoc::Inst().SuccessfullyWrittenLog(m_FrameCounter);
-
-    SAFE_DELETE(m_pFileSerialiser);
+    // compression and disk writes happen on the capture writer thread, which takes ownership of
+    // the serialiser and its own references to any chunks it doesn't already own.
+    // The thumbnail pixels are handed over too, to be JPEG compressed there.
+    RenderDoc::Inst().QueueCaptureWrite(m_pFileSerialiser, m_FrameCounter, thpixels, thwidth,
+                                        thheight);
+    m_pFileSerialiser = NULL;
+    thpixels = NULL;
 
     m_State = WRITING_IDLE;
 
@@ -2719,57 +2747,107 @@ WrappedOpenGL::BackbufferImage *WrappedOpenGL::SaveBackbufferImage()
     m_Real.glPixelStorei(eGL_PACK_SKIP_PIXELS, 0);
     m_Real.glPixelStorei(eGL_PACK_ALIGNMENT, 1);
 
-    thwidth = m_InitParams.width;
-    thheight = m_InitParams.height;
+    uint32_t width = m_InitParams.width;
+    uint32_t height = m_InitParams.height;
 
-    thpixels = new byte[thwidth * thheight * 3];
+    float widthf = float(width);
+    float heightf = float(height);
 
-    m_Real.glReadPixels(0, 0, thwidth, thheight, eGL_RGB, eGL_UNSIGNED_BYTE, thpixels);
+    thwidth = width;
+    thheight = height;
 
-    // flip the image in-place
-    for(uint32_t y = 0; y <= thheight / 2; y++)
+    // clamp dimensions to a width of maxSize
+    if(thwidth > maxSize)
     {
-      uint32_t flipY = (thheight - 1 - y);
+      float aspect = widthf / heightf;
 
-      for(uint32_t x = 0; x < thwidth; x++)
-      {
-        byte save[3];
-        save[0] = thpixels[y * (thwidth * 3) + x * 3 + 0];
-        save[1] = thpixels[y * (thwidth * 3) + x * 3 + 1];
-        save[2] = thpixels[y * (thwidth * 3) + x * 3 + 2];
-
-        thpixels[y * (thwidth * 3) + x * 3 + 0] = thpixels[flipY * (thwidth * 3) + x * 3 + 0];
-        thpixels[y * (thwidth * 3) + x * 3 + 1] = thpixels[flipY * (thwidth * 3) + x * 3 + 1];
-        thpixels[y * (thwidth * 3) + x * 3 + 2] = thpixels[flipY * (thwidth * 3) + x * 3 + 2];
-
-        thpixels[flipY * (thwidth * 3) + x * 3 + 0] = save[0];
-        thpixels[flipY * (thwidth * 3) + x * 3 + 1] = save[1];
-        thpixels[flipY * (thwidth * 3) + x * 3 + 2] = save[2];
-      }
+      thwidth = maxSize;
+      thheight = uint32_t(float(thwidth) / aspect);
     }
 
-    m_Real.glBindBuffer(eGL_PIXEL_PACK_BUFFER, packBufBind);
-    m_Real.glBindFramebuffer(eGL_READ_FRAMEBUFFER, prevBuf);
-    m_Real.glReadBuffer(prevReadBuf);
-    m_Real.glPixelStorei(eGL_PACK_ROW_LENGTH, prevPackRowLen);
-    m_Real.glPixelStorei(eGL_PACK_SKIP_ROWS, prevPackSkipRows);
-    m_Real.glPixelStorei(eGL_PACK_SKIP_PIXELS, prevPackSkipPixels);
-    m_Real.glPixelStorei(eGL_PACK_ALIGNMENT, prevPackAlignment);
+    thpixels = new byte[thwidth * thheight * 3];
 
-    // scale down if necessary using simple point sampling
-    if(thwidth > maxSize)
+    ContextData &ctxdata = GetCtxData();
+
+    bool canBlit = ctxdata.Modern() && (!IsGLES || ctxdata.version >= 30) &&
+                   m_Real.glBlitFramebuffer && m_Real.glGenFramebuffers &&
+                   m_Real.glGenRenderbuffers && m_Real.glRenderbufferStorage &&
+                   m_Real.glFramebufferRenderbuffer;
+
+    if(canBlit)
     {
-      float widthf = float(thwidth);
-      float heightf = float(thheight);
+      // downscale and flip with a blit on the GPU, so that only the thumbnail is read back.
+      GLint prevDrawBuf = 0;
+      GLint prevRenderbuf = 0;
+      m_Real.glGetIntegerv(eGL_DRAW_FRAMEBUFFER_BINDING, &prevDrawBuf);
+      m_Real.glGetIntegerv(eGL_RENDERBUFFER_BINDING, &prevRenderbuf);
+
+      // blits are clipped by the scissor, and we want the raw backbuffer bytes without any sRGB
+      // conversion - the same as glReadPixels would give.
+      bool prevScissor = m_Real.glIsEnabled(eGL_SCISSOR_TEST) != 0;
+      bool prevSRGB = !IsGLES && m_Real.glIsEnabled(eGL_FRAMEBUFFER_SRGB) != 0;
+
+      m_Real.glDisable(eGL_SCISSOR_TEST);
+      if(prevSRGB)
+        m_Real.glDisable(eGL_FRAMEBUFFER_SRGB);
+
+      // GL_SAMPLES is queried from the draw framebuffer
+      GLint samples = 0;
+      m_Real.glBindFramebuffer(eGL_DRAW_FRAMEBUFFER, 0);
+      m_Real.glGetIntegerv(eGL_SAMPLES, &samples);
+
+      GLuint fbos[2] = {0};
+      GLuint rbs[2] = {0};
+      m_Real.glGenFramebuffers(2, fbos);
+      m_Real.glGenRenderbuffers(2, rbs);
+
+      // multisampled backbuffers can't be scaled in the same blit that resolves them
+      if(samples > 1)
+      {
+        m_Real.glBindRenderbuffer(eGL_RENDERBUFFER, rbs[1]);
+        m_Real.glRenderbufferStorage(eGL_RENDERBUFFER, eGL_RGBA8, width, height);
+        m_Real.glBindFramebuffer(eGL_DRAW_FRAMEBUFFER, fbos[1]);
+        m_Real.glFramebufferRenderbuffer(eGL_DRAW_FRAMEBUFFER, eGL_COLOR_ATTACHMENT0,
+                                         eGL_RENDERBUFFER, rbs[1]);
 
-      float aspect = widthf / heightf;
+        m_Real.glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT,
+                                 eGL_NEAREST);
 
-      // clamp dimensions to a width of maxSize
-      thwidth = maxSize;
-      thheight = uint32_t(float(thwidth) / aspect);
+        m_Real.glBindFramebuffer(eGL_READ_FRAMEBUFFER, fbos[1]);
+      }
+
+      m_Real.glBindRenderbuffer(eGL_RENDERBUFFER, rbs[0]);
+      m_Real.glRenderbufferStorage(eGL_RENDERBUFFER, eGL_RGBA8, thwidth, thheight);
+      m_Real.glBindFramebuffer(eGL_DRAW_FRAMEBUFFER, fbos[0]);
+      m_Real.glFramebufferRenderbuffer(eGL_DRAW_FRAMEBUFFER, eGL_COLOR_ATTACHMENT0,
+                                       eGL_RENDERBUFFER, rbs[0]);
+
+      // the destination rect is upside down, to flip from GL's bottom-left origin
+      m_Real.glBlitFramebuffer(0, 0, width, height, 0, thheight, thwidth, 0, GL_COLOR_BUFFER_BIT,
+                               eGL_LINEAR);
+
+      m_Real.glBindFramebuffer(eGL_READ_FRAMEBUFFER, fbos[0]);
+      m_Real.glReadPixels(0, 0, thwidth, thheight, eGL_RGB, eGL_UNSIGNED_BYTE, thpixels);
+
+      m_Real.glBindFramebuffer(eGL_DRAW_FRAMEBUFFER, prevDrawBuf);
+      m_Real.glBindRenderbuffer(eGL_RENDERBUFFER, prevRenderbuf);
 
-      byte *src = thpixels;
-      byte *dst = thpixels = new byte[3 * thwidth * thheight];
+      m_Real.glDeleteFramebuffers(2, fbos);
+      m_Real.glDeleteRenderbuffers(2, rbs);
+
+      if(prevScissor)
+        m_Real.glEnable(eGL_SCISSOR_TEST);
+      if(prevSRGB)
+        m_Real.glEnable(eGL_FRAMEBUFFER_SRGB);
+    }
+    else
+    {
+      byte *src = new byte[width * height * 3];
+
+      m_Real.glReadPixels(0, 0, width, height, eGL_RGB, eGL_UNSIGNED_BYTE, src);
+
+      // scale down using simple point sampling, and flip from GL's bottom-left origin
+      byte *dst = thpixels;
 
       for(uint32_t y = 0; y < thheight; y++)
       {
@@ -2778,47 +2856,29 @@ WrappedOpenGL::BackbufferImage *WrappedOpenGL::SaveBackbufferImage()
           float xf = float(x) / float(thwidth);
           float yf = float(y) / float(thheight);
 
-          byte *pixelsrc =
-              &src[3 * uint32_t(xf * widthf) + m_InitParams.width * 3 * uint32_t(yf * heightf)];
+          uint32_t srcY = height - 1 - uint32_t(yf * heightf);
 
-          memcpy(dst, pixelsrc, 3);
+          memcpy(dst, &src[3 * uint32_t(xf * widthf) + width * 3 * srcY], 3);
 
           dst += 3;
         }
       }
 
-      // src is the raw unscaled pixels, which is no longer needed
       SAFE_DELETE_ARRAY(src);
     }
-  }
 
-  byte *jpgbuf = NULL;
-  int len = thwidth * thheight;
-
-  if(len > 0)
-  {
-    jpgbuf = new byte[len];
-
-    jpge::params p;
-    p.m_quality = 80;
-
-    bool success =
-        jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thwidth, thheight, 3, thpixels, p);
-
-    if(!success)
-    {
-      RDCERR("Failed to compress to jpg");
-      SAFE_DELETE_ARRAY(jpgbuf);
-      thwidth = 0;
-      thheight = 0;
-    }
+    m_Real.glBindBuffer(eGL_PIXEL_PACK_BUFFER, packBufBind);
+    m_Real.glBindFramebuffer(eGL_READ_FRAMEBUFFER, prevBuf);
+    m_Real.glReadBuffer(prevReadBuf);
+    m_Real.glPixelStorei(eGL_PACK_ROW_LENGTH, prevPackRowLen);
+    m_Real.glPixelStorei(eGL_PACK_SKIP_ROWS, prevPackSkipRows);
+    m_Real.glPixelStorei(eGL_PACK_SKIP_PIXELS, prevPackSkipPixels);
+    m_Real.glPixelStorei(eGL_PACK_ALIGNMENT, prevPackAlignment);
   }
 
-  SAFE_DELETE_ARRAY(thpixels);
-
+  // JPEG compression happens later on the capture writer thread
   BackbufferImage *bbim = new BackbufferImage();
-  bbim->jpgbuf = jpgbuf;
-  bbim->len = len;
+  bbim->thpixels = thpixels;
   bbim->thwidth = thwidth;
   bbim->thheight = thheight;
 
@@ -3702,35 +3762,7 @@ void WrappedOpenGL::ContextReplayLog(LogState readType, uint32_t startEventID, u
   RDCASSERTEQUAL(header, CONTEXT_CAPTURE_HEADER);
 
   if(m_State == EXECUTING && !partial)
-  {
-    for(size_t i = 0; i < 8; i++)
-    {
-      GLenum q = QueryEnum(i);
-      if(q == eGL_NONE)
-        break;
-
-      for(int j = 0; j < 8; j++)
-      {
-        if(m_ActiveQueries[i][j])
-        {
-          m_Real.glEndQueryIndexed(q, j);
-          m_ActiveQueries[i][j] = false;
-        }
-      }
-    }
-
-    if(m_ActiveConditional)
-    {
-      m_Real.glEndConditionalRender();
-      m_ActiveConditional = false;
-    }
-
-    if(m_ActiveFeedback)
-    {
-      m_Real.glEndTransformFeedback();
-      m_ActiveFeedback = false;
-    }
-  }
+    EndActiveQueries();
 
   Serialise_BeginCaptureFrame(!partial);
 
@@ -3780,6 +3812,9 @@ void WrappedOpenGL::ContextReplayLog(LogState readType, uint32_t startEventID, u
     if(chunktype == CONTEXT_CAPTURE_FOOTER)
       break;
 
+    if(m_State == EXECUTING && m_CheckpointsAllowed && (m_CurEventID % m_CheckpointInterval) == 0)
+      CreateCheckpoint();
+
     m_CurEventID++;
   }
 
@@ -4239,11 +4274,45 @@ void WrappedOpenGL::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 
   m_pSerialiser->PopContext(header);
 
+  // the last event that will actually be replayed
+  uint32_t lastEventID = endEventID;
+  if(replayType == eReplay_WithoutDraw)
+    lastEventID = RDCMAX(1U, endEventID) - 1;
+
+  m_CheckpointsAllowed = !partial;
+
   if(!partial)
   {
-    GLMarkerRegion apply("ApplyInitialContents");
-    GetResourceManager()->ApplyInitialContents();
-    GetResourceManager()->ReleaseInFrameResources();
+    if(GetResourceManager()->HasInFrameResources())
+      DisableCheckpoints();
+
+    // find the latest checkpoint at or before the last event, if there is one
+    const ReplayCheckpoint *checkpoint = NULL;
+    for(size_t i = 0; i < m_Checkpoints.size() && m_Checkpoints[i].eventID <= lastEventID; i++)
+      checkpoint = &m_Checkpoints[i];
+
+    if(checkpoint)
+    {
+      GLMarkerRegion apply(StringFormat::Fmt("ApplyCheckpoint %u", checkpoint->eventID));
+
+      EndActiveQueries();
+
+      GetResourceManager()->ApplyCheckpoint(checkpoint->contents);
+      checkpoint->state->ApplyState(GetCtx(), this);
+
+      // continue from the event after the checkpoint, as if we had replayed up to it
+      startEventID = checkpoint->eventID + 1;
+      partial = true;
+
+      if(startEventID > lastEventID)
+        return;
+    }
+    else
+    {
+      GLMarkerRegion apply("ApplyInitialContents");
+      GetResourceManager()->ApplyInitialContents();
+      GetResourceManager()->ReleaseInFrameResources();
+    }
   }
 
   if(replayType == eReplay_Full)
@@ -4269,3 +4338,116 @@ void WrappedOpenGL::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
     RDCFATAL("Unexpected replay type");
   }
 }
+
+void WrappedOpenGL::EndActiveQueries()
+{
+  for(size_t i = 0; i < 8; i++)
+  {
+    GLenum q = QueryEnum(i);
+    if(q == eGL_NONE)
+      break;
+
+    for(int j = 0; j < 8; j++)
+    {
+      if(m_ActiveQueries[i][j])
+      {
+        m_Real.glEndQueryIndexed(q, j);
+        m_ActiveQueries[i][j] = false;
+      }
+    }
+  }
+
+  if(m_ActiveConditional)
+  {
+    m_Real.glEndConditionalRender();
+    m_ActiveConditional = false;
+  }
+
+  if(m_ActiveFeedback)
+  {
+    m_Real.glEndTransformFeedback();
+    m_ActiveFeedback = false;
+  }
+}
+
+void WrappedOpenGL::CreateCheckpoint()
+{
+  if(m_CheckpointBudget == 0)
+    return;
+
+  if(GetResourceManager()->HasInFrameResources())
+  {
+    DisableCheckpoints();
+    return;
+  }
+
+  // queries, conditional rendering and transform feedback can't be resumed partway through, so we
+  // can't checkpoint inside them.
+  if(m_ActiveConditional || m_ActiveFeedback)
+    return;
+
+  for(size_t i = 0; i < MAX_QUERIES; i++)
+    for(size_t j = 0; j < MAX_QUERY_INDICES; j++)
+      if(m_ActiveQueries[i][j])
+        return;
+
+  size_t idx = 0;
+  while(idx < m_Checkpoints.size() && m_Checkpoints[idx].eventID < m_CurEventID)
+    idx++;
+
+  if(idx < m_Checkpoints.size() && m_Checkpoints[idx].eventID == m_CurEventID)
+    return;
+
+  // every checkpoint snapshots the same set of resources, so assume this one will be as big as the
+  // last one and don't bother if it won't fit.
+  if(m_CheckpointBytes + m_CheckpointSize > m_CheckpointBudget)
+    return;
+
+  ReplayCheckpoint checkpoint;
+  checkpoint.eventID = m_CurEventID;
+  checkpoint.state = new GLRenderState(&m_Real, m_pSerialiser, m_State);
+  checkpoint.state->FetchState(GetCtx(), this);
+  checkpoint.size =
+      sizeof(GLRenderState) + GetResourceManager()->CreateCheckpoint(checkpoint.contents);
+
+  m_CheckpointSize = checkpoint.size;
+
+  if(m_CheckpointBytes + checkpoint.size > m_CheckpointBudget)
+  {
+    RDCDEBUG("Checkpoint at %u needs %llu bytes, over the remaining budget", m_CurEventID,
+             checkpoint.size);
+    GetResourceManager()->FreeCheckpoint(checkpoint.contents);
+    SAFE_DELETE(checkpoint.state);
+    return;
+  }
+
+  m_CheckpointBytes += checkpoint.size;
+  m_Checkpoints.insert(m_Checkpoints.begin() + idx, checkpoint);
+}
+
+void WrappedOpenGL::DisableCheckpoints()
+{
+  // checkpoints only snapshot resources that existed before the frame. Objects the frame creates
+  // itself are released and re-created when replaying from the start, but restoring a checkpoint
+  // would leave whatever the previous replay created, in whatever state it ended in. E.g. seeking
+  // to 1200, then 300, then 1200 in a frame that creates a texture at 500 would re-create it on
+  // top of the one left from the first replay, with the contents of that first replay's end.
+  // Rather than snapshotting in-frame objects, frames that create any always replay from the
+  // start.
+  RDCDEBUG("Frame creates resources, disabling replay checkpoints");
+
+  ClearCheckpoints();
+  m_CheckpointBudget = 0;
+}
+
+void WrappedOpenGL::ClearCheckpoints()
+{
+  for(size_t i = 0; i < m_Checkpoints.size(); i++)
+  {
+    GetResourceManager()->FreeCheckpoint(m_Checkpoints[i].contents);
+    SAFE_DELETE(m_Checkpoints[i].state);
+  }
+
+  m_Checkpoints.clear();
+  m_CheckpointBytes = 0;
+}
@@ -177,6 +177,29 @@ private:
   bool m_ActiveConditional;
   bool m_ActiveFeedback;
 
+  // replay checkpoints hold the replay state after an event partway through the frame, so that
+  // seeking can restart from the nearest earlier checkpoint rather than the start of the frame.
+  struct ReplayCheckpoint
+  {
+    uint32_t eventID;
+    uint64_t size;
+    GLRenderState *state;
+    GLResourceManager::CheckpointContents contents;
+  };
+  vector<ReplayCheckpoint> m_Checkpoints;
+  uint64_t m_CheckpointBytes;
+  uint64_t m_CheckpointBudget;
+  uint64_t m_CheckpointSize;
+  uint32_t m_CheckpointInterval;
+  // checkpoints can only be taken while replaying from a known good state. Partial replays might be
+  // running with modified state for debugging or overlays.
+  bool m_CheckpointsAllowed;
+
+  void CreateCheckpoint();
+  void ClearCheckpoints();
+  void DisableCheckpoints();
+  void EndActiveQueries();
+
   ResourceId m_DeviceResourceID;
   GLResourceRecord *m_DeviceRecord;
 
@@ -499,10 +522,10 @@ private:
 
   struct BackbufferImage
   {
-    BackbufferImage() : jpgbuf(NULL), len(0), thwidth(0), thheight(0) {}
-    ~BackbufferImage() { SAFE_DELETE_ARRAY(jpgbuf); }
-    byte *jpgbuf;
-    size_t len;
+    BackbufferImage() : thpixels(NULL), thwidth(0), thheight(0) {}
+    ~BackbufferImage() { SAFE_DELETE_ARRAY(thpixels); }
+    // raw 8-bit RGB, only JPEG compressed when the capture is written
+    byte *thpixels;
     uint32_t thwidth;
     uint32_t thheight;
   };
@@ -429,6 +429,38 @@ bool GLResourceManager::Prepare_InitialState(GLResource res, byte *blob)
   return true;
 }
 
+GLResourceManager::InitialContentData GLResourceManager::SnapshotBuffer(GLResource res)
+{
+  const GLHookSet &gl = m_State < WRITING ? m_GL->GetHookset() : m_GL->GetInternalHookset();
+
+  // get the length of the buffer
+  uint32_t length = 1;
+  gl.glGetNamedBufferParameterivEXT(res.name, eGL_BUFFER_SIZE, (GLint *)&length);
+
+  // save old bindings
+  GLuint oldbuf1 = 0, oldbuf2 = 0;
+  gl.glGetIntegerv(eGL_COPY_READ_BUFFER_BINDING, (GLint *)&oldbuf1);
+  gl.glGetIntegerv(eGL_COPY_WRITE_BUFFER_BINDING, (GLint *)&oldbuf2);
+
+  // create a new buffer big enough to hold the contents
+  GLuint buf = 0;
+  gl.glGenBuffers(1, &buf);
+  gl.glBindBuffer(eGL_COPY_WRITE_BUFFER, buf);
+  gl.glNamedBufferDataEXT(buf, (GLsizeiptr)length, NULL, eGL_STATIC_READ);
+
+  // bind the live buffer for copying
+  gl.glBindBuffer(eGL_COPY_READ_BUFFER, res.name);
+
+  // do the actual copy
+  gl.glCopyBufferSubData(eGL_COPY_READ_BUFFER, eGL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)length);
+
+  // restore old bindings
+  gl.glBindBuffer(eGL_COPY_READ_BUFFER, oldbuf1);
+  gl.glBindBuffer(eGL_COPY_WRITE_BUFFER, oldbuf2);
+
+  return InitialContentData(BufferRes(res.Context, buf), length, NULL);
+}
+
 bool GLResourceManager::Prepare_InitialState(GLResource res)
 {
   // this function needs to be refactored to better deal with multiple
@@ -440,32 +472,7 @@ bool GLResourceManager::Prepare_InitialState(GLResource res)
 
   if(res.Namespace == eResBuffer)
   {
-    // get the length of the buffer
-    uint32_t length = 1;
-    gl.glGetNamedBufferParameterivEXT(res.name, eGL_BUFFER_SIZE, (GLint *)&length);
-
-    // save old bindings
-    GLuint oldbuf1 = 0, oldbuf2 = 0;
-    gl.glGetIntegerv(eGL_COPY_READ_BUFFER_BINDING, (GLint *)&oldbuf1);
-    gl.glGetIntegerv(eGL_COPY_WRITE_BUFFER_BINDING, (GLint *)&oldbuf2);
-
-    // create a new buffer big enough to hold the contents
-    GLuint buf = 0;
-    gl.glGenBuffers(1, &buf);
-    gl.glBindBuffer(eGL_COPY_WRITE_BUFFER, buf);
-    gl.glNamedBufferDataEXT(buf, (GLsizeiptr)length, NULL, eGL_STATIC_READ);
-
-    // bind the live buffer for copying
-    gl.glBindBuffer(eGL_COPY_READ_BUFFER, res.name);
-
-    // do the actual copy
-    gl.glCopyBufferSubData(eGL_COPY_READ_BUFFER, eGL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)length);
-
-    // restore old bindings
-    gl.glBindBuffer(eGL_COPY_READ_BUFFER, oldbuf1);
-    gl.glBindBuffer(eGL_COPY_WRITE_BUFFER, oldbuf2);
-
-    SetInitialContents(Id, InitialContentData(BufferRes(res.Context, buf), length, NULL));
+    SetInitialContents(Id, SnapshotBuffer(res));
   }
   else if(res.Namespace == eResProgram)
   {
@@ -563,6 +570,14 @@ bool GLResourceManager::Prepare_InitialState(GLResource res)
 
 void GLResourceManager::PrepareTextureInitialContents(ResourceId liveid, ResourceId origid,
                                                       GLResource res)
+{
+  uint64_t size = 0;
+  SetInitialContents(origid, SnapshotTexture(liveid, res, size));
+}
+
+GLResourceManager::InitialContentData GLResourceManager::SnapshotTexture(ResourceId liveid,
+                                                                         GLResource res,
+                                                                         uint64_t &size)
 {
   const GLHookSet &gl = m_State < WRITING ? m_GL->GetHookset() : m_GL->GetInternalHookset();
 
@@ -577,7 +592,7 @@ void GLResourceManager::PrepareTextureInitialContents(ResourceId liveid, Resourc
     // textures can get here as GL_NONE if they were created and dirtied (by setting lots of
     // texture parameters) without ever having storage allocated (via glTexStorage or glTexImage).
     // in that case, just ignore as we won't bother with the initial states.
-    SetInitialContents(origid, InitialContentData(GLResource(MakeNullResource), 0, (byte *)state));
+    return InitialContentData(GLResource(MakeNullResource), 0, (byte *)state);
   }
   else if(details.curType != eGL_TEXTURE_BUFFER)
   {
@@ -840,6 +855,11 @@ void GLResourceManager::PrepareTextureInitialContents(ResourceId liveid, Resourc
                 details.curType == eGL_TEXTURE_1D_ARRAY || details.curType == eGL_TEXTURE_2D_ARRAY)
           d = details.depth;
 
+        if(iscomp)
+          size += GetCompressedByteSize(w, h, d, details.internalFormat, i);
+        else
+          size += GetByteSize(w, h, d, baseFormat, dataType) * RDCMAX(1, details.samples);
+
         // AMD throws an error copying mips that are smaller than the block size in one dimension,
         // so do copy via CPU instead (will be slow, potentially we could optimise this if there's a
         // different GPU-side image copy routine that works on these dimensions. Hopefully there'll
@@ -930,7 +950,7 @@ void GLResourceManager::PrepareTextureInitialContents(ResourceId liveid, Resourc
                                  (GLint *)&state->maxLevel);
     }
 
-    SetInitialContents(origid, InitialContentData(TextureRes(res.Context, tex), 0, (byte *)state));
+    return InitialContentData(TextureRes(res.Context, tex), 0, (byte *)state);
   }
   else
   {
@@ -946,7 +966,7 @@ void GLResourceManager::PrepareTextureInitialContents(ResourceId liveid, Resourc
     gl.glGetTextureLevelParameterivEXT(res.name, details.curType, 0, eGL_TEXTURE_BUFFER_SIZE,
                                        (GLint *)&state->texBufSize);
 
-    SetInitialContents(origid, InitialContentData(GLResource(MakeNullResource), 0, (byte *)state));
+    return InitialContentData(GLResource(MakeNullResource), 0, (byte *)state);
   }
 }
 
@@ -970,14 +990,14 @@ bool GLResourceManager::Force_InitialState(GLResource res, bool prepare)
       return true;
 
     // if this data resource was referenced already, just skip
-    if(m_FrameReferencedResources.find(record->GetResourceID()) != m_FrameReferencedResources.end())
+    if(m_FrameReferencedResources.Contains(record->GetResourceID()))
       return false;
 
     // see if any of our viewers were referenced
     for(auto it = record->viewTextures.begin(); it != record->viewTextures.end(); ++it)
     {
       // if so, return true to force our inclusion, for the benefit of the view
-      if(m_FrameReferencedResources.find(*it) != m_FrameReferencedResources.end())
+      if(m_FrameReferencedResources.Contains(*it))
       {
         RDCDEBUG("Forcing inclusion of %llu for %llu", record->GetResourceID(), *it);
         return true;
@@ -2235,3 +2255,108 @@ void GLResourceManager::Apply_InitialState(GLResource live, InitialContentData i
     RDCERR("Unexpected type of resource requiring initial state");
   }
 }
+
+uint64_t GLResourceManager::CreateCheckpoint(CheckpointContents &contents)
+{
+  const GLHookSet &gl = m_GL->GetHookset();
+
+  uint64_t size = 0;
+
+  for(auto it = m_InitialContents.begin(); it != m_InitialContents.end(); ++it)
+  {
+    ResourceId id = it->first;
+
+    if(!HasLiveResource(id))
+      continue;
+
+    GLResource res = GetLiveResource(id);
+
+    if(res.Namespace == eResBuffer)
+    {
+      InitialContentData data = SnapshotBuffer(res);
+      size += data.num;
+      contents[id] = data;
+    }
+    else if(res.Namespace == eResTexture)
+    {
+      contents[id] = SnapshotTexture(GetID(res), res, size);
+    }
+    else if(res.Namespace == eResProgram)
+    {
+      // save the uniform values to memory rather than to a duplicate program, so we don't have to
+      // link a new program for every checkpoint
+      Serialiser ser(NULL, Serialiser::WRITING, false, 1024);
+
+      SerialiseProgramUniforms(gl, &ser, res.name, NULL, true);
+
+      uint32_t len = (uint32_t)ser.GetOffset();
+      byte *blob = Serialiser::AllocAlignedBuffer(len);
+      memcpy(blob, ser.GetRawPtr(0), len);
+
+      size += len;
+      contents[id] = InitialContentData(GLResource(MakeNullResource), len, blob);
+    }
+    else if(res.Namespace == eResFramebuffer || res.Namespace == eResFeedback ||
+            res.Namespace == eResVertexArray)
+    {
+      size_t len = sizeof(VAOInitialData);
+      if(res.Namespace == eResFramebuffer)
+        len = sizeof(FramebufferInitialData);
+      else if(res.Namespace == eResFeedback)
+        len = sizeof(FeedbackInitialData);
+
+      byte *blob = Serialiser::AllocAlignedBuffer(len);
+      RDCEraseMem(blob, len);
+
+      Prepare_InitialState(res, blob);
+
+      size += len;
+      contents[id] = InitialContentData(GLResource(MakeNullResource), 0, blob);
+    }
+  }
+
+  return size;
+}
+
+void GLResourceManager::ApplyCheckpoint(const CheckpointContents &contents)
+{
+  const GLHookSet &gl = m_GL->GetHookset();
+
+  for(auto it = contents.begin(); it != contents.end(); ++it)
+  {
+    if(!HasLiveResource(it->first))
+      continue;
+
+    GLResource live = GetLiveResource(it->first);
+
+    if(live.Namespace == eResProgram)
+    {
+      Serialiser ser(it->second.num, it->second.blob, false);
+
+      SerialiseProgramUniforms(gl, &ser, live.name, NULL, false);
+    }
+    else
+    {
+      Apply_InitialState(live, it->second);
+    }
+  }
+}
+
+void GLResourceManager::FreeCheckpoint(CheckpointContents &contents)
+{
+  const GLHookSet &gl = m_GL->GetHookset();
+
+  for(auto it = contents.begin(); it != contents.end(); ++it)
+  {
+    GLResource res = it->second.resource;
+
+    if(res.Namespace == eResBuffer)
+      gl.glDeleteBuffers(1, &res.name);
+    else if(res.Namespace == eResTexture)
+      gl.glDeleteTextures(1, &res.name);
+
+    Serialiser::FreeAlignedBuffer(it->second.blob);
+  }
+
+  contents.clear();
+}
@@ -212,6 +212,13 @@ public:
   bool Prepare_InitialState(GLResource res, byte *blob);
   bool Serialise_InitialState(ResourceId resid, GLResource res);
 
+  // replay checkpoints snapshot the current state of every resource with initial contents, in the
+  // same form as the initial contents, so that replay can restart from partway through the frame.
+  typedef map<ResourceId, InitialContentData> CheckpointContents;
+  uint64_t CreateCheckpoint(CheckpointContents &contents);
+  void ApplyCheckpoint(const CheckpointContents &contents);
+  void FreeCheckpoint(CheckpointContents &contents);
+
 private:
   bool SerialisableResource(ResourceId id, GLResourceRecord *record);
 
@@ -221,6 +228,8 @@ private:
   bool Prepare_InitialState(GLResource res);
 
   void PrepareTextureInitialContents(ResourceId liveid, ResourceId origid, GLResource res);
+  InitialContentData SnapshotTexture(ResourceId liveid, GLResource res, uint64_t &size);
+  InitialContentData SnapshotBuffer(GLResource res);
 
   void Create_InitialState(ResourceId id, GLResource live, bool hasData);
   void Apply_InitialState(GLResource live, InitialContentData initial);
@@ -2792,12 +2792,17 @@ void GLReplay::ReplaceResource(ResourceId from, ResourceId to)
 {
   MakeCurrentReplayContext(&m_ReplayCtx);
   m_pDriver->ReplaceResource(from, to);
+
+  // a replaced shader can move the vertices, so the picking BVH must be rebuilt
+  m_MeshPickBVH.Clear();
 }
 
 void GLReplay::RemoveReplacement(ResourceId id)
 {
   MakeCurrentReplayContext(&m_ReplayCtx);
   m_pDriver->RemoveReplacement(id);
+
+  m_MeshPickBVH.Clear();
 }
 
 void GLReplay::FreeTargetResource(ResourceId id)
@@ -27,6 +27,7 @@
 
 #include "api/replay/renderdoc_replay.h"
 #include "core/core.h"
+#include "replay/mesh_pick.h"
 #include "replay/replay_driver.h"
 #include "gl_common.h"
 
@@ -362,6 +363,11 @@ private:
   FloatVector InterpretVertex(byte *data, uint32_t vert, const MeshDisplay &cfg, byte *end,
                               bool useidx, bool &valid);
 
+  void GetMeshPickData(const MeshDisplay &cfg, vector<FloatVector> &positions,
+                       vector<uint32_t> &idxs);
+
+  MeshPickBVH m_MeshPickBVH;
+
   // simple cache for when we need buffer data for highlighting
   // vertices, typical use will be lots of vertices in the same
   // mesh, not jumping back and forth much between meshes.
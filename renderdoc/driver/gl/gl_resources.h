@@ -135,6 +135,12 @@ struct GLResource
   }
 };
 
+inline uint64_t ResourceHash(const GLResource &res)
+{
+  return ResourceHashMix(ResourceHashMix((uint64_t)(uintptr_t)res.Context) ^
+                         ((uint64_t)res.Namespace << 32) ^ (uint64_t)res.name);
+}
+
 // Shared objects currently ignore the context parameter.
 // For correctness we'd need to check if the context is shared and if so move up to a 'parent'
 // so the context value ends up being identical for objects being shared, but can be different
@@ -228,6 +234,10 @@ struct GLResourceRecord : public ResourceRecord
 
     byte *persistentPtr;
     int64_t persistentMaps;    // counter indicating how many coherent maps are 'live'
+
+    // the modified range left to serialise when unmapping, relative to the map offset
+    size_t diffStart;
+    size_t diffEnd;
   } Map;
 
   template <typename ChunkFilter>
@@ -376,7 +376,7 @@ void WrappedOpenGL::Common_glNamedBufferStorageEXT(ResourceId id, GLsizeiptr siz
 
     {
       record->AddChunk(chunk);
-      record->SetDataPtr(chunk->GetData());
+      record->SetDataPtr(chunk);
       record->Length = (int32_t)size;
       record->DataInSerialiser = true;
     }
@@ -601,7 +601,7 @@ void WrappedOpenGL::glNamedBufferDataEXT(GLuint buffer, GLsizeiptr size, const v
     else
     {
       record->AddChunk(chunk);
-      record->SetDataPtr(chunk->GetData());
+      record->SetDataPtr(chunk);
       record->Length = (int32_t)size;
       record->usage = usage;
       record->DataInSerialiser = true;
@@ -735,7 +735,7 @@ void WrappedOpenGL::glBufferData(GLenum target, GLsizeiptr size, const void *dat
     else
     {
       record->AddChunk(chunk);
-      record->SetDataPtr(chunk->GetData());
+      record->SetDataPtr(chunk);
       record->Length = size;
       record->usage = usage;
       record->DataInSerialiser = true;
@@ -2097,27 +2097,14 @@ bool WrappedOpenGL::Serialise_glUnmapNamedBufferEXT(GLuint buffer)
   size_t diffStart = 0;
   size_t diffEnd = (size_t)len;
 
-  if(m_State == WRITING_CAPFRAME &&
-     // don't bother checking diff range for tiny buffers
-     len > 512 &&
-     // if the map has a sub-range specified, trust the user to have specified
-     // a minimal range, similar to glFlushMappedBufferRange, so don't find diff
-     // range.
-     record->Map.offset == 0 && record->Map.length == (GLsizeiptr)record->Length &&
-     // similarly for invalidate maps, we want to update the whole buffer
-     !record->Map.invalidate)
+  // the modified range was found in glUnmapNamedBufferEXT
+  if(m_State == WRITING_CAPFRAME)
   {
-    bool found = FindDiffRange(record->Map.ptr, record->GetShadowPtr(1) + offs, (size_t)len,
-                               diffStart, diffEnd);
-    if(found)
-    {
-      static size_t saved = 0;
-
-      saved += (size_t)len - (diffEnd - diffStart);
-
-      RDCDEBUG("Mapped resource size %u, difference: %u -> %u. Total bytes saved so far: %u",
-               (uint32_t)len, (uint32_t)diffStart, (uint32_t)diffEnd, (uint32_t)saved);
+    diffStart = record->Map.diffStart;
+    diffEnd = record->Map.diffEnd;
 
+    if(diffEnd > diffStart)
+    {
       len = diffEnd - diffStart;
     }
     else
@@ -2246,6 +2233,57 @@ GLboolean WrappedOpenGL::glUnmapNamedBufferEXT(GLuint buffer)
         }
         else if(m_State == WRITING_CAPFRAME)
         {
+          size_t len = (size_t)record->Map.length;
+
+          record->Map.diffStart = 0;
+          record->Map.diffEnd = len;
+
+          if(  // don't bother checking diff range for tiny buffers
+              len > 512 &&
+              // if the map has a sub-range specified, trust the user to have specified
+              // a minimal range, similar to glFlushMappedBufferRange, so don't find diff
+              // range.
+              record->Map.offset == 0 && record->Map.length == (GLsizeiptr)record->Length &&
+              // similarly for invalidate maps, we want to update the whole buffer
+              !record->Map.invalidate)
+          {
+            vector<DiffRange> ranges;
+
+            if(FindDiffRanges(record->Map.ptr, record->GetShadowPtr(1), len, DiffRangeGranularity,
+                              ranges))
+            {
+              static size_t saved = 0;
+
+              // serialise every modified range but the last as an explicit flush, the unmap
+              // below then contains only the last range
+              for(size_t r = 0; r + 1 < ranges.size(); r++)
+              {
+                SCOPED_SERIALISE_CONTEXT(FLUSHMAP);
+                Serialise_glFlushMappedNamedBufferRangeEXT(
+                    buffer, GLintptr(ranges[r].start), GLsizeiptr(ranges[r].end - ranges[r].start));
+                m_ContextRecord->AddChunk(scope.Get());
+
+                len -= ranges[r].end - ranges[r].start;
+              }
+
+              record->Map.diffStart = ranges.back().start;
+              record->Map.diffEnd = ranges.back().end;
+
+              len -= ranges.back().end - ranges.back().start;
+              saved += len;
+
+              RDCDEBUG(
+                  "Mapped resource size %u, %u modified ranges: %u -> %u. Total bytes saved so "
+                  "far: %u",
+                  (uint32_t)record->Map.length, (uint32_t)ranges.size(),
+                  (uint32_t)ranges.front().start, (uint32_t)ranges.back().end, (uint32_t)saved);
+            }
+            else
+            {
+              record->Map.diffEnd = 0;
+            }
+          }
+
           SCOPED_SERIALISE_CONTEXT(UNMAP);
           Serialise_glUnmapNamedBufferEXT(buffer);
           m_ContextRecord->AddChunk(scope.Get());
@@ -2497,11 +2535,14 @@ void WrappedOpenGL::PersistentMapMemoryBarrier(const set<GLResourceRecord *> &ma
 
     RDCASSERT(record && record->Map.persistentPtr);
 
-    size_t diffStart = 0, diffEnd = 0;
-    bool found = FindDiffRange(record->GetShadowPtr(0), record->GetShadowPtr(1),
-                               (size_t)record->Length, diffStart, diffEnd);
-    if(found)
+    vector<DiffRange> ranges;
+    FindDiffRanges(record->GetShadowPtr(0), record->GetShadowPtr(1), (size_t)record->Length,
+                   DiffRangeGranularity, ranges);
+
+    for(size_t r = 0; r < ranges.size(); r++)
     {
+      size_t diffStart = ranges[r].start, diffEnd = ranges[r].end;
+
       // update the modified region in the 'comparison' shadow buffer for next check
       memcpy(record->GetShadowPtr(1) + diffStart, record->GetShadowPtr(0) + diffStart,
              diffEnd - diffStart);
@@ -52,3 +52,42 @@ void ShutdownSPIRVCompiler()
     glslang::FinalizeProcess();
   }
 }
+
+void *SPVArena::Alloc(size_t size)
+{
+  // keep every allocation 16-byte aligned, which covers any member of the IR structs
+  size = AlignUp(size, (size_t)16);
+
+  if(size > BlockSize)
+  {
+    char *block = new char[size];
+    m_Blocks.push_back(block);
+    return block;
+  }
+
+  if(size > m_Remaining)
+  {
+    m_Head = new char[BlockSize];
+    m_Remaining = BlockSize;
+    m_Blocks.push_back(m_Head);
+  }
+
+  void *ret = m_Head;
+  m_Head += size;
+  m_Remaining -= size;
+  return ret;
+}
+
+void SPVArena::Clear()
+{
+  for(size_t i = 0; i < m_Objects.size(); i++)
+    m_Objects[i].second(m_Objects[i].first);
+  m_Objects.clear();
+
+  for(size_t i = 0; i < m_Blocks.size(); i++)
+    delete[] m_Blocks[i];
+  m_Blocks.clear();
+
+  m_Head = NULL;
+  m_Remaining = 0;
+}
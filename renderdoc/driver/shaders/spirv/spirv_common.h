@@ -25,7 +25,9 @@
 #pragma once
 
 #include <stdint.h>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
 #include "3rdparty/glslang/SPIRV/spirv.hpp"
 
@@ -51,13 +53,62 @@ struct SPVInstruction;
 struct ShaderReflection;
 struct ShaderBindpointMapping;
 
+// bump allocator for the parsed IR objects of a module. Modules contain one object or more for
+// every instruction, so allocating them out of large blocks avoids a heap allocation each. All
+// objects are destroyed together when the arena is cleared.
+class SPVArena
+{
+public:
+  SPVArena() : m_Head(NULL), m_Remaining(0) {}
+  ~SPVArena() { Clear(); }
+  template <typename T>
+  T *New()
+  {
+    T *ret = new(Alloc(sizeof(T))) T();
+    m_Objects.push_back(std::make_pair((void *)ret, &Destroy<T>));
+    return ret;
+  }
+
+  void Clear();
+
+private:
+  // no copy semantics
+  SPVArena(const SPVArena &);
+  SPVArena &operator=(const SPVArena &);
+
+  template <typename T>
+  static void Destroy(void *obj)
+  {
+    ((T *)obj)->~T();
+  }
+
+  void *Alloc(size_t size);
+
+  static const size_t BlockSize = 64 * 1024;
+
+  vector<char *> m_Blocks;
+  char *m_Head;
+  size_t m_Remaining;
+  vector<std::pair<void *, void (*)(void *)> > m_Objects;
+};
+
 struct SPVModule
 {
   SPVModule();
   ~SPVModule();
 
+  // discard the module contents, to be re-parsed from new SPIR-V
+  void Reset();
+
   vector<uint32_t> spirv;
 
+  // ParseSPIRV only reads the header, the instructions are parsed on first use by EnsureParsed().
+  // Everything below apart from the header information is only valid after that.
+  bool parsed;
+  void EnsureParsed();
+
+  SPVArena arena;
+
   struct
   {
     uint8_t major, minor;
@@ -23,8 +23,6 @@
  ******************************************************************************/
 
 #include "vk_core.h"
-#include "jpeg-compressor/jpge.h"
-#include "maths/formatpacking.h"
 #include "serialise/string_utils.h"
 #include "vk_debug.h"
 
@@ -308,6 +306,9 @@ WrappedVulkan::WrappedVulkan(const char *logFilename) : m_RenderState(&m_Creatio
 
   m_LastCmdBufferID = ResourceId();
 
+  m_CmdBufferRecordBegin = 0;
+  m_CmdBufferSkipTo = 0;
+
   m_DrawcallStack.push_back(&m_ParentDrawcall);
 
   m_SetDeviceLoaderData = NULL;
@@ -645,7 +646,11 @@ Serialiser *WrappedVulkan::GetThreadSerialiser()
 {
   Serialiser *ser = (Serialiser *)Threading::GetTLSValue(threadSerialiserTLSSlot);
   if(ser)
+  {
+    // only chunks recorded during a frame capture are short-lived enough to come from the arena
+    ser->SetChunkArenaActive(m_State == WRITING_CAPFRAME);
     return ser;
+  }
 
 // slow path, but rare
 
@@ -660,6 +665,11 @@ Serialiser *WrappedVulkan::GetThreadSerialiser()
 
   ser->SetChunkNameLookup(&GetChunkName);
 
+  // thread serialisers are only used from their own thread, and create the bulk of the chunks
+  // during capture, so allocate those out of an arena
+  ser->EnableChunkArena();
+  ser->SetChunkArenaActive(m_State == WRITING_CAPFRAME);
+
   Threading::SetTLSValue(threadSerialiserTLSSlot, (void *)ser);
 
   {
@@ -1139,6 +1149,10 @@ void WrappedVulkan::StartFrameCapture(void *dev, void *wnd)
     SCOPED_LOCK(m_CapTransitionLock);
     GetResourceManager()->PrepareInitialContents();
 
+    // wait for the last batches of initial state readbacks, since the application can modify
+    // resources (e.g. through persistent maps) as soon as we return.
+    FlushInitStateBatches();
+
     RDCDEBUG("Attempting capture");
     m_FrameCaptureRecord->DeleteChunks();
 
@@ -1266,272 +1280,224 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
     const SwapchainInfo &swapInfo = *swaprecord->swapInfo;
 
-    // since these objects are very short lived (only this scope), we
-    // don't wrap them.
-    VkImage readbackIm = VK_NULL_HANDLE;
-    VkDeviceMemory readbackMem = VK_NULL_HANDLE;
+    float widthf = float(swapInfo.extent.width);
+    float heightf = float(swapInfo.extent.height);
 
-    VkResult vkr = VK_SUCCESS;
+    float aspect = widthf / heightf;
 
-    // create identical image
-    VkImageCreateInfo imInfo = {
-        VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-        NULL,
-        0,
-        VK_IMAGE_TYPE_2D,
-        swapInfo.format,
-        {swapInfo.extent.width, swapInfo.extent.height, 1},
-        1,
-        1,
-        VK_SAMPLE_COUNT_1_BIT,
-        VK_IMAGE_TILING_LINEAR,
-        VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-        VK_SHARING_MODE_EXCLUSIVE,
-        0,
-        NULL,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-    };
-    vt->CreateImage(Unwrap(device), &imInfo, NULL, &readbackIm);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    thwidth = RDCMIN(maxSize, swapInfo.extent.width);
+    thwidth &= ~0x7;    // align down to multiple of 8
+    thheight = uint32_t(float(thwidth) / aspect);
 
-    VkMemoryRequirements mrq = {0};
-    vt->GetImageMemoryRequirements(Unwrap(device), readbackIm, &mrq);
+    // the downscale and conversion to 8-bit RGBA are done with a blit on the GPU, so that only
+    // the thumbnail itself needs to be read back. Linear float backbuffers are blitted into an
+    // sRGB image, which applies the sRGB curve for us.
+    ResourceFormat fmt = MakeResourceFormat(swapInfo.format);
 
-    VkImageSubresource subr = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0};
-    VkSubresourceLayout layout = {0};
-    vt->GetImageSubresourceLayout(Unwrap(device), readbackIm, &subr, &layout);
-
-    // allocate readback memory
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        GetReadbackMemoryIndex(mrq.memoryTypeBits),
-    };
+    VkFormat thumbFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    if(fmt.srgbCorrected || fmt.compType == eCompType_Float)
+      thumbFormat = VK_FORMAT_R8G8B8A8_SRGB;
 
-    vkr = vt->AllocateMemory(Unwrap(device), &allocInfo, NULL, &readbackMem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-    vkr = vt->BindImageMemory(Unwrap(device), readbackIm, readbackMem, 0);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    VkFormatFeatureFlags srcFeatures = GetFormatProperties(swapInfo.format).optimalTilingFeatures;
+    VkFormatFeatureFlags dstFeatures = GetFormatProperties(thumbFormat).optimalTilingFeatures;
 
-    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+    if((srcFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) == 0 ||
+       (dstFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT) == 0)
+    {
+      RDCWARN("Can't blit from backbuffer format %d, no thumbnail will be saved", swapInfo.format);
+      thwidth = thheight = 0;
+    }
 
-    // do image copy
-    vkr = vt->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    if(thwidth > 0 && thheight > 0)
+    {
+      // since these objects are very short lived (only this scope), we
+      // don't wrap them.
+      VkImage thumbIm = VK_NULL_HANDLE;
+      VkDeviceMemory thumbMem = VK_NULL_HANDLE;
+      VkBuffer readbackBuf = VK_NULL_HANDLE;
+      VkDeviceMemory readbackMem = VK_NULL_HANDLE;
+
+      VkResult vkr = VK_SUCCESS;
+
+      VkImageCreateInfo imInfo = {
+          VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+          NULL,
+          0,
+          VK_IMAGE_TYPE_2D,
+          thumbFormat,
+          {thwidth, thheight, 1},
+          1,
+          1,
+          VK_SAMPLE_COUNT_1_BIT,
+          VK_IMAGE_TILING_OPTIMAL,
+          VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+          VK_SHARING_MODE_EXCLUSIVE,
+          0,
+          NULL,
+          VK_IMAGE_LAYOUT_UNDEFINED,
+      };
+      vkr = vt->CreateImage(Unwrap(device), &imInfo, NULL, &thumbIm);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    VkImageCopy cpy = {
-        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},           {0, 0, 0},
-        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},           {0, 0, 0},
-        {imInfo.extent.width, imInfo.extent.height, 1},
-    };
+      VkMemoryRequirements mrq = {0};
+      vt->GetImageMemoryRequirements(Unwrap(device), thumbIm, &mrq);
 
-    VkImageMemoryBarrier bbBarrier = {
-        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        NULL,
-        0,
-        VK_ACCESS_TRANSFER_READ_BIT,
-        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        0,
-        0,    // MULTIDEVICE - need to actually pick the right queue family here maybe?
-        Unwrap(backbuffer),
-        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
-
-    VkImageMemoryBarrier readBarrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                                        NULL,
-                                        0,
-                                        VK_ACCESS_TRANSFER_WRITE_BIT,
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                        VK_QUEUE_FAMILY_IGNORED,
-                                        VK_QUEUE_FAMILY_IGNORED,
-                                        readbackIm,    // was never wrapped
-                                        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
-
-    DoPipelineBarrier(cmd, 1, &bbBarrier);
-    DoPipelineBarrier(cmd, 1, &readBarrier);
-
-    vt->CmdCopyImage(Unwrap(cmd), Unwrap(backbuffer), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                     readbackIm, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &cpy);
-
-    // barrier to switch backbuffer back to present layout
-    std::swap(bbBarrier.oldLayout, bbBarrier.newLayout);
-    std::swap(bbBarrier.srcAccessMask, bbBarrier.dstAccessMask);
-
-    readBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    readBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
-    readBarrier.oldLayout = readBarrier.newLayout;
-    readBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-    DoPipelineBarrier(cmd, 1, &bbBarrier);
-    DoPipelineBarrier(cmd, 1, &readBarrier);
-
-    vkr = vt->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      VkMemoryAllocateInfo allocInfo = {
+          VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
+          GetGPULocalMemoryIndex(mrq.memoryTypeBits),
+      };
 
-    SubmitCmds();
-    FlushQ();    // need to wait so we can readback
+      vkr = vt->AllocateMemory(Unwrap(device), &allocInfo, NULL, &thumbMem);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      vkr = vt->BindImageMemory(Unwrap(device), thumbIm, thumbMem, 0);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // map memory and readback
-    byte *pData = NULL;
-    vkr = vt->MapMemory(Unwrap(device), readbackMem, 0, VK_WHOLE_SIZE, 0, (void **)&pData);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      VkBufferCreateInfo bufInfo = {
+          VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+          NULL,
+          0,
+          VkDeviceSize(thwidth * thheight * 4),
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      };
 
-    RDCASSERT(pData != NULL);
+      vkr = vt->CreateBuffer(Unwrap(device), &bufInfo, NULL, &readbackBuf);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // point sample info into raw buffer
-    {
-      ResourceFormat fmt = MakeResourceFormat(imInfo.format);
+      vt->GetBufferMemoryRequirements(Unwrap(device), readbackBuf, &mrq);
 
-      byte *data = (byte *)pData;
+      allocInfo.allocationSize = mrq.size;
+      allocInfo.memoryTypeIndex = GetReadbackMemoryIndex(mrq.memoryTypeBits);
 
-      data += layout.offset;
+      vkr = vt->AllocateMemory(Unwrap(device), &allocInfo, NULL, &readbackMem);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      vkr = vt->BindBufferMemory(Unwrap(device), readbackBuf, readbackMem, 0);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-      float widthf = float(imInfo.extent.width);
-      float heightf = float(imInfo.extent.height);
+      VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
 
-      float aspect = widthf / heightf;
+      vkr = vt->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-      thwidth = RDCMIN(maxSize, imInfo.extent.width);
-      thwidth &= ~0x7;    // align down to multiple of 8
-      thheight = uint32_t(float(thwidth) / aspect);
+      VkImageMemoryBarrier bbBarrier = {
+          VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          NULL,
+          0,
+          VK_ACCESS_TRANSFER_READ_BIT,
+          VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+          VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+          0,
+          0,    // MULTIDEVICE - need to actually pick the right queue family here maybe?
+          Unwrap(backbuffer),
+          {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+
+      VkImageMemoryBarrier thumbBarrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                                           NULL,
+                                           0,
+                                           VK_ACCESS_TRANSFER_WRITE_BIT,
+                                           VK_IMAGE_LAYOUT_UNDEFINED,
+                                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                           VK_QUEUE_FAMILY_IGNORED,
+                                           VK_QUEUE_FAMILY_IGNORED,
+                                           thumbIm,    // was never wrapped
+                                           {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+
+      DoPipelineBarrier(cmd, 1, &bbBarrier);
+      DoPipelineBarrier(cmd, 1, &thumbBarrier);
+
+      VkImageBlit blit = {
+          {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+          {
+              {0, 0, 0}, {(int32_t)swapInfo.extent.width, (int32_t)swapInfo.extent.height, 1},
+          },
+          {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+          {
+              {0, 0, 0}, {(int32_t)thwidth, (int32_t)thheight, 1},
+          },
+      };
+
+      VkFilter filter = (srcFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+                            ? VK_FILTER_LINEAR
+                            : VK_FILTER_NEAREST;
+
+      vt->CmdBlitImage(Unwrap(cmd), Unwrap(backbuffer), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       thumbIm, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, filter);
+
+      thumbBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      thumbBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+      thumbBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      thumbBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+      DoPipelineBarrier(cmd, 1, &thumbBarrier);
+
+      VkBufferImageCopy cpy = {
+          0, 0, 0, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1}, {0, 0, 0}, {thwidth, thheight, 1},
+      };
+
+      vt->CmdCopyImageToBuffer(Unwrap(cmd), thumbIm, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               readbackBuf, 1, &cpy);
+
+      // barrier to switch backbuffer back to present layout
+      std::swap(bbBarrier.oldLayout, bbBarrier.newLayout);
+      std::swap(bbBarrier.srcAccessMask, bbBarrier.dstAccessMask);
+
+      VkBufferMemoryBarrier readBarrier = {
+          VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+          NULL,
+          VK_ACCESS_TRANSFER_WRITE_BIT,
+          VK_ACCESS_HOST_READ_BIT,
+          VK_QUEUE_FAMILY_IGNORED,
+          VK_QUEUE_FAMILY_IGNORED,
+          readbackBuf,    // was never wrapped
+          0,
+          VK_WHOLE_SIZE,
+      };
+
+      DoPipelineBarrier(cmd, 1, &bbBarrier);
+      DoPipelineBarrier(cmd, 1, &readBarrier);
+
+      vkr = vt->EndCommandBuffer(Unwrap(cmd));
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-      thpixels = new byte[3 * thwidth * thheight];
+      SubmitCmds();
+      FlushQ();    // need to wait so we can readback
 
-      uint32_t stride = fmt.compByteWidth * fmt.compCount;
+      // map memory and readback
+      byte *pData = NULL;
+      vkr = vt->MapMemory(Unwrap(device), readbackMem, 0, VK_WHOLE_SIZE, 0, (void **)&pData);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-      bool buf1010102 = false;
-      bool buf565 = false, buf5551 = false;
-      bool bufBGRA = (fmt.bgraOrder != false);
+      RDCASSERT(pData != NULL);
 
-      if(fmt.special)
+      if(pData)
       {
-        switch(fmt.specialFormat)
-        {
-          case eSpecial_R10G10B10A2:
-            stride = 4;
-            buf1010102 = true;
-            break;
-          case eSpecial_R5G6B5:
-            stride = 2;
-            buf565 = true;
-            break;
-          case eSpecial_R5G5B5A1:
-            stride = 2;
-            buf5551 = true;
-            break;
-          default: break;
-        }
-      }
-
-      byte *dst = thpixels;
+        // drop the alpha channel, the rest is ready to be compressed as-is
+        thpixels = new byte[3 * thwidth * thheight];
 
-      for(uint32_t y = 0; y < thheight; y++)
-      {
-        for(uint32_t x = 0; x < thwidth; x++)
+        byte *dst = thpixels;
+        for(uint32_t i = 0; i < thwidth * thheight; i++)
         {
-          float xf = float(x) / float(thwidth);
-          float yf = float(y) / float(thheight);
-
-          byte *src =
-              &data[stride * uint32_t(xf * widthf) + layout.rowPitch * uint32_t(yf * heightf)];
-
-          if(buf1010102)
-          {
-            uint32_t *src1010102 = (uint32_t *)src;
-            Vec4f unorm = ConvertFromR10G10B10A2(*src1010102);
-            dst[0] = (byte)(unorm.x * 255.0f);
-            dst[1] = (byte)(unorm.y * 255.0f);
-            dst[2] = (byte)(unorm.z * 255.0f);
-          }
-          else if(buf565)
-          {
-            uint16_t *src565 = (uint16_t *)src;
-            Vec3f unorm = ConvertFromB5G6R5(*src565);
-            dst[0] = (byte)(unorm.z * 255.0f);
-            dst[1] = (byte)(unorm.y * 255.0f);
-            dst[2] = (byte)(unorm.x * 255.0f);
-          }
-          else if(buf5551)
-          {
-            uint16_t *src5551 = (uint16_t *)src;
-            Vec4f unorm = ConvertFromB5G5R5A1(*src5551);
-            dst[0] = (byte)(unorm.z * 255.0f);
-            dst[1] = (byte)(unorm.y * 255.0f);
-            dst[2] = (byte)(unorm.x * 255.0f);
-          }
-          else if(bufBGRA)
-          {
-            dst[0] = src[2];
-            dst[1] = src[1];
-            dst[2] = src[0];
-          }
-          else if(fmt.compByteWidth == 2)    // R16G16B16A16 backbuffer
-          {
-            uint16_t *src16 = (uint16_t *)src;
-
-            float linearR = RDCCLAMP(ConvertFromHalf(src16[0]), 0.0f, 1.0f);
-            float linearG = RDCCLAMP(ConvertFromHalf(src16[1]), 0.0f, 1.0f);
-            float linearB = RDCCLAMP(ConvertFromHalf(src16[2]), 0.0f, 1.0f);
-
-            if(linearR < 0.0031308f)
-              dst[0] = byte(255.0f * (12.92f * linearR));
-            else
-              dst[0] = byte(255.0f * (1.055f * powf(linearR, 1.0f / 2.4f) - 0.055f));
-
-            if(linearG < 0.0031308f)
-              dst[1] = byte(255.0f * (12.92f * linearG));
-            else
-              dst[1] = byte(255.0f * (1.055f * powf(linearG, 1.0f / 2.4f) - 0.055f));
-
-            if(linearB < 0.0031308f)
-              dst[2] = byte(255.0f * (12.92f * linearB));
-            else
-              dst[2] = byte(255.0f * (1.055f * powf(linearB, 1.0f / 2.4f) - 0.055f));
-          }
-          else
-          {
-            dst[0] = src[0];
-            dst[1] = src[1];
-            dst[2] = src[2];
-          }
+          dst[0] = pData[0];
+          dst[1] = pData[1];
+          dst[2] = pData[2];
 
           dst += 3;
+          pData += 4;
         }
-      }
-    }
-
-    vt->UnmapMemory(Unwrap(device), readbackMem);
-
-    // delete all
-    vt->DestroyImage(Unwrap(device), readbackIm, NULL);
-    vt->FreeMemory(Unwrap(device), readbackMem, NULL);
-  }
-
-  byte *jpgbuf = NULL;
-  int len = thwidth * thheight;
-
-  if(wnd)
-  {
-    jpgbuf = new byte[len];
-
-    jpge::params p;
-    p.m_quality = 80;
 
-    bool success =
-        jpge::compress_image_to_jpeg_file_in_memory(jpgbuf, len, thwidth, thheight, 3, thpixels, p);
+        vt->UnmapMemory(Unwrap(device), readbackMem);
+      }
 
-    if(!success)
-    {
-      RDCERR("Failed to compress to jpg");
-      SAFE_DELETE_ARRAY(jpgbuf);
-      thwidth = 0;
-      thheight = 0;
+      // delete all
+      vt->DestroyImage(Unwrap(device), thumbIm, NULL);
+      vt->FreeMemory(Unwrap(device), thumbMem, NULL);
+      vt->DestroyBuffer(Unwrap(device), readbackBuf, NULL);
+      vt->FreeMemory(Unwrap(device), readbackMem, NULL);
     }
   }
 
-  Serialiser *m_pFileSerialiser = RenderDoc::Inst().OpenWriteSerialiser(
-      m_FrameCounter, &m_InitParams, jpgbuf, len, thwidth, thheight);
+  Serialiser *m_pFileSerialiser =
+      RenderDoc::Inst().OpenWriteSerialiser(m_FrameCounter, &m_InitParams);
 
   {
     CACHE_THREAD_SERIALISER();
@@ -1592,16 +1558,19 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
     RDCDEBUG("Done");
   }
 
-  m_pFileSerialiser->FlushToDisk();
+  // compression and disk writes happen on the capture writer thread, which takes ownership of
+  // the serialiser and its own references to any chunks it doesn't already own.
+  // The thumbnail pixels are handed over too, to be JPEG compressed there.
+  RenderDoc::Inst().QueueCaptureWrite(m_pFileSerialiser, m_FrameCounter, thpixels, thwidth,
+                                      thheight);
+  m_pFileSerialiser = NULL;
+  thpixels = NULL;
 
-  RenderDoc::Inst().SuccessfullyWrittenLog(m_FrameCounter);
-
-  SAFE_DELETE(m_pFileSerialiser);
   SAFE_DELETE(m_HeaderChunk);
 
   m_State = WRITING_IDLE;
 
-  // delete cmd buffers now - had to keep them alive until after serialiser flush.
+  // delete cmd buffers now - had to keep them alive until after the serialiser was queued.
   for(size_t i = 0; i < m_CmdBufferRecords.size(); i++)
     m_CmdBufferRecords[i]->Delete(GetResourceManager());
 
@@ -1629,7 +1598,21 @@ void WrappedVulkan::ReadLogInitialisation()
 
   m_pSerialiser->Rewind();
 
-  while(!m_pSerialiser->AtEnd())
+  // the chunk index already lists where every capture scope is, so there's no need to read any
+  // chunk headers to find them
+  const vector<Serialiser::ChunkIndexEntry> &chunkIndex = m_pSerialiser->GetChunkIndex();
+
+  for(size_t i = 0; i < chunkIndex.size(); i++)
+  {
+    if(chunkIndex[i].chunkType == CAPTURE_SCOPE)
+    {
+      lastFrame = chunkIndex[i].offset;
+      if(firstFrame == 0)
+        firstFrame = chunkIndex[i].offset;
+    }
+  }
+
+  while(chunkIndex.empty() && !m_pSerialiser->AtEnd())
   {
     m_pSerialiser->SkipToChunk(CAPTURE_SCOPE);
 
@@ -1807,6 +1790,23 @@ void WrappedVulkan::ContextReplayLog(LogState readType, uint32_t startEventID, u
 
     ContextProcessChunk(offset, context);
 
+    if(m_State == READING)
+    {
+      // command buffer recordings are inserted contiguously ahead of their submit, so note where
+      // each one ends for skipping on later replays.
+      if(context == BEGIN_CMD_BUFFER)
+        m_CmdBufferRecordBegin = offset;
+      else if(context == END_CMD_BUFFER)
+        m_CmdBufferRecordEnds[m_CmdBufferRecordBegin] = m_pSerialiser->GetOffset();
+    }
+    else if(m_CmdBufferSkipTo != 0)
+    {
+      // none of the chunks up to the end would do anything, so don't decode them. The END chunk
+      // would only reset curEventID, which the BEGIN chunk already did.
+      m_pSerialiser->SetOffset(m_CmdBufferSkipTo);
+      m_CmdBufferSkipTo = 0;
+    }
+
     RenderDoc::Inst().SetProgress(FileInitialRead, float(offset) / float(m_pSerialiser->GetSize()));
 
     // for now just abort after capture scope. Really we'd need to support multiple frames
@@ -2874,7 +2874,10 @@ void WrappedVulkan::AddUsage(VulkanDrawcallTreeNode &drawNode, vector<DebugMessa
     const vector<BakedCmdBufferInfo::CmdBufferState::DescriptorAndOffsets> &descSets =
         (shad == 5 ? state.computeDescSets : state.graphicsDescSets);
 
-    RDCASSERT(sh.mapping);
+    ShaderBindpointMapping *mapping = sh.GetMapping();
+    ShaderReflection *refl = sh.GetReflection();
+
+    RDCASSERT(mapping);
 
     struct ResUsageType
     {
@@ -2884,9 +2887,9 @@ void WrappedVulkan::AddUsage(VulkanDrawcallTreeNode &drawNode, vector<DebugMessa
     };
 
     ResUsageType types[] = {
-        ResUsageType(sh.mapping->ReadOnlyResources, eUsage_VS_Resource),
-        ResUsageType(sh.mapping->ReadWriteResources, eUsage_VS_RWResource),
-        ResUsageType(sh.mapping->ConstantBlocks, eUsage_VS_Constants),
+        ResUsageType(mapping->ReadOnlyResources, eUsage_VS_Resource),
+        ResUsageType(mapping->ReadWriteResources, eUsage_VS_RWResource),
+        ResUsageType(mapping->ConstantBlocks, eUsage_VS_Constants),
     };
 
     DebugMessage msg;
@@ -2904,7 +2907,7 @@ void WrappedVulkan::AddUsage(VulkanDrawcallTreeNode &drawNode, vector<DebugMessa
           continue;
 
         // ignore push constants
-        if(t == 2 && !sh.refl->ConstantBlocks[i].bufferBacked)
+        if(t == 2 && !refl->ConstantBlocks[i].bufferBacked)
           continue;
 
         int32_t bindset = types[t].bindmap[i].bindset;
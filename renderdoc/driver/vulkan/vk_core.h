@@ -368,6 +368,23 @@ private:
     // -> FlushQ() ----back to freesems-------^
   } m_InternalCmds;
 
+  // initial state readbacks are recorded into batches which are submitted without waiting. Each
+  // batch's temporary objects and command buffers are kept until its fence has been waited on.
+  struct InitStateBatch
+  {
+    InitStateBatch() : fence(VK_NULL_HANDLE), numResources(0), byteSize(0) {}
+    VkFence fence;
+    vector<VkCommandBuffer> cmds;
+    vector<VkBuffer> bufferDeletes;
+    vector<VkImage> imageDeletes;
+    vector<VkDeviceMemory> memoryDeletes;
+    uint32_t numResources;
+    VkDeviceSize byteSize;
+  };
+
+  // the batch currently being recorded, and the previously submitted batch still on the GPU
+  InitStateBatch m_InitStateRecording, m_InitStateInFlight;
+
   vector<VkDeviceMemory> m_CleanupMems;
   vector<VkEvent> m_CleanupEvents;
 
@@ -436,6 +453,15 @@ private:
   // handled.
   ResourceId m_LastCmdBufferID;
 
+  // file offset of each in-frame BEGIN_CMD_BUFFER chunk -> the offset just past its
+  // matching END_CMD_BUFFER. Built on the first read, and used while executing to
+  // jump over recordings that won't be re-recorded instead of decoding every chunk.
+  map<uint64_t, uint64_t> m_CmdBufferRecordEnds;
+  uint64_t m_CmdBufferRecordBegin;
+
+  // set by vkBeginCommandBuffer when the rest of the recording can be skipped
+  uint64_t m_CmdBufferSkipTo;
+
   // this is a list of uint64_t file offset -> uint32_t EIDs of where each
   // drawcall is used. E.g. the drawcall at offset 873954 is EID 50. If a
   // command buffer is submitted more than once, there may be more than
@@ -612,6 +638,11 @@ private:
 
   // replay
 
+  void AddInitStateBatchWork(VkDeviceSize byteSize);
+  void SubmitInitStateBatch();
+  void ReleaseInitStateBatch(InitStateBatch &batch);
+  void FlushInitStateBatches();
+
   bool Prepare_SparseInitialState(WrappedVkBuffer *buf);
   bool Prepare_SparseInitialState(WrappedVkImage *im);
   bool Serialise_SparseBufferInitialState(ResourceId id,
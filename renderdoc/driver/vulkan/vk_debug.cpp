@@ -2721,6 +2721,9 @@ void VulkanDebugManager::ReplaceResource(ResourceId from, ResourceId to)
 {
   VkDevice dev = m_pDriver->GetDev();
 
+  // a replaced shader can move the vertices, so the picking BVH must be rebuilt
+  m_MeshPickBVH.Clear();
+
   // we're passed in the original ID but we want the live ID for comparison
   ResourceId liveid = GetResourceManager()->GetLiveID(from);
 
@@ -2797,6 +2800,8 @@ void VulkanDebugManager::RemoveReplacement(ResourceId id)
 {
   VkDevice dev = m_pDriver->GetDev();
 
+  m_MeshPickBVH.Clear();
+
   // we're passed in the original ID but we want the live ID for comparison
   ResourceId liveid = GetResourceManager()->GetLiveID(id);
 
@@ -3945,6 +3950,71 @@ FloatVector VulkanDebugManager::InterpretVertex(byte *data, uint32_t vert, const
   return ret;
 }
 
+void VulkanDebugManager::GetMeshPickData(const MeshDisplay &cfg, vector<FloatVector> &positions,
+                                         vector<uint32_t> &idxs)
+{
+  idxs.clear();
+  positions.clear();
+
+  if(cfg.position.idxByteWidth && cfg.position.idxbuf != ResourceId())
+  {
+    vector<byte> idxdata;
+    GetBufferData(cfg.position.idxbuf, cfg.position.idxoffs, 0, idxdata);
+
+    if(!idxdata.empty())
+    {
+      idxs.resize(cfg.position.numVerts, 0);
+
+      // if indices are 16-bit, manually upcast them so we only have to deal with one type
+      if(cfg.position.idxByteWidth == 2)
+      {
+        uint16_t *idxs16 = (uint16_t *)&idxdata[0];
+        size_t bufsize = idxdata.size() / 2;
+
+        for(uint32_t i = 0; i < bufsize && i < cfg.position.numVerts; i++)
+          idxs[i] = idxs16[i];
+      }
+      else
+      {
+        size_t bufsize = idxdata.size() / 4;
+
+        memcpy(&idxs[0], &idxdata[0],
+               RDCMIN(bufsize, (size_t)cfg.position.numVerts) * sizeof(uint32_t));
+      }
+    }
+  }
+
+  // unpack and linearise the data
+  vector<byte> oldData;
+  GetBufferData(cfg.position.buf, cfg.position.offset, 0, oldData);
+
+  positions.resize(cfg.position.numVerts);
+
+  byte *data = oldData.empty() ? NULL : &oldData[0];
+  byte *dataEnd = data + oldData.size();
+
+  bool valid = true;
+
+  uint32_t idxclamp = 0;
+  if(cfg.position.baseVertex < 0)
+    idxclamp = uint32_t(-cfg.position.baseVertex);
+
+  for(uint32_t i = 0; i < cfg.position.numVerts; i++)
+  {
+    uint32_t idx = i;
+
+    // apply baseVertex but clamp to 0 (don't allow index to become negative)
+    if(idx < idxclamp)
+      idx = 0;
+    else if(cfg.position.baseVertex < 0)
+      idx -= idxclamp;
+    else if(cfg.position.baseVertex > 0)
+      idx += cfg.position.baseVertex;
+
+    positions[i] = InterpretVertex(data, idx, cfg, dataEnd, valid);
+  }
+}
+
 // TODO: Point meshes don't pick correctly
 uint32_t VulkanDebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg, uint32_t x,
                                         uint32_t y, uint32_t w, uint32_t h)
@@ -4034,6 +4104,24 @@ uint32_t VulkanDebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg
     }
   }
 
+  // triangle meshes are picked on the CPU against a BVH that's built the first time the mesh is
+  // picked, and kept until a different mesh or event is picked.
+  if(MeshPickBVH::SupportsTopology(cfg.position.topo))
+  {
+    if(!m_MeshPickBVH.Matches(eventID, cfg.position))
+    {
+      vector<uint32_t> idxs;
+      vector<FloatVector> positions;
+
+      GetMeshPickData(cfg, positions, idxs);
+
+      // the picking shader flips Y on unprojected positions, match it
+      m_MeshPickBVH.Build(eventID, cfg.position, positions, idxs, true);
+    }
+
+    return m_MeshPickBVH.Pick(rayPos, rayDir);
+  }
+
   MeshPickUBOData *ubo = (MeshPickUBOData *)m_MeshPickUBO.Map();
 
   ubo->rayPos = rayPos;
@@ -4084,10 +4172,10 @@ uint32_t VulkanDebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg
 
   m_MeshPickUBO.Unmap();
 
-  vector<byte> idxs;
+  vector<uint32_t> idxs;
+  vector<FloatVector> positions;
 
-  if(cfg.position.idxByteWidth && cfg.position.idxbuf != ResourceId())
-    GetBufferData(cfg.position.idxbuf, cfg.position.idxoffs, 0, idxs);
+  GetMeshPickData(cfg, positions, idxs);
 
   // We copy into our own buffers to promote to the target type (uint32) that the
   // shader expects. Most IBs will be 16-bit indices, most VBs will not be float4.
@@ -4113,25 +4201,7 @@ uint32_t VulkanDebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg
     uint32_t *outidxs = (uint32_t *)m_MeshPickIBUpload.Map();
 
     memset(outidxs, 0, m_MeshPickIBSize);
-
-    uint16_t *idxs16 = (uint16_t *)&idxs[0];
-    uint32_t *idxs32 = (uint32_t *)&idxs[0];
-
-    // if indices are 16-bit, manually upcast them so the shader only
-    // has to deal with one type
-    if(cfg.position.idxByteWidth == 2)
-    {
-      size_t bufsize = idxs.size() / 2;
-
-      for(uint32_t i = 0; i < bufsize && i < cfg.position.numVerts; i++)
-        outidxs[i] = idxs16[i];
-    }
-    else
-    {
-      size_t bufsize = idxs.size() / 4;
-
-      memcpy(outidxs, idxs32, RDCMIN(bufsize, cfg.position.numVerts * sizeof(uint32_t)));
-    }
+    memcpy(outidxs, &idxs[0], idxs.size() * sizeof(uint32_t));
 
     m_MeshPickIBUpload.Unmap();
   }
@@ -4151,39 +4221,9 @@ uint32_t VulkanDebugManager::PickVertex(uint32_t eventID, const MeshDisplay &cfg
     m_MeshPickVBUpload.Create(m_pDriver, dev, m_MeshPickVBSize, 1, 0);
   }
 
-  // unpack and linearise the data
-  {
-    vector<byte> oldData;
-    GetBufferData(cfg.position.buf, cfg.position.offset, 0, oldData);
-
-    byte *data = &oldData[0];
-    byte *dataEnd = data + oldData.size();
-
-    bool valid = true;
-
-    FloatVector *vbData = (FloatVector *)m_MeshPickVBUpload.Map();
-
-    uint32_t idxclamp = 0;
-    if(cfg.position.baseVertex < 0)
-      idxclamp = uint32_t(-cfg.position.baseVertex);
-
-    for(uint32_t i = 0; i < cfg.position.numVerts; i++)
-    {
-      uint32_t idx = i;
-
-      // apply baseVertex but clamp to 0 (don't allow index to become negative)
-      if(idx < idxclamp)
-        idx = 0;
-      else if(cfg.position.baseVertex < 0)
-        idx -= idxclamp;
-      else if(cfg.position.baseVertex > 0)
-        idx += cfg.position.baseVertex;
-
-      vbData[i] = InterpretVertex(data, idx, cfg, dataEnd, valid);
-    }
-
-    m_MeshPickVBUpload.Unmap();
-  }
+  FloatVector *vbData = (FloatVector *)m_MeshPickVBUpload.Map();
+  memcpy(vbData, &positions[0], positions.size() * sizeof(FloatVector));
+  m_MeshPickVBUpload.Unmap();
 
   VkDescriptorBufferInfo ibInfo = {};
   VkDescriptorBufferInfo vbInfo = {};
@@ -7924,7 +7964,7 @@ void VulkanDebugManager::InitPostVSBuffers(uint32_t eventID)
   const VulkanCreationInfo::ShaderModule &moduleInfo =
       creationInfo.m_ShaderModule[pipeInfo.shaders[0].module];
 
-  ShaderReflection *refl = pipeInfo.shaders[0].refl;
+  ShaderReflection *refl = pipeInfo.shaders[0].GetReflection();
 
   // no outputs from this shader? unexpected but theoretically possible (dummy VS before
   // tessellation maybe). Just fill out an empty data set
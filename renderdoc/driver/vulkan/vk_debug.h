@@ -26,6 +26,7 @@
 
 #include "api/replay/renderdoc_replay.h"
 #include "core/core.h"
+#include "replay/mesh_pick.h"
 #include "replay/replay_driver.h"
 #include "vk_common.h"
 #include "vk_core.h"
@@ -319,6 +320,7 @@ public:
   VkDescriptorSet m_MeshPickDescSet;
   VkPipelineLayout m_MeshPickLayout;
   VkPipeline m_MeshPickPipeline;
+  MeshPickBVH m_MeshPickBVH;
 
   VkDescriptorSetLayout m_OutlineDescSetLayout;
   VkPipelineLayout m_OutlinePipeLayout;
@@ -357,6 +359,9 @@ private:
 
   void PatchFixedColShader(VkShaderModule &mod, float col[4]);
 
+  void GetMeshPickData(const MeshDisplay &cfg, vector<FloatVector> &positions,
+                       vector<uint32_t> &idxs);
+
   void RenderTextInternal(const TextPrintState &textstate, float x, float y, const char *text);
   static const uint32_t FONT_TEX_WIDTH = 256;
   static const uint32_t FONT_TEX_HEIGHT = 128;
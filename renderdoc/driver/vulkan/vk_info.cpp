@@ -111,8 +111,6 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
     {
       reflData.entryPoint = shad.entryPoint;
       reflData.stage = stageIndex;
-      info.m_ShaderModule[id].spirv.MakeReflection(reflData.entryPoint, &reflData.refl,
-                                                   &reflData.mapping);
     }
 
     if(pCreateInfo->pStages[i].pSpecializationInfo)
@@ -133,8 +131,7 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
       }
     }
 
-    shad.refl = &reflData.refl;
-    shad.mapping = &reflData.mapping;
+    shad.moduleInfo = &info.m_ShaderModule[id];
   }
 
   if(pCreateInfo->pVertexInputState)
@@ -323,11 +320,7 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
     ShaderModule::Reflection &reflData = info.m_ShaderModule[id].m_Reflections[shad.entryPoint];
 
     if(reflData.entryPoint.empty())
-    {
       reflData.entryPoint = shad.entryPoint;
-      info.m_ShaderModule[id].spirv.MakeReflection(reflData.entryPoint, &reflData.refl,
-                                                   &reflData.mapping);
-    }
 
     if(pCreateInfo->stage.pSpecializationInfo)
     {
@@ -345,8 +338,7 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
       }
     }
 
-    shad.refl = &reflData.refl;
-    shad.mapping = &reflData.mapping;
+    shad.moduleInfo = &info.m_ShaderModule[id];
   }
 
   topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -560,6 +552,37 @@ void VulkanCreationInfo::ImageView::Init(VulkanResourceManager *resourceMan, Vul
   swizzle[3] = Convert(pCreateInfo->components.a, 3);
 }
 
+ShaderReflection *VulkanCreationInfo::Pipeline::Shader::GetReflection() const
+{
+  if(moduleInfo == NULL)
+    return NULL;
+
+  return &moduleInfo->GetReflection(entryPoint).refl;
+}
+
+ShaderBindpointMapping *VulkanCreationInfo::Pipeline::Shader::GetMapping() const
+{
+  if(moduleInfo == NULL)
+    return NULL;
+
+  return &moduleInfo->GetReflection(entryPoint).mapping;
+}
+
+VulkanCreationInfo::ShaderModule::Reflection &VulkanCreationInfo::ShaderModule::GetReflection(
+    const string &entryPoint)
+{
+  Reflection &reflData = m_Reflections[entryPoint];
+
+  if(!reflData.populated)
+  {
+    reflData.populated = true;
+    reflData.entryPoint = entryPoint;
+    spirv.MakeReflection(entryPoint, &reflData.refl, &reflData.mapping);
+  }
+
+  return reflData;
+}
+
 void VulkanCreationInfo::ShaderModule::Init(VulkanResourceManager *resourceMan,
                                             VulkanCreationInfo &info,
                                             const VkShaderModuleCreateInfo *pCreateInfo)
@@ -62,6 +62,8 @@ struct DescSetLayout
 
 struct VulkanCreationInfo
 {
+  struct ShaderModule;
+
   struct Pipeline
   {
     void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
@@ -79,11 +81,16 @@ struct VulkanCreationInfo
     // VkPipelineShaderStageCreateInfo
     struct Shader
     {
-      Shader() : refl(NULL), mapping(NULL) {}
+      Shader() : moduleInfo(NULL) {}
       ResourceId module;
       string entryPoint;
-      ShaderReflection *refl;
-      ShaderBindpointMapping *mapping;
+
+      // the module's reflection for this entry point. Built on first use, these return NULL
+      // if the stage isn't used in this pipeline
+      ShaderReflection *GetReflection() const;
+      ShaderBindpointMapping *GetMapping() const;
+
+      ShaderModule *moduleInfo;
 
       vector<byte> specdata;
       struct SpecInfo
@@ -329,11 +336,18 @@ struct VulkanCreationInfo
 
     struct Reflection
     {
+      Reflection() : stage(0), populated(false) {}
       uint32_t stage;
       string entryPoint;
       ShaderReflection refl;
       ShaderBindpointMapping mapping;
+      bool populated;
     };
+
+    // returns the reflection for an entry point, which is only generated (and the SPIR-V only
+    // parsed) the first time it's requested.
+    Reflection &GetReflection(const string &entryPoint);
+
     map<string, Reflection> m_Reflections;
   };
   map<ResourceId, ShaderModule> m_ShaderModule;
@@ -34,12 +34,14 @@
 // VKTODOLOW The code pattern for creating a few contiguous arrays all in one
 // AllocAlignedBuffer for the initial contents buffer is ugly.
 
-// VKTODOLOW in general we do a lot of "create buffer, use it, flush/sync then destroy".
-// I don't know what the exact cost is, but it would be nice to batch up the buffers/etc
-// used across init state use, and only do a single flush. Also we could then get some
-// nice command buffer reuse (although need to be careful we don't create too large a
-// command buffer that stalls the GPU).
-// See INITSTATEBATCH
+// INITSTATEBATCH: on capture the readbacks for initial states are batched rather than doing a
+// submit and a full queue flush for every resource. Command buffers for each resource are left
+// pending, and submitted together once enough resources or bytes have been recorded. We only wait
+// for the previous batch when submitting the next one, so the CPU work of preparing one batch
+// overlaps with the GPU copies of the last. Temporary buffers/images are destroyed once the batch
+// that uses them has completed, and everything is flushed at the end of PrepareInitialContents.
+static const uint32_t InitStateBatchMaxResources = 256;
+static const VkDeviceSize InitStateBatchMaxBytes = 64 * 1024 * 1024;
 
 struct MemIDOffset
 {
@@ -86,6 +88,90 @@ struct SparseImageInitState
   VkDeviceSize totalSize;
 };
 
+void WrappedVulkan::AddInitStateBatchWork(VkDeviceSize byteSize)
+{
+  m_InitStateRecording.numResources++;
+  m_InitStateRecording.byteSize += byteSize;
+
+  if(m_InitStateRecording.numResources >= InitStateBatchMaxResources ||
+     m_InitStateRecording.byteSize >= InitStateBatchMaxBytes)
+    SubmitInitStateBatch();
+}
+
+void WrappedVulkan::SubmitInitStateBatch()
+{
+  VkDevice d = GetDev();
+
+  if(m_InitStateRecording.numResources == 0 && m_InternalCmds.pendingcmds.empty())
+    return;
+
+  m_InitStateRecording.cmds = m_InternalCmds.pendingcmds;
+
+  SubmitCmds();
+
+  // an empty submit with a fence signals once everything previously submitted has completed
+  if(m_Queue != VK_NULL_HANDLE)
+  {
+    VkFenceCreateInfo fenceInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, NULL, 0};
+
+    VkResult vkr =
+        ObjDisp(d)->CreateFence(Unwrap(d), &fenceInfo, NULL, &m_InitStateRecording.fence);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    vkr = ObjDisp(m_Queue)->QueueSubmit(Unwrap(m_Queue), 0, NULL, m_InitStateRecording.fence);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
+
+  // the previous batch has had the whole time this one was being recorded to complete, so waiting
+  // for it now should rarely stall.
+  ReleaseInitStateBatch(m_InitStateInFlight);
+
+  m_InitStateInFlight = m_InitStateRecording;
+  m_InitStateRecording = InitStateBatch();
+}
+
+void WrappedVulkan::ReleaseInitStateBatch(InitStateBatch &batch)
+{
+  VkDevice d = GetDev();
+
+  if(batch.fence != VK_NULL_HANDLE)
+  {
+    VkResult vkr = ObjDisp(d)->WaitForFences(Unwrap(d), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    ObjDisp(d)->DestroyFence(Unwrap(d), batch.fence, NULL);
+  }
+
+  for(size_t i = 0; i < batch.bufferDeletes.size(); i++)
+    ObjDisp(d)->DestroyBuffer(Unwrap(d), batch.bufferDeletes[i], NULL);
+
+  for(size_t i = 0; i < batch.imageDeletes.size(); i++)
+    ObjDisp(d)->DestroyImage(Unwrap(d), batch.imageDeletes[i], NULL);
+
+  for(size_t i = 0; i < batch.memoryDeletes.size(); i++)
+    ObjDisp(d)->FreeMemory(Unwrap(d), batch.memoryDeletes[i], NULL);
+
+  // recycle the batch's command buffers, unless a FlushQ() in between already did
+  for(size_t i = 0; i < batch.cmds.size(); i++)
+  {
+    auto it = std::find(m_InternalCmds.submittedcmds.begin(), m_InternalCmds.submittedcmds.end(),
+                        batch.cmds[i]);
+    if(it != m_InternalCmds.submittedcmds.end())
+    {
+      m_InternalCmds.submittedcmds.erase(it);
+      m_InternalCmds.freecmds.push_back(batch.cmds[i]);
+    }
+  }
+
+  batch = InitStateBatch();
+}
+
+void WrappedVulkan::FlushInitStateBatches()
+{
+  SubmitInitStateBatch();
+  ReleaseInitStateBatch(m_InitStateInFlight);
+}
+
 bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
 {
   ResourceId id = buf->id;
@@ -204,11 +290,9 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
-
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), bufdeletes[i], NULL);
+  m_InitStateRecording.bufferDeletes.insert(m_InitStateRecording.bufferDeletes.end(),
+                                            bufdeletes.begin(), bufdeletes.end());
+  AddInitStateBatchWork(info->totalSize);
 
   GetResourceManager()->SetInitialContents(
       id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), 0, (byte *)info));
@@ -379,11 +463,9 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
   // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
-
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), bufdeletes[i], NULL);
+  m_InitStateRecording.bufferDeletes.insert(m_InitStateRecording.bufferDeletes.end(),
+                                            bufdeletes.begin(), bufdeletes.end());
+  AddInitStateBatchWork(state->totalSize);
 
   GetResourceManager()->SetInitialContents(
       id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), 0, (byte *)blob));
@@ -1290,17 +1372,16 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
-
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), dstBuf, NULL);
+    m_InitStateRecording.bufferDeletes.push_back(dstBuf);
 
     if(arrayIm != VK_NULL_HANDLE)
     {
-      ObjDisp(d)->DestroyImage(Unwrap(d), arrayIm, NULL);
-      ObjDisp(d)->FreeMemory(Unwrap(d), arrayMem, NULL);
+      m_InitStateRecording.imageDeletes.push_back(arrayIm);
+      m_InitStateRecording.memoryDeletes.push_back(arrayMem);
     }
 
+    AddInitStateBatchWork(mrq.size);
+
     GetResourceManager()->SetInitialContents(
         id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), (uint32_t)mrq.size,
                                                       NULL));
@@ -1383,11 +1464,10 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
     // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
+    m_InitStateRecording.bufferDeletes.push_back(srcBuf);
+    m_InitStateRecording.bufferDeletes.push_back(dstBuf);
 
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), srcBuf, NULL);
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), dstBuf, NULL);
+    AddInitStateBatchWork(datasize);
 
     GetResourceManager()->SetInitialContents(
         id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), (uint32_t)datasize,
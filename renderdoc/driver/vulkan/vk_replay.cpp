@@ -912,20 +912,20 @@ ShaderReflection *VulkanReplay::GetShader(ResourceId shader, string entryPoint)
     return NULL;
   }
 
-  // disassemble lazily on demand
-  if(shad->second.m_Reflections[entryPoint].refl.Disassembly.count == 0)
-    shad->second.m_Reflections[entryPoint].refl.Disassembly =
-        shad->second.spirv.Disassemble(entryPoint);
+  // reflect and disassemble lazily on demand
+  ShaderReflection &refl = shad->second.GetReflection(entryPoint).refl;
 
-  if(shad->second.m_Reflections[entryPoint].refl.RawBytes.count == 0 &&
-     !shad->second.spirv.spirv.empty())
+  if(refl.Disassembly.count == 0)
+    refl.Disassembly = shad->second.spirv.Disassemble(entryPoint);
+
+  if(refl.RawBytes.count == 0 && !shad->second.spirv.spirv.empty())
   {
-    rdctype::array<byte> &bytes = shad->second.m_Reflections[entryPoint].refl.RawBytes;
+    rdctype::array<byte> &bytes = refl.RawBytes;
     const vector<uint32_t> &spirv = shad->second.spirv.spirv;
     create_array_init(bytes, spirv.size() * sizeof(uint32_t), (byte *)&spirv[0]);
   }
 
-  return &shad->second.m_Reflections[entryPoint].refl;
+  return &refl;
 }
 
 void VulkanReplay::PickPixel(ResourceId texture, uint32_t x, uint32_t y, uint32_t sliceFace,
@@ -3197,8 +3197,8 @@ void VulkanReplay::SavePipelineState()
         }
 
         stage.stage = eShaderStage_Compute;
-        if(p.shaders[i].mapping)
-          stage.BindpointMapping = *p.shaders[i].mapping;
+        if(p.shaders[i].GetMapping())
+          stage.BindpointMapping = *p.shaders[i].GetMapping();
 
         create_array_uninit(stage.specialization, p.shaders[i].specialization.size());
         for(size_t s = 0; s < p.shaders[i].specialization.size(); s++)
@@ -3267,8 +3267,8 @@ void VulkanReplay::SavePipelineState()
         }
 
         stages[i]->stage = ShaderStageType(eShaderStage_Vertex + i);
-        if(p.shaders[i].mapping)
-          stages[i]->BindpointMapping = *p.shaders[i].mapping;
+        if(p.shaders[i].GetMapping())
+          stages[i]->BindpointMapping = *p.shaders[i].GetMapping();
 
         create_array_uninit(stages[i]->specialization, p.shaders[i].specialization.size());
         for(size_t s = 0; s < p.shaders[i].specialization.size(); s++)
@@ -3958,8 +3958,10 @@ void VulkanReplay::FillCBufferVariables(ResourceId shader, string entryPoint, ui
     return;
   }
 
-  ShaderReflection &refl = it->second.m_Reflections[entryPoint].refl;
-  ShaderBindpointMapping &mapping = it->second.m_Reflections[entryPoint].mapping;
+  VulkanCreationInfo::ShaderModule::Reflection &reflData = it->second.GetReflection(entryPoint);
+
+  ShaderReflection &refl = reflData.refl;
+  ShaderBindpointMapping &mapping = reflData.mapping;
 
   if(cbufSlot >= (uint32_t)refl.ConstantBlocks.count)
   {
@@ -4000,8 +4002,7 @@ void VulkanReplay::FillCBufferVariables(ResourceId shader, string entryPoint, ui
 
         if(pipeIt != m_pDriver->m_CreationInfo.m_Pipeline.end())
         {
-          auto specInfo =
-              pipeIt->second.shaders[it->second.m_Reflections[entryPoint].stage].specialization;
+          auto specInfo = pipeIt->second.shaders[reflData.stage].specialization;
 
           // find any actual values specified
           for(size_t i = 0; i < specInfo.size(); i++)
@@ -4540,7 +4541,7 @@ struct VulkanInitPostVSCallback : public VulkanDrawcallCallback
   ~VulkanInitPostVSCallback() { m_pDriver->SetDrawcallCB(NULL); }
   void PreDraw(uint32_t eid, VkCommandBuffer cmd)
   {
-    if(std::find(m_Events.begin(), m_Events.end(), eid) != m_Events.end())
+    if(std::binary_search(m_Events.begin(), m_Events.end(), eid))
       m_pDriver->GetDebugManager()->InitPostVSBuffers(eid);
   }
 
@@ -4554,30 +4555,29 @@ struct VulkanInitPostVSCallback : public VulkanDrawcallCallback
   void PreMisc(uint32_t eid, DrawcallFlags flags, VkCommandBuffer cmd) {}
   bool PostMisc(uint32_t eid, DrawcallFlags flags, VkCommandBuffer cmd) { return false; }
   void PostRemisc(uint32_t eid, DrawcallFlags flags, VkCommandBuffer cmd) {}
-  bool RecordAllCmds() { return false; }
+  bool RecordAllCmds() { return true; }
   void AliasEvent(uint32_t primary, uint32_t alias)
   {
-    if(std::find(m_Events.begin(), m_Events.end(), primary) != m_Events.end())
+    if(std::binary_search(m_Events.begin(), m_Events.end(), primary))
       m_pDriver->GetDebugManager()->AliasPostVSBuffers(primary, alias);
   }
 
   WrappedVulkan *m_pDriver;
+  // sorted, so draws can be looked up quickly even when fetching a whole frame's worth
   const vector<uint32_t> &m_Events;
 };
 
 void VulkanReplay::InitPostVSBuffers(const vector<uint32_t> &events)
 {
-  // first we must replay up to the first event without replaying it. This ensures any
-  // non-command buffer calls like memory unmaps etc all happen correctly before this
-  // command buffer
-  m_pDriver->ReplayLog(0, events.front(), eReplay_WithoutDraw);
+  if(events.empty())
+    return;
 
+  // the events can come from any number of command buffers and submissions, so rather than
+  // replaying up to each one in turn we re-record every command buffer and fetch the data for all
+  // of them in a single replay of the frame.
   VulkanInitPostVSCallback cb(m_pDriver, events);
 
-  // now we replay the events, which are guaranteed (because we generated them in
-  // GetPassEvents above) to come from the same command buffer, so the event IDs are
-  // still locally continuous, even if we jump into replaying.
-  m_pDriver->ReplayLog(events.front(), events.back(), eReplay_Full);
+  m_pDriver->ReplayLog(0, events.back(), eReplay_Full);
 }
 
 vector<EventUsage> VulkanReplay::GetUsage(ResourceId id)
@@ -138,6 +138,12 @@ struct TypedRealHandle
   bool operator!=(const TypedRealHandle o) const { return !(*this == o); }
 };
 
+// only hash the handle, NULL handles compare equal regardless of type
+inline uint64_t ResourceHash(const TypedRealHandle &h)
+{
+  return ResourceHashMix(h.real.handle);
+}
+
 struct WrappedVkNonDispRes : public WrappedVkRes
 {
   template <typename T>
@@ -568,6 +568,14 @@ bool WrappedVulkan::Serialise_vkBeginCommandBuffer(Serialiser *localSerialiser,
 
       ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &info);
     }
+    else if(!ShouldRerecordCmd(cmdId))
+    {
+      // every command in this recording would be parsed and then discarded, so skip straight
+      // past the end of it.
+      auto it = m_CmdBufferRecordEnds.find(m_CurChunkOffset);
+      if(it != m_CmdBufferRecordEnds.end())
+        m_CmdBufferSkipTo = it->second;
+    }
 
     m_BakedCmdBufferInfo[cmdId].curEventID = 0;
   }
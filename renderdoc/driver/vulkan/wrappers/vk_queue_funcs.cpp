@@ -732,7 +732,7 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
           continue;
         }
 
-        size_t diffStart = 0, diffEnd = 0;
+        vector<DiffRange> ranges;
         bool found = true;
 
 // enabled as this is necessary for programs with very large coherent mappings
@@ -745,7 +745,7 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
         // the buffer and whenever we then copy into the ref data, e.g. below.
         // during this time, data could be written to the buffer and it won't have
         // been caught in the serialised snapshot, and if it doesn't change then
-        // it *also* won't be caught in any future FindDiffRange() calls.
+        // it *also* won't be caught in any future FindDiffRanges() calls.
         //
         // Likewise once refData is allocated, the call below will also update it
         // with the data serialised out for the same reason.
@@ -761,11 +761,14 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
         // if we have a previous set of data, compare.
         // otherwise just serialise it all
         if(state.refData)
-          found = FindDiffRange((byte *)state.mappedPtr, state.refData, (size_t)state.mapSize,
-                                diffStart, diffEnd);
+          found = FindDiffRanges(state.mappedPtr + (size_t)state.mapOffset, state.refData,
+                                 (size_t)state.mapSize, DiffRangeGranularity, ranges);
         else
 #endif
-          diffEnd = (size_t)state.mapSize;
+        {
+          DiffRange all = {0, (size_t)state.mapSize};
+          ranges.push_back(all);
+        }
 
         if(found)
         {
@@ -774,12 +777,22 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
           VkDevice dev = GetDev();
 
           {
-            RDCLOG("Persistent map flush forced for %llu (%llu -> %llu)", record->GetResourceID(),
-                   (uint64_t)diffStart, (uint64_t)diffEnd);
-            VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL,
-                                         (VkDeviceMemory)(uint64_t)record->Resource,
-                                         state.mapOffset + diffStart, diffEnd - diffStart};
-            vkFlushMappedMemoryRanges(dev, 1, &range);
+            RDCLOG("Persistent map flush forced for %llu (%llu -> %llu in %u ranges)",
+                   record->GetResourceID(), (uint64_t)ranges.front().start,
+                   (uint64_t)ranges.back().end, (uint32_t)ranges.size());
+
+            // flush only the modified ranges, each is serialised separately
+            vector<VkMappedMemoryRange> flushRanges(ranges.size());
+            for(size_t r = 0; r < ranges.size(); r++)
+            {
+              VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL,
+                                           (VkDeviceMemory)(uint64_t)record->Resource,
+                                           state.mapOffset + ranges[r].start,
+                                           ranges[r].end - ranges[r].start};
+              flushRanges[r] = range;
+            }
+
+            vkFlushMappedMemoryRanges(dev, (uint32_t)flushRanges.size(), &flushRanges[0]);
             state.mapFlushed = false;
           }
 
@@ -549,7 +549,8 @@ bool WrappedVulkan::Serialise_vkUnmapMemory(Serialiser *localSerialiser, VkDevic
 
   SERIALISE_ELEMENT(uint64_t, memOffset, state->mapOffset);
   SERIALISE_ELEMENT(uint64_t, memSize, state->mapSize);
-  SERIALISE_ELEMENT_BUF(byte *, data, (byte *)state->mappedPtr + state->mapOffset, (size_t)memSize);
+  SERIALISE_ELEMENT_BUF_INPLACE(byte *, data, (byte *)state->mappedPtr + state->mapOffset,
+                                (size_t)memSize);
 
   if(m_State < WRITING)
   {
@@ -570,8 +571,6 @@ bool WrappedVulkan::Serialise_vkUnmapMemory(Serialiser *localSerialiser, VkDevic
 
       ObjDisp(device)->UnmapMemory(Unwrap(device), Unwrap(mem));
     }
-
-    SAFE_DELETE_ARRAY(data);
   }
 
   return true;
@@ -677,7 +676,8 @@ bool WrappedVulkan::Serialise_vkFlushMappedMemoryRanges(Serialiser *localSeriali
 
   SERIALISE_ELEMENT(uint64_t, memOffset, pMemRanges->offset);
   SERIALISE_ELEMENT(uint64_t, memSize, memRangeSize);
-  SERIALISE_ELEMENT_BUF(byte *, data, state->mappedPtr + (size_t)memOffset, (size_t)memSize);
+  SERIALISE_ELEMENT_BUF_INPLACE(byte *, data, state->mappedPtr + (size_t)memOffset,
+                                (size_t)memSize);
 
   // if we need to save off this serialised buffer as reference for future comparison,
   // do so now. See the call to vkFlushMappedMemoryRanges in WrappedVulkan::vkQueueSubmit()
@@ -685,8 +685,8 @@ bool WrappedVulkan::Serialise_vkFlushMappedMemoryRanges(Serialiser *localSeriali
   {
     if(!state->refData)
     {
-      // if we're in this case, the range should be for the whole memory region.
-      RDCASSERT(memOffset == 0 && memSize == state->mapSize);
+      // if we're in this case, the range should be for the whole mapped region.
+      RDCASSERT(memOffset == state->mapOffset && memSize == state->mapSize);
 
       // allocate ref data so we can compare next time to minimise serialised data
       state->refData = Serialiser::AllocAlignedBuffer((size_t)state->mapSize);
@@ -699,7 +699,13 @@ bool WrappedVulkan::Serialise_vkFlushMappedMemoryRanges(Serialiser *localSeriali
 
     byte *serialisedData = localSerialiser->GetRawPtr(offs);
 
-    memcpy(state->refData, serialisedData + (size_t)memOffset, (size_t)memSize);
+    // the ref data covers the mapped region, which the flushed range must lie within
+    if(memOffset >= state->mapOffset && memOffset + memSize <= state->mapOffset + state->mapSize)
+      memcpy(state->refData + (size_t)(memOffset - state->mapOffset), serialisedData,
+             (size_t)memSize);
+    else
+      RDCERR("Flushed range %llu -> %llu is outside the mapped range %llu -> %llu", memOffset,
+             memOffset + memSize, state->mapOffset, state->mapOffset + state->mapSize);
   }
 
   if(m_State < WRITING)
@@ -721,8 +727,6 @@ bool WrappedVulkan::Serialise_vkFlushMappedMemoryRanges(Serialiser *localSeriali
 
       ObjDisp(device)->UnmapMemory(Unwrap(device), Unwrap(mem));
     }
-
-    SAFE_DELETE_ARRAY(data);
   }
 
   return true;
@@ -25,6 +25,7 @@
 
 #include "os/os_specific.h"
 #include <stdarg.h>
+#include "common/threading.h"
 #include "serialise/string_utils.h"
 
 using std::string;
@@ -127,6 +128,216 @@ int Wide2UTF8(wchar_t chr, char mbchr[4])
 
 };    // namespace StringFormat
 
+namespace Threading
+{
+struct ParallelForData
+{
+  ParallelEntry entryFunc;
+  void *userData;
+  int32_t count;
+  volatile int32_t next;
+
+  // the below are protected by the pool lock. The number of pool workers currently inside this
+  // job, and whether the caller has finished its share and is waiting for them to leave
+  int32_t workers;
+  bool finished;
+  Semaphore workersDone;
+};
+
+// workers are created the first time they're needed and then kept around, so that short parallel
+// loops don't pay for thread creation every time. Waiting jobs are handed to whichever workers are
+// idle, which also means nested or concurrent ParallelFor calls share the same threads.
+struct ParallelForPool
+{
+  CriticalSection lock;
+  Semaphore wake;
+  vector<ThreadHandle> threads;
+  vector<ParallelForData *> jobs;
+  bool shutdown;
+};
+
+static ParallelForPool *parallelPool = NULL;
+static CriticalSection parallelPoolCreateLock;
+
+static uint64_t parallelRegionSlot = AllocateTLSSlot();
+
+bool InParallelRegion()
+{
+  return GetTLSValue(parallelRegionSlot) != NULL;
+}
+
+void SetInParallelRegion(bool inRegion)
+{
+  SetTLSValue(parallelRegionSlot, inRegion ? (void *)1 : NULL);
+}
+
+static void ParallelForWorker(ParallelForData *work)
+{
+  for(;;)
+  {
+    // Inc32 returns the post-increment value
+    int32_t idx = Atomic::Inc32(&work->next) - 1;
+
+    if(idx >= work->count)
+      return;
+
+    work->entryFunc(work->userData, (uint32_t)idx);
+  }
+}
+
+static void ParallelForPoolThread(void *data)
+{
+  ParallelForPool *pool = (ParallelForPool *)data;
+
+  SetInParallelRegion(true);
+
+  for(;;)
+  {
+    pool->wake.WaitForWake();
+
+    ParallelForData *job = NULL;
+
+    {
+      SCOPED_LOCK(pool->lock);
+
+      if(pool->shutdown)
+        return;
+
+      // pick the oldest job that still has indices left to hand out
+      for(size_t i = 0; i < pool->jobs.size(); i++)
+      {
+        if(pool->jobs[i]->next < pool->jobs[i]->count)
+        {
+          job = pool->jobs[i];
+          job->workers++;
+          break;
+        }
+      }
+    }
+
+    if(job == NULL)
+      continue;
+
+    ParallelForWorker(job);
+
+    {
+      SCOPED_LOCK(pool->lock);
+
+      job->workers--;
+      if(job->workers == 0 && job->finished)
+        job->workersDone.Wake();
+    }
+  }
+}
+
+static ParallelForPool *GetParallelForPool()
+{
+  // only one thread can create the pool, any others racing see it once it's filled in
+  SCOPED_LOCK(parallelPoolCreateLock);
+
+  if(parallelPool)
+    return parallelPool;
+
+  ParallelForPool *pool = new ParallelForPool();
+  pool->shutdown = false;
+
+  // the calling thread always does work too, so one fewer thread than cores
+  for(uint32_t i = 1; i < NumberOfCores(); i++)
+  {
+    ThreadHandle thread = CreateThread(&ParallelForPoolThread, pool);
+    if(thread)
+      pool->threads.push_back(thread);
+  }
+
+  parallelPool = pool;
+
+  return pool;
+}
+
+void ParallelFor(uint32_t count, ParallelEntry entryFunc, void *userData)
+{
+  if(count == 0)
+    return;
+
+  // nothing to share, or every core is already busy with the outer loop. Skip the pool entirely
+  if(count == 1 || NumberOfCores() == 1 || InParallelRegion())
+  {
+    for(uint32_t i = 0; i < count; i++)
+      entryFunc(userData, i);
+    return;
+  }
+
+  ParallelForPool *pool = GetParallelForPool();
+
+  ParallelForData work;
+  work.entryFunc = entryFunc;
+  work.userData = userData;
+  work.count = (int32_t)count;
+  work.next = 0;
+  work.workers = 0;
+  work.finished = false;
+
+  {
+    SCOPED_LOCK(pool->lock);
+    pool->jobs.push_back(&work);
+  }
+
+  pool->wake.Wake((uint32_t)RDCMIN(pool->threads.size(), size_t(count - 1)));
+
+  SetInParallelRegion(true);
+  ParallelForWorker(&work);
+  SetInParallelRegion(false);
+
+  // every index has been handed out by now, but workers may still be running their last one.
+  bool wait = false;
+
+  {
+    SCOPED_LOCK(pool->lock);
+
+    for(size_t i = 0; i < pool->jobs.size(); i++)
+    {
+      if(pool->jobs[i] == &work)
+      {
+        pool->jobs.erase(pool->jobs.begin() + i);
+        break;
+      }
+    }
+
+    work.finished = true;
+    wait = work.workers > 0;
+  }
+
+  if(wait)
+    work.workersDone.WaitForWake();
+}
+
+void ShutdownParallelFor()
+{
+  SCOPED_LOCK(parallelPoolCreateLock);
+
+  ParallelForPool *pool = parallelPool;
+
+  if(pool == NULL)
+    return;
+
+  {
+    SCOPED_LOCK(pool->lock);
+    pool->shutdown = true;
+  }
+
+  pool->wake.Wake((uint32_t)pool->threads.size());
+
+  for(size_t i = 0; i < pool->threads.size(); i++)
+  {
+    JoinThread(pool->threads[i]);
+    CloseThread(pool->threads[i]);
+  }
+
+  parallelPool = NULL;
+  delete pool;
+}
+};    // namespace Threading
+
 string Callstack::AddressDetails::formattedString(const char *commonPath)
 {
   char fmt[512] = {0};
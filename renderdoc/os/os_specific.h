@@ -124,6 +124,26 @@ private:
   data m_Data;
 };
 
+// counting semaphore, for threads to block until another thread wakes them
+template <class data>
+class SemaphoreTemplate
+{
+public:
+  SemaphoreTemplate();
+  ~SemaphoreTemplate();
+  void Wake(uint32_t count = 1);
+  void WaitForWake();
+  // returns false if the timeout passed without being woken
+  bool WaitForWake(uint32_t timeoutMS);
+
+private:
+  // no copying
+  SemaphoreTemplate &operator=(const SemaphoreTemplate &other);
+  SemaphoreTemplate(const SemaphoreTemplate &other);
+
+  data m_Data;
+};
+
 void Init();
 void Shutdown();
 uint64_t AllocateTLSSlot();
@@ -131,7 +151,7 @@ uint64_t AllocateTLSSlot();
 void *GetTLSValue(uint64_t slot);
 void SetTLSValue(uint64_t slot, void *value);
 
-// must typedef CriticalSectionTemplate<X> CriticalSection
+// must typedef CriticalSectionTemplate<X> CriticalSection and SemaphoreTemplate<Y> Semaphore
 
 typedef void (*ThreadEntry)(void *);
 typedef uint64_t ThreadHandle;
@@ -141,6 +161,23 @@ void JoinThread(ThreadHandle handle);
 void CloseThread(ThreadHandle handle);
 void Sleep(uint32_t milliseconds);
 
+// number of logical processors available, always at least 1
+uint32_t NumberOfCores();
+
+// calls entryFunc(userData, i) for every i in [0, count), spread across up to NumberOfCores()
+// threads including the calling thread. Returns once every index has been processed. Indices are
+// handed out one at a time so uneven amounts of work still balance out.
+// If the calling thread is already inside a parallel region, the loop runs serially on it.
+typedef void (*ParallelEntry)(void *userData, uint32_t idx);
+void ParallelFor(uint32_t count, ParallelEntry entryFunc, void *userData);
+// threads that are one of several running work side-by-side mark themselves as being inside a
+// parallel region, so that any ParallelFor they call doesn't multiply the number of busy threads.
+// ParallelFor does this itself for the threads it runs on.
+bool InParallelRegion();
+void SetInParallelRegion(bool inRegion);
+// stops and joins the persistent worker threads used by ParallelFor, if they were ever started
+void ShutdownParallelFor();
+
 // kind of windows specific, to handle this case:
 // http://blogs.msdn.com/b/oldnewthing/archive/2013/11/05/10463645.aspx
 void KeepModuleAlive();
@@ -158,12 +195,16 @@ public:
 
   bool Connected() const;
 
-  Socket *AcceptClient(bool wait);
+  // waits up to timeoutMS for a pending connection, 0 returns immediately
+  Socket *AcceptClient(uint32_t timeoutMS);
 
   uint32_t GetRemoteIP() const;
 
   bool IsRecvDataWaiting();
 
+  // sleeps until data arrives or timeoutMS passes, then behaves as IsRecvDataWaiting()
+  bool WaitForRecvData(uint32_t timeoutMS);
+
   bool SendDataBlocking(const void *buf, uint32_t length);
   bool RecvDataBlocking(void *data, uint32_t length);
 
@@ -211,6 +252,7 @@ int64_t Inc64(volatile int64_t *i);
 int64_t Dec64(volatile int64_t *i);
 int64_t ExchAdd64(volatile int64_t *i, int64_t a);
 int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal);
+int64_t CmpExch64(volatile int64_t *dest, int64_t oldVal, int64_t newVal);
 };
 
 namespace Callstack
@@ -240,6 +282,13 @@ class StackResolver
 public:
   virtual ~StackResolver() {}
   virtual AddressDetails GetAddr(uint64_t addr) = 0;
+
+  // resolve many addresses at once, which lets implementations batch up expensive lookups
+  virtual void GetAddrs(const uint64_t *addrs, size_t num, AddressDetails *details)
+  {
+    for(size_t i = 0; i < num; i++)
+      details[i] = GetAddr(addrs[i]);
+  }
 };
 
 void Init();
@@ -268,6 +317,8 @@ string GetFullPathname(const string &filename);
 void GetExecutableFilename(string &selfName);
 
 uint64_t GetModifiedTimestamp(const string &filename);
+// sets the modified timestamp of an existing file to the current time
+void Touch(const string &filename);
 
 void Copy(const char *from, const char *to, bool allowOverwrite);
 void Delete(const char *path);
@@ -309,6 +360,12 @@ bool feof(FILE *f);
 
 int fclose(FILE *f);
 
+// map the first size bytes of an open file read-only into memory. Returns NULL if the file can't
+// be mapped, in which case the caller should fall back to reading through the FILE*. The mapping
+// remains valid after the file is closed, until it is released with funmap.
+const void *fmap(FILE *f, uint64_t size);
+void funmap(const void *ptr, uint64_t size);
+
 // functions for atomically appending to a log that may be in use in multiple
 // processes
 void *logfile_open(const char *filename);
@@ -383,6 +440,10 @@ namespace OSUtility
 inline void ForceCrash();
 inline void DebugBreak();
 bool DebuggerPresent();
+// alignment must be a power of two, at least sizeof(void *). The memory must be freed with
+// AlignedFree. Returns NULL on failure.
+inline void *AlignedAlloc(size_t size, size_t alignment);
+inline void AlignedFree(void *ptr);
 enum
 {
   Output_DebugMon,
@@ -23,15 +23,178 @@
  ******************************************************************************/
 
 #include <execinfo.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <map>
 #include <vector>
+#include "common/threading.h"
 #include "os/os_specific.h"
+#include "os/posix/linux/linux_symbols.h"
 
 void *renderdocBase = NULL;
 void *renderdocEnd = NULL;
 
+// per-thread stack extents, so frame pointers can be checked before they're followed. They're
+// freed by the key's destructor when the thread exits.
+struct StackBounds
+{
+  uintptr_t lo;
+  uintptr_t hi;
+};
+
+static pthread_key_t stackBoundsKey;
+static bool stackBoundsKeyValid = false;
+
+static void FreeStackBounds(void *bounds)
+{
+  delete (StackBounds *)bounds;
+}
+
+static StackBounds *GetStackBounds()
+{
+  StackBounds *bounds = (StackBounds *)pthread_getspecific(stackBoundsKey);
+
+  if(bounds)
+    return bounds;
+
+  bounds = new StackBounds();
+  bounds->lo = bounds->hi = 0;
+
+  pthread_attr_t attr;
+  if(pthread_getattr_np(pthread_self(), &attr) == 0)
+  {
+    void *addr = NULL;
+    size_t size = 0;
+
+    if(pthread_attr_getstack(&attr, &addr, &size) == 0)
+    {
+      bounds->lo = (uintptr_t)addr;
+      bounds->hi = (uintptr_t)addr + size;
+    }
+
+    pthread_attr_destroy(&attr);
+  }
+
+  pthread_setspecific(stackBoundsKey, bounds);
+
+  return bounds;
+}
+
+// executable mappings in the process, sorted by address. Every return address found by walking
+// frame pointers must point into one of these, otherwise we've followed something that isn't
+// really a frame pointer.
+struct ExecutableRange
+{
+  uintptr_t lo;
+  uintptr_t hi;
+  bool operator==(const ExecutableRange &o) const { return lo == o.lo && hi == o.hi; }
+};
+
+// walks read the current list without locking. It's never modified once published, a refresh
+// builds a new list under executableRangesLock and swaps the pointer.
+static Threading::CriticalSection executableRangesLock;
+static const std::vector<ExecutableRange> *executableRanges = NULL;
+static uint64_t executableRangesTick = 0;
+
+// don't re-read the mappings more often than this looking for newly loaded modules
+static const double ExecutableRangesRefreshMS = 1000.0;
+
+static void ReadExecutableRanges(std::vector<ExecutableRange> &ranges)
+{
+  FILE *f = FileIO::fopen("/proc/self/maps", "r");
+
+  if(f == NULL)
+    return;
+
+  while(!feof(f))
+  {
+    char line[512] = {0};
+    if(fgets(line, 511, f))
+    {
+      void *lo = NULL, *hi = NULL;
+      char perms[5] = {0};
+
+      if(sscanf(line, "%p-%p %4s", &lo, &hi, perms) == 3 && perms[2] == 'x')
+      {
+        ExecutableRange range = {(uintptr_t)lo, (uintptr_t)hi};
+        ranges.push_back(range);
+      }
+    }
+  }
+
+  FileIO::fclose(f);
+}
+
+static bool ExecutableRangesStale()
+{
+  uint64_t tick = __atomic_load_n(&executableRangesTick, __ATOMIC_RELAXED);
+
+  return double(Timing::GetTick() - tick) / Timing::GetTickFrequency() >= ExecutableRangesRefreshMS;
+}
+
+static void RefreshExecutableRanges(bool force)
+{
+  SCOPED_LOCK(executableRangesLock);
+
+  // another thread may have refreshed them while we waited for the lock
+  if(!force && !ExecutableRangesStale())
+    return;
+
+  __atomic_store_n(&executableRangesTick, Timing::GetTick(), __ATOMIC_RELAXED);
+
+  std::vector<ExecutableRange> *ranges = new std::vector<ExecutableRange>();
+  ReadExecutableRanges(*ranges);
+
+  // most refreshes are from code without frame pointers rather than a newly loaded module, and
+  // find nothing has changed
+  if(executableRanges && *executableRanges == *ranges)
+  {
+    delete ranges;
+    return;
+  }
+
+  // walks on other threads may still be reading the old list, so it's never freed. That only
+  // happens when the executable mappings change, i.e. when modules are loaded or unloaded.
+  __atomic_store_n(&executableRanges, ranges, __ATOMIC_RELEASE);
+}
+
+static bool IsInExecutableRange(uintptr_t addr)
+{
+  const std::vector<ExecutableRange> *ranges = __atomic_load_n(&executableRanges, __ATOMIC_ACQUIRE);
+
+  if(ranges == NULL)
+    return false;
+
+  // the maps file lists mappings in address order, so find the last one starting at or before addr
+  size_t lo = 0, hi = ranges->size();
+  while(lo < hi)
+  {
+    size_t mid = (lo + hi) / 2;
+    if((*ranges)[mid].lo <= addr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo > 0 && addr < (*ranges)[lo - 1].hi;
+}
+
+static bool IsExecutableAddress(uintptr_t addr)
+{
+  if(IsInExecutableRange(addr))
+    return true;
+
+  // the address might be in a module loaded since we last looked
+  if(!ExecutableRangesStale())
+    return false;
+
+  RefreshExecutableRanges(false);
+
+  return IsInExecutableRange(addr);
+}
+
 class LinuxCallstack : public Callstack::Stackwalk
 {
 public:
@@ -55,7 +218,76 @@ public:
 private:
   LinuxCallstack(const Callstack::Stackwalk &other);
 
+  // if walking frame pointers finds fewer frames than this outside of renderdoc, assume the
+  // application wasn't built with them and fall back to a full unwind
+  enum
+  {
+    MinFramePointerLevels = 2,
+  };
+
   void Collect()
+  {
+    if(!CollectFramePointers() || numLevels < MinFramePointerLevels)
+      CollectBacktrace();
+  }
+
+  // walk the chain of saved frame pointers. This is far cheaper than backtrace(), which unwinds
+  // using the exception tables, but only sees through code that keeps a frame pointer. Each frame
+  // is checked to be inside this thread's stack and above the last, so a register that isn't
+  // really a frame pointer will end the walk rather than crash it. Code built without frame
+  // pointers can still leave a plausible looking chain, so if any return address doesn't point
+  // into executable code the walk is abandoned and false is returned.
+  bool CollectFramePointers()
+  {
+    numLevels = 0;
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+    if(!stackBoundsKeyValid)
+      return false;
+
+    // frame records on all of these are the caller's frame pointer followed by the return address
+    const StackBounds *bounds = GetStackBounds();
+    const uintptr_t *frame = (const uintptr_t *)__builtin_frame_address(0);
+
+    while(numLevels < (int)ARRAY_COUNT(addrs))
+    {
+      uintptr_t fp = (uintptr_t)frame;
+
+      if(fp < bounds->lo || fp + 2 * sizeof(uintptr_t) > bounds->hi ||
+         (fp & (sizeof(uintptr_t) - 1)) != 0)
+        break;
+
+      uintptr_t ret = frame[1];
+
+      if(ret == 0)
+        break;
+
+      if(!IsExecutableAddress(ret))
+      {
+        numLevels = 0;
+        return false;
+      }
+
+      // skip our own frames at the top of the stack
+      if(numLevels > 0 || (void *)ret < renderdocBase || (void *)ret >= renderdocEnd)
+        addrs[numLevels++] = (uint64_t)ret;
+
+      const uintptr_t *next = (const uintptr_t *)frame[0];
+
+      // callers are always further up the stack
+      if(next <= frame)
+        break;
+
+      frame = next;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void CollectBacktrace()
   {
     void *addrs_ptr[ARRAY_COUNT(addrs)];
 
@@ -82,6 +314,12 @@ namespace Callstack
 {
 void Init()
 {
+  stackBoundsKeyValid = (pthread_key_create(&stackBoundsKey, &FreeStackBounds) == 0);
+  if(!stackBoundsKeyValid)
+    RDCWARN("Couldn't allocate TLS key for stack bounds, callstacks will always use backtrace()");
+
+  RefreshExecutableRanges(true);
+
   // look for our own line
   FILE *f = FileIO::fopen("/proc/self/maps", "r");
 
@@ -151,82 +389,379 @@ struct LookupModule
 {
   uint64_t base;
   uint64_t end;
+  // file offset the mapping starts at
+  uint64_t offset;
+  // subtracted from a runtime address to get the module's own virtual address
+  uint64_t bias;
   char path[2048];
+  // hex GNU build-id, identifies the exact binary for the on-disk symbol cache. Empty if the
+  // module doesn't have one, in which case nothing is persisted for it.
+  char buildID[128];
 };
 
+typedef std::pair<uint64_t, Callstack::AddressDetails> CachedAddress;
+
+// version the cache files so we can change the format without misinterpreting old files
+static const char symbolCacheHeader[] = "RDOCSYMS3";
+
+// every binary that's ever been resolved gets a cache file, so the folder is trimmed back to this
+// size by deleting the files for the least recently used binaries.
+static const uint64_t MaxSymbolCacheFolderSize = 64 * 1024 * 1024;
+
+static string GetSymbolCacheFilename(const char *buildID)
+{
+  return FileIO::GetAppFolderFilename(StringFormat::Fmt("symbolcache/%s.txt", buildID));
+}
+
+static bool LeastRecentlyUsed(const FileIO::FoundFile &a, const FileIO::FoundFile &b)
+{
+  return a.lastmod < b.lastmod;
+}
+
+static void TrimSymbolCacheFolder()
+{
+  string folder = FileIO::GetAppFolderFilename("symbolcache");
+
+  vector<FileIO::FoundFile> files = FileIO::GetFilesInDirectory(folder.c_str());
+
+  uint64_t total = 0;
+
+  for(size_t i = 0; i < files.size(); i++)
+    total += files[i].size;
+
+  if(total <= MaxSymbolCacheFolderSize)
+    return;
+
+  std::sort(files.begin(), files.end(), LeastRecentlyUsed);
+
+  for(size_t i = 0; i < files.size() && total > MaxSymbolCacheFolderSize; i++)
+  {
+    if(files[i].flags & FileIO::eFileProp_Directory)
+      continue;
+
+    FileIO::Delete((folder + "/" + files[i].filename).c_str());
+    total -= files[i].size;
+  }
+}
+
+static bool CachedAddressLess(const CachedAddress &a, const CachedAddress &b)
+{
+  return a.first < b.first;
+}
+
+static bool CachedAddressEqual(const CachedAddress &a, const CachedAddress &b)
+{
+  return a.first == b.first;
+}
+
+static string FormatSymbolCacheLine(uint64_t relative, const Callstack::AddressDetails &details)
+{
+  return StringFormat::Fmt("%llx\t%u\t%s\t%s\n", relative, details.line, details.function.c_str(),
+                           details.filename.c_str());
+}
+
+// replaces the whole file, used to drop duplicate entries
+static void RewriteSymbolCache(const char *buildID, const std::vector<CachedAddress> &cached)
+{
+  string contents = symbolCacheHeader;
+  contents += "\n";
+
+  for(size_t i = 0; i < cached.size(); i++)
+    contents += FormatSymbolCacheLine(cached[i].first, cached[i].second);
+
+  FILE *f = FileIO::fopen(GetSymbolCacheFilename(buildID).c_str(), "wb");
+
+  if(f == NULL)
+    return;
+
+  FileIO::fwrite(contents.c_str(), 1, contents.size(), f);
+
+  FileIO::fclose(f);
+}
+
+// each cached line is "relative\tline\tfunction\tfilename", with filename last so it can contain
+// anything up to the end of the line.
+static void LoadSymbolCache(const char *buildID, std::vector<CachedAddress> &cached)
+{
+  FILE *f = FileIO::fopen(GetSymbolCacheFilename(buildID).c_str(), "rb");
+
+  if(f == NULL)
+    return;
+
+  FileIO::fseek64(f, 0, SEEK_END);
+  uint64_t size = FileIO::ftell64(f);
+  FileIO::fseek64(f, 0, SEEK_SET);
+
+  string contents;
+  contents.resize((size_t)size);
+  if(size > 0)
+    contents.resize(FileIO::fread(&contents[0], 1, (size_t)size, f));
+
+  FileIO::fclose(f);
+
+  char *search = &contents[0];
+  char *fileEnd = search + contents.size();
+
+  if(contents.compare(0, sizeof(symbolCacheHeader) - 1, symbolCacheHeader) != 0)
+  {
+    // remove it so it's recreated with the current header on the next append
+    RDCWARN("Discarding symbol cache for build-id %s with unrecognised header", buildID);
+    FileIO::Delete(GetSymbolCacheFilename(buildID).c_str());
+    return;
+  }
+
+  while(search < fileEnd)
+  {
+    char *lineEnd = (char *)memchr(search, '\n', fileEnd - search);
+    if(lineEnd == NULL)
+      break;
+    *lineEnd = 0;
+
+    unsigned long long relative = 0;
+    unsigned int line = 0;
+    int offs = 0;
+    if(sscanf(search, "%llx\t%u\t%n", &relative, &line, &offs) == 2 && offs > 0)
+    {
+      char *function = search + offs;
+      char *filename = strchr(function, '\t');
+
+      if(filename)
+      {
+        *filename = 0;
+        filename++;
+
+        CachedAddress entry;
+        entry.first = (uint64_t)relative;
+        entry.second.function = function;
+        entry.second.filename = filename;
+        entry.second.line = (uint32_t)line;
+        cached.push_back(entry);
+      }
+    }
+
+    search = lineEnd + 1;
+  }
+
+  // several processes resolving the same binary at once can each append the same addresses, so
+  // rewrite the file without the duplicates if that's happened. Otherwise just mark it as recently
+  // used, so it's not trimmed.
+  size_t numLoaded = cached.size();
+
+  std::sort(cached.begin(), cached.end(), CachedAddressLess);
+  cached.erase(std::unique(cached.begin(), cached.end(), CachedAddressEqual), cached.end());
+
+  if(cached.size() < numLoaded)
+    RewriteSymbolCache(buildID, cached);
+  else
+    FileIO::Touch(GetSymbolCacheFilename(buildID));
+}
+
+static void AppendSymbolCache(const char *buildID, const uint64_t *relative,
+                              const Callstack::AddressDetails *details, size_t num)
+{
+  string filename = GetSymbolCacheFilename(buildID);
+
+  FileIO::CreateParentDirectory(filename);
+
+  FILE *f = FileIO::fopen(filename.c_str(), "ab");
+
+  if(f == NULL)
+    return;
+
+  string contents;
+
+  if(FileIO::ftell64(f) == 0)
+  {
+    contents = symbolCacheHeader;
+    contents += "\n";
+  }
+
+  for(size_t i = 0; i < num; i++)
+    contents += FormatSymbolCacheLine(relative[i], details[i]);
+
+  // write everything at once so that concurrent appends from other processes don't interleave
+  FileIO::fwrite(contents.c_str(), 1, contents.size(), f);
+
+  FileIO::fclose(f);
+}
+
+struct ModulePrepare
+{
+  LookupModule mod;
+  ElfSymbols *symbols;
+  std::vector<CachedAddress> cached;
+};
+
+static void PrepareModule(void *userData, uint32_t idx)
+{
+  ModulePrepare &prep = ((ModulePrepare *)userData)[idx];
+  LookupModule &mod = prep.mod;
+
+  prep.symbols = new ElfSymbols();
+
+  uint64_t address = 0;
+
+  if(!prep.symbols->Open(mod.path) || !prep.symbols->FileOffsetToAddress(mod.offset, address))
+  {
+    SAFE_DELETE(prep.symbols);
+    return;
+  }
+
+  mod.bias = mod.base - address;
+
+  const std::string &buildID = prep.symbols->GetBuildID();
+
+  if(buildID.size() < ARRAY_COUNT(mod.buildID))
+    memcpy(mod.buildID, buildID.c_str(), buildID.size() + 1);
+
+  if(mod.buildID[0])
+    LoadSymbolCache(mod.buildID, prep.cached);
+}
+
+// the addresses to resolve within one module
+struct ResolveBatch
+{
+  ElfSymbols *symbols;
+  std::vector<uint64_t> relative;
+  std::vector<Callstack::AddressDetails> details;
+  // parallel to relative, whether the lookup found anything
+  std::vector<byte> found;
+};
+
+static void ResolveBatchAddrs(void *userData, uint32_t idx)
+{
+  ResolveBatch &batch = ((ResolveBatch *)userData)[idx];
+
+  // parsing the tables is the expensive part, each module is only ever in one batch at a time
+  batch.symbols->BuildIndex();
+
+  batch.found.resize(batch.relative.size());
+
+  for(size_t i = 0; i < batch.relative.size(); i++)
+    batch.found[i] = batch.symbols->Lookup(batch.relative[i], batch.details[i]) ? 1 : 0;
+}
+
 class LinuxResolver : public Callstack::StackResolver
 {
 public:
-  LinuxResolver(vector<LookupModule> modules) { m_Modules = modules; }
-  Callstack::AddressDetails GetAddr(uint64_t addr)
+  LinuxResolver(const vector<LookupModule> &modules, const vector<ElfSymbols *> &symbols,
+                const vector<CachedAddress> *cached)
   {
-    EnsureCached(addr);
+    m_Modules = modules;
+    m_Symbols = symbols;
 
-    return m_Cache[addr];
+    // cached addresses are relative to the module, so rebase them for this capture
+    for(size_t m = 0; m < m_Modules.size(); m++)
+      for(size_t i = 0; i < cached[m].size(); i++)
+        m_Cache[m_Modules[m].bias + cached[m][i].first] = cached[m][i].second;
   }
 
-private:
-  void EnsureCached(uint64_t addr)
+  ~LinuxResolver()
   {
-    auto it = m_Cache.insert(
-        std::pair<uint64_t, Callstack::AddressDetails>(addr, Callstack::AddressDetails()));
-    if(!it.second)
-      return;
+    for(size_t m = 0; m < m_Symbols.size(); m++)
+      delete m_Symbols[m];
+  }
+
+  Callstack::AddressDetails GetAddr(uint64_t addr)
+  {
+    Callstack::AddressDetails ret;
+    GetAddrs(&addr, 1, &ret);
+    return ret;
+  }
 
-    Callstack::AddressDetails &ret = it.first->second;
+  void GetAddrs(const uint64_t *addrs, size_t num, Callstack::AddressDetails *details)
+  {
+    SCOPED_LOCK(m_Lock);
 
-    ret.filename = "Unknown";
-    ret.line = 0;
-    ret.function = StringFormat::Fmt("0x%08llx", addr);
+    EnsureCached(addrs, num);
 
-    for(size_t i = 0; i < m_Modules.size(); i++)
+    for(size_t i = 0; i < num; i++)
+      details[i] = m_Cache[addrs[i]];
+  }
+
+private:
+  void EnsureCached(const uint64_t *addrs, size_t num)
+  {
+    std::map<size_t, std::vector<uint64_t> > moduleAddrs;
+
+    for(size_t a = 0; a < num; a++)
     {
-      if(addr >= m_Modules[i].base && addr < m_Modules[i].end)
-      {
-        uint64_t relative = addr - m_Modules[i].base;
-        string cmd =
-            StringFormat::Fmt("addr2line -j.text -fCe \"%s\" 0x%llx", m_Modules[i].path, relative);
+      uint64_t addr = addrs[a];
 
-        FILE *f = ::popen(cmd.c_str(), "r");
+      auto it = m_Cache.insert(CachedAddress(addr, Callstack::AddressDetails()));
+      if(!it.second)
+        continue;
 
-        char result[2048] = {0};
-        fread(result, 1, 2047, f);
+      Callstack::AddressDetails &ret = it.first->second;
 
-        fclose(f);
+      ret.filename = "Unknown";
+      ret.line = 0;
+      ret.function = StringFormat::Fmt("0x%08llx", addr);
 
-        char *line2 = strchr(result, '\n');
-        if(line2)
+      for(size_t i = 0; i < m_Modules.size(); i++)
+      {
+        if(addr >= m_Modules[i].base && addr < m_Modules[i].end)
         {
-          *line2 = 0;
-          line2++;
+          moduleAddrs[i].push_back(addr - m_Modules[i].bias);
+          break;
         }
+      }
+    }
 
-        ret.function = result;
+    if(moduleAddrs.empty())
+      return;
 
-        if(line2)
-        {
-          char *last = line2 + strlen(line2) - 1;
-          uint32_t mul = 1;
-          ret.line = 0;
-          while(*last >= '0' && *last <= '9')
-          {
-            ret.line += mul * (uint32_t(*last) - uint32_t('0'));
-            *last = 0;
-            last--;
-            mul *= 10;
-          }
-          if(*last == ':')
-            *last = 0;
+    std::vector<ResolveBatch> batches;
+    std::vector<size_t> batchModules;
 
-          ret.filename = line2;
-        }
+    for(auto it = moduleAddrs.begin(); it != moduleAddrs.end(); ++it)
+    {
+      const LookupModule &mod = m_Modules[it->first];
+
+      ResolveBatch batch;
+      batch.symbols = m_Symbols[it->first];
+      batch.relative.swap(it->second);
+      // anything not found keeps the placeholder details
+      batch.details.resize(batch.relative.size());
+      for(size_t j = 0; j < batch.relative.size(); j++)
+        batch.details[j] = m_Cache[mod.bias + batch.relative[j]];
+      batches.push_back(batch);
+      batchModules.push_back(it->first);
+    }
 
-        break;
+    Threading::ParallelFor((uint32_t)batches.size(), &ResolveBatchAddrs, &batches[0]);
+
+    for(size_t b = 0; b < batches.size(); b++)
+    {
+      const ResolveBatch &batch = batches[b];
+      const LookupModule &mod = m_Modules[batchModules[b]];
+
+      // failed lookups keep their placeholder in memory, but aren't persisted. Otherwise they'd
+      // hide the real details once symbols become available for the same binary.
+      std::vector<uint64_t> persistRelative;
+      std::vector<Callstack::AddressDetails> persistDetails;
+
+      for(size_t i = 0; i < batch.relative.size(); i++)
+      {
+        m_Cache[mod.bias + batch.relative[i]] = batch.details[i];
+
+        if(batch.found[i])
+        {
+          persistRelative.push_back(batch.relative[i]);
+          persistDetails.push_back(batch.details[i]);
+        }
       }
+
+      if(mod.buildID[0] && !persistRelative.empty())
+        AppendSymbolCache(mod.buildID, &persistRelative[0], &persistDetails[0],
+                          persistRelative.size());
     }
   }
 
+  Threading::CriticalSection m_Lock;
   std::vector<LookupModule> m_Modules;
+  // parallel to m_Modules, owned by the resolver
+  std::vector<ElfSymbols *> m_Symbols;
   std::map<uint64_t, Callstack::AddressDetails> m_Cache;
 };
 
@@ -247,7 +782,7 @@ StackResolver *MakeResolver(char *moduleDB, size_t DBSize, string pdbSearchPaths
 
   char *search = moduleDB + 8;
 
-  vector<LookupModule> modules;
+  vector<ModulePrepare> prepare;
 
   while(valid && search && size_t(search - moduleDB) < DBSize)
   {
@@ -256,21 +791,23 @@ StackResolver *MakeResolver(char *moduleDB, size_t DBSize, string pdbSearchPaths
 
     // find .text segments
     {
-      long unsigned int base = 0, end = 0;
+      long unsigned int base = 0, end = 0, fileoffs = 0;
 
       int inode = 0;
       int offs = 0;
       //                        base-end   perms offset devid   inode offs
-      int num = sscanf(search, "%lx-%lx  r-xp  %*x    %*x:%*x %d    %n", &base, &end, &inode, &offs);
+      int num = sscanf(search, "%lx-%lx  r-xp  %lx    %*x:%*x %d    %n", &base, &end, &fileoffs,
+                       &inode, &offs);
 
       // we don't care about inode actually, we ust use it to verify that
-      // we read all 3 params (and so perms == r-xp)
-      if(num == 3 && offs > 0)
+      // we read all 4 params (and so perms == r-xp)
+      if(num == 4 && offs > 0)
       {
         LookupModule mod = {0};
 
         mod.base = (uint64_t)base;
         mod.end = (uint64_t)end;
+        mod.offset = (uint64_t)fileoffs;
 
         search += offs;
         while(size_t(search - moduleDB) < DBSize && (*search == ' ' || *search == '\t'))
@@ -295,37 +832,10 @@ StackResolver *MakeResolver(char *moduleDB, size_t DBSize, string pdbSearchPaths
             mod.path[i] = search[i];
           }
 
-          // addr2line wants offsets relative to text section, have to find offset of .text section
-          // in this
-          // mmapped section
-
-          int textoffs = 0;
-          string cmd = StringFormat::Fmt("readelf -WS \"%s\"", mod.path);
-
-          FILE *f = ::popen(cmd.c_str(), "r");
-
-          char result[4096] = {0};
-          fread(result, 1, 4095, f);
-
-          fclose(f);
-
-          // find .text line
-          char *find = strstr(result, ".text");
-
-          if(find)
-          {
-            find += 5;
-
-            while(isalpha(*find) || isspace(*find))
-              find++;
-
-            // virtual address is listed first, we want the offset
-            sscanf(find, "%*x %x", &textoffs);
-
-            mod.base += textoffs;
-
-            modules.push_back(mod);
-          }
+          ModulePrepare prep;
+          prep.mod = mod;
+          prep.symbols = NULL;
+          prepare.push_back(prep);
         }
       }
     }
@@ -338,6 +848,28 @@ StackResolver *MakeResolver(char *moduleDB, size_t DBSize, string pdbSearchPaths
       search++;
   }
 
-  return new LinuxResolver(modules);
+  // each module's file is mapped and its headers read, do them all in parallel
+  if(!prepare.empty() && !(killSignal && *killSignal))
+    Threading::ParallelFor((uint32_t)prepare.size(), &PrepareModule, &prepare[0]);
+
+  // the files for this process's modules were just touched, so they're the last to go
+  TrimSymbolCacheFolder();
+
+  vector<LookupModule> modules;
+  vector<ElfSymbols *> symbols;
+  vector<vector<CachedAddress> > cached;
+
+  for(size_t i = 0; i < prepare.size(); i++)
+  {
+    if(prepare[i].symbols == NULL)
+      continue;
+
+    modules.push_back(prepare[i].mod);
+    symbols.push_back(prepare[i].symbols);
+    cached.push_back(vector<CachedAddress>());
+    cached.back().swap(prepare[i].cached);
+  }
+
+  return new LinuxResolver(modules, symbols, cached.empty() ? NULL : &cached[0]);
 }
 };
@@ -0,0 +1,927 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include <cxxabi.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include "os/posix/linux/linux_symbols.h"
+#include "serialise/string_utils.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ELF
+
+struct ElfSection
+{
+  const char *name;
+  uint32_t type;
+  uint64_t flags;
+  uint64_t offset;
+  uint64_t size;
+  uint32_t link;
+};
+
+struct ElfSegment
+{
+  uint32_t type;
+  uint64_t offset;
+  uint64_t vaddr;
+  uint64_t filesz;
+  uint64_t align;
+};
+
+// a read-only mapping of an ELF file, with the section and segment headers unpacked to be the same
+// for 32-bit and 64-bit files.
+struct ElfFile
+{
+  ElfFile() : data(NULL), size(0), is64(false) {}
+  ~ElfFile()
+  {
+    if(data)
+      munmap(data, size);
+  }
+
+  bool Open(const char *path);
+
+  const ElfSection *FindSection(const char *name) const
+  {
+    for(size_t i = 0; i < sections.size(); i++)
+      if(!strcmp(sections[i].name, name))
+        return &sections[i];
+
+    return NULL;
+  }
+
+  // NULL if the section has no contents in this file, e.g. .text in a separate debug file
+  const byte *GetData(const ElfSection *section) const
+  {
+    if(section == NULL || section->type == SHT_NOBITS || section->offset > size ||
+       section->size > size - section->offset)
+      return NULL;
+
+    return data + section->offset;
+  }
+
+  byte *data;
+  size_t size;
+  bool is64;
+  std::vector<ElfSection> sections;
+  std::vector<ElfSegment> segments;
+};
+
+template <typename Ehdr, typename Shdr, typename Phdr>
+static bool ReadElfHeaders(ElfFile &file)
+{
+  if(file.size < sizeof(Ehdr))
+    return false;
+
+  const Ehdr *ehdr = (const Ehdr *)file.data;
+
+  if(ehdr->e_shoff > file.size || ehdr->e_phoff > file.size ||
+     uint64_t(ehdr->e_shnum) * sizeof(Shdr) > file.size - ehdr->e_shoff ||
+     uint64_t(ehdr->e_phnum) * sizeof(Phdr) > file.size - ehdr->e_phoff)
+    return false;
+
+  const Phdr *phdrs = (const Phdr *)(file.data + ehdr->e_phoff);
+
+  for(uint16_t i = 0; i < ehdr->e_phnum; i++)
+  {
+    ElfSegment seg;
+    seg.type = phdrs[i].p_type;
+    seg.offset = phdrs[i].p_offset;
+    seg.vaddr = phdrs[i].p_vaddr;
+    seg.filesz = phdrs[i].p_filesz;
+    seg.align = phdrs[i].p_align;
+    file.segments.push_back(seg);
+  }
+
+  const Shdr *shdrs = (const Shdr *)(file.data + ehdr->e_shoff);
+
+  const char *names = NULL;
+  uint64_t namesSize = 0;
+
+  if(ehdr->e_shstrndx < ehdr->e_shnum && shdrs[ehdr->e_shstrndx].sh_offset < file.size &&
+     shdrs[ehdr->e_shstrndx].sh_size <= file.size - shdrs[ehdr->e_shstrndx].sh_offset)
+  {
+    names = (const char *)file.data + shdrs[ehdr->e_shstrndx].sh_offset;
+    namesSize = shdrs[ehdr->e_shstrndx].sh_size;
+  }
+
+  for(uint16_t i = 0; i < ehdr->e_shnum; i++)
+  {
+    ElfSection sec;
+    sec.name = (names && shdrs[i].sh_name < namesSize) ? names + shdrs[i].sh_name : "";
+    sec.type = shdrs[i].sh_type;
+    sec.flags = shdrs[i].sh_flags;
+    sec.offset = shdrs[i].sh_offset;
+    sec.size = shdrs[i].sh_size;
+    sec.link = shdrs[i].sh_link;
+    file.sections.push_back(sec);
+  }
+
+  return true;
+}
+
+bool ElfFile::Open(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+
+  if(fd < 0)
+    return false;
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size < EI_NIDENT)
+  {
+    close(fd);
+    return false;
+  }
+
+  void *mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  close(fd);
+
+  if(mapped == MAP_FAILED)
+    return false;
+
+  data = (byte *)mapped;
+  size = (size_t)st.st_size;
+
+  if(memcmp(data, ELFMAG, SELFMAG) != 0)
+    return false;
+
+  // we only read files with our own byte order, which all modules loaded into a process have
+  const uint16_t endianTest = 1;
+  const byte nativeData = *(const byte *)&endianTest == 1 ? ELFDATA2LSB : ELFDATA2MSB;
+
+  if(data[EI_DATA] != nativeData)
+    return false;
+
+  if(data[EI_CLASS] == ELFCLASS64)
+  {
+    is64 = true;
+    return ReadElfHeaders<Elf64_Ehdr, Elf64_Shdr, Elf64_Phdr>(*this);
+  }
+  else if(data[EI_CLASS] == ELFCLASS32)
+  {
+    is64 = false;
+    return ReadElfHeaders<Elf32_Ehdr, Elf32_Shdr, Elf32_Phdr>(*this);
+  }
+
+  return false;
+}
+
+static std::string ReadBuildID(const ElfFile &file)
+{
+  for(size_t i = 0; i < file.sections.size(); i++)
+  {
+    const ElfSection &sec = file.sections[i];
+
+    if(sec.type != SHT_NOTE)
+      continue;
+
+    const byte *note = file.GetData(&sec);
+    const byte *end = note + sec.size;
+
+    // each note is namesz, descsz, type then the name and desc, each padded to 4 bytes
+    while(note && end - note >= 12)
+    {
+      uint32_t nameSize = 0, descSize = 0, type = 0;
+      memcpy(&nameSize, note + 0, sizeof(uint32_t));
+      memcpy(&descSize, note + 4, sizeof(uint32_t));
+      memcpy(&type, note + 8, sizeof(uint32_t));
+
+      const byte *name = note + 12;
+      const byte *desc = name + AlignUp4(nameSize);
+
+      if(desc > end || AlignUp4(descSize) > uint64_t(end - desc))
+        break;
+
+      if(type == NT_GNU_BUILD_ID && nameSize == 4 && !memcmp(name, "GNU", 4))
+      {
+        std::string ret;
+        for(uint32_t b = 0; b < descSize; b++)
+          ret += StringFormat::Fmt("%02x", desc[b]);
+        return ret;
+      }
+
+      note = desc + AlignUp4(descSize);
+    }
+  }
+
+  return "";
+}
+
+static std::string Demangle(const char *name)
+{
+  int status = 0;
+  char *demangled = abi::__cxa_demangle(name, NULL, NULL, &status);
+
+  if(demangled == NULL)
+    return name;
+
+  std::string ret = demangled;
+  free(demangled);
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// DWARF
+
+enum
+{
+  DW_LNS_copy = 0x01,
+  DW_LNS_advance_pc = 0x02,
+  DW_LNS_advance_line = 0x03,
+  DW_LNS_set_file = 0x04,
+  DW_LNS_const_add_pc = 0x08,
+  DW_LNS_fixed_advance_pc = 0x09,
+
+  DW_LNE_end_sequence = 0x01,
+  DW_LNE_set_address = 0x02,
+  DW_LNE_define_file = 0x03,
+
+  DW_LNCT_path = 0x1,
+  DW_LNCT_directory_index = 0x2,
+
+  DW_FORM_data2 = 0x05,
+  DW_FORM_data4 = 0x06,
+  DW_FORM_data8 = 0x07,
+  DW_FORM_string = 0x08,
+  DW_FORM_block = 0x09,
+  DW_FORM_data1 = 0x0b,
+  DW_FORM_strp = 0x0e,
+  DW_FORM_udata = 0x0f,
+  DW_FORM_data16 = 0x1e,
+  DW_FORM_line_strp = 0x1f,
+};
+
+// bounds-checked cursor over DWARF data. Any read past the end clears ok and returns 0, so callers
+// can read a whole structure and check once.
+struct DwarfReader
+{
+  DwarfReader(const byte *begin, const byte *finish) : cur(begin), end(finish), ok(true) {}
+  bool Has(uint64_t bytes)
+  {
+    if(ok && uint64_t(end - cur) >= bytes)
+      return true;
+    ok = false;
+    return false;
+  }
+
+  template <typename T>
+  T Read()
+  {
+    T ret = 0;
+    if(Has(sizeof(T)))
+    {
+      memcpy(&ret, cur, sizeof(T));
+      cur += sizeof(T);
+    }
+    return ret;
+  }
+
+  uint64_t ReadULEB()
+  {
+    uint64_t ret = 0;
+    uint32_t shift = 0;
+    while(Has(1))
+    {
+      byte b = *cur++;
+      if(shift < 64)
+        ret |= uint64_t(b & 0x7f) << shift;
+      shift += 7;
+      if((b & 0x80) == 0)
+        break;
+    }
+    return ret;
+  }
+
+  int64_t ReadSLEB()
+  {
+    uint64_t ret = 0;
+    uint32_t shift = 0;
+    byte b = 0;
+    while(Has(1))
+    {
+      b = *cur++;
+      if(shift < 64)
+        ret |= uint64_t(b & 0x7f) << shift;
+      shift += 7;
+      if((b & 0x80) == 0)
+        break;
+    }
+    if(shift < 64 && (b & 0x40))
+      ret |= ~0ULL << shift;
+    return (int64_t)ret;
+  }
+
+  uint64_t ReadOffset(bool dwarf64) { return dwarf64 ? Read<uint64_t>() : Read<uint32_t>(); }
+  const char *ReadString()
+  {
+    const byte *str = cur;
+    while(Has(1))
+    {
+      if(*cur++ == 0)
+        return (const char *)str;
+    }
+    return "";
+  }
+
+  void Skip(uint64_t bytes)
+  {
+    if(Has(bytes))
+      cur += bytes;
+  }
+
+  const byte *cur;
+  const byte *end;
+  bool ok;
+};
+
+// string sections that v5 line tables can reference
+struct DwarfStrings
+{
+  const char *str;
+  uint64_t strSize;
+  const char *lineStr;
+  uint64_t lineStrSize;
+};
+
+// read one attribute of a v5 directory or file entry, either a string or a value
+static bool ReadLineForm(DwarfReader &reader, uint64_t form, bool dwarf64,
+                         const DwarfStrings &strings, const char *&str, uint64_t &val)
+{
+  switch(form)
+  {
+    case DW_FORM_string: str = reader.ReadString(); break;
+    case DW_FORM_strp:
+    {
+      uint64_t offs = reader.ReadOffset(dwarf64);
+      str = offs < strings.strSize ? strings.str + offs : "";
+      break;
+    }
+    case DW_FORM_line_strp:
+    {
+      uint64_t offs = reader.ReadOffset(dwarf64);
+      str = offs < strings.lineStrSize ? strings.lineStr + offs : "";
+      break;
+    }
+    case DW_FORM_udata: val = reader.ReadULEB(); break;
+    case DW_FORM_data1: val = reader.Read<uint8_t>(); break;
+    case DW_FORM_data2: val = reader.Read<uint16_t>(); break;
+    case DW_FORM_data4: val = reader.Read<uint32_t>(); break;
+    case DW_FORM_data8: val = reader.Read<uint64_t>(); break;
+    case DW_FORM_data16: reader.Skip(16); break;
+    case DW_FORM_block: reader.Skip(reader.ReadULEB()); break;
+    default: return false;
+  }
+
+  return reader.ok;
+}
+
+// read a v5 directory or file name table, keeping only the paths and directory indices
+static bool ReadEntryTable(DwarfReader &reader, bool dwarf64, const DwarfStrings &strings,
+                           std::vector<const char *> &paths, std::vector<uint64_t> *dirs)
+{
+  uint8_t formatCount = reader.Read<uint8_t>();
+
+  std::vector<std::pair<uint64_t, uint64_t> > format(formatCount);
+  for(uint8_t i = 0; i < formatCount; i++)
+  {
+    format[i].first = reader.ReadULEB();
+    format[i].second = reader.ReadULEB();
+  }
+
+  uint64_t count = reader.ReadULEB();
+
+  if(!reader.ok || (formatCount == 0 && count > 0))
+    return false;
+
+  for(uint64_t i = 0; i < count && reader.ok; i++)
+  {
+    const char *path = "";
+    uint64_t dir = 0;
+
+    for(size_t f = 0; f < format.size(); f++)
+    {
+      const char *str = NULL;
+      uint64_t val = 0;
+
+      if(!ReadLineForm(reader, format[f].second, dwarf64, strings, str, val))
+        return false;
+
+      if(format[f].first == DW_LNCT_path && str)
+        path = str;
+      else if(format[f].first == DW_LNCT_directory_index)
+        dir = val;
+    }
+
+    paths.push_back(path);
+    if(dirs)
+      dirs->push_back(dir);
+  }
+
+  return reader.ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ElfSymbols
+
+ElfSymbols::ElfSymbols()
+{
+  m_File = NULL;
+  m_DebugFile = NULL;
+  m_Indexed = false;
+}
+
+ElfSymbols::~ElfSymbols()
+{
+  SAFE_DELETE(m_File);
+  SAFE_DELETE(m_DebugFile);
+}
+
+bool ElfSymbols::Open(const char *path)
+{
+  m_Path = path;
+
+  m_File = new ElfFile();
+
+  if(!m_File->Open(path))
+  {
+    SAFE_DELETE(m_File);
+    return false;
+  }
+
+  m_BuildID = ReadBuildID(*m_File);
+
+  return true;
+}
+
+bool ElfSymbols::FileOffsetToAddress(uint64_t offset, uint64_t &address) const
+{
+  if(m_File == NULL)
+    return false;
+
+  for(size_t i = 0; i < m_File->segments.size(); i++)
+  {
+    const ElfSegment &seg = m_File->segments[i];
+
+    if(seg.type != PT_LOAD)
+      continue;
+
+    // the segment is mapped from the page containing its start, so the offset we get may be
+    // slightly before p_offset. Offsets and addresses are congruent modulo the alignment.
+    uint64_t align = seg.align > 1 ? seg.align : 1;
+    uint64_t start = seg.offset & ~(align - 1);
+
+    if(offset >= start && offset < seg.offset + seg.filesz)
+    {
+      address = seg.vaddr - seg.offset + offset;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+ElfFile *ElfSymbols::OpenDebugFile()
+{
+  std::vector<std::string> candidates;
+
+  if(m_BuildID.size() > 2)
+    candidates.push_back(StringFormat::Fmt("/usr/lib/debug/.build-id/%s/%s.debug",
+                                           m_BuildID.substr(0, 2).c_str(),
+                                           m_BuildID.substr(2).c_str()));
+
+  const ElfSection *link = m_File->FindSection(".gnu_debuglink");
+  const char *linkName = (const char *)m_File->GetData(link);
+
+  if(linkName && memchr(linkName, 0, (size_t)link->size))
+  {
+    std::string dir = dirname(m_Path);
+
+    candidates.push_back(dir + "/" + linkName);
+    candidates.push_back(dir + "/.debug/" + linkName);
+    candidates.push_back("/usr/lib/debug" + dir + "/" + linkName);
+  }
+
+  for(size_t i = 0; i < candidates.size(); i++)
+  {
+    if(candidates[i] == m_Path)
+      continue;
+
+    ElfFile *file = new ElfFile();
+
+    if(file->Open(candidates[i].c_str()) && file->FindSection(".debug_line"))
+      return file;
+
+    delete file;
+  }
+
+  return NULL;
+}
+
+template <typename Sym>
+void ElfSymbols::ReadSymbols(const Sym *syms, size_t count, const char *strings,
+                             uint64_t stringsSize)
+{
+  for(size_t i = 0; i < count; i++)
+  {
+    const Sym &sym = syms[i];
+
+    // st_info has the same layout for 32-bit and 64-bit
+    int type = ELF64_ST_TYPE(sym.st_info);
+
+    if((type != STT_FUNC && type != STT_GNU_IFUNC) || sym.st_shndx == SHN_UNDEF ||
+       sym.st_value == 0 || sym.st_name >= stringsSize)
+      continue;
+
+    Symbol s = {sym.st_value, sym.st_size, strings + sym.st_name};
+    m_Symbols.push_back(s);
+  }
+}
+
+void ElfSymbols::AddSymbols(ElfFile *file, const char *symtab)
+{
+  const ElfSection *sec = file->FindSection(symtab);
+
+  if(sec == NULL || sec->link >= file->sections.size())
+    return;
+
+  const ElfSection *strSec = &file->sections[sec->link];
+
+  const byte *syms = file->GetData(sec);
+  const char *strings = (const char *)file->GetData(strSec);
+
+  if(syms == NULL || strings == NULL)
+    return;
+
+  if(file->is64)
+    ReadSymbols((const Elf64_Sym *)syms, size_t(sec->size / sizeof(Elf64_Sym)), strings,
+                strSec->size);
+  else
+    ReadSymbols((const Elf32_Sym *)syms, size_t(sec->size / sizeof(Elf32_Sym)), strings,
+                strSec->size);
+}
+
+uint32_t ElfSymbols::AddFile(const std::vector<const char *> &dirs, uint64_t dir, const char *name,
+                             std::map<std::string, uint32_t> &fileLookup)
+{
+  std::string path = name;
+
+  if(name[0] != '/' && dir < dirs.size() && dirs[dir][0])
+    path = std::string(dirs[dir]) + "/" + name;
+
+  auto it = fileLookup.find(path);
+  if(it != fileLookup.end())
+    return it->second;
+
+  uint32_t idx = (uint32_t)m_Files.size();
+  m_Files.push_back(path);
+  fileLookup[path] = idx;
+  return idx;
+}
+
+void ElfSymbols::AddLineProgram(DwarfReader &reader, bool dwarf64, const DwarfStrings &strings,
+                                std::map<std::string, uint32_t> &fileLookup)
+{
+  uint16_t version = reader.Read<uint16_t>();
+
+  if(version < 2 || version > 5)
+    return;
+
+  if(version >= 5)
+  {
+    reader.Read<uint8_t>();    // address_size
+    reader.Read<uint8_t>();    // segment_selector_size
+  }
+
+  uint64_t headerLength = reader.ReadOffset(dwarf64);
+
+  if(!reader.Has(headerLength))
+    return;
+
+  const byte *program = reader.cur + headerLength;
+
+  uint8_t minInstLength = reader.Read<uint8_t>();
+  if(version >= 4)
+    reader.Read<uint8_t>();    // maximum_operations_per_instruction, only for VLIW
+  reader.Read<uint8_t>();      // default_is_stmt
+  int8_t lineBase = reader.Read<int8_t>();
+  uint8_t lineRange = reader.Read<uint8_t>();
+  uint8_t opcodeBase = reader.Read<uint8_t>();
+
+  if(!reader.ok || lineRange == 0 || opcodeBase == 0)
+    return;
+
+  std::vector<uint8_t> opcodeLengths(opcodeBase, 0);
+  for(uint8_t i = 1; i < opcodeBase; i++)
+    opcodeLengths[i] = reader.Read<uint8_t>();
+
+  std::vector<const char *> dirs;
+  // file index in this unit -> index in m_Files
+  std::vector<uint32_t> files;
+
+  if(version >= 5)
+  {
+    std::vector<const char *> fileNames;
+    std::vector<uint64_t> fileDirs;
+
+    if(!ReadEntryTable(reader, dwarf64, strings, dirs, NULL) ||
+       !ReadEntryTable(reader, dwarf64, strings, fileNames, &fileDirs))
+      return;
+
+    for(size_t i = 0; i < fileNames.size(); i++)
+      files.push_back(AddFile(dirs, fileDirs[i], fileNames[i], fileLookup));
+  }
+  else
+  {
+    // directory 0 is the compilation directory, which is only listed in .debug_info. Paths relative
+    // to it are left relative.
+    dirs.push_back("");
+
+    for(;;)
+    {
+      const char *dir = reader.ReadString();
+      if(!reader.ok || dir[0] == 0)
+        break;
+      dirs.push_back(dir);
+    }
+
+    // file indices are 1-based before v5
+    files.push_back(EndSequence);
+
+    for(;;)
+    {
+      const char *name = reader.ReadString();
+      if(!reader.ok || name[0] == 0)
+        break;
+      uint64_t dir = reader.ReadULEB();
+      reader.ReadULEB();    // modification time
+      reader.ReadULEB();    // file length
+      files.push_back(AddFile(dirs, dir, name, fileLookup));
+    }
+  }
+
+  if(!reader.ok || program > reader.end)
+    return;
+
+  reader.cur = program;
+
+  uint64_t address = 0;
+  uint64_t file = 1;
+  int64_t line = 1;
+
+  size_t sequenceStart = m_Lines.size();
+
+  while(reader.ok && reader.cur < reader.end)
+  {
+    uint8_t op = reader.Read<uint8_t>();
+    bool emit = false;
+
+    if(op >= opcodeBase)
+    {
+      // special opcode, advances both address and line then adds a row
+      uint8_t adjusted = op - opcodeBase;
+      address += (adjusted / lineRange) * minInstLength;
+      line += lineBase + (adjusted % lineRange);
+      emit = true;
+    }
+    else if(op == 0)
+    {
+      uint64_t len = reader.ReadULEB();
+
+      if(len == 0 || !reader.Has(len))
+        break;
+
+      const byte *next = reader.cur + len;
+      uint8_t extended = reader.Read<uint8_t>();
+
+      if(extended == DW_LNE_end_sequence)
+      {
+        // code discarded at link time still has its sequences, relocated to address 0
+        if(sequenceStart < m_Lines.size() && m_Lines[sequenceStart].address == 0)
+        {
+          m_Lines.resize(sequenceStart);
+        }
+        else
+        {
+          LineRow row = {address, EndSequence, 0};
+          m_Lines.push_back(row);
+        }
+
+        sequenceStart = m_Lines.size();
+
+        address = 0;
+        file = 1;
+        line = 1;
+      }
+      else if(extended == DW_LNE_set_address)
+      {
+        if(len - 1 == sizeof(uint64_t))
+          address = reader.Read<uint64_t>();
+        else if(len - 1 == sizeof(uint32_t))
+          address = reader.Read<uint32_t>();
+      }
+      else if(extended == DW_LNE_define_file && version < 5)
+      {
+        const char *name = reader.ReadString();
+        uint64_t dir = reader.ReadULEB();
+        files.push_back(AddFile(dirs, dir, name, fileLookup));
+      }
+
+      reader.cur = next;
+    }
+    else
+    {
+      switch(op)
+      {
+        case DW_LNS_copy: emit = true; break;
+        case DW_LNS_advance_pc: address += reader.ReadULEB() * minInstLength; break;
+        case DW_LNS_advance_line: line += reader.ReadSLEB(); break;
+        case DW_LNS_set_file: file = reader.ReadULEB(); break;
+        case DW_LNS_const_add_pc:
+          address += ((255 - opcodeBase) / lineRange) * minInstLength;
+          break;
+        case DW_LNS_fixed_advance_pc: address += reader.Read<uint16_t>(); break;
+        default:
+          // nothing else affects the rows we keep, skip over the operands
+          for(uint8_t i = 0; i < opcodeLengths[op]; i++)
+            reader.ReadULEB();
+          break;
+      }
+    }
+
+    if(emit && file < files.size() && files[file] != EndSequence)
+    {
+      LineRow row = {address, files[file], line > 0 ? uint32_t(line) : 0};
+      m_Lines.push_back(row);
+    }
+  }
+
+  // drop any sequence that wasn't terminated
+  m_Lines.resize(sequenceStart);
+}
+
+void ElfSymbols::AddLines(ElfFile *file)
+{
+  const ElfSection *lineSec = file->FindSection(".debug_line");
+  const byte *lineData = file->GetData(lineSec);
+
+  if(lineData == NULL)
+    return;
+
+  if(lineSec->flags & SHF_COMPRESSED)
+  {
+    RDCWARN("Compressed debug info in %s isn't supported, no line numbers will be available",
+            m_Path.c_str());
+    return;
+  }
+
+  const ElfSection *strSec = file->FindSection(".debug_str");
+  const ElfSection *lineStrSec = file->FindSection(".debug_line_str");
+
+  DwarfStrings strings;
+  strings.str = (const char *)file->GetData(strSec);
+  strings.strSize = strings.str ? strSec->size : 0;
+  strings.lineStr = (const char *)file->GetData(lineStrSec);
+  strings.lineStrSize = strings.lineStr ? lineStrSec->size : 0;
+
+  std::map<std::string, uint32_t> fileLookup;
+
+  DwarfReader units(lineData, lineData + lineSec->size);
+
+  while(units.ok && units.cur < units.end)
+  {
+    bool dwarf64 = false;
+    uint64_t unitLength = units.Read<uint32_t>();
+
+    if(unitLength == 0xffffffff)
+    {
+      dwarf64 = true;
+      unitLength = units.Read<uint64_t>();
+    }
+
+    if(!units.Has(unitLength))
+      break;
+
+    DwarfReader unit(units.cur, units.cur + unitLength);
+    units.cur += unitLength;
+
+    AddLineProgram(unit, dwarf64, strings, fileLookup);
+  }
+}
+
+bool ElfSymbols::SortRows(const LineRow &a, const LineRow &b)
+{
+  if(a.address != b.address)
+    return a.address < b.address;
+
+  // a sequence can start where another ends, make sure the start wins
+  return a.file == EndSequence && b.file != EndSequence;
+}
+
+void ElfSymbols::BuildIndex()
+{
+  if(m_Indexed || m_File == NULL)
+    return;
+
+  m_Indexed = true;
+
+  ElfFile *lineFile = m_File;
+
+  if(m_File->FindSection(".debug_line") == NULL)
+  {
+    m_DebugFile = OpenDebugFile();
+    if(m_DebugFile)
+      lineFile = m_DebugFile;
+  }
+
+  AddSymbols(m_File, ".symtab");
+  if(m_DebugFile)
+    AddSymbols(m_DebugFile, ".symtab");
+  AddSymbols(m_File, ".dynsym");
+
+  std::sort(m_Symbols.begin(), m_Symbols.end());
+
+  // aliases and symbols in several tables share an address, keep one with a size if there is one
+  size_t unique = 0;
+  for(size_t i = 0; i < m_Symbols.size(); i++)
+  {
+    if(unique > 0 && m_Symbols[unique - 1].address == m_Symbols[i].address)
+    {
+      if(m_Symbols[unique - 1].size == 0)
+        m_Symbols[unique - 1] = m_Symbols[i];
+      continue;
+    }
+
+    m_Symbols[unique++] = m_Symbols[i];
+  }
+  m_Symbols.resize(unique);
+
+  AddLines(lineFile);
+
+  std::sort(m_Lines.begin(), m_Lines.end(), &SortRows);
+}
+
+bool ElfSymbols::Lookup(uint64_t address, Callstack::AddressDetails &details) const
+{
+  bool found = false;
+
+  Symbol symKey = {address, 0, NULL};
+  auto sym = std::upper_bound(m_Symbols.begin(), m_Symbols.end(), symKey);
+
+  if(sym != m_Symbols.begin())
+  {
+    --sym;
+
+    if(sym->size == 0 || address < sym->address + sym->size)
+    {
+      details.function = Demangle(sym->name);
+      found = true;
+    }
+  }
+
+  LineRow lineKey = {address, 0, 0};
+  auto row = std::upper_bound(m_Lines.begin(), m_Lines.end(), lineKey, &SortRows);
+
+  if(row != m_Lines.begin())
+  {
+    --row;
+
+    if(row->file != EndSequence)
+    {
+      details.filename = m_Files[row->file];
+      details.line = row->line;
+      found = true;
+    }
+  }
+
+  return found;
+}
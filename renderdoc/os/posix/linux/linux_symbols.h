@@ -0,0 +1,105 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "os/os_specific.h"
+
+struct ElfFile;
+struct DwarfReader;
+struct DwarfStrings;
+
+// Symbol lookup for an ELF module, read directly from its symbol tables and DWARF line tables
+// (or those of its separate debug file). Addresses are the module's own virtual addresses, as used
+// in the symbol and line tables, not where it happened to be loaded.
+class ElfSymbols
+{
+public:
+  ElfSymbols();
+  ~ElfSymbols();
+
+  // map the file and read its headers. Cheap, the tables themselves aren't parsed until needed
+  bool Open(const char *path);
+
+  // hex GNU build-id, or empty if the module doesn't have one
+  const std::string &GetBuildID() const { return m_BuildID; }
+  // convert an offset into the file, e.g. from /proc/pid/maps, into a virtual address
+  bool FileOffsetToAddress(uint64_t offset, uint64_t &address) const;
+
+  // parse the symbol and line tables into sorted lookup arrays. Only done once.
+  void BuildIndex();
+
+  // fill in whatever details are known for address, leaving the rest untouched. Falls back to
+  // .symtab/.dynsym for the function if there's no debug info. Returns false if nothing was found.
+  bool Lookup(uint64_t address, Callstack::AddressDetails &details) const;
+
+private:
+  struct Symbol
+  {
+    uint64_t address;
+    uint64_t size;
+    const char *name;
+    bool operator<(const Symbol &o) const { return address < o.address; }
+  };
+
+  struct LineRow
+  {
+    uint64_t address;
+    // index into m_Files, or EndSequence for the first address after a sequence
+    uint32_t file;
+    uint32_t line;
+  };
+
+  enum
+  {
+    EndSequence = ~0U,
+  };
+
+  static bool SortRows(const LineRow &a, const LineRow &b);
+
+  ElfFile *OpenDebugFile();
+
+  void AddSymbols(ElfFile *file, const char *symtab);
+  template <typename Sym>
+  void ReadSymbols(const Sym *syms, size_t count, const char *strings, uint64_t stringsSize);
+
+  void AddLines(ElfFile *file);
+  void AddLineProgram(DwarfReader &reader, bool dwarf64, const DwarfStrings &strings,
+                      std::map<std::string, uint32_t> &fileLookup);
+  uint32_t AddFile(const std::vector<const char *> &dirs, uint64_t dir, const char *name,
+                   std::map<std::string, uint32_t> &fileLookup);
+
+  ElfFile *m_File;
+  ElfFile *m_DebugFile;
+  std::string m_Path;
+  std::string m_BuildID;
+  bool m_Indexed;
+
+  std::vector<Symbol> m_Symbols;
+  std::vector<LineRow> m_Lines;
+  std::vector<std::string> m_Files;
+};
@@ -27,6 +27,7 @@
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -79,33 +80,56 @@ uint32_t Socket::GetRemoteIP() const
   return ntohl(addr.sin_addr.s_addr);
 }
 
-Socket *Socket::AcceptClient(bool wait)
+// sockets are always left non-blocking, so anything that has to wait goes through here rather
+// than sleeping and retrying. Returns false on timeout, true if the socket is ready or in error
+// (the next send/recv will report the error).
+static bool WaitForSocket(int socket, short events, int timeoutMS)
 {
+  pollfd pfd = {};
+  pfd.fd = socket;
+  pfd.events = events;
+
+  int ret = 0;
+
   do
   {
-    int s = accept(socket, NULL, NULL);
+    ret = poll(&pfd, 1, timeoutMS);
+  } while(ret == -1 && errno == EINTR);
 
-    if(s != -1)
-    {
-      int flags = fcntl(s, F_GETFL, 0);
-      fcntl(s, F_SETFL, flags | O_NONBLOCK);
+  if(ret == -1)
+  {
+    RDCWARN("poll: %d", errno);
+    return true;
+  }
 
-      int nodelay = 1;
-      setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (char *)&nodelay, sizeof(nodelay));
+  return ret > 0;
+}
 
-      return new Socket((ptrdiff_t)s);
-    }
+Socket *Socket::AcceptClient(uint32_t timeoutMS)
+{
+  if(timeoutMS > 0 && !WaitForSocket((int)socket, POLLIN, (int)timeoutMS))
+    return NULL;
 
-    int err = errno;
+  int s = accept(socket, NULL, NULL);
 
-    if(err != EWOULDBLOCK && err != EAGAIN)
-    {
-      RDCWARN("accept: %d", err);
-      Shutdown();
-    }
+  if(s != -1)
+  {
+    int flags = fcntl(s, F_GETFL, 0);
+    fcntl(s, F_SETFL, flags | O_NONBLOCK);
 
-    Threading::Sleep(4);
-  } while(wait);
+    int nodelay = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (char *)&nodelay, sizeof(nodelay));
+
+    return new Socket((ptrdiff_t)s);
+  }
+
+  int err = errno;
+
+  if(err != EWOULDBLOCK && err != EAGAIN && err != EINTR)
+  {
+    RDCWARN("accept: %d", err);
+    Shutdown();
+  }
 
   return NULL;
 }
@@ -119,9 +143,6 @@ bool Socket::SendDataBlocking(const void *buf, uint32_t length)
 
   char *src = (char *)buf;
 
-  int flags = fcntl(socket, F_GETFL, 0);
-  fcntl(socket, F_SETFL, flags & ~O_NONBLOCK);
-
   while(sent < length)
   {
     int ret = send(socket, src, length - sent, 0);
@@ -130,8 +151,9 @@ bool Socket::SendDataBlocking(const void *buf, uint32_t length)
     {
       int err = errno;
 
-      if(err == EWOULDBLOCK || err == EAGAIN)
+      if(err == EWOULDBLOCK || err == EAGAIN || err == EINTR)
       {
+        WaitForSocket((int)socket, POLLOUT, -1);
         ret = 0;
       }
       else
@@ -146,9 +168,6 @@ bool Socket::SendDataBlocking(const void *buf, uint32_t length)
     src += ret;
   }
 
-  flags = fcntl(socket, F_GETFL, 0);
-  fcntl(socket, F_SETFL, flags | O_NONBLOCK);
-
   RDCASSERT(sent == length);
 
   return true;
@@ -183,6 +202,17 @@ bool Socket::IsRecvDataWaiting()
   return ret > 0;
 }
 
+bool Socket::WaitForRecvData(uint32_t timeoutMS)
+{
+  if(!Connected())
+    return false;
+
+  if(!WaitForSocket((int)socket, POLLIN, (int)timeoutMS))
+    return false;
+
+  return IsRecvDataWaiting();
+}
+
 bool Socket::RecvDataBlocking(void *buf, uint32_t length)
 {
   if(length == 0)
@@ -192,9 +222,6 @@ bool Socket::RecvDataBlocking(void *buf, uint32_t length)
 
   char *dst = (char *)buf;
 
-  int flags = fcntl(socket, F_GETFL, 0);
-  fcntl(socket, F_SETFL, flags & ~O_NONBLOCK);
-
   while(received < length)
   {
     int ret = recv(socket, dst, length - received, 0);
@@ -208,8 +235,9 @@ bool Socket::RecvDataBlocking(void *buf, uint32_t length)
     {
       int err = errno;
 
-      if(err == EWOULDBLOCK || err == EAGAIN)
+      if(err == EWOULDBLOCK || err == EAGAIN || err == EINTR)
       {
+        WaitForSocket((int)socket, POLLIN, -1);
         ret = 0;
       }
       else
@@ -224,9 +252,6 @@ bool Socket::RecvDataBlocking(void *buf, uint32_t length)
     dst += ret;
   }
 
-  flags = fcntl(socket, F_GETFL, 0);
-  fcntl(socket, F_SETFL, flags | O_NONBLOCK);
-
   RDCASSERT(received == length);
 
   return true;
@@ -26,6 +26,7 @@
 
 #include <pthread.h>
 #include <signal.h>
+#include <stdlib.h>
 #include "data/embedded_files.h"
 
 #define __PRETTY_FUNCTION_SIGNATURE__ __PRETTY_FUNCTION__
@@ -46,6 +47,17 @@ inline void DebugBreak()
 {
   raise(SIGTRAP);
 }
+inline void *AlignedAlloc(size_t size, size_t alignment)
+{
+  void *ret = NULL;
+  if(posix_memalign(&ret, alignment, size) != 0)
+    return NULL;
+  return ret;
+}
+inline void AlignedFree(void *ptr)
+{
+  free(ptr);
+}
 bool DebuggerPresent();
 void WriteOutput(int channel, const char *str);
 };
@@ -58,6 +70,14 @@ struct pthreadLockData
   pthread_mutexattr_t attr;
 };
 typedef CriticalSectionTemplate<pthreadLockData> CriticalSection;
+
+struct pthreadSemaphoreData
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint32_t count;
+};
+typedef SemaphoreTemplate<pthreadSemaphoreData> Semaphore;
 };
 
 namespace Bits
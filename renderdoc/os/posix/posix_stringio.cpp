@@ -31,7 +31,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
@@ -200,6 +202,11 @@ uint64_t GetModifiedTimestamp(const string &filename)
   return 0;
 }
 
+void Touch(const string &filename)
+{
+  utimes(filename.c_str(), NULL);
+}
+
 void Copy(const char *from, const char *to, bool allowOverwrite)
 {
   if(from[0] == 0 || to[0] == 0)
@@ -373,6 +380,28 @@ int fclose(FILE *f)
   return ::fclose(f);
 }
 
+const void *fmap(FILE *f, uint64_t size)
+{
+  if(f == NULL || size == 0 || uint64_t((size_t)size) != size)
+    return NULL;
+
+  void *ret = mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+
+  if(ret == MAP_FAILED)
+  {
+    RDCWARN("Couldn't map file for read - errno %d", errno);
+    return NULL;
+  }
+
+  return ret;
+}
+
+void funmap(const void *ptr, uint64_t size)
+{
+  if(ptr)
+    munmap((void *)ptr, (size_t)size);
+}
+
 void *logfile_open(const char *filename)
 {
   int fd = open(filename, O_APPEND | O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
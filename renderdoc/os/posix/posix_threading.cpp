@@ -22,6 +22,8 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <errno.h>
+#include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 #include "os/os_specific.h"
@@ -64,6 +66,11 @@ int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal)
 {
   return __sync_val_compare_and_swap(dest, oldVal, newVal);
 }
+
+int64_t CmpExch64(volatile int64_t *dest, int64_t oldVal, int64_t newVal)
+{
+  return __sync_val_compare_and_swap(dest, oldVal, newVal);
+}
 };
 
 namespace Threading
@@ -101,6 +108,75 @@ void CriticalSection::Unlock()
   pthread_mutex_unlock(&m_Data.lock);
 }
 
+template <>
+Semaphore::SemaphoreTemplate()
+{
+  pthread_mutex_init(&m_Data.lock, NULL);
+  pthread_cond_init(&m_Data.cond, NULL);
+  m_Data.count = 0;
+}
+
+template <>
+Semaphore::~SemaphoreTemplate()
+{
+  pthread_cond_destroy(&m_Data.cond);
+  pthread_mutex_destroy(&m_Data.lock);
+}
+
+template <>
+void Semaphore::Wake(uint32_t count)
+{
+  pthread_mutex_lock(&m_Data.lock);
+  m_Data.count += count;
+  if(count == 1)
+    pthread_cond_signal(&m_Data.cond);
+  else
+    pthread_cond_broadcast(&m_Data.cond);
+  pthread_mutex_unlock(&m_Data.lock);
+}
+
+template <>
+void Semaphore::WaitForWake()
+{
+  pthread_mutex_lock(&m_Data.lock);
+  while(m_Data.count == 0)
+    pthread_cond_wait(&m_Data.cond, &m_Data.lock);
+  m_Data.count--;
+  pthread_mutex_unlock(&m_Data.lock);
+}
+
+template <>
+bool Semaphore::WaitForWake(uint32_t timeoutMS)
+{
+  // gettimeofday rather than clock_gettime, as the condition's clock is the realtime clock and
+  // this is available everywhere including apple
+  timeval now;
+  gettimeofday(&now, NULL);
+
+  uint64_t usec = uint64_t(now.tv_usec) + uint64_t(timeoutMS) * 1000;
+
+  timespec deadline;
+  deadline.tv_sec = now.tv_sec + time_t(usec / 1000000);
+  deadline.tv_nsec = long(usec % 1000000) * 1000;
+
+  bool ret = true;
+
+  pthread_mutex_lock(&m_Data.lock);
+  while(m_Data.count == 0)
+  {
+    if(pthread_cond_timedwait(&m_Data.cond, &m_Data.lock, &deadline) == ETIMEDOUT)
+    {
+      ret = false;
+      break;
+    }
+  }
+  if(ret)
+    m_Data.count--;
+  pthread_mutex_unlock(&m_Data.lock);
+
+  return ret;
+}
+
 struct ThreadInitData
 {
   ThreadEntry entryFunc;
@@ -245,4 +321,11 @@ void Sleep(uint32_t milliseconds)
 {
   usleep(milliseconds * 1000);
 }
+
+uint32_t NumberOfCores()
+{
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return cores > 0 ? (uint32_t)cores : 1;
+}
 };
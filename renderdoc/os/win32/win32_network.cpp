@@ -74,33 +74,56 @@ uint32_t Socket::GetRemoteIP() const
   return ntohl(addr.sin_addr.s_addr);
 }
 
-Socket *Socket::AcceptClient(bool wait)
+// wait for the socket to become readable (or have a pending connection, for listening sockets).
+// Returns false on timeout, true if the socket is ready or in error.
+static bool WaitForSocketRead(SOCKET socket, uint32_t timeoutMS)
 {
-  do
+  fd_set readSet, errSet;
+  FD_ZERO(&readSet);
+  FD_ZERO(&errSet);
+  FD_SET(socket, &readSet);
+  FD_SET(socket, &errSet);
+
+  timeval timeout;
+  timeout.tv_sec = (timeoutMS / 1000);
+  timeout.tv_usec = (timeoutMS % 1000) * 1000;
+
+  int ret = select(0, &readSet, NULL, &errSet, &timeout);
+
+  if(ret == SOCKET_ERROR)
   {
-    SOCKET s = accept(socket, NULL, NULL);
+    RDCWARN("select: %d", WSAGetLastError());
+    return true;
+  }
 
-    if(s != INVALID_SOCKET)
-    {
-      u_long enable = 1;
-      ioctlsocket(s, FIONBIO, &enable);
+  return ret > 0;
+}
 
-      BOOL nodelay = TRUE;
-      setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, sizeof(nodelay));
+Socket *Socket::AcceptClient(uint32_t timeoutMS)
+{
+  if(timeoutMS > 0 && !WaitForSocketRead((SOCKET)socket, timeoutMS))
+    return NULL;
 
-      return new Socket((ptrdiff_t)s);
-    }
+  SOCKET s = accept(socket, NULL, NULL);
 
-    int err = WSAGetLastError();
+  if(s != INVALID_SOCKET)
+  {
+    u_long enable = 1;
+    ioctlsocket(s, FIONBIO, &enable);
 
-    if(err != WSAEWOULDBLOCK)
-    {
-      RDCWARN("accept: %d", err);
-      Shutdown();
-    }
+    BOOL nodelay = TRUE;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, sizeof(nodelay));
 
-    Threading::Sleep(4);
-  } while(wait);
+    return new Socket((ptrdiff_t)s);
+  }
+
+  int err = WSAGetLastError();
+
+  if(err != WSAEWOULDBLOCK)
+  {
+    RDCWARN("accept: %d", err);
+    Shutdown();
+  }
 
   return NULL;
 }
@@ -184,6 +207,17 @@ bool Socket::IsRecvDataWaiting()
   return ret > 0;
 }
 
+bool Socket::WaitForRecvData(uint32_t timeoutMS)
+{
+  if(!Connected())
+    return false;
+
+  if(!WaitForSocketRead((SOCKET)socket, timeoutMS))
+    return false;
+
+  return IsRecvDataWaiting();
+}
+
 bool Socket::RecvDataBlocking(void *buf, uint32_t length)
 {
   if(length == 0)
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <intrin.h>
+#include <malloc.h>
 #include <windows.h>
 #include "data/resource.h"
 
@@ -56,12 +57,21 @@ inline bool DebuggerPresent()
 {
   return ::IsDebuggerPresent() == TRUE;
 }
+inline void *AlignedAlloc(size_t size, size_t alignment)
+{
+  return _aligned_malloc(size, alignment);
+}
+inline void AlignedFree(void *ptr)
+{
+  _aligned_free(ptr);
+}
 void WriteOutput(int channel, const char *str);
 };
 
 namespace Threading
 {
 typedef CriticalSectionTemplate<CRITICAL_SECTION> CriticalSection;
+typedef SemaphoreTemplate<HANDLE> Semaphore;
 };
 
 namespace Bits
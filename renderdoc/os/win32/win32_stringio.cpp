@@ -23,6 +23,7 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <io.h>
 #include <shlobj.h>
 #include <stdio.h>
 #include <string.h>
@@ -333,6 +334,23 @@ uint64_t GetModifiedTimestamp(const string &filename)
   return 0;
 }
 
+void Touch(const string &filename)
+{
+  wstring wfn = StringFormat::UTF82Wide(filename);
+
+  HANDLE h = ::CreateFileW(wfn.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if(h == INVALID_HANDLE_VALUE)
+    return;
+
+  FILETIME now;
+  GetSystemTimeAsFileTime(&now);
+  ::SetFileTime(h, NULL, NULL, &now);
+
+  CloseHandle(h);
+}
+
 void Copy(const char *from, const char *to, bool allowOverwrite)
 {
   wstring wfrom = StringFormat::UTF82Wide(string(from));
@@ -514,6 +532,42 @@ int fclose(FILE *f)
   return ::fclose(f);
 }
 
+const void *fmap(FILE *f, uint64_t size)
+{
+  if(f == NULL || size == 0 || uint64_t((size_t)size) != size)
+    return NULL;
+
+  HANDLE file = (HANDLE)_get_osfhandle(_fileno(f));
+
+  if(file == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, DWORD(size >> 32),
+                                      DWORD(size & 0xffffffff), NULL);
+
+  if(mapping == NULL)
+  {
+    RDCWARN("Couldn't create file mapping - error %u", GetLastError());
+    return NULL;
+  }
+
+  void *ret = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+
+  if(ret == NULL)
+    RDCWARN("Couldn't map view of file - error %u", GetLastError());
+
+  // the view keeps the mapping object alive
+  CloseHandle(mapping);
+
+  return ret;
+}
+
+void funmap(const void *ptr, uint64_t size)
+{
+  if(ptr)
+    UnmapViewOfFile(ptr);
+}
+
 void *logfile_open(const char *filename)
 {
   wstring wfn = StringFormat::UTF82Wide(string(filename));
@@ -77,6 +77,11 @@ int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal)
 {
   return (int32_t)InterlockedCompareExchange((volatile LONG *)dest, newVal, oldVal);
 }
+
+int64_t CmpExch64(volatile int64_t *dest, int64_t oldVal, int64_t newVal)
+{
+  return (int64_t)InterlockedCompareExchange64((volatile LONG64 *)dest, newVal, oldVal);
+}
 };
 
 namespace Threading
@@ -106,6 +111,31 @@ void CriticalSection::Unlock()
   LeaveCriticalSection(&m_Data);
 }
 
+Semaphore::SemaphoreTemplate()
+{
+  m_Data = CreateSemaphore(NULL, 0, MAXLONG, NULL);
+}
+
+Semaphore::~SemaphoreTemplate()
+{
+  CloseHandle(m_Data);
+}
+
+void Semaphore::Wake(uint32_t count)
+{
+  ReleaseSemaphore(m_Data, (LONG)count, NULL);
+}
+
+void Semaphore::WaitForWake()
+{
+  WaitForSingleObject(m_Data, INFINITE);
+}
+
+bool Semaphore::WaitForWake(uint32_t timeoutMS)
+{
+  return WaitForSingleObject(m_Data, timeoutMS) == WAIT_OBJECT_0;
+}
+
 struct ThreadInitData
 {
   ThreadEntry entryFunc;
@@ -253,4 +283,12 @@ void Sleep(uint32_t milliseconds)
 {
   ::Sleep((DWORD)milliseconds);
 }
+
+uint32_t NumberOfCores()
+{
+  SYSTEM_INFO info = {};
+  GetSystemInfo(&info);
+
+  return info.dwNumberOfProcessors > 0 ? (uint32_t)info.dwNumberOfProcessors : 1;
+}
 };
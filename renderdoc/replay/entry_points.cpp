@@ -27,11 +27,13 @@
 #include "api/replay/renderdoc_replay.h"
 #include "api/replay/version.h"
 #include "common/common.h"
+#include "core/benchmarks.h"
 #include "core/core.h"
 #include "jpeg-compressor/jpgd.h"
 #include "jpeg-compressor/jpge.h"
 #include "maths/camera.h"
 #include "maths/formatpacking.h"
+#include "replay/replay_driver.h"
 #include "replay/replay_renderer.h"
 #include "serialise/serialiser.h"
 #include "serialise/string_utils.h"
@@ -170,6 +172,16 @@ extern "C" RENDERDOC_API uint16_t RENDERDOC_CC Maths_FloatToHalf(float f)
   return ConvertToHalf(f);
 }
 
+extern "C" RENDERDOC_API bool32 RENDERDOC_CC ShaderDebug_GetState(const ShaderDebugTrace *trace,
+                                                                  uint32_t step,
+                                                                  ShaderDebugState *state)
+{
+  if(trace == NULL || state == NULL)
+    return false;
+
+  return GetShaderDebugState(*trace, step, *state);
+}
+
 extern "C" RENDERDOC_API Camera *RENDERDOC_CC Camera_InitArcball()
 {
   return new Camera(Camera::eType_Arcball);
@@ -577,6 +589,35 @@ extern "C" RENDERDOC_API bool32 RENDERDOC_CC RENDERDOC_GetThumbnail(const char *
   return true;
 }
 
+extern "C" RENDERDOC_API bool32 RENDERDOC_CC RENDERDOC_RunBenchmark(const char *name,
+                                                                    uint32_t numThreads,
+                                                                    uint32_t iterations,
+                                                                    rdctype::str *results)
+{
+  std::string ret;
+
+  if(!strcmp(name, "resourcemanager"))
+  {
+    ret = Benchmark_ResourceManager(numThreads, iterations);
+  }
+  else if(!strcmp(name, "network"))
+  {
+    ret = Benchmark_NetworkLatency(iterations);
+  }
+  else
+  {
+    RDCERR("Unknown benchmark '%s'", name);
+    return false;
+  }
+
+  RDCLOG("%s", ret.c_str());
+
+  if(results)
+    *results = ret;
+
+  return true;
+}
+
 extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_FreeArrayMem(const void *mem)
 {
   rdctype::array<char>::deallocate(mem);
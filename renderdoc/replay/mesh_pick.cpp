@@ -0,0 +1,352 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ * Copyright (c) 2014 Crytek
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "mesh_pick.h"
+#include <float.h>
+#include <algorithm>
+#include "common/common.h"
+
+// triangles per leaf. Small leaves keep the number of ray/triangle tests per pick low, the BVH
+// is built once per mesh so build cost matters much less.
+static const uint32_t MaxLeafTriangles = 4;
+
+static bool IsFinite(const Vec3f &v)
+{
+  // NaN fails every comparison, and infinities are outside the range
+  return v.x >= -FLT_MAX && v.x <= FLT_MAX && v.y >= -FLT_MAX && v.y <= FLT_MAX &&
+         v.z >= -FLT_MAX && v.z <= FLT_MAX;
+}
+
+static float Component(const Vec3f &v, int axis)
+{
+  return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+struct TriangleCentroidSort
+{
+  int axis;
+
+  template <typename T>
+  bool operator()(const T &a, const T &b) const
+  {
+    return Component(a.pos[0] + a.pos[1] + a.pos[2], axis) <
+           Component(b.pos[0] + b.pos[1] + b.pos[2], axis);
+  }
+};
+
+bool MeshPickBVH::SupportsTopology(PrimitiveTopology topo)
+{
+  return topo == eTopology_TriangleList || topo == eTopology_TriangleStrip ||
+         topo == eTopology_TriangleFan || topo == eTopology_TriangleList_Adj ||
+         topo == eTopology_TriangleStrip_Adj;
+}
+
+bool MeshPickBVH::Matches(uint32_t eventID, const MeshFormat &fmt) const
+{
+  return m_EventID == eventID && m_Format.buf == fmt.buf && m_Format.offset == fmt.offset &&
+         m_Format.stride == fmt.stride && m_Format.compCount == fmt.compCount &&
+         m_Format.compByteWidth == fmt.compByteWidth && m_Format.compType == fmt.compType &&
+         m_Format.specialFormat == fmt.specialFormat && m_Format.idxbuf == fmt.idxbuf &&
+         m_Format.idxoffs == fmt.idxoffs && m_Format.idxByteWidth == fmt.idxByteWidth &&
+         m_Format.baseVertex == fmt.baseVertex && m_Format.topo == fmt.topo &&
+         m_Format.numVerts == fmt.numVerts && m_Format.unproject == fmt.unproject;
+}
+
+void MeshPickBVH::Clear()
+{
+  m_EventID = ~0U;
+  m_Format = MeshFormat();
+  m_Tris.clear();
+  m_Nodes.clear();
+}
+
+void MeshPickBVH::Build(uint32_t eventID, const MeshFormat &fmt,
+                        const vector<FloatVector> &positions, const vector<uint32_t> &indices,
+                        bool flipY)
+{
+  Clear();
+
+  m_EventID = eventID;
+  m_Format = fmt;
+
+  uint32_t numVerts = fmt.numVerts;
+
+  // work out how many triangles there are and the stride between them, matching the vertex
+  // selection in the picking shaders
+  uint32_t numTris = 0, triStride = 1, cornerStride = 1;
+
+  switch(fmt.topo)
+  {
+    case eTopology_TriangleList:
+      numTris = numVerts / 3;
+      triStride = 3;
+      break;
+    case eTopology_TriangleStrip:
+    case eTopology_TriangleFan: numTris = numVerts >= 3 ? numVerts - 2 : 0; break;
+    case eTopology_TriangleList_Adj:
+      numTris = numVerts / 6;
+      triStride = 6;
+      cornerStride = 2;
+      break;
+    case eTopology_TriangleStrip_Adj:
+      numTris = numVerts >= 6 ? (numVerts - 4) / 2 : 0;
+      triStride = 2;
+      cornerStride = 2;
+      break;
+    default: return;
+  }
+
+  m_Tris.reserve(numTris);
+
+  for(uint32_t t = 0; t < numTris; t++)
+  {
+    Triangle tri;
+    bool valid = true;
+
+    for(uint32_t c = 0; c < 3; c++)
+    {
+      uint32_t vertid = t * triStride + c * cornerStride;
+
+      if(fmt.topo == eTopology_TriangleFan)
+        vertid = c == 0 ? 0 : t + c;
+
+      uint32_t idx = vertid;
+
+      if(!indices.empty())
+        idx = vertid < indices.size() ? indices[vertid] : ~0U;
+
+      if(idx >= positions.size())
+      {
+        valid = false;
+        break;
+      }
+
+      FloatVector pos = positions[idx];
+
+      if(fmt.unproject)
+      {
+        if(flipY)
+          pos.y = -pos.y;
+
+        tri.pos[c] = Vec3f(pos.x / pos.w, pos.y / pos.w, pos.z / pos.w);
+      }
+      else
+      {
+        tri.pos[c] = Vec3f(pos.x, pos.y, pos.z);
+      }
+
+      tri.vertid[c] = vertid;
+
+      valid = valid && IsFinite(tri.pos[c]);
+    }
+
+    if(valid)
+      m_Tris.push_back(tri);
+  }
+
+  if(m_Tris.empty())
+    return;
+
+  m_Nodes.reserve(2 * (m_Tris.size() / MaxLeafTriangles + 1));
+
+  struct PendingNode
+  {
+    uint32_t node, first, count;
+  };
+
+  vector<PendingNode> stack;
+
+  m_Nodes.push_back(Node());
+  PendingNode root = {0, 0, (uint32_t)m_Tris.size()};
+  stack.push_back(root);
+
+  while(!stack.empty())
+  {
+    PendingNode cur = stack.back();
+    stack.pop_back();
+
+    Vec3f bmin(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vec3f bmax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    Vec3f cmin = bmin, cmax = bmax;
+
+    for(uint32_t i = cur.first; i < cur.first + cur.count; i++)
+    {
+      Vec3f centroid = m_Tris[i].pos[0] + m_Tris[i].pos[1] + m_Tris[i].pos[2];
+
+      cmin = Vec3f(RDCMIN(cmin.x, centroid.x), RDCMIN(cmin.y, centroid.y),
+                   RDCMIN(cmin.z, centroid.z));
+      cmax = Vec3f(RDCMAX(cmax.x, centroid.x), RDCMAX(cmax.y, centroid.y),
+                   RDCMAX(cmax.z, centroid.z));
+
+      for(int c = 0; c < 3; c++)
+      {
+        const Vec3f &p = m_Tris[i].pos[c];
+        bmin = Vec3f(RDCMIN(bmin.x, p.x), RDCMIN(bmin.y, p.y), RDCMIN(bmin.z, p.z));
+        bmax = Vec3f(RDCMAX(bmax.x, p.x), RDCMAX(bmax.y, p.y), RDCMAX(bmax.z, p.z));
+      }
+    }
+
+    m_Nodes[cur.node].bmin = bmin;
+    m_Nodes[cur.node].bmax = bmax;
+
+    if(cur.count <= MaxLeafTriangles)
+    {
+      m_Nodes[cur.node].first = cur.first;
+      m_Nodes[cur.node].count = cur.count;
+      continue;
+    }
+
+    // split at the median centroid along the longest axis of the centroid bounds
+    Vec3f extent = cmax - cmin;
+
+    TriangleCentroidSort sort;
+    sort.axis = 0;
+    if(extent.y > extent.x && extent.y >= extent.z)
+      sort.axis = 1;
+    else if(extent.z > extent.x && extent.z > extent.y)
+      sort.axis = 2;
+
+    uint32_t half = cur.count / 2;
+
+    std::nth_element(m_Tris.begin() + cur.first, m_Tris.begin() + cur.first + half,
+                     m_Tris.begin() + cur.first + cur.count, sort);
+
+    uint32_t left = (uint32_t)m_Nodes.size();
+    uint32_t right = left + 1;
+    m_Nodes.push_back(Node());
+    m_Nodes.push_back(Node());
+
+    m_Nodes[cur.node].first = left;
+    m_Nodes[cur.node].count = 0;
+
+    PendingNode r = {right, cur.first + half, cur.count - half};
+    PendingNode l = {left, cur.first, half};
+    stack.push_back(r);
+    stack.push_back(l);
+  }
+}
+
+uint32_t MeshPickBVH::Pick(const Vec3f &rayPos, const Vec3f &rayDir) const
+{
+  if(m_Nodes.empty())
+    return ~0U;
+
+  Vec3f invDir(1.0f / rayDir.x, 1.0f / rayDir.y, 1.0f / rayDir.z);
+
+  const Triangle *closest = NULL;
+  float closestT = FLT_MAX;
+
+  uint32_t stack[64];
+  uint32_t stackSize = 0;
+
+  stack[stackSize++] = 0;
+
+  while(stackSize > 0)
+  {
+    const Node &node = m_Nodes[stack[--stackSize]];
+
+    // slab test against the node bounds, skipping anything further than our closest hit
+    float tmin = 0.0f, tmax = closestT;
+
+    for(int axis = 0; axis < 3; axis++)
+    {
+      float o = Component(rayPos, axis), inv = Component(invDir, axis);
+      float t0 = (Component(node.bmin, axis) - o) * inv;
+      float t1 = (Component(node.bmax, axis) - o) * inv;
+
+      if(t0 > t1)
+        std::swap(t0, t1);
+
+      // written so that NaNs (ray parallel to and on a slab boundary) don't reject the node
+      tmin = t0 > tmin ? t0 : tmin;
+      tmax = t1 < tmax ? t1 : tmax;
+    }
+
+    if(tmin > tmax)
+      continue;
+
+    if(node.count == 0)
+    {
+      if(stackSize + 2 > ARRAY_COUNT(stack))
+      {
+        RDCERR("Mesh pick BVH is too deep");
+        break;
+      }
+
+      stack[stackSize++] = node.first + 1;
+      stack[stackSize++] = node.first;
+      continue;
+    }
+
+    for(uint32_t i = node.first; i < node.first + node.count; i++)
+    {
+      const Triangle &tri = m_Tris[i];
+
+      // same intersection test as the picking shaders, back-facing triangles are included
+      Vec3f v0v1 = tri.pos[1] - tri.pos[0];
+      Vec3f v0v2 = tri.pos[2] - tri.pos[0];
+      Vec3f pvec = rayDir.Cross(v0v2);
+      float det = v0v1.Dot(pvec);
+
+      if(det == 0.0f)
+        continue;
+
+      float invDet = 1.0f / det;
+
+      Vec3f tvec = rayPos - tri.pos[0];
+      Vec3f qvec = tvec.Cross(v0v1);
+      float u = tvec.Dot(pvec) * invDet;
+      float v = rayDir.Dot(qvec) * invDet;
+
+      if(u < 0.0f || u > 1.0f || v < 0.0f || u + v > 1.0f)
+        continue;
+
+      float t = v0v2.Dot(qvec) * invDet;
+
+      if(t > 0.0f && t < closestT)
+      {
+        closestT = t;
+        closest = &tri;
+      }
+    }
+  }
+
+  if(closest == NULL)
+    return ~0U;
+
+  // return the vertex closest to the hit point
+  Vec3f hit = rayPos + rayDir * closestT;
+
+  float dist0 = (closest->pos[0] - hit).Length();
+  float dist1 = (closest->pos[1] - hit).Length();
+  float dist2 = (closest->pos[2] - hit).Length();
+
+  if(dist1 < dist0 && dist1 < dist2)
+    return closest->vertid[1];
+  else if(dist2 < dist0 && dist2 < dist1)
+    return closest->vertid[2];
+
+  return closest->vertid[0];
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ * Copyright (c) 2014 Crytek
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include "api/replay/renderdoc_replay.h"
+#include "maths/vec.h"
+
+using std::vector;
+
+// CPU-side bounding volume hierarchy over the triangles of a mesh, used to answer mesh picking
+// queries without testing every triangle. Built once for a given event & mesh format and then
+// re-used for every click until the mesh being displayed changes.
+class MeshPickBVH
+{
+public:
+  MeshPickBVH() { m_EventID = ~0U; }
+  // only triangle topologies can be picked by casting a ray
+  static bool SupportsTopology(PrimitiveTopology topo);
+
+  // returns true if the BVH was built for this event and position format, so can be used as-is.
+  bool Matches(uint32_t eventID, const MeshFormat &fmt) const;
+
+  // positions are the linearised vertex positions, indices (if non-empty) index into positions.
+  // If unproject is set the positions are homogeneous and are divided by w before testing, with
+  // flipY negating y first to match the driver's picking shader.
+  void Build(uint32_t eventID, const MeshFormat &fmt, const vector<FloatVector> &positions,
+             const vector<uint32_t> &indices, bool flipY);
+
+  void Clear();
+
+  // returns the vertex of the closest triangle hit by the ray that is closest to the hit point,
+  // or ~0U if nothing was hit.
+  uint32_t Pick(const Vec3f &rayPos, const Vec3f &rayDir) const;
+
+private:
+  struct Triangle
+  {
+    Vec3f pos[3];
+    uint32_t vertid[3];
+  };
+
+  struct Node
+  {
+    Vec3f bmin, bmax;
+    // for leaves, the first triangle and count. For inner nodes count is 0 and first is the
+    // index of the left child, with the right child immediately after it.
+    uint32_t first;
+    uint32_t count;
+  };
+
+  uint32_t m_EventID;
+  MeshFormat m_Format;
+
+  vector<Triangle> m_Tris;
+  vector<Node> m_Nodes;
+};
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ * Copyright (c) 2014 Crytek
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "replay_driver.h"
+
+static void DiffVariables(const rdctype::array<ShaderVariable> &prev,
+                          const rdctype::array<ShaderVariable> &cur, ShaderDebugVariableSet set,
+                          uint32_t arrayIndex, vector<ShaderVariableChange> &changes)
+{
+  // the set of variables never changes size during a trace, only their values
+  RDCASSERT(prev.count == cur.count);
+
+  int32_t count = RDCMIN(prev.count, cur.count);
+
+  for(int32_t i = 0; i < count; i++)
+  {
+    const uint32_t *a = prev[i].value.uv;
+    const uint32_t *b = cur[i].value.uv;
+
+    for(uint32_t c = 0; c < 16; c++)
+    {
+      if(a[c] != b[c])
+      {
+        ShaderVariableChange change;
+        change.set = set;
+        change.arrayIndex = arrayIndex;
+        change.index = (uint32_t)i;
+        change.component = c;
+        change.value = b[c];
+        changes.push_back(change);
+      }
+    }
+  }
+}
+
+void DiffShaderDebugState(const ShaderDebugState &prev, const ShaderDebugState &cur,
+                          vector<ShaderVariableChange> &changes)
+{
+  DiffVariables(prev.registers, cur.registers, eShaderDebugVar_Register, 0, changes);
+  DiffVariables(prev.outputs, cur.outputs, eShaderDebugVar_Output, 0, changes);
+
+  RDCASSERT(prev.indexableTemps.count == cur.indexableTemps.count);
+
+  int32_t count = RDCMIN(prev.indexableTemps.count, cur.indexableTemps.count);
+
+  for(int32_t i = 0; i < count; i++)
+    DiffVariables(prev.indexableTemps[i], cur.indexableTemps[i], eShaderDebugVar_IndexableTemp,
+                  (uint32_t)i, changes);
+}
+
+void ApplyShaderDebugStep(ShaderDebugState &state, const ShaderDebugStep &step)
+{
+  state.nextInstruction = step.nextInstruction;
+  state.flags = step.flags;
+
+  for(int32_t i = 0; i < step.changes.count; i++)
+  {
+    const ShaderVariableChange &change = step.changes[i];
+
+    rdctype::array<ShaderVariable> *vars = NULL;
+
+    if(change.set == eShaderDebugVar_Register)
+      vars = &state.registers;
+    else if(change.set == eShaderDebugVar_Output)
+      vars = &state.outputs;
+    else if(change.set == eShaderDebugVar_IndexableTemp &&
+            change.arrayIndex < (uint32_t)state.indexableTemps.count)
+      vars = &state.indexableTemps[change.arrayIndex];
+
+    if(vars == NULL || change.index >= (uint32_t)vars->count || change.component >= 16)
+    {
+      RDCERR("Invalid shader debug variable change %u[%u][%u].%u", change.set, change.arrayIndex,
+             change.index, change.component);
+      continue;
+    }
+
+    (*vars)[change.index].value.uv[change.component] = change.value;
+  }
+}
+
+void BuildShaderDebugKeyframes(ShaderDebugTrace &trace)
+{
+  uint32_t numSteps = (uint32_t)trace.steps.count;
+
+  if(numSteps == 0)
+  {
+    trace.keyframes = vector<ShaderDebugState>();
+    return;
+  }
+
+  vector<ShaderDebugState> keyframes;
+  keyframes.reserve((numSteps + ShaderDebugKeyframeInterval - 1) / ShaderDebugKeyframeInterval);
+
+  ShaderDebugState state = trace.initialState;
+
+  for(uint32_t i = 0; i < numSteps; i++)
+  {
+    ApplyShaderDebugStep(state, trace.steps[i]);
+
+    if(i % ShaderDebugKeyframeInterval == 0)
+      keyframes.push_back(state);
+  }
+
+  trace.keyframes = keyframes;
+}
+
+bool GetShaderDebugState(const ShaderDebugTrace &trace, uint32_t step, ShaderDebugState &state)
+{
+  if(step >= (uint32_t)trace.steps.count)
+    return false;
+
+  uint32_t keyframe = step / ShaderDebugKeyframeInterval;
+  uint32_t start = 0;
+
+  if(keyframe < (uint32_t)trace.keyframes.count)
+  {
+    state = trace.keyframes[keyframe];
+    start = keyframe * ShaderDebugKeyframeInterval + 1;
+  }
+  else
+  {
+    state = trace.initialState;
+  }
+
+  for(uint32_t i = start; i <= step; i++)
+    ApplyShaderDebugStep(state, trace.steps[i]);
+
+  return true;
+}
@@ -54,6 +54,9 @@ struct GetTextureDataParams
   RemapTextureEnum remap;
   float blackPoint;
   float whitePoint;
+  // if non-NULL, updated from 0 to 1 as the data is fetched so that another thread can poll it.
+  // Only remote proxies fetch in stages. This stays local and isn't sent to the remote side.
+  float *progress;
 
   GetTextureDataParams()
       : forDiskSave(false),
@@ -61,7 +64,8 @@ struct GetTextureDataParams
         resolve(false),
         remap(eRemap_None),
         blackPoint(0.0f),
-        whitePoint(0.0f)
+        whitePoint(0.0f),
+        progress(NULL)
   {
   }
 };
@@ -109,12 +113,26 @@ public:
   virtual vector<uint32_t> GetPassEvents(uint32_t eventID) = 0;
 
   virtual void InitPostVSBuffers(uint32_t eventID) = 0;
+  // passEvents must be sorted, but can come from anywhere in the frame. Drivers replay as few
+  // times as they can to capture all of them.
   virtual void InitPostVSBuffers(const vector<uint32_t> &passEvents) = 0;
 
   virtual ResourceId GetLiveID(ResourceId id) = 0;
 
   virtual MeshFormat GetPostVSBuffers(uint32_t eventID, uint32_t instID, MeshDataStage stage) = 0;
 
+  // fetches the buffers for several events at once, with instIDs[i] selecting the instance of
+  // events[i]. Drivers where each fetch is expensive (such as the remote proxy) can override this.
+  virtual vector<MeshFormat> GetPostVSBuffersForEvents(const vector<uint32_t> &events,
+                                                       const vector<uint32_t> &instIDs,
+                                                       MeshDataStage stage)
+  {
+    vector<MeshFormat> ret(events.size());
+    for(size_t i = 0; i < events.size(); i++)
+      ret[i] = GetPostVSBuffers(events[i], instIDs[i], stage);
+    return ret;
+  }
+
   virtual void GetBufferData(ResourceId buff, uint64_t offset, uint64_t len,
                              vector<byte> &retData) = 0;
   virtual byte *GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
@@ -263,3 +281,20 @@ FetchDrawcall *SetupDrawcallPointers(vector<FetchDrawcall *> *drawcallTable,
 
   return ret;
 }
+
+// shader debug traces only store the changes made by each step. A full copy of the state is
+// kept every ShaderDebugKeyframeInterval steps so that any step can be reconstructed quickly.
+static const uint32_t ShaderDebugKeyframeInterval = 64;
+
+// append the components that differ between prev and cur to changes
+void DiffShaderDebugState(const ShaderDebugState &prev, const ShaderDebugState &cur,
+                          vector<ShaderVariableChange> &changes);
+
+// apply a single step's changes on top of the state for the previous step
+void ApplyShaderDebugStep(ShaderDebugState &state, const ShaderDebugStep &step);
+
+// (re-)generate the keyframes for a trace from its initial state and steps
+void BuildShaderDebugKeyframes(ShaderDebugTrace &trace);
+
+// reconstruct the full state at a given step, using the keyframes if they're present
+bool GetShaderDebugState(const ShaderDebugTrace &trace, uint32_t step, ShaderDebugState &state);
@@ -24,6 +24,7 @@
  ******************************************************************************/
 
 #include "replay_renderer.h"
+#include <algorithm>
 #include <string.h>
 #include <time.h>
 #include "common/dds_readwrite.h"
@@ -37,6 +38,11 @@
 #include "stb/stb_image_write.h"
 #include "tinyexr/tinyexr.h"
 
+#if ENABLED(RDOC_X86) && ENABLED(RDOC_X64)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+
 float ConvertComponent(const ResourceFormat &fmt, byte *data)
 {
   if(fmt.compByteWidth == 4)
@@ -133,6 +139,497 @@ static void fileWriteFunc(void *context, void *data, int size)
   FileIO::fwrite(data, 1, size, (FILE *)context);
 }
 
+// state for converting a whole image to floats, for saving to HDR/EXR. Each row is converted to
+// interleaved RGBA floats by a format-specific kernel, then any channel swaps/clamps are applied
+// and the row is written out either interleaved or split into planes.
+struct FloatConversion;
+
+typedef void (*ConvertRowFunc)(const FloatConversion &conv, const byte *src, float *dst);
+
+struct FloatConversion
+{
+  ResourceFormat fmt;
+  ConvertRowFunc convertRow;
+
+  const byte *src;
+  uint32_t width;
+  uint32_t height;
+  size_t srcRowPitch;
+
+  bool clampNegative;
+  int32_t channelExtract;
+
+  // output either interleaved RGBA, or planar A, B, G, R
+  float *rgba;
+  float *abgr[4];
+
+  // for 8-bit components, every possible value converted up front
+  float byteTable[256];
+};
+
+// rows are converted in batches of this many per job
+static const uint32_t FloatConversionRowBatch = 32;
+
+static void ConvertRowBytes(const FloatConversion &conv, const byte *src, float *dst)
+{
+  const uint32_t compCount = conv.fmt.compCount;
+  const uint32_t width = conv.width;
+
+  if(compCount == 4)
+  {
+    for(uint32_t i = 0; i < width * 4; i++)
+      dst[i] = conv.byteTable[src[i]];
+    return;
+  }
+
+  for(uint32_t x = 0; x < width; x++)
+  {
+    float *pix = dst + x * 4;
+    pix[0] = pix[1] = pix[2] = 0.0f;
+    pix[3] = 1.0f;
+    for(uint32_t c = 0; c < compCount; c++)
+      pix[c] = conv.byteTable[src[x * compCount + c]];
+  }
+}
+
+static void ConvertRowFloat(const FloatConversion &conv, const byte *src, float *dst)
+{
+  const uint32_t compCount = conv.fmt.compCount;
+  const uint32_t width = conv.width;
+
+  if(compCount == 4)
+  {
+    memcpy(dst, src, width * 4 * sizeof(float));
+    return;
+  }
+
+  const float *srcf = (const float *)src;
+
+  for(uint32_t x = 0; x < width; x++)
+  {
+    float *pix = dst + x * 4;
+    pix[0] = pix[1] = pix[2] = 0.0f;
+    pix[3] = 1.0f;
+    for(uint32_t c = 0; c < compCount; c++)
+      pix[c] = srcf[x * compCount + c];
+  }
+}
+
+static void ConvertRowGeneric(const FloatConversion &conv, const byte *src, float *dst)
+{
+  const ResourceFormat &fmt = conv.fmt;
+  const uint32_t compCount = fmt.compCount;
+  const uint32_t width = conv.width;
+
+  byte *srcData = (byte *)src;
+
+  for(uint32_t x = 0; x < width; x++)
+  {
+    float *pix = dst + x * 4;
+    pix[0] = pix[1] = pix[2] = 0.0f;
+    pix[3] = 1.0f;
+    for(uint32_t c = 0; c < compCount; c++)
+      pix[c] = ConvertComponent(fmt, srcData + fmt.compByteWidth * c);
+    srcData += compCount * fmt.compByteWidth;
+  }
+}
+
+static void ConvertRowHalfScalar(const uint16_t *src, float *dst, uint32_t count)
+{
+  for(uint32_t i = 0; i < count; i++)
+    dst[i] = ConvertFromHalf(src[i]);
+}
+
+static void ConvertRowR10G10B10A2Scalar(const uint32_t *src, float *dst, uint32_t width)
+{
+  for(uint32_t x = 0; x < width; x++)
+  {
+    Vec4f vec = ConvertFromR10G10B10A2(src[x]);
+
+    dst[x * 4 + 0] = vec.x;
+    dst[x * 4 + 1] = vec.y;
+    dst[x * 4 + 2] = vec.z;
+    dst[x * 4 + 3] = vec.w;
+  }
+}
+
+static float ConvertFromR11G11B10Component(uint32_t data, uint32_t mantissaBits)
+{
+  uint32_t mantissa = data & ((1U << mantissaBits) - 1);
+  uint32_t exponent = (data >> mantissaBits) & 0x1f;
+
+  union
+  {
+    uint32_t u;
+    float f;
+  } ret;
+
+  if(exponent == 0)
+  {
+    // zero or denormal, mantissa * 2^-14 / 2^mantissaBits
+    ret.f = float(mantissa) / float(1U << (14 + mantissaBits));
+  }
+  else if(exponent == 0x1f)
+  {
+    // infinity or nan
+    ret.u = 0x7f800000 | mantissa << (23 - mantissaBits);
+  }
+  else
+  {
+    // shift exponent and mantissa to the right range for 32bit floats
+    ret.u = (exponent + (127 - 15)) << 23 | mantissa << (23 - mantissaBits);
+  }
+
+  return ret.f;
+}
+
+static void ConvertRowR11G11B10Scalar(const uint32_t *src, float *dst, uint32_t width)
+{
+  for(uint32_t x = 0; x < width; x++)
+  {
+    dst[x * 4 + 0] = ConvertFromR11G11B10Component(src[x] >> 0, 6);
+    dst[x * 4 + 1] = ConvertFromR11G11B10Component(src[x] >> 11, 6);
+    dst[x * 4 + 2] = ConvertFromR11G11B10Component(src[x] >> 22, 5);
+    dst[x * 4 + 3] = 1.0f;
+  }
+}
+
+#if ENABLED(RDOC_X86) && ENABLED(RDOC_X64)
+
+// SSE2 is part of the x86-64 baseline, so these need no runtime check. 32-bit x86 builds aren't
+// guaranteed to have it and use the scalar versions below.
+
+// converts 4 halfs (zero-extended to 32-bits) to floats. Matches ConvertFromHalf exactly,
+// including returning +0 for -0 and the same NaN for infinities and NaNs.
+static inline __m128 ConvertFromHalf4(__m128i h)
+{
+  const __m128i signMask = _mm_set1_epi32(0x8000);
+  const __m128i valueMask = _mm_set1_epi32(0x7fff);
+
+  __m128i sign = _mm_slli_epi32(_mm_and_si128(h, signMask), 16);
+  __m128i em = _mm_and_si128(h, valueMask);
+
+  // normal numbers: rebias the exponent and shift everything up
+  __m128i normal = _mm_add_epi32(_mm_slli_epi32(em, 13), _mm_set1_epi32((127 - 15) << 23));
+
+  // subnormals (and zero): mantissa * 2^-24, which is exact in float
+  __m128i denormal =
+      _mm_castps_si128(_mm_mul_ps(_mm_cvtepi32_ps(em), _mm_set1_ps(1.0f / 16777216.0f)));
+
+  __m128i isDenormal = _mm_cmplt_epi32(em, _mm_set1_epi32(0x0400));
+  __m128i isSpecial = _mm_cmpgt_epi32(em, _mm_set1_epi32(0x7bff));
+  __m128i isZero = _mm_cmpeq_epi32(em, _mm_setzero_si128());
+
+  __m128i ret = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+  ret = _mm_or_si128(ret, _mm_andnot_si128(isZero, sign));
+  ret = _mm_or_si128(_mm_andnot_si128(isSpecial, ret),
+                     _mm_and_si128(isSpecial, _mm_set1_epi32(0x7F800001)));
+
+  return _mm_castsi128_ps(ret);
+}
+
+static void ConvertRowHalf(const FloatConversion &conv, const byte *src, float *dst)
+{
+  const uint32_t compCount = conv.fmt.compCount;
+  const uint32_t width = conv.width;
+  const uint16_t *src16 = (const uint16_t *)src;
+
+  if(compCount == 4)
+  {
+    const uint32_t count = width * 4;
+    const __m128i zero = _mm_setzero_si128();
+
+    uint32_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+      __m128i h = _mm_loadu_si128((const __m128i *)(src16 + i));
+
+      _mm_storeu_ps(dst + i + 0, ConvertFromHalf4(_mm_unpacklo_epi16(h, zero)));
+      _mm_storeu_ps(dst + i + 4, ConvertFromHalf4(_mm_unpackhi_epi16(h, zero)));
+    }
+
+    ConvertRowHalfScalar(src16 + i, dst + i, count - i);
+    return;
+  }
+
+  for(uint32_t x = 0; x < width; x++)
+  {
+    float *pix = dst + x * 4;
+    pix[0] = pix[1] = pix[2] = 0.0f;
+    pix[3] = 1.0f;
+    ConvertRowHalfScalar(src16 + x * compCount, pix, compCount);
+  }
+}
+
+static void ConvertRowR10G10B10A2(const FloatConversion &conv, const byte *src, float *dst)
+{
+  const uint32_t width = conv.width;
+  const uint32_t *src32 = (const uint32_t *)src;
+
+  const __m128i mask10 = _mm_set1_epi32(0x3ff);
+  const __m128 max10 = _mm_set1_ps(1023.0f);
+  const __m128 max2 = _mm_set1_ps(3.0f);
+
+  uint32_t x = 0;
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src32 + x));
+
+    // divide rather than multiply by the reciprocal to match ConvertFromR10G10B10A2 exactly
+    __m128 r = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(v, mask10)), max10);
+    __m128 g = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 10), mask10)), max10);
+    __m128 b = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 20), mask10)), max10);
+    __m128 a = _mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 30)), max2);
+
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+
+    _mm_storeu_ps(dst + x * 4 + 0, r);
+    _mm_storeu_ps(dst + x * 4 + 4, g);
+    _mm_storeu_ps(dst + x * 4 + 8, b);
+    _mm_storeu_ps(dst + x * 4 + 12, a);
+  }
+
+  ConvertRowR10G10B10A2Scalar(src32 + x, dst + x * 4, width - x);
+}
+
+static inline __m128 ConvertFromR11G11B10Component4(__m128i v, const int mantissaBits)
+{
+  const __m128i mantissaMask = _mm_set1_epi32((1 << mantissaBits) - 1);
+  const __m128i exponentMask = _mm_set1_epi32(0x1f);
+
+  __m128i mantissa = _mm_and_si128(v, mantissaMask);
+  __m128i exponent = _mm_and_si128(_mm_srl_epi32(v, _mm_cvtsi32_si128(mantissaBits)), exponentMask);
+
+  __m128i shiftedMantissa = _mm_sll_epi32(mantissa, _mm_cvtsi32_si128(23 - mantissaBits));
+
+  __m128i normal = _mm_or_si128(
+      _mm_slli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(127 - 15)), 23), shiftedMantissa);
+  __m128i special = _mm_or_si128(_mm_set1_epi32(0x7f800000), shiftedMantissa);
+  __m128i denormal = _mm_castps_si128(_mm_div_ps(
+      _mm_cvtepi32_ps(mantissa), _mm_set1_ps(float(1U << (14 + mantissaBits)))));
+
+  __m128i isDenormal = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+  __m128i isSpecial = _mm_cmpeq_epi32(exponent, exponentMask);
+
+  __m128i ret = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+  ret = _mm_or_si128(_mm_andnot_si128(isSpecial, ret), _mm_and_si128(isSpecial, special));
+
+  return _mm_castsi128_ps(ret);
+}
+
+static void ConvertRowR11G11B10(const FloatConversion &conv, const byte *src, float *dst)
+{
+  const uint32_t width = conv.width;
+  const uint32_t *src32 = (const uint32_t *)src;
+
+  uint32_t x = 0;
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src32 + x));
+
+    __m128 r = ConvertFromR11G11B10Component4(v, 6);
+    __m128 g = ConvertFromR11G11B10Component4(_mm_srli_epi32(v, 11), 6);
+    __m128 b = ConvertFromR11G11B10Component4(_mm_srli_epi32(v, 22), 5);
+    __m128 a = _mm_set1_ps(1.0f);
+
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+
+    _mm_storeu_ps(dst + x * 4 + 0, r);
+    _mm_storeu_ps(dst + x * 4 + 4, g);
+    _mm_storeu_ps(dst + x * 4 + 8, b);
+    _mm_storeu_ps(dst + x * 4 + 12, a);
+  }
+
+  ConvertRowR11G11B10Scalar(src32 + x, dst + x * 4, width - x);
+}
+
+static void SplitRowPlanes(const float *rgba, float *a, float *b, float *g, float *r, uint32_t width)
+{
+  uint32_t x = 0;
+  for(; x + 4 <= width; x += 4)
+  {
+    __m128 p0 = _mm_loadu_ps(rgba + x * 4 + 0);
+    __m128 p1 = _mm_loadu_ps(rgba + x * 4 + 4);
+    __m128 p2 = _mm_loadu_ps(rgba + x * 4 + 8);
+    __m128 p3 = _mm_loadu_ps(rgba + x * 4 + 12);
+
+    // transposes to p0 = R, p1 = G, p2 = B, p3 = A
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+    _mm_storeu_ps(r + x, p0);
+    _mm_storeu_ps(g + x, p1);
+    _mm_storeu_ps(b + x, p2);
+    _mm_storeu_ps(a + x, p3);
+  }
+
+  for(; x < width; x++)
+  {
+    r[x] = rgba[x * 4 + 0];
+    g[x] = rgba[x * 4 + 1];
+    b[x] = rgba[x * 4 + 2];
+    a[x] = rgba[x * 4 + 3];
+  }
+}
+
+#else
+
+static void ConvertRowHalf(const FloatConversion &conv, const byte *src, float *dst)
+{
+  const uint32_t compCount = conv.fmt.compCount;
+  const uint32_t width = conv.width;
+  const uint16_t *src16 = (const uint16_t *)src;
+
+  if(compCount == 4)
+  {
+    ConvertRowHalfScalar(src16, dst, width * 4);
+    return;
+  }
+
+  for(uint32_t x = 0; x < width; x++)
+  {
+    float *pix = dst + x * 4;
+    pix[0] = pix[1] = pix[2] = 0.0f;
+    pix[3] = 1.0f;
+    ConvertRowHalfScalar(src16 + x * compCount, pix, compCount);
+  }
+}
+
+static void ConvertRowR10G10B10A2(const FloatConversion &conv, const byte *src, float *dst)
+{
+  ConvertRowR10G10B10A2Scalar((const uint32_t *)src, dst, conv.width);
+}
+
+static void ConvertRowR11G11B10(const FloatConversion &conv, const byte *src, float *dst)
+{
+  ConvertRowR11G11B10Scalar((const uint32_t *)src, dst, conv.width);
+}
+
+static void SplitRowPlanes(const float *rgba, float *a, float *b, float *g, float *r, uint32_t width)
+{
+  for(uint32_t x = 0; x < width; x++)
+  {
+    r[x] = rgba[x * 4 + 0];
+    g[x] = rgba[x * 4 + 1];
+    b[x] = rgba[x * 4 + 2];
+    a[x] = rgba[x * 4 + 3];
+  }
+}
+
+#endif
+
+static void ConvertFloatRows(void *userData, uint32_t batch)
+{
+  const FloatConversion &conv = *(const FloatConversion *)userData;
+
+  const uint32_t width = conv.width;
+  const uint32_t startRow = batch * FloatConversionRowBatch;
+  const uint32_t endRow = RDCMIN(conv.height, startRow + FloatConversionRowBatch);
+
+  // planar output needs somewhere to put the interleaved row first
+  float *tempRow = conv.rgba ? NULL : new float[width * 4];
+
+  for(uint32_t y = startRow; y < endRow; y++)
+  {
+    float *row = conv.rgba ? conv.rgba + size_t(y) * width * 4 : tempRow;
+
+    conv.convertRow(conv, conv.src + conv.srcRowPitch * y, row);
+
+    if(conv.fmt.bgraOrder)
+    {
+      for(uint32_t x = 0; x < width; x++)
+        std::swap(row[x * 4 + 0], row[x * 4 + 2]);
+    }
+
+    // HDR can't represent negative values
+    if(conv.clampNegative)
+    {
+      for(uint32_t i = 0; i < width * 4; i++)
+        row[i] = RDCMAX(row[i], 0.0f);
+    }
+
+    if(conv.channelExtract >= 0 && conv.channelExtract < 4)
+    {
+      const int32_t c = conv.channelExtract;
+      for(uint32_t x = 0; x < width; x++)
+      {
+        float *pix = row + x * 4;
+        pix[0] = pix[1] = pix[2] = pix[c];
+        pix[3] = 1.0f;
+      }
+    }
+
+    if(tempRow)
+    {
+      size_t offs = size_t(y) * width;
+      SplitRowPlanes(row, conv.abgr[0] + offs, conv.abgr[1] + offs, conv.abgr[2] + offs,
+                     conv.abgr[3] + offs, width);
+    }
+  }
+
+  delete[] tempRow;
+}
+
+// converts the whole image to floats, either interleaved RGBA into rgba, or into separate
+// A, B, G, R planes in abgr.
+static void ConvertToFloats(const ResourceFormat &fmt, const byte *src, uint32_t width,
+                            uint32_t height, bool clampNegative, int32_t channelExtract,
+                            float *rgba, float **abgr)
+{
+  FloatConversion conv;
+  conv.fmt = fmt;
+  conv.src = src;
+  conv.width = width;
+  conv.height = height;
+  conv.clampNegative = clampNegative;
+  conv.channelExtract = channelExtract;
+  conv.rgba = rgba;
+  for(int i = 0; i < 4; i++)
+    conv.abgr[i] = abgr ? abgr[i] : NULL;
+
+  if(fmt.special && fmt.specialFormat == eSpecial_R10G10B10A2)
+  {
+    conv.convertRow = &ConvertRowR10G10B10A2;
+    conv.srcRowPitch = size_t(width) * 4;
+  }
+  else if(fmt.special && fmt.specialFormat == eSpecial_R11G11B10)
+  {
+    conv.convertRow = &ConvertRowR11G11B10;
+    conv.srcRowPitch = size_t(width) * 4;
+  }
+  else
+  {
+    if(fmt.compByteWidth == 1)
+    {
+      // with only 256 possible values, convert them all once and look up per component
+      for(uint32_t i = 0; i < 256; i++)
+      {
+        byte b = (byte)i;
+        conv.byteTable[i] = ConvertComponent(fmt, &b);
+      }
+
+      conv.convertRow = &ConvertRowBytes;
+    }
+    else if(fmt.compByteWidth == 2 && fmt.compType == eCompType_Float)
+    {
+      conv.convertRow = &ConvertRowHalf;
+    }
+    else if(fmt.compByteWidth == 4 && fmt.compType == eCompType_Float)
+    {
+      conv.convertRow = &ConvertRowFloat;
+    }
+    else
+    {
+      conv.convertRow = &ConvertRowGeneric;
+    }
+
+    conv.srcRowPitch = size_t(width) * fmt.compCount * fmt.compByteWidth;
+  }
+
+  uint32_t numBatches = (height + FloatConversionRowBatch - 1) / FloatConversionRowBatch;
+
+  Threading::ParallelFor(numBatches, &ConvertFloatRows, &conv);
+}
+
 ReplayRenderer::ReplayRenderer()
 {
   m_pDevice = NULL;
@@ -347,12 +844,12 @@ bool ReplayRenderer::GetResolve(uint64_t *callstack, uint32_t callstackLen,
     return true;
   }
 
+  vector<Callstack::AddressDetails> info(callstackLen);
+  resolv->GetAddrs(callstack, callstackLen, &info[0]);
+
   create_array_uninit(*arr, callstackLen);
   for(size_t i = 0; i < callstackLen; i++)
-  {
-    Callstack::AddressDetails info = resolv->GetAddr(callstack[i]);
-    arr->elems[i] = info.formattedString();
-  }
+    arr->elems[i] = info[i].formattedString();
 
   return true;
 }
@@ -402,6 +899,77 @@ bool ReplayRenderer::GetPostVSData(uint32_t instID, MeshDataStage stage, MeshFor
   return true;
 }
 
+bool ReplayRenderer::GetPostVSDataForEvents(uint32_t count, const uint32_t *eventIDs,
+                                            uint32_t instID, MeshFormat *vsData, MeshFormat *gsData)
+{
+  if(count == 0)
+    return true;
+
+  if(eventIDs == NULL || (vsData == NULL && gsData == NULL))
+    return false;
+
+  // only drawcalls have post-transform data, and the driver wants them sorted and unique
+  vector<uint32_t> draws;
+  draws.reserve(count);
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    FetchDrawcall *draw = GetDrawcallByEID(eventIDs[i]);
+
+    if(draw && (draw->flags & eDraw_Drawcall))
+      draws.push_back(draw->eventID);
+  }
+
+  std::sort(draws.begin(), draws.end());
+  draws.erase(std::unique(draws.begin(), draws.end()), draws.end());
+
+  vector<MeshFormat> vs, gs;
+
+  if(!draws.empty())
+  {
+    vector<uint32_t> instIDs(draws.size());
+    for(size_t i = 0; i < draws.size(); i++)
+      instIDs[i] = RDCMIN(instID, RDCMAX(1U, GetDrawcallByEID(draws[i])->numInstances) - 1);
+
+    m_pDevice->InitPostVSBuffers(draws);
+
+    // the replay above leaves the device at whichever event it finished on
+    m_pDevice->ReplayLog(m_EventID, eReplay_Full);
+
+    if(vsData)
+      vs = m_pDevice->GetPostVSBuffersForEvents(draws, instIDs, eMeshDataStage_VSOut);
+    if(gsData)
+      gs = m_pDevice->GetPostVSBuffersForEvents(draws, instIDs, eMeshDataStage_GSOut);
+  }
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    FetchDrawcall *draw = GetDrawcallByEID(eventIDs[i]);
+
+    auto it = draws.end();
+    if(draw)
+      it = std::lower_bound(draws.begin(), draws.end(), draw->eventID);
+
+    if(it == draws.end() || *it != draw->eventID)
+    {
+      if(vsData)
+        vsData[i] = MeshFormat();
+      if(gsData)
+        gsData[i] = MeshFormat();
+      continue;
+    }
+
+    size_t idx = it - draws.begin();
+
+    if(vsData)
+      vsData[i] = vs[idx];
+    if(gsData)
+      gsData[i] = gs[idx];
+  }
+
+  return true;
+}
+
 bool ReplayRenderer::GetBufferData(ResourceId buff, uint64_t offset, uint64_t len,
                                    rdctype::array<byte> *data)
 {
@@ -425,7 +993,7 @@ bool ReplayRenderer::GetBufferData(ResourceId buff, uint64_t offset, uint64_t le
 }
 
 bool ReplayRenderer::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t mip,
-                                    rdctype::array<byte> *data)
+                                    float *progress, rdctype::array<byte> *data)
 {
   if(data == NULL)
     return false;
@@ -438,8 +1006,15 @@ bool ReplayRenderer::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t
     return false;
   }
 
+  GetTextureDataParams params;
+  params.progress = progress;
+
   size_t sz = 0;
-  byte *bytes = m_pDevice->GetTextureData(liveId, arrayIdx, mip, GetTextureDataParams(), sz);
+  byte *bytes = m_pDevice->GetTextureData(liveId, arrayIdx, mip, params, sz);
+
+  // local replays and cached data don't report any progress along the way
+  if(progress)
+    *progress = 1.0f;
 
   if(sz == 0 || bytes == NULL)
     create_array_uninit(*data, 0);
@@ -451,14 +1026,12 @@ bool ReplayRenderer::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t
   return true;
 }
 
-bool ReplayRenderer::SaveTexture(const TextureSave &saveData, const char *path)
+bool ReplayRenderer::ReadbackTextureForSave(const TextureSave &saveData, TextureSaveJob &job)
 {
   TextureSave sd = saveData;    // mutable copy
   ResourceId liveid = m_pDevice->GetLiveID(sd.id);
   FetchTexture td = m_pDevice->GetTexture(liveid);
 
-  bool success = false;
-
   // clamp sample/mip/slice indices
   if(td.msSamp == 1)
   {
@@ -776,6 +1349,30 @@ bool ReplayRenderer::SaveTexture(const TextureSave &saveData, const char *path)
     }
   }
 
+  job.sd = sd;
+  job.td = td;
+  job.subdata.swap(subdata);
+  job.rowPitch = rowPitch;
+  job.numMips = numMips;
+  job.numSlices = numSlices;
+
+  return true;
+}
+
+// does everything after the readback - arranging and converting the data, then encoding and
+// writing the file. Doesn't touch the device, so can run on any thread.
+static bool EncodeSavedTexture(TextureSaveJob &job)
+{
+  TextureSave &sd = job.sd;
+  FetchTexture &td = job.td;
+  vector<byte *> &subdata = job.subdata;
+  uint32_t rowPitch = job.rowPitch;
+  uint32_t numMips = job.numMips;
+  uint32_t numSlices = job.numSlices;
+  const char *path = job.path.c_str();
+
+  bool success = false;
+
   // should have been handled above, but verify incoming data is RGBA8
   if(sd.slice.slicesAsGrid && td.format.compByteWidth == 1 && td.format.compCount == 4)
   {
@@ -1058,127 +1655,25 @@ bool ReplayRenderer::SaveTexture(const TextureSave &saveData, const char *path)
     }
     else if(sd.destType == eFileType_HDR || sd.destType == eFileType_EXR)
     {
-      float *fldata = NULL;
+      // HDR takes interleaved data, EXR takes separate planes. Either way it's one allocation
+      float *fldata = new float[td.width * td.height * 4];
       float *abgr[4] = {NULL, NULL, NULL, NULL};
 
-      if(sd.destType == eFileType_HDR)
-      {
-        fldata = new float[td.width * td.height * 4];
-      }
-      else
+      if(sd.destType == eFileType_EXR)
       {
-        abgr[0] = new float[td.width * td.height];
-        abgr[1] = new float[td.width * td.height];
-        abgr[2] = new float[td.width * td.height];
-        abgr[3] = new float[td.width * td.height];
+        for(int i = 0; i < 4; i++)
+          abgr[i] = fldata + td.width * td.height * i;
       }
 
-      byte *srcData = subdata[0];
-
       ResourceFormat saveFmt = td.format;
       if(saveFmt.compType == eCompType_None)
         saveFmt.compType = sd.typeHint;
       if(saveFmt.compType == eCompType_None)
         saveFmt.compType = saveFmt.compByteWidth == 4 ? eCompType_Float : eCompType_UNorm;
 
-      for(uint32_t y = 0; y < td.height; y++)
-      {
-        for(uint32_t x = 0; x < td.width; x++)
-        {
-          float r = 0.0f;
-          float g = 0.0f;
-          float b = 0.0f;
-          float a = 1.0f;
-
-          if(saveFmt.special && saveFmt.specialFormat == eSpecial_R10G10B10A2)
-          {
-            uint32_t *u32 = (uint32_t *)srcData;
-
-            Vec4f vec = ConvertFromR10G10B10A2(*u32);
-
-            r = vec.x;
-            g = vec.y;
-            b = vec.z;
-            a = vec.w;
-
-            srcData += 4;
-          }
-          else if(saveFmt.special && saveFmt.specialFormat == eSpecial_R11G11B10)
-          {
-            uint32_t *u32 = (uint32_t *)srcData;
-
-            Vec3f vec = ConvertFromR11G11B10(*u32);
-
-            r = vec.x;
-            g = vec.y;
-            b = vec.z;
-            a = 1.0f;
-
-            srcData += 4;
-          }
-          else
-          {
-            if(saveFmt.compCount >= 1)
-              r = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 0);
-            if(saveFmt.compCount >= 2)
-              g = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 1);
-            if(saveFmt.compCount >= 3)
-              b = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 2);
-            if(saveFmt.compCount >= 4)
-              a = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 3);
-
-            srcData += saveFmt.compCount * saveFmt.compByteWidth;
-          }
-
-          if(saveFmt.bgraOrder)
-            std::swap(r, b);
-
-          // HDR can't represent negative values
-          if(sd.destType == eFileType_HDR)
-          {
-            r = RDCMAX(r, 0.0f);
-            g = RDCMAX(g, 0.0f);
-            b = RDCMAX(b, 0.0f);
-            a = RDCMAX(a, 0.0f);
-          }
-
-          if(sd.channelExtract == 0)
-          {
-            g = b = r;
-            a = 1.0f;
-          }
-          if(sd.channelExtract == 1)
-          {
-            r = b = g;
-            a = 1.0f;
-          }
-          if(sd.channelExtract == 2)
-          {
-            r = g = b;
-            a = 1.0f;
-          }
-          if(sd.channelExtract == 3)
-          {
-            r = g = b = a;
-            a = 1.0f;
-          }
-
-          if(fldata)
-          {
-            fldata[(y * td.width + x) * 4 + 0] = r;
-            fldata[(y * td.width + x) * 4 + 1] = g;
-            fldata[(y * td.width + x) * 4 + 2] = b;
-            fldata[(y * td.width + x) * 4 + 3] = a;
-          }
-          else
-          {
-            abgr[0][(y * td.width + x)] = a;
-            abgr[1][(y * td.width + x)] = b;
-            abgr[2][(y * td.width + x)] = g;
-            abgr[3][(y * td.width + x)] = r;
-          }
-        }
-      }
+      ConvertToFloats(saveFmt, subdata[0], td.width, td.height, sd.destType == eFileType_HDR,
+                      sd.channelExtract, sd.destType == eFileType_HDR ? fldata : NULL,
+                      sd.destType == eFileType_EXR ? abgr : NULL);
 
       if(sd.destType == eFileType_HDR)
       {
@@ -1222,17 +1717,7 @@ bool ReplayRenderer::SaveTexture(const TextureSave &saveData, const char *path)
         free(mem);
       }
 
-      if(fldata)
-      {
-        delete[] fldata;
-      }
-      else
-      {
-        delete[] abgr[0];
-        delete[] abgr[1];
-        delete[] abgr[2];
-        delete[] abgr[3];
-      }
+      delete[] fldata;
     }
 
     FileIO::fclose(f);
@@ -1240,10 +1725,143 @@ bool ReplayRenderer::SaveTexture(const TextureSave &saveData, const char *path)
 
   for(size_t i = 0; i < subdata.size(); i++)
     delete[] subdata[i];
+  subdata.clear();
 
   return success;
 }
 
+bool ReplayRenderer::SaveTexture(const TextureSave &saveData, const char *path)
+{
+  TextureSaveJob job;
+  job.path = path;
+
+  if(!ReadbackTextureForSave(saveData, job))
+    return false;
+
+  return EncodeSavedTexture(job);
+}
+
+struct TextureEncodeQueue
+{
+  Threading::CriticalSection lock;
+  vector<TextureSaveJob *> pending;
+
+  // woken once for every job queued, then once per worker when readback has finished
+  Threading::Semaphore jobQueued;
+  // woken once for every job a worker takes off the queue, to let readback continue
+  Threading::Semaphore slotFree;
+
+  // if there are several workers, each one encodes serially
+  bool serialEncode;
+};
+
+static void TextureEncodeWorker(void *userData)
+{
+  TextureEncodeQueue *queue = (TextureEncodeQueue *)userData;
+
+  Threading::SetInParallelRegion(queue->serialEncode);
+
+  for(;;)
+  {
+    queue->jobQueued.WaitForWake();
+
+    TextureSaveJob *job = NULL;
+
+    {
+      SCOPED_LOCK(queue->lock);
+      if(!queue->pending.empty())
+      {
+        job = queue->pending.front();
+        queue->pending.erase(queue->pending.begin());
+      }
+    }
+
+    // jobs are always queued before the final wakes, so an empty queue means we're done
+    if(job == NULL)
+      return;
+
+    queue->slotFree.Wake();
+
+    job->success = EncodeSavedTexture(*job);
+  }
+}
+
+bool ReplayRenderer::SaveTextures(uint32_t count, const TextureSave *saveData,
+                                  const char *const *paths, bool32 *results)
+{
+  if(count == 0)
+    return true;
+
+  vector<TextureSaveJob> jobs;
+  jobs.resize(count);
+
+  TextureEncodeQueue queue;
+
+  uint32_t numWorkers = RDCMIN(Threading::NumberOfCores(), count);
+
+  queue.serialEncode = numWorkers > 1;
+
+  vector<Threading::ThreadHandle> workers;
+  for(uint32_t i = 0; i < numWorkers; i++)
+  {
+    Threading::ThreadHandle thread = Threading::CreateThread(&TextureEncodeWorker, &queue);
+    if(thread)
+      workers.push_back(thread);
+  }
+
+  // don't let readbacks get too far ahead of encoding, as every queued job holds all of its
+  // texture data in memory.
+  const size_t maxPending = RDCMAX((size_t)2, workers.size() * 2);
+
+  queue.slotFree.Wake((uint32_t)maxPending);
+
+  // readbacks have to happen here in order, since they use the device. Encoding and writing are
+  // handed to the workers as soon as each texture's data is available.
+  for(uint32_t i = 0; i < count; i++)
+  {
+    TextureSaveJob &job = jobs[i];
+    job.path = paths[i];
+    job.success = false;
+
+    if(!ReadbackTextureForSave(saveData[i], job))
+      continue;
+
+    if(workers.empty())
+    {
+      job.success = EncodeSavedTexture(job);
+      continue;
+    }
+
+    queue.slotFree.WaitForWake();
+
+    {
+      SCOPED_LOCK(queue.lock);
+      queue.pending.push_back(&job);
+    }
+
+    queue.jobQueued.Wake();
+  }
+
+  queue.jobQueued.Wake((uint32_t)workers.size());
+
+  for(size_t i = 0; i < workers.size(); i++)
+  {
+    Threading::JoinThread(workers[i]);
+    Threading::CloseThread(workers[i]);
+  }
+
+  bool ret = true;
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    if(results)
+      results[i] = jobs[i].success;
+    ret &= jobs[i].success;
+  }
+
+  return ret;
+}
+
 bool ReplayRenderer::PixelHistory(ResourceId target, uint32_t x, uint32_t y, uint32_t slice,
                                   uint32_t mip, uint32_t sampleIdx, FormatComponentType typeHint,
                                   rdctype::array<PixelModification> *history)
@@ -1354,6 +1972,8 @@ bool ReplayRenderer::DebugVertex(uint32_t vertid, uint32_t instid, uint32_t idx,
 
   *trace = m_pDevice->DebugVertex(m_EventID, vertid, instid, idx, instOffset, vertOffset);
 
+  BuildShaderDebugKeyframes(*trace);
+
   SetFrameEvent(m_EventID, true);
 
   return true;
@@ -1367,6 +1987,8 @@ bool ReplayRenderer::DebugPixel(uint32_t x, uint32_t y, uint32_t sample, uint32_
 
   *trace = m_pDevice->DebugPixel(m_EventID, x, y, sample, primitive);
 
+  BuildShaderDebugKeyframes(*trace);
+
   SetFrameEvent(m_EventID, true);
 
   return true;
@@ -1379,6 +2001,8 @@ bool ReplayRenderer::DebugThread(uint32_t groupid[3], uint32_t threadid[3], Shad
 
   *trace = m_pDevice->DebugThread(m_EventID, groupid, threadid);
 
+  BuildShaderDebugKeyframes(*trace);
+
   SetFrameEvent(m_EventID, true);
 
   return true;
@@ -1876,6 +2500,13 @@ extern "C" RENDERDOC_API bool32 RENDERDOC_CC ReplayRenderer_SaveTexture(IReplayR
   return rend->SaveTexture(saveData, path);
 }
 
+extern "C" RENDERDOC_API bool32 RENDERDOC_CC
+ReplayRenderer_SaveTextures(IReplayRenderer *rend, uint32_t count, const TextureSave *saveData,
+                            const char *const *paths, bool32 *results)
+{
+  return rend->SaveTextures(count, saveData, paths, results);
+}
+
 extern "C" RENDERDOC_API bool32 RENDERDOC_CC ReplayRenderer_GetPostVSData(IReplayRenderer *rend,
                                                                           uint32_t instID,
                                                                           MeshDataStage stage,
@@ -1884,6 +2515,14 @@ extern "C" RENDERDOC_API bool32 RENDERDOC_CC ReplayRenderer_GetPostVSData(IRepla
   return rend->GetPostVSData(instID, stage, data);
 }
 
+extern "C" RENDERDOC_API bool32 RENDERDOC_CC
+ReplayRenderer_GetPostVSDataForEvents(IReplayRenderer *rend, uint32_t count,
+                                      const uint32_t *eventIDs, uint32_t instID,
+                                      MeshFormat *vsData, MeshFormat *gsData)
+{
+  return rend->GetPostVSDataForEvents(count, eventIDs, instID, vsData, gsData);
+}
+
 extern "C" RENDERDOC_API bool32 RENDERDOC_CC ReplayRenderer_GetBufferData(
     IReplayRenderer *rend, ResourceId buff, uint64_t offset, uint64_t len, rdctype::array<byte> *data)
 {
@@ -1892,7 +2531,7 @@ extern "C" RENDERDOC_API bool32 RENDERDOC_CC ReplayRenderer_GetBufferData(
 
 extern "C" RENDERDOC_API bool32 RENDERDOC_CC
 ReplayRenderer_GetTextureData(IReplayRenderer *rend, ResourceId tex, uint32_t arrayIdx,
-                              uint32_t mip, rdctype::array<byte> *data)
+                              uint32_t mip, float *progress, rdctype::array<byte> *data)
 {
-  return rend->GetTextureData(tex, arrayIdx, mip, data);
+  return rend->GetTextureData(tex, arrayIdx, mip, progress, data);
 }
@@ -35,6 +35,21 @@
 
 struct ReplayRenderer;
 
+// a texture being saved to disk, with its data read back and ready to be encoded
+struct TextureSaveJob
+{
+  TextureSave sd;
+  FetchTexture td;
+  std::string path;
+
+  std::vector<byte *> subdata;
+  uint32_t rowPitch;
+  uint32_t numMips;
+  uint32_t numSlices;
+
+  bool success;
+};
+
 struct ReplayOutput : public IReplayOutput
 {
 public:
@@ -175,13 +190,18 @@ public:
   bool DebugThread(uint32_t groupid[3], uint32_t threadid[3], ShaderDebugTrace *trace);
 
   bool GetPostVSData(uint32_t instID, MeshDataStage stage, MeshFormat *data);
+  bool GetPostVSDataForEvents(uint32_t count, const uint32_t *eventIDs, uint32_t instID,
+                              MeshFormat *vsData, MeshFormat *gsData);
 
   bool GetUsage(ResourceId id, rdctype::array<EventUsage> *usage);
 
   bool GetBufferData(ResourceId buff, uint64_t offset, uint64_t len, rdctype::array<byte> *data);
-  bool GetTextureData(ResourceId buff, uint32_t arrayIdx, uint32_t mip, rdctype::array<byte> *data);
+  bool GetTextureData(ResourceId buff, uint32_t arrayIdx, uint32_t mip, float *progress,
+                      rdctype::array<byte> *data);
 
   bool SaveTexture(const TextureSave &saveData, const char *path);
+  bool SaveTextures(uint32_t count, const TextureSave *saveData, const char *const *paths,
+                    bool32 *results);
 
   bool GetCBufferVariableContents(ResourceId shader, const char *entryPoint, uint32_t cbufslot,
                                   ResourceId buffer, uint64_t offs,
@@ -199,6 +219,8 @@ private:
 
   FetchDrawcall *GetDrawcallByEID(uint32_t eventID);
 
+  bool ReadbackTextureForSave(const TextureSave &saveData, TextureSaveJob &job);
+
   IReplayDriver *GetDevice() { return m_pDevice; }
   struct FrameRecord
   {
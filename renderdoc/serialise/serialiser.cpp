@@ -25,9 +25,11 @@
 
 #include "serialiser.h"
 #include <errno.h>
+#include <algorithm>
 #include "3rdparty/lz4/lz4.h"
 #include "common/timing.h"
 #include "core/core.h"
+#include "core/resource_hashmap.h"
 #include "serialise/string_utils.h"
 
 #if ENABLED(RDOC_MSVS)
@@ -237,6 +239,554 @@ struct CompressedFileIO
   size_t m_CompressSize;
 };
 
+// stores data as independently LZ4 compressed blocks, followed by an index of where each block
+// begins. Since there's no dictionary chaining between blocks they can be compressed and
+// decompressed on several threads at once, and reading can begin at any block.
+struct BlockCompressedFileIO
+{
+  static const size_t BlockSize = 1024 * 1024;
+
+  // upper bound on blocks held in memory at once, which is also the most blocks that are
+  // (de)compressed in parallel.
+  static const uint32_t MaxBatchBlocks = 16;
+
+  BlockCompressedFileIO(FILE *f)
+  {
+    m_F = f;
+    m_Base = FileIO::ftell64(f);
+    m_BlockSize = BlockSize;
+    m_CompressedSize = m_UncompressedSize = 0;
+    m_IndexOffset = 0;
+    m_Offset = 0;
+    m_PageOffset = 0;
+    m_DecodedFirst = m_DecodedCount = 0;
+    m_MappedFile = NULL;
+    m_MappedSize = 0;
+
+    m_BatchBlocks = RDCCLAMP(Threading::NumberOfCores(), 1U, MaxBatchBlocks);
+  }
+
+  uint64_t GetCompressedSize() { return m_CompressedSize; }
+  uint64_t GetUncompressedSize() { return m_UncompressedSize; }
+  //////////////////////////////////////////
+  // writing
+
+  // write out some data - accumulate a batch of blocks, then compress them all in parallel when
+  // the batch is full
+  void Write(const void *data, size_t len)
+  {
+    if(data == NULL || len == 0)
+      return;
+
+    if(m_CompressedSize == 0)
+    {
+      // placeholder for the index offset, fixed up in Flush()
+      FileIO::fwrite(&m_IndexOffset, sizeof(m_IndexOffset), 1, m_F);
+      m_CompressedSize = sizeof(m_IndexOffset);
+
+      m_Pages.resize(m_BatchBlocks * m_BlockSize);
+    }
+
+    m_UncompressedSize += len;
+
+    const byte *src = (const byte *)data;
+
+    while(len > 0)
+    {
+      size_t copySize = RDCMIN(len, m_Pages.size() - m_PageOffset);
+
+      memcpy(&m_Pages[m_PageOffset], src, copySize);
+      m_PageOffset += copySize;
+
+      src += copySize;
+      len -= copySize;
+
+      if(m_PageOffset == m_Pages.size())
+        CompressBatch();
+    }
+  }
+
+  // compress and write any pending data, then write out the block index
+  void Flush()
+  {
+    if(m_CompressedSize == 0)
+    {
+      FileIO::fwrite(&m_IndexOffset, sizeof(m_IndexOffset), 1, m_F);
+      m_CompressedSize = sizeof(m_IndexOffset);
+    }
+
+    CompressBatch();
+
+    m_IndexOffset = m_CompressedSize;
+
+    uint32_t blockSize = (uint32_t)m_BlockSize;
+    uint32_t numBlocks = (uint32_t)m_BlockOffsets.size();
+
+    FileIO::fwrite(&blockSize, sizeof(blockSize), 1, m_F);
+    FileIO::fwrite(&numBlocks, sizeof(numBlocks), 1, m_F);
+    if(numBlocks > 0)
+      FileIO::fwrite(&m_BlockOffsets[0], sizeof(uint64_t), numBlocks, m_F);
+
+    m_CompressedSize += sizeof(blockSize) + sizeof(numBlocks) + sizeof(uint64_t) * numBlocks;
+
+    uint64_t curoffs = FileIO::ftell64(m_F);
+
+    FileIO::fseek64(m_F, m_Base, SEEK_SET);
+    FileIO::fwrite(&m_IndexOffset, sizeof(m_IndexOffset), 1, m_F);
+    FileIO::fseek64(m_F, curoffs, SEEK_SET);
+  }
+
+  //////////////////////////////////////////
+  // reading
+
+  // reads the block index, and leaves the file pointing immediately after the section so that
+  // any following sections can be read.
+  bool ReadIndex()
+  {
+    FileIO::fseek64(m_F, m_Base, SEEK_SET);
+
+    uint32_t blockSize = 0, numBlocks = 0;
+
+    FileIO::fread(&m_IndexOffset, sizeof(m_IndexOffset), 1, m_F);
+    FileIO::fseek64(m_F, m_Base + m_IndexOffset, SEEK_SET);
+    FileIO::fread(&blockSize, sizeof(blockSize), 1, m_F);
+    FileIO::fread(&numBlocks, sizeof(numBlocks), 1, m_F);
+
+    if(m_IndexOffset < sizeof(m_IndexOffset) || blockSize == 0 || FileIO::feof(m_F))
+    {
+      RDCERR("Invalid block index at offset %llu, block size %u", m_IndexOffset, blockSize);
+      return false;
+    }
+
+    m_BlockSize = blockSize;
+    m_BlockOffsets.resize(numBlocks);
+
+    if(numBlocks > 0 &&
+       FileIO::fread(&m_BlockOffsets[0], sizeof(uint64_t), numBlocks, m_F) != numBlocks)
+    {
+      RDCERR("Truncated block index, expected %u blocks", numBlocks);
+      return false;
+    }
+
+    for(uint32_t i = 0; i < numBlocks; i++)
+    {
+      if(m_BlockOffsets[i] >= m_IndexOffset || (i > 0 && m_BlockOffsets[i] <= m_BlockOffsets[i - 1]))
+      {
+        RDCERR("Invalid offset %llu for block %u", m_BlockOffsets[i], i);
+        return false;
+      }
+    }
+
+    m_CompressedSize = m_IndexOffset + sizeof(blockSize) + sizeof(numBlocks) +
+                       sizeof(uint64_t) * numBlocks;
+
+    return true;
+  }
+
+  // if the whole file is mapped into memory, compressed blocks are decoded straight out of the
+  // mapping instead of being read through the FILE*. The mapping must outlive this reader.
+  void SetMappedFile(const byte *mapped, uint64_t size)
+  {
+    m_MappedFile = mapped;
+    m_MappedSize = size;
+  }
+
+  // set the position in the uncompressed data that the next Read() will come from
+  void Seek(uint64_t offset) { m_Offset = offset; }
+  void Reset() { Seek(0); }
+  // read out some data - decompressing a batch of blocks if the data isn't already available
+  void Read(byte *data, size_t len)
+  {
+    if(data == NULL || len == 0)
+      return;
+
+    while(len > 0)
+    {
+      uint32_t block = uint32_t(m_Offset / m_BlockSize);
+
+      if(block < m_DecodedFirst || block >= m_DecodedFirst + m_DecodedCount)
+      {
+        if(!DecompressBatch(block))
+        {
+          memset(data, 0, len);
+          return;
+        }
+      }
+
+      const vector<byte> &decoded = m_Decoded[block - m_DecodedFirst];
+
+      size_t blockOffset = size_t(m_Offset % m_BlockSize);
+
+      if(blockOffset >= decoded.size())
+      {
+        RDCERR("Reading past end of block %u", block);
+        memset(data, 0, len);
+        return;
+      }
+
+      size_t readSize = RDCMIN(len, decoded.size() - blockOffset);
+
+      memcpy(data, &decoded[blockOffset], readSize);
+
+      m_Offset += readSize;
+      data += readSize;
+      len -= readSize;
+    }
+  }
+
+  // decompress a whole in-memory section, starting at the index offset
+  static void Decompress(byte *destBuf, size_t destLen, const byte *srcBuf, size_t len)
+  {
+    DecompressJob job = {};
+    job.src = srcBuf;
+    job.dest = destBuf;
+    job.destSize = destLen;
+
+    uint64_t indexOffset = 0;
+    if(len < sizeof(indexOffset))
+      return;
+
+    memcpy(&indexOffset, srcBuf, sizeof(indexOffset));
+
+    if(indexOffset + sizeof(uint32_t) * 2 > len)
+      return;
+
+    uint32_t numBlocks = 0;
+    memcpy(&job.blockSize, srcBuf + indexOffset, sizeof(uint32_t));
+    memcpy(&numBlocks, srcBuf + indexOffset + sizeof(uint32_t), sizeof(uint32_t));
+
+    if(job.blockSize == 0 || indexOffset + sizeof(uint32_t) * 2 + sizeof(uint64_t) * numBlocks > len)
+      return;
+
+    job.offsets = (const uint64_t *)(srcBuf + indexOffset + sizeof(uint32_t) * 2);
+    job.end = indexOffset;
+
+    Threading::ParallelFor(numBlocks, &DecompressInMemoryBlock, &job);
+  }
+
+private:
+  void CompressBatch()
+  {
+    if(m_PageOffset == 0)
+      return;
+
+    uint32_t numBlocks = uint32_t((m_PageOffset + m_BlockSize - 1) / m_BlockSize);
+
+    m_CompressBufs.resize(numBlocks);
+    m_CompressSizes.resize(numBlocks);
+
+    for(uint32_t i = 0; i < numBlocks; i++)
+      m_CompressBufs[i].resize(LZ4_COMPRESSBOUND(m_BlockSize));
+
+    Threading::ParallelFor(numBlocks, &CompressBlock, this);
+
+    // blocks are written in order so the file doesn't depend on thread timing
+    for(uint32_t i = 0; i < numBlocks; i++)
+    {
+      int32_t compSize = m_CompressSizes[i];
+
+      if(compSize <= 0)
+      {
+        RDCERR("Error compressing: %i", compSize);
+        compSize = 0;
+      }
+
+      m_BlockOffsets.push_back(m_CompressedSize);
+
+      FileIO::fwrite(&compSize, sizeof(compSize), 1, m_F);
+      FileIO::fwrite(&m_CompressBufs[i][0], 1, compSize, m_F);
+
+      m_CompressedSize += compSize + sizeof(int32_t);
+    }
+
+    m_PageOffset = 0;
+  }
+
+  static void CompressBlock(void *ths, uint32_t idx)
+  {
+    BlockCompressedFileIO *io = (BlockCompressedFileIO *)ths;
+
+    size_t offs = idx * io->m_BlockSize;
+    size_t size = RDCMIN(io->m_BlockSize, io->m_PageOffset - offs);
+
+    io->m_CompressSizes[idx] =
+        LZ4_compress_fast((const char *)&io->m_Pages[offs], (char *)&io->m_CompressBufs[idx][0],
+                          (int)size, (int)io->m_CompressBufs[idx].size(), 1);
+  }
+
+  struct DecompressJob
+  {
+    const byte *src;
+    const uint64_t *offsets;
+    uint64_t base;
+    uint64_t end;
+    uint32_t blockSize;
+    byte *dest;
+    uint64_t destSize;
+    vector<byte> *decoded;
+  };
+
+  bool DecompressBatch(uint32_t block)
+  {
+    if(block >= m_BlockOffsets.size())
+    {
+      RDCERR("Reading block %u past end of section (%u blocks)", block,
+             (uint32_t)m_BlockOffsets.size());
+      return false;
+    }
+
+    uint32_t count = RDCMIN(m_BatchBlocks, uint32_t(m_BlockOffsets.size() - block));
+
+    // the compressed blocks are contiguous, so read the whole batch at once
+    uint64_t start = m_BlockOffsets[block];
+    uint64_t end = block + count < m_BlockOffsets.size() ? m_BlockOffsets[block + count] : m_IndexOffset;
+
+    const byte *src = NULL;
+
+    if(m_MappedFile && m_Base + end <= m_MappedSize)
+    {
+      src = m_MappedFile + m_Base + start;
+    }
+    else
+    {
+      m_CompressedData.resize(size_t(end - start));
+
+      FileIO::fseek64(m_F, m_Base + start, SEEK_SET);
+      if(FileIO::fread(&m_CompressedData[0], 1, m_CompressedData.size(), m_F) !=
+         m_CompressedData.size())
+      {
+        RDCERR("Truncated compressed data reading block %u", block);
+        return false;
+      }
+
+      src = &m_CompressedData[0];
+    }
+
+    m_Decoded.resize(count);
+    for(uint32_t i = 0; i < count; i++)
+      m_Decoded[i].resize(m_BlockSize);
+
+    DecompressJob job = {};
+    job.src = src;
+    job.offsets = &m_BlockOffsets[block];
+    job.base = start;
+    job.end = end;
+    job.blockSize = (uint32_t)m_BlockSize;
+    job.decoded = &m_Decoded[0];
+
+    Threading::ParallelFor(count, &DecompressFileBlock, &job);
+
+    m_DecodedFirst = block;
+    m_DecodedCount = count;
+
+    return true;
+  }
+
+  // decompresses block idx of a job into its own buffer, sized to the decompressed data
+  static void DecompressFileBlock(void *data, uint32_t idx)
+  {
+    DecompressJob *job = (DecompressJob *)data;
+
+    vector<byte> &decoded = job->decoded[idx];
+
+    int32_t decompSize = DecompressBlock(job, idx, &decoded[0], job->blockSize);
+
+    decoded.resize(decompSize > 0 ? decompSize : 0);
+  }
+
+  // decompresses block idx of a job directly into place in a single destination buffer
+  static void DecompressInMemoryBlock(void *data, uint32_t idx)
+  {
+    DecompressJob *job = (DecompressJob *)data;
+
+    uint64_t destOffs = uint64_t(idx) * job->blockSize;
+
+    if(destOffs >= job->destSize)
+    {
+      RDCERR("Block %u is past the end of the decompressed data", idx);
+      return;
+    }
+
+    DecompressBlock(job, idx, job->dest + destOffs,
+                    (uint32_t)RDCMIN(uint64_t(job->blockSize), job->destSize - destOffs));
+  }
+
+  static int32_t DecompressBlock(DecompressJob *job, uint32_t idx, byte *dest, uint32_t destSize)
+  {
+    uint64_t offs = job->offsets[idx] - job->base;
+
+    int32_t compSize = 0;
+
+    if(offs + sizeof(compSize) > job->end - job->base)
+    {
+      RDCERR("Block %u is out of bounds", idx);
+      return -1;
+    }
+
+    memcpy(&compSize, job->src + offs, sizeof(compSize));
+    offs += sizeof(compSize);
+
+    if(compSize < 0 || offs + compSize > job->end - job->base)
+    {
+      RDCERR("Block %u has invalid compressed size %i", idx, compSize);
+      return -1;
+    }
+
+    int32_t decompSize =
+        LZ4_decompress_safe((const char *)job->src + offs, (char *)dest, compSize, (int)destSize);
+
+    if(decompSize < 0)
+      RDCERR("Error decompressing block %u: %i", idx, decompSize);
+
+    return decompSize;
+  }
+
+  FILE *m_F;
+
+  // file offset of the start of the section data, all offsets are relative to this
+  uint64_t m_Base;
+
+  size_t m_BlockSize;
+  uint32_t m_BatchBlocks;
+
+  uint64_t m_CompressedSize, m_UncompressedSize;
+  uint64_t m_IndexOffset;
+  vector<uint64_t> m_BlockOffsets;
+
+  // writing
+  vector<byte> m_Pages;
+  size_t m_PageOffset;
+  vector<vector<byte> > m_CompressBufs;
+  vector<int32_t> m_CompressSizes;
+
+  // reading
+  uint64_t m_Offset;
+  const byte *m_MappedFile;
+  uint64_t m_MappedSize;
+  vector<byte> m_CompressedData;
+  vector<vector<byte> > m_Decoded;
+  uint32_t m_DecodedFirst, m_DecodedCount;
+};
+
+struct ChunkPage
+{
+  // one reference for each chunk allocated in the page, plus one held by the arena while this is
+  // its current page
+  volatile int32_t refcount;
+  uint32_t used;
+  byte *data;
+  // pages not from an arena wrap a single heap-allocated chunk so that it can be shared, and free
+  // the allocation instead of going back to the pool.
+  bool arena;
+  bool aligned;
+};
+
+// freed pages are kept for reuse up to this limit, beyond that they're deallocated
+static const size_t MaxPooledChunkPages = 256;
+
+struct ChunkPagePool
+{
+  Threading::CriticalSection lock;
+  vector<ChunkPage *> pages;
+};
+
+static ChunkPagePool &GetChunkPagePool()
+{
+  // deliberately never destroyed, as chunks can be freed during static destruction
+  static ChunkPagePool *pool = new ChunkPagePool();
+  return *pool;
+}
+
+static ChunkPage *AllocChunkPage()
+{
+  ChunkPage *page = NULL;
+
+  {
+    ChunkPagePool &pool = GetChunkPagePool();
+    SCOPED_LOCK(pool.lock);
+    if(!pool.pages.empty())
+    {
+      page = pool.pages.back();
+      pool.pages.pop_back();
+    }
+  }
+
+  if(page == NULL)
+  {
+    page = new ChunkPage;
+    page->data = Serialiser::AllocAlignedBuffer(ChunkArena::PageSize, ChunkArena::AllocAlignment);
+  }
+
+  page->refcount = 1;
+  page->used = 0;
+  page->arena = true;
+  page->aligned = true;
+
+  return page;
+}
+
+ChunkArena::~ChunkArena()
+{
+  if(m_Current)
+    Release(m_Current);
+  m_Current = NULL;
+}
+
+byte *ChunkArena::Alloc(uint32_t size, ChunkPage *&page)
+{
+  if(size > MaxAllocSize)
+    return NULL;
+
+  uint32_t offset = 0;
+
+  if(m_Current)
+    offset = AlignUp(m_Current->used, AllocAlignment);
+
+  if(m_Current == NULL || offset + size > PageSize)
+  {
+    if(m_Current)
+      Release(m_Current);
+
+    m_Current = AllocChunkPage();
+    offset = 0;
+  }
+
+  Atomic::Inc32(&m_Current->refcount);
+  m_Current->used = offset + size;
+
+  page = m_Current;
+  return m_Current->data + offset;
+}
+
+void ChunkArena::Release(ChunkPage *page)
+{
+  if(Atomic::Dec32(&page->refcount) != 0)
+    return;
+
+  if(!page->arena)
+  {
+    if(page->aligned)
+      Serialiser::FreeAlignedBuffer(page->data);
+    else
+      delete[] page->data;
+    delete page;
+    return;
+  }
+
+  {
+    ChunkPagePool &pool = GetChunkPagePool();
+    SCOPED_LOCK(pool.lock);
+    if(pool.pages.size() < MaxPooledChunkPages)
+    {
+      pool.pages.push_back(page);
+      return;
+    }
+  }
+
+  Serialiser::FreeAlignedBuffer(page->data);
+  delete page;
+}
+
 Chunk::Chunk(Serialiser *ser, uint32_t chunkType, bool temporary)
 {
   m_Length = (uint32_t)ser->GetOffset();
@@ -246,8 +796,20 @@ Chunk::Chunk(Serialiser *ser, uint32_t chunkType, bool temporary)
   m_ChunkType = chunkType;
 
   m_Temporary = temporary;
+  m_DataMutable = false;
+
+  m_Page = NULL;
+  m_Data = NULL;
+
+  // arena allocations are always aligned, so they can be used for aligned data too
+  if(ser->GetChunkArena())
+    m_Data = ser->GetChunkArena()->Alloc(m_Length, m_Page);
 
-  if(ser->HasAlignedData())
+  if(m_Data)
+  {
+    m_AlignedData = ser->HasAlignedData();
+  }
+  else if(ser->HasAlignedData())
   {
     m_Data = Serialiser::AllocAlignedBuffer(m_Length);
     m_AlignedData = true;
@@ -286,7 +848,9 @@ Chunk *Chunk::Duplicate()
   ret->m_Length = m_Length;
   ret->m_ChunkType = m_ChunkType;
   ret->m_Temporary = m_Temporary;
+  ret->m_DataMutable = false;
   ret->m_AlignedData = m_AlignedData;
+  ret->m_Page = NULL;
 
   if(m_AlignedData)
     ret->m_Data = Serialiser::AllocAlignedBuffer(m_Length);
@@ -311,6 +875,43 @@ Chunk *Chunk::Duplicate()
   return ret;
 }
 
+Chunk *Chunk::Share()
+{
+  if(m_Page == NULL)
+  {
+    // wrap our heap allocation so that it's reference counted like an arena page. Whichever of
+    // the chunks is deleted last frees it.
+    ChunkPage *page = new ChunkPage;
+    page->refcount = 1;
+    page->used = m_Length;
+    page->data = m_Data;
+    page->arena = false;
+    page->aligned = m_AlignedData;
+    m_Page = page;
+  }
+
+  Atomic::Inc32(&m_Page->refcount);
+
+  RDCASSERT(!m_DataMutable);
+
+  Chunk *ret = new Chunk();
+  ret->m_DebugStr = m_DebugStr;
+  ret->m_Length = m_Length;
+  ret->m_ChunkType = m_ChunkType;
+  ret->m_Temporary = m_Temporary;
+  ret->m_DataMutable = false;
+  ret->m_AlignedData = m_AlignedData;
+  ret->m_Data = m_Data;
+  ret->m_Page = m_Page;
+
+#if ENABLED(RDOC_DEVEL)
+  Atomic::Inc64(&m_LiveChunks);
+  Atomic::ExchAdd64(&m_TotalMem, m_Length);
+#endif
+
+  return ret;
+}
+
 Chunk::~Chunk()
 {
 #if ENABLED(RDOC_DEVEL)
@@ -318,7 +919,14 @@ Chunk::~Chunk()
   Atomic::ExchAdd64(&m_TotalMem, -int64_t(m_Length));
 #endif
 
-  if(m_AlignedData)
+  if(m_Page)
+  {
+    ChunkArena::Release(m_Page);
+
+    m_Page = NULL;
+    m_Data = NULL;
+  }
+  else if(m_AlignedData)
   {
     if(m_Data)
       Serialiser::FreeAlignedBuffer(m_Data);
@@ -399,6 +1007,41 @@ Chunk::~Chunk()
  // binary form
  Section sections[];
 
+ -----------------------------
+ File format for version 0x33:
+
+ Identical to 0x32, except binary sections can also be stored with eSectionFlag_LZ4Blocks, and
+ the frame capture section is always written that way. The section data is then:
+
+ uint64_t uncompressedLength;
+ uint64_t blockIndexOffset; // where the block index starts, relative to this field
+
+ Block
+ {
+   int32_t compressedSize;
+   byte compressedData[compressedSize]; // decompresses to blockSize bytes, except the last block
+ };
+
+ Block blocks[]; // each compressed independently, with no dictionary shared between blocks
+
+ uint32_t blockSize;
+ uint32_t numBlocks;
+ // where each Block starts, relative to the blockIndexOffset field (not to the index), the same
+ // base blockIndexOffset itself is relative to
+ uint64_t blockOffsets[numBlocks];
+
+ The frame capture can be followed by an uncompressed chunk index section, which is optional for
+ readers:
+
+ ChunkIndexEntry
+ {
+   uint64_t offset; // where the chunk starts in the uncompressed frame capture data
+   uint32_t chunkType;
+   uint32_t length; // byte length of the chunk, including its header
+ };
+
+ ChunkIndexEntry entries[sectionLength / sizeof(ChunkIndexEntry)]; // sorted by offset
+
 */
 
 struct FileHeader
@@ -437,7 +1080,12 @@ struct BinarySectionHeader
   }
 
 Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
-    : m_pCallstack(NULL), m_pResolver(NULL), m_Buffer(NULL)
+    : m_pCallstack(NULL),
+      m_pResolver(NULL),
+      m_Buffer(NULL),
+      m_MappedFile(NULL),
+      m_MappedSize(0),
+      m_BufferMapped(false)
 {
   m_ResolverThread = 0;
 
@@ -447,6 +1095,8 @@ Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
 
   RDCCOMPILE_ASSERT(offsetof(BinarySectionHeader, name) == sizeof(uint32_t) * 5,
                     "BinarySectionHeader size has changed or contains padding");
+  RDCCOMPILE_ASSERT(sizeof(ChunkIndexEntry) == sizeof(uint64_t) * 2,
+                    "ChunkIndexEntry size has changed or contains padding");
 
   Reset();
 
@@ -533,7 +1183,7 @@ Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
     m_Sections.push_back(frameCap);
     m_KnownSections[eSectionType_FrameCapture] = frameCap;
   }
-  else if(header->version == SERIALISE_VERSION)
+  else if(header->version >= 0x00000032 && header->version <= SERIALISE_VERSION)
   {
     memoryBuf += sizeof(FileHeader);
 
@@ -628,6 +1278,11 @@ Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
   {
     CompressedFileIO::Decompress(m_Buffer, memoryBuf, memoryBufEnd - memoryBuf);
   }
+  else if(m_KnownSections[eSectionType_FrameCapture]->flags & eSectionFlag_LZ4Blocks)
+  {
+    BlockCompressedFileIO::Decompress(m_Buffer, m_CurrentBufferSize, memoryBuf,
+                                      memoryBufEnd - memoryBuf);
+  }
   else
   {
     memcpy(m_Buffer, memoryBuf, m_CurrentBufferSize);
@@ -635,7 +1290,12 @@ Serialiser::Serialiser(size_t length, const byte *memoryBuf, bool fileheader)
 }
 
 Serialiser::Serialiser(const char *path, Mode mode, bool debugMode, uint64_t sizeHint)
-    : m_pCallstack(NULL), m_pResolver(NULL), m_Buffer(NULL)
+    : m_pCallstack(NULL),
+      m_pResolver(NULL),
+      m_Buffer(NULL),
+      m_MappedFile(NULL),
+      m_MappedSize(0),
+      m_BufferMapped(false)
 {
   m_ResolverThread = 0;
 
@@ -742,7 +1402,7 @@ Serialiser::Serialiser(const char *path, Mode mode, bool debugMode, uint64_t siz
       m_Sections.push_back(frameCap);
       m_KnownSections[eSectionType_FrameCapture] = frameCap;
     }
-    else if(header.version == SERIALISE_VERSION)
+    else if(header.version >= 0x00000032 && header.version <= SERIALISE_VERSION)
     {
       while(!FileIO::feof(m_ReadFileHandle))
       {
@@ -865,14 +1525,31 @@ Serialiser::Serialiser(const char *path, Mode mode, bool debugMode, uint64_t siz
 
             sect->fileoffset += sizeof(uint64_t);
           }
+          else if(sect->flags & eSectionFlag_LZ4Blocks)
+          {
+            FileIO::fread(&sect->size, 1, sizeof(uint64_t), m_ReadFileHandle);
+
+            sect->fileoffset += sizeof(uint64_t);
+
+            sect->blockReader = new BlockCompressedFileIO(m_ReadFileHandle);
+          }
 
           if(sect->type != eSectionType_Unknown && sect->type < eSectionType_Num)
             m_KnownSections[sect->type] = sect;
           m_Sections.push_back(sect);
 
+          if(sect->blockReader)
+          {
+            // the block index is at the end of the section, so reading it leaves us at the start of
+            // the next section
+            if(!sect->blockReader->ReadIndex())
+              RETURNCORRUPT("Invalid block index in section '%s'", sect->name.c_str());
+          }
           // if section isn't frame capture data and is small enough, read it all into memory now,
-          // otherwise skip
-          if(sect->type != eSectionType_FrameCapture && sectionHeader.sectionLength < 4 * 1024 * 1024)
+          // otherwise skip. The chunk index is always needed, whatever its size.
+          else if((sect->type != eSectionType_FrameCapture &&
+                   sectionHeader.sectionLength < 4 * 1024 * 1024) ||
+                  sect->type == eSectionType_ChunkIndex || sect->type == eSectionType_Callstacks)
           {
             sect->data.resize(sectionHeader.sectionLength);
             FileIO::fread(&sect->data[0], 1, sectionHeader.sectionLength, m_ReadFileHandle);
@@ -913,16 +1590,48 @@ Serialiser::Serialiser(const char *path, Mode mode, bool debugMode, uint64_t siz
       return;
     }
 
-    m_BufferSize = m_KnownSections[eSectionType_FrameCapture]->size;
-    m_CurrentBufferSize = (size_t)RDCMIN(m_BufferSize, (uint64_t)64 * 1024);
-    m_BufferHead = m_Buffer = AllocAlignedBuffer(m_CurrentBufferSize);
+    Section *frameCap = m_KnownSections[eSectionType_FrameCapture];
+
+    m_BufferSize = frameCap->size;
     m_ReadOffset = 0;
 
-    FileIO::fseek64(m_ReadFileHandle, m_KnownSections[eSectionType_FrameCapture]->fileoffset,
-                    SEEK_SET);
+    LoadChunkIndex();
+    LoadCallstacks();
 
-    // read initial buffer of data
-    ReadFromFile(0, m_CurrentBufferSize);
+    // uncompressed data can be read straight out of a mapping of the file, then the whole section
+    // is in our window from the start and only the pages we touch are ever read from disk.
+    // Block compressed data still decodes into a heap window, but the compressed blocks are
+    // decoded directly from the mapping rather than being read into a staging buffer first.
+    const uint32_t compressedFlags = eSectionFlag_LZ4Compressed | eSectionFlag_LZ4Blocks;
+    bool uncompressed = (frameCap->flags & compressedFlags) == 0;
+
+    if((uncompressed && frameCap->fileoffset + m_BufferSize <= m_FileSize) || frameCap->blockReader)
+    {
+      m_MappedFile = (const byte *)FileIO::fmap(m_ReadFileHandle, m_FileSize);
+      m_MappedSize = m_FileSize;
+    }
+
+    if(m_MappedFile && frameCap->blockReader)
+      frameCap->blockReader->SetMappedFile(m_MappedFile, m_MappedSize);
+
+    if(m_MappedFile && uncompressed)
+    {
+      RDCDEBUG("Mapped capture file for read");
+
+      m_BufferMapped = true;
+      m_CurrentBufferSize = (size_t)m_BufferSize;
+      m_BufferHead = m_Buffer = (byte *)m_MappedFile + frameCap->fileoffset;
+    }
+    else
+    {
+      m_CurrentBufferSize = (size_t)RDCMIN(m_BufferSize, (uint64_t)64 * 1024);
+      m_BufferHead = m_Buffer = AllocAlignedBuffer(m_CurrentBufferSize);
+
+      FileIO::fseek64(m_ReadFileHandle, frameCap->fileoffset, SEEK_SET);
+
+      // read initial buffer of data
+      ReadFromFile(0, m_CurrentBufferSize);
+    }
   }
   else
   {
@@ -968,18 +1677,20 @@ void Serialiser::Reset()
 
   SAFE_DELETE(m_pCallstack);
   SAFE_DELETE(m_pResolver);
-  if(m_Buffer)
-  {
-    FreeAlignedBuffer(m_Buffer);
-    m_Buffer = NULL;
-  }
+  FreeWindow();
 
   m_ChunkLookup = NULL;
 
   m_AlignedData = false;
 
+  m_ChunkArena = NULL;
+  m_ChunkArenaActive = false;
+
   m_ReadFileHandle = NULL;
 
+  m_FirstCallstackID = 0;
+  m_CallstacksSnapshotted = false;
+
   m_ReadOffset = 0;
 
   m_BufferHead = m_Buffer = NULL;
@@ -1006,6 +1717,7 @@ Serialiser::~Serialiser()
   for(size_t i = 0; i < m_Sections.size(); i++)
   {
     SAFE_DELETE(m_Sections[i]->compressedReader);
+    SAFE_DELETE(m_Sections[i]->blockReader);
     SAFE_DELETE(m_Sections[i]);
   }
 
@@ -1019,13 +1731,15 @@ Serialiser::~Serialiser()
 
   SAFE_DELETE(m_pResolver);
   SAFE_DELETE(m_pCallstack);
-  if(m_Buffer)
+  SAFE_DELETE(m_ChunkArena);
+  FreeWindow();
+  m_BufferHead = NULL;
+
+  if(m_MappedFile)
   {
-    FreeAlignedBuffer(m_Buffer);
-    m_Buffer = NULL;
+    FileIO::funmap(m_MappedFile, m_MappedSize);
+    m_MappedFile = NULL;
   }
-  m_Buffer = NULL;
-  m_BufferHead = NULL;
 }
 
 void Serialiser::WriteBytes(const byte *buf, size_t nBytes)
@@ -1072,6 +1786,20 @@ void *Serialiser::ReadBytes(size_t nBytes)
   // if we would read off the end of our current window
   if(m_BufferHead + nBytes > m_Buffer + m_CurrentBufferSize)
   {
+    // a mapped window already covers the whole section, so we can only get here with corrupt
+    // data. Copy the window out of the mapping so it can be handled like any other window below.
+    if(m_BufferMapped)
+    {
+      RDCWARN("Reading %llu bytes past the end of mapped capture data", (uint64_t)nBytes);
+
+      byte *copy = AllocAlignedBuffer(m_CurrentBufferSize);
+      memcpy(copy, m_Buffer, m_CurrentBufferSize);
+
+      m_BufferHead = copy + (m_BufferHead - m_Buffer);
+      m_Buffer = copy;
+      m_BufferMapped = false;
+    }
+
     // store old buffer and the read data, so we can move it into the new buffer
     byte *oldBuffer = m_Buffer;
 
@@ -1139,12 +1867,27 @@ void Serialiser::ReadFromFile(uint64_t bufferOffs, size_t length)
     RDCASSERT(s->compressedReader);
     s->compressedReader->Read(m_Buffer + bufferOffs, length);
   }
+  else if(s->flags & eSectionFlag_LZ4Blocks)
+  {
+    RDCASSERT(s->blockReader);
+    s->blockReader->Read(m_Buffer + bufferOffs, length);
+  }
   else
   {
     FileIO::fread(m_Buffer + bufferOffs, 1, length, m_ReadFileHandle);
   }
 }
 
+void Serialiser::FreeWindow()
+{
+  // a mapped window is released along with the mapping itself
+  if(m_Buffer && !m_BufferMapped)
+    FreeAlignedBuffer(m_Buffer);
+
+  m_Buffer = NULL;
+  m_BufferMapped = false;
+}
+
 byte *Serialiser::AllocAlignedBuffer(size_t size, size_t alignment)
 {
   byte *rawAlloc = NULL;
@@ -1200,6 +1943,16 @@ void Serialiser::SetPersistentBlock(uint64_t offs)
   // ensure sane offset
   RDCASSERT(offs < m_BufferSize);
 
+  // if the window is mapped, everything is already resident
+  if(m_BufferMapped)
+  {
+    RDCASSERT(m_ReadFileHandle);
+
+    FileIO::fclose(m_ReadFileHandle);
+    m_ReadFileHandle = 0;
+    return;
+  }
+
   size_t persistentSize = (size_t)(m_BufferSize - offs);
 
   // allocate our persistent buffer
@@ -1215,7 +1968,7 @@ void Serialiser::SetPersistentBlock(uint64_t offs)
 
   memcpy(newBuf, persistentBase, persistentInMemory);
 
-  FreeAlignedBuffer(m_Buffer);
+  FreeWindow();
 
   m_CurrentBufferSize = persistentSize;
   m_Buffer = newBuf;
@@ -1245,29 +1998,52 @@ void Serialiser::SetOffset(uint64_t offs)
     return;
   }
 
+  // offsets can come from the file (e.g. the chunk index) so don't trust them to be in range
+  if(m_Mode == READING && offs > m_BufferSize)
+  {
+    RDCERR("Setting offset %llu past the end of the serialiser (%llu bytes)", offs, m_BufferSize);
+    m_ErrorCode = eSerError_Corrupt;
+    m_HasError = true;
+    return;
+  }
+
+  Section *frameCap = m_KnownSections[eSectionType_FrameCapture];
+
+  // block compressed data can be read starting from anywhere, so we can also move the window to
+  // jump forward past what's in memory
+  bool seekable = IsSeekable();
+
   // if we're jumping back before our in-memory window just reset the window
   // and load it all in from scratch.
-  if(m_Mode == READING && offs < m_ReadOffset)
+  if(m_Mode == READING &&
+     (offs < m_ReadOffset || (seekable && offs > m_ReadOffset + m_CurrentBufferSize)))
   {
     // if we're reading from file, only support rewinding all the way to the start
-    RDCASSERT(m_ReadFileHandle == NULL || offs == 0);
+    RDCASSERT(m_ReadFileHandle == NULL || offs == 0 || seekable);
 
     if(m_ReadFileHandle)
     {
-      Section *s = m_KnownSections[eSectionType_FrameCapture];
-      RDCASSERT(s);
-      FileIO::fseek64(m_ReadFileHandle, s->fileoffset, SEEK_SET);
+      RDCASSERT(frameCap);
 
-      if(s->flags & eSectionFlag_LZ4Compressed)
+      if(frameCap->blockReader)
+      {
+        frameCap->blockReader->Seek(offs);
+      }
+      else
       {
-        RDCASSERT(s->compressedReader);
-        s->compressedReader->Reset();
+        FileIO::fseek64(m_ReadFileHandle, frameCap->fileoffset, SEEK_SET);
+
+        if(frameCap->flags & eSectionFlag_LZ4Compressed)
+        {
+          RDCASSERT(frameCap->compressedReader);
+          frameCap->compressedReader->Reset();
+        }
       }
     }
 
-    FreeAlignedBuffer(m_Buffer);
+    FreeWindow();
 
-    m_CurrentBufferSize = (size_t)RDCMIN(m_BufferSize, (uint64_t)64 * 1024);
+    m_CurrentBufferSize = (size_t)RDCMIN(m_BufferSize - offs, (uint64_t)64 * 1024);
     m_BufferHead = m_Buffer = AllocAlignedBuffer(m_CurrentBufferSize);
     m_ReadOffset = offs;
 
@@ -1279,6 +2055,306 @@ void Serialiser::SetOffset(uint64_t offs)
   m_Indent = 0;
 }
 
+bool Serialiser::IsSeekable() const
+{
+  Section *frameCap = m_KnownSections[eSectionType_FrameCapture];
+
+  return m_ReadFileHandle && frameCap && frameCap->blockReader;
+}
+
+static bool ChunkEntryBefore(const Serialiser::ChunkIndexEntry &entry, uint64_t offs)
+{
+  return entry.offset < offs;
+}
+
+void Serialiser::SkipToChunk(uint32_t chunkIdx, uint32_t *idx)
+{
+  if(!m_ChunkIndex.empty())
+  {
+    uint64_t offs = GetOffset();
+
+    // find the first chunk at or after our current position, then look for the type we want
+    vector<ChunkIndexEntry>::iterator it =
+        std::lower_bound(m_ChunkIndex.begin(), m_ChunkIndex.end(), offs, ChunkEntryBefore);
+
+    uint32_t skipped = 0;
+
+    while(it != m_ChunkIndex.end() && it->chunkType != chunkIdx)
+    {
+      ++it;
+      skipped++;
+    }
+
+    uint64_t target = it != m_ChunkIndex.end() ? it->offset : m_BufferSize;
+
+    // we can only jump if the target is in memory, or the data allows jumping forward.
+    // Otherwise fall back to walking the chunks to read through the data
+    if(IsSeekable() || target <= m_ReadOffset + m_CurrentBufferSize)
+    {
+      SetOffset(target);
+
+      if(idx)
+        (*idx) += skipped;
+
+      return;
+    }
+  }
+
+  do
+  {
+    size_t offs = m_BufferHead - m_Buffer + (size_t)m_ReadOffset;
+
+    uint32_t c = PushContext(NULL, NULL, 1, false);
+
+    // found
+    if(c == chunkIdx)
+    {
+      m_Indent--;
+      m_BufferHead = (m_Buffer + offs) - (size_t)m_ReadOffset;
+      return;
+    }
+    else
+    {
+      SkipCurrentChunk();
+      PopContext(1);
+    }
+
+    if(idx)
+      (*idx)++;
+
+  } while(!AtEnd());
+}
+
+void Serialiser::LoadChunkIndex()
+{
+  Section *sect = m_KnownSections[eSectionType_ChunkIndex];
+
+  if(sect == NULL)
+    return;
+
+  if(sect->data.size() % sizeof(ChunkIndexEntry) != 0)
+  {
+    RDCWARN("Ignoring chunk index of unexpected size %llu", (uint64_t)sect->data.size());
+    return;
+  }
+
+  m_ChunkIndex.resize(sect->data.size() / sizeof(ChunkIndexEntry));
+
+  if(!m_ChunkIndex.empty())
+    memcpy(&m_ChunkIndex[0], &sect->data[0], sect->data.size());
+
+  // the parsed copy is all we need from now on
+  vector<byte>().swap(sect->data);
+
+  // a broken index would send us to bogus offsets, so validate it up front
+  uint64_t end = 0;
+  for(size_t i = 0; i < m_ChunkIndex.size(); i++)
+  {
+    const ChunkIndexEntry &entry = m_ChunkIndex[i];
+
+    if(entry.offset < end || entry.offset + entry.length > m_BufferSize)
+    {
+      RDCWARN("Ignoring corrupt chunk index, entry %u is out of bounds", (uint32_t)i);
+      m_ChunkIndex.clear();
+      return;
+    }
+
+    end = entry.offset + entry.length;
+  }
+}
+
+// every unique callstack seen during the current capture, chunks only store an index into it.
+// Chunks recorded outside of a capture (e.g. resource creation) can be written into any number of
+// later captures, so they keep their stacks in full. The table is emptied when a capture starts,
+// but IDs keep counting up from where the last capture left off. A chunk recorded during one
+// capture and written again into a later one then refers to an ID that isn't in the later table,
+// and loses its callstack rather than picking up an unrelated one. Captures queued for writing
+// take a copy of the table first (see SnapshotCallstacks), so the reset never affects them.
+struct CallstackHash
+{
+  uint64_t hash;
+  bool operator==(const CallstackHash &o) const { return hash == o.hash; }
+};
+
+inline uint64_t ResourceHash(const CallstackHash &key)
+{
+  return key.hash;
+}
+
+struct CallstackTable
+{
+  CallstackTable() : firstID(0) {}
+  Threading::CriticalSection lock;
+  ResourceHashMap<CallstackHash, uint32_t> lookup;
+  // ID of the first stack in the table
+  uint32_t firstID;
+  // same layout as Serialiser::m_CallstackAddrs/m_CallstackOffsets
+  vector<uint64_t> addrs;
+  vector<uint32_t> offsets;
+};
+
+static CallstackTable callstackTable;
+
+void Serialiser::ResetCallstacks()
+{
+  CallstackTable &table = callstackTable;
+
+  SCOPED_LOCK(table.lock);
+
+  if(!table.offsets.empty())
+    table.firstID += uint32_t(table.offsets.size() - 1);
+
+  table.lookup.clear();
+  vector<uint64_t>().swap(table.addrs);
+  vector<uint32_t>().swap(table.offsets);
+}
+
+bool Serialiser::InternCallstack(const uint64_t *levels, size_t numLevels, uint32_t &id)
+{
+  CallstackHash key = {numLevels};
+  for(size_t i = 0; i < numLevels; i++)
+    key.hash = ResourceHashMix(key.hash ^ levels[i]);
+
+  CallstackTable &table = callstackTable;
+
+  SCOPED_LOCK(table.lock);
+
+  if(table.offsets.empty())
+    table.offsets.push_back(0);
+
+  ResourceHashMap<CallstackHash, uint32_t>::iterator it = table.lookup.find(key);
+
+  if(it != table.lookup.end())
+  {
+    uint32_t idx = it->second;
+
+    id = table.firstID + idx;
+
+    size_t existingLevels = table.offsets[idx + 1] - table.offsets[idx];
+
+    // on the off chance of a hash collision, the stack is written out in full instead
+    return existingLevels == numLevels &&
+           (numLevels == 0 ||
+            !memcmp(&table.addrs[table.offsets[idx]], levels, numLevels * sizeof(uint64_t)));
+  }
+
+  uint32_t idx = uint32_t(table.offsets.size() - 1);
+
+  id = table.firstID + idx;
+
+  table.addrs.insert(table.addrs.end(), levels, levels + numLevels);
+  table.offsets.push_back((uint32_t)table.addrs.size());
+  table.lookup.insert(key, idx);
+
+  return true;
+}
+
+// section contents are the stack count, the first stack's ID, then count+1 offsets, then all the
+// addresses. Nothing is written if no chunk in this capture refers to a stack.
+void Serialiser::SnapshotCallstacks()
+{
+  m_CallstacksSnapshotted = true;
+  m_CallstackSection.clear();
+
+  CallstackTable &table = callstackTable;
+
+  SCOPED_LOCK(table.lock);
+
+  if(table.offsets.size() <= 1)
+    return;
+
+  uint32_t count = uint32_t(table.offsets.size() - 1);
+
+  m_CallstackSection.resize(sizeof(uint32_t) * 2 + table.offsets.size() * sizeof(uint32_t) +
+                            table.addrs.size() * sizeof(uint64_t));
+
+  byte *dst = &m_CallstackSection[0];
+  memcpy(dst, &count, sizeof(uint32_t));
+  dst += sizeof(uint32_t);
+  memcpy(dst, &table.firstID, sizeof(uint32_t));
+  dst += sizeof(uint32_t);
+  memcpy(dst, &table.offsets[0], table.offsets.size() * sizeof(uint32_t));
+  dst += table.offsets.size() * sizeof(uint32_t);
+  if(!table.addrs.empty())
+    memcpy(dst, &table.addrs[0], table.addrs.size() * sizeof(uint64_t));
+}
+
+void Serialiser::WriteCallstacks(FILE *f)
+{
+  if(!m_CallstacksSnapshotted)
+    SnapshotCallstacks();
+
+  if(m_CallstackSection.empty())
+    return;
+
+  const vector<byte> &data = m_CallstackSection;
+
+  const char sectionName[] = "renderdoc/internal/callstacks";
+
+  BinarySectionHeader section = {0};
+  section.isASCII = 0;                                // redundant but explicit
+  section.sectionNameLength = sizeof(sectionName);    // includes null terminator
+  section.sectionType = eSectionType_Callstacks;
+  section.sectionFlags = eSectionFlag_None;
+  section.sectionLength = uint32_t(data.size());
+
+  FileIO::fwrite(&section, 1, offsetof(BinarySectionHeader, name), f);
+  FileIO::fwrite(sectionName, 1, sizeof(sectionName), f);
+  FileIO::fwrite(&data[0], 1, data.size(), f);
+}
+
+void Serialiser::LoadCallstacks()
+{
+  Section *sect = m_KnownSections[eSectionType_Callstacks];
+
+  if(sect == NULL)
+    return;
+
+  const vector<byte> &data = sect->data;
+
+  const size_t headerSize = sizeof(uint32_t) * 2;
+
+  uint32_t count = 0;
+  if(data.size() >= headerSize)
+  {
+    memcpy(&count, &data[0], sizeof(uint32_t));
+    memcpy(&m_FirstCallstackID, &data[sizeof(uint32_t)], sizeof(uint32_t));
+  }
+
+  uint64_t offsetsSize = (uint64_t(count) + 1) * sizeof(uint32_t);
+
+  if(data.size() < headerSize + offsetsSize ||
+     (data.size() - headerSize - offsetsSize) % sizeof(uint64_t) != 0)
+  {
+    RDCWARN("Ignoring callstack table of unexpected size %llu", (uint64_t)data.size());
+    return;
+  }
+
+  m_CallstackOffsets.resize(count + 1);
+  memcpy(&m_CallstackOffsets[0], &data[headerSize], (size_t)offsetsSize);
+
+  size_t addrsOffset = headerSize + (size_t)offsetsSize;
+
+  m_CallstackAddrs.resize((data.size() - addrsOffset) / sizeof(uint64_t));
+  if(!m_CallstackAddrs.empty())
+    memcpy(&m_CallstackAddrs[0], &data[addrsOffset], m_CallstackAddrs.size() * sizeof(uint64_t));
+
+  // the parsed copy is all we need from now on
+  vector<byte>().swap(sect->data);
+
+  for(uint32_t i = 0; i < count; i++)
+  {
+    if(m_CallstackOffsets[i] > m_CallstackOffsets[i + 1] ||
+       m_CallstackOffsets[i + 1] > m_CallstackAddrs.size())
+    {
+      RDCWARN("Ignoring corrupt callstack table, stack %u is out of bounds", i);
+      m_CallstackOffsets.clear();
+      m_CallstackAddrs.clear();
+      return;
+    }
+  }
+}
+
 void Serialiser::InitCallstackResolver()
 {
   if(m_pResolver == NULL && m_ResolverThread == 0 &&
@@ -1310,6 +2386,21 @@ void Serialiser::CreateResolver(void *ths)
                                              &ser->m_ResolverThreadKillSignal);
 }
 
+void Serialiser::OwnChunks()
+{
+  for(size_t i = 0; i < m_Chunks.size(); i++)
+  {
+    if(m_Chunks[i]->IsTemporary())
+      continue;
+
+    // chunks that are updated in place after the frame have to be snapshotted now. Everything
+    // else is immutable once recorded, so it's shared rather than copied.
+    Chunk *chunk = m_Chunks[i]->IsDataMutable() ? m_Chunks[i]->Duplicate() : m_Chunks[i]->Share();
+    chunk->m_Temporary = true;
+    m_Chunks[i] = chunk;
+  }
+}
+
 void Serialiser::FlushToDisk()
 {
   SCOPED_TIMER("File writing");
@@ -1376,7 +2467,7 @@ void Serialiser::FlushToDisk()
       section.isASCII = 0;                                // redundant but explicit
       section.sectionNameLength = sizeof(sectionName);    // includes null terminator
       section.sectionType = eSectionType_FrameCapture;
-      section.sectionFlags = eSectionFlag_LZ4Compressed;
+      section.sectionFlags = eSectionFlag_LZ4Blocks;
       section.sectionLength =
           0;    // will be fixed up later, to avoid having to compress everything into memory
 
@@ -1390,13 +2481,16 @@ void Serialiser::FlushToDisk()
       FileIO::fwrite(&len, 1, sizeof(uint64_t), binFile);
     }
 
-    CompressedFileIO fwriter(binFile);
+    BlockCompressedFileIO fwriter(binFile);
 
     // track offset so we can add padding. The padding is relative
     // to the start of the decompressed buffer, so we start it from 0
     uint64_t offs = 0;
     uint64_t alignedoffs = 0;
 
+    vector<ChunkIndexEntry> chunkIndex;
+    chunkIndex.reserve(m_Chunks.size());
+
     // write frame capture contents
     for(size_t i = 0; i < m_Chunks.size(); i++)
     {
@@ -1434,6 +2528,12 @@ void Serialiser::FlushToDisk()
         }
       }
 
+      ChunkIndexEntry entry;
+      entry.offset = offs;
+      entry.chunkType = chunk->GetChunkType();
+      entry.length = chunk->GetLength();
+      chunkIndex.push_back(entry);
+
       fwriter.Write(chunk->GetData(), chunk->GetLength());
 
       offs += chunk->GetLength();
@@ -1455,7 +2555,9 @@ void Serialiser::FlushToDisk()
 
       FileIO::fseek64(binFile, compressedSizeOffset, SEEK_SET);
 
-      compsize = fwriter.GetCompressedSize();
+      // this can't represent sections over 4GB, but readers locate the end of block compressed
+      // sections through the block index instead.
+      compsize = (uint32_t)fwriter.GetCompressedSize();
       FileIO::fwrite(&compsize, 1, sizeof(compsize), binFile);
 
       FileIO::fseek64(binFile, uncompressedSizeOffset, SEEK_SET);
@@ -1465,10 +2567,27 @@ void Serialiser::FlushToDisk()
 
       FileIO::fseek64(binFile, curoffs, SEEK_SET);
 
-      RDCLOG("Compressed frame capture data from %u to %u", fwriter.GetUncompressedSize(),
+      RDCLOG("Compressed frame capture data from %llu to %llu", fwriter.GetUncompressedSize(),
              fwriter.GetCompressedSize());
     }
 
+    // write chunk index section
+    if(!chunkIndex.empty())
+    {
+      const char sectionName[] = "renderdoc/internal/chunkindex";
+
+      BinarySectionHeader section = {0};
+      section.isASCII = 0;                                // redundant but explicit
+      section.sectionNameLength = sizeof(sectionName);    // includes null terminator
+      section.sectionType = eSectionType_ChunkIndex;
+      section.sectionFlags = eSectionFlag_None;
+      section.sectionLength = uint32_t(chunkIndex.size() * sizeof(ChunkIndexEntry));
+
+      FileIO::fwrite(&section, 1, offsetof(BinarySectionHeader, name), binFile);
+      FileIO::fwrite(sectionName, 1, sizeof(sectionName), binFile);
+      FileIO::fwrite(&chunkIndex[0], sizeof(ChunkIndexEntry), chunkIndex.size(), binFile);
+    }
+
     char *symbolDB = NULL;
     size_t symbolDBSize = 0;
 
@@ -1504,6 +2623,11 @@ void Serialiser::FlushToDisk()
       SAFE_DELETE_ARRAY(symbolDB);
     }
 
+    // write the interned callstacks that chunk headers refer to, if there are any. This doesn't
+    // depend on the current capture options, which might have changed since the chunks were
+    // recorded.
+    WriteCallstacks(binFile);
+
     // write the machine identifier as an ASCII section
     {
       const char sectionName[] = "renderdoc/internal/machineid";
@@ -1589,11 +2713,24 @@ uint32_t Serialiser::PushContext(const char *name, const char *typeName, uint32_
       if(call)
       {
         uint8_t numLevels = call->NumLevels() & 0xff;
-        WriteFrom(numLevels);
+        uint32_t stackID = 0;
 
-        if(call->NumLevels())
+        // only chunks from within a capture are interned, see CallstackTable
+        if(RenderDoc::Inst().IsFrameCapturing() &&
+           InternCallstack(call->GetAddrs(), numLevels, stackID))
+        {
+          numLevels = InternedCallstack;
+          WriteFrom(numLevels);
+          WriteFrom(stackID);
+        }
+        else
         {
-          WriteBytes((byte *)call->GetAddrs(), sizeof(uint64_t) * numLevels);
+          WriteFrom(numLevels);
+
+          if(call->NumLevels())
+          {
+            WriteBytes((byte *)call->GetAddrs(), sizeof(uint64_t) * numLevels);
+          }
         }
 
         SAFE_DELETE(call);
@@ -1675,8 +2812,32 @@ uint32_t Serialiser::PushContext(const char *name, const char *typeName, uint32_
           uint8_t callLen = 0;
           ReadInto(callLen);
 
-          uint64_t *calls = (uint64_t *)ReadBytes(callLen * sizeof(uint64_t));
-          SetCallstack(calls, callLen);
+          if(callLen == InternedCallstack)
+          {
+            uint32_t stackID = 0;
+            ReadInto(stackID);
+
+            uint32_t idx = stackID - m_FirstCallstackID;
+
+            if(stackID >= m_FirstCallstackID && idx + 1 < m_CallstackOffsets.size())
+            {
+              uint32_t offs = m_CallstackOffsets[idx];
+              size_t levels = m_CallstackOffsets[idx + 1] - offs;
+              SetCallstack(levels ? &m_CallstackAddrs[offs] : NULL, levels);
+            }
+            else
+            {
+              // chunks recorded during an earlier capture refer to that capture's stacks
+              if(stackID >= m_FirstCallstackID)
+                RDCWARN("Chunk references unknown callstack %u", stackID);
+              SetCallstack(NULL, 0);
+            }
+          }
+          else
+          {
+            uint64_t *calls = (uint64_t *)ReadBytes(callLen * sizeof(uint64_t));
+            SetCallstack(calls, callLen);
+          }
         }
         else
         {
@@ -1821,6 +2982,13 @@ void Serialiser::Insert(Chunk *chunk)
   m_DebugText += chunk->GetDebugString();
 }
 
+void Serialiser::InsertFirst(Chunk *chunk)
+{
+  m_Chunks.insert(m_Chunks.begin(), chunk);
+
+  m_DebugText = chunk->GetDebugString() + m_DebugText;
+}
+
 void Serialiser::AlignNextBuffer(const size_t alignment)
 {
   // on new logs, we don't have to align. This code will be deleted once backwards-compat is dropped
@@ -1866,6 +3034,16 @@ void Serialiser::AlignNextBuffer(const size_t alignment)
 }
 
 void Serialiser::SerialiseBuffer(const char *name, byte *&buf, size_t &len)
+{
+  SerialiseBufferData(name, buf, len, false);
+}
+
+void Serialiser::SerialiseBufferInPlace(const char *name, byte *&buf, size_t &len)
+{
+  SerialiseBufferData(name, buf, len, true);
+}
+
+void Serialiser::SerialiseBufferData(const char *name, byte *&buf, size_t &len, bool inPlace)
 {
   uint32_t bufLen = (uint32_t)len;
 
@@ -1904,9 +3082,16 @@ void Serialiser::SerialiseBuffer(const char *name, byte *&buf, size_t &len)
       ReadBytes((size_t)(alignedoffs - offs));
     }
 
-    if(buf == NULL)
-      buf = new byte[bufLen];
-    memcpy(buf, ReadBytes(bufLen), bufLen);
+    if(inPlace)
+    {
+      buf = (byte *)ReadBytes(bufLen);
+    }
+    else
+    {
+      if(buf == NULL)
+        buf = new byte[bufLen];
+      memcpy(buf, ReadBytes(bufLen), bufLen);
+    }
   }
 
   len = (size_t)bufLen;
@@ -88,6 +88,38 @@ typedef const char *(*ChunkLookup)(uint32_t chunkType);
 class Serialiser;
 class ScopedContext;
 struct CompressedFileIO;
+struct BlockCompressedFileIO;
+
+struct ChunkPage;
+
+// chunks recorded at capture time are small, very numerous and mostly short-lived, so rather than
+// a heap allocation each, a serialiser can carve their storage out of larger pages. Only the owning
+// thread allocates from an arena, but chunks can be freed from anywhere. Each page counts the
+// chunks still alive in it and is returned to a shared pool once the last one is freed and the
+// arena has moved on to a new page.
+class ChunkArena
+{
+public:
+  ChunkArena() : m_Current(NULL) {}
+  ~ChunkArena();
+
+  // returns NULL if the size is too large to come from a page, in which case the caller should
+  // allocate normally.
+  byte *Alloc(uint32_t size, ChunkPage *&page);
+  static void Release(ChunkPage *page);
+
+  static const uint32_t PageSize = 64 * 1024;
+  static const uint32_t MaxAllocSize = 8 * 1024;
+  // matches the default alignment of Serialiser::AllocAlignedBuffer
+  static const uint32_t AllocAlignment = 64;
+
+private:
+  // no copy semantics
+  ChunkArena(const ChunkArena &);
+  ChunkArena &operator=(const ChunkArena &);
+
+  ChunkPage *m_Current;
+};
 
 // holds the memory, length and type for a given chunk, so that it can be
 // passed around and moved between owners before being serialised out
@@ -102,6 +134,9 @@ public:
   uint32_t GetChunkType() { return m_ChunkType; }
   bool IsAligned() { return m_AlignedData; }
   bool IsTemporary() { return m_Temporary; }
+  // set when a resource record keeps a pointer into the data to update it in place
+  void MarkDataMutable() { m_DataMutable = true; }
+  bool IsDataMutable() { return m_DataMutable; }
 #if ENABLED(RDOC_DEVEL)
   static uint64_t NumLiveChunks() { return m_LiveChunks; }
   static uint64_t TotalMem() { return m_TotalMem; }
@@ -114,6 +149,9 @@ public:
   Chunk(Serialiser *ser, uint32_t chunkType, bool temp);
 
   Chunk *Duplicate();
+  // returns a new chunk referencing the same data without copying it. Either can be freed
+  // independently of the other. Not for chunks marked as having mutable data.
+  Chunk *Share();
 
 private:
   Chunk() {}
@@ -122,14 +160,18 @@ private:
   Chunk &operator=(const Chunk &);
 
   friend class ScopedContext;
+  friend class Serialiser;
 
   bool m_AlignedData;
   bool m_Temporary;
+  bool m_DataMutable;
 
   uint32_t m_ChunkType;
 
   uint32_t m_Length;
   byte *m_Data;
+  // if non-NULL, m_Data was allocated from this arena page rather than the heap
+  ChunkPage *m_Page;
   string m_DebugStr;
 
 #if ENABLED(RDOC_DEVEL)
@@ -153,6 +195,10 @@ private:
 // whichever is the biggest single element within a chunk that's read (so that you can always
 // guarantee
 // while reading that the element you're interested in is always in memory).
+//
+// If the frame capture data is stored uncompressed, the file is instead mapped into memory and the
+// window covers the whole section, so data is paged in by the OS only as it's touched. Block
+// compressed data is decoded into the window straight from a mapping of the file.
 class Serialiser
 {
 public:
@@ -176,6 +222,7 @@ public:
     eSectionFlag_None = 0x0,
     eSectionFlag_ASCIIStored = 0x1,
     eSectionFlag_LZ4Compressed = 0x2,
+    eSectionFlag_LZ4Blocks = 0x4,
   };
 
   enum SectionType
@@ -186,15 +233,29 @@ public:
     eSectionType_MachineID,          // renderdoc/internal/machineid
     eSectionType_FrameBookmarks,     // renderdoc/ui/bookmarks
     eSectionType_Notes,              // renderdoc/ui/notes
+    eSectionType_ChunkIndex,         // renderdoc/internal/chunkindex
+    eSectionType_Callstacks,         // renderdoc/internal/callstacks
     eSectionType_Num,
   };
 
   // version number of overall file format or chunk organisation. If the contents/meaning/order of
   // chunks have changed this does not need to be bumped, there are version numbers within each
   // API that interprets the stream that can be bumped.
-  static const uint64_t SERIALISE_VERSION = 0x00000032;
+  //
+  // 0x32 files can still be read, 0x33 added block compressed sections.
+  static const uint64_t SERIALISE_VERSION = 0x00000033;
   static const uint32_t MAGIC_HEADER;
 
+  // one entry per chunk in the frame capture, written in the chunk index section. There are no
+  // event IDs here, those are only assigned by each driver as it reads the capture, and from then
+  // on it seeks to events with FetchAPIEvent::fileOffset.
+  struct ChunkIndexEntry
+  {
+    uint64_t offset;
+    uint32_t chunkType;
+    uint32_t length;
+  };
+
   //////////////////////////////////////////
   // Init and error handling
 
@@ -211,6 +272,17 @@ public:
   void SetUserData(void *userData) { m_pUserData = userData; }
   bool AtEnd() { return GetOffset() >= m_BufferSize; }
   bool HasAlignedData() { return m_AlignedData; }
+  // allocate chunks created from this serialiser out of a ChunkArena. Only valid when the
+  // serialiser is used from a single thread.
+  void EnableChunkArena()
+  {
+    if(m_ChunkArena == NULL)
+      m_ChunkArena = new ChunkArena();
+  }
+  // chunks that outlive the frame (e.g. resource creation chunks kept in records) would pin whole
+  // pages, so the arena is only used while this is set and otherwise chunks come from the heap.
+  void SetChunkArenaActive(bool active) { m_ChunkArenaActive = active; }
+  ChunkArena *GetChunkArena() { return m_ChunkArenaActive ? m_ChunkArena : NULL; }
   bool IsReading() const { return m_Mode == READING; }
   bool IsWriting() const { return !IsReading(); }
   uint64_t GetOffset() const
@@ -257,33 +329,12 @@ public:
     SetOffset(0);
   }
 
-  // assumes buffer head is sitting before a chunk (ie. pushcontext will be valid)
-  void SkipToChunk(uint32_t chunkIdx, uint32_t *idx = NULL)
-  {
-    do
-    {
-      size_t offs = m_BufferHead - m_Buffer + (size_t)m_ReadOffset;
+  // assumes buffer head is sitting before a chunk (ie. pushcontext will be valid). If the file
+  // has a chunk index, this jumps directly to the chunk instead of walking there.
+  void SkipToChunk(uint32_t chunkIdx, uint32_t *idx = NULL);
 
-      uint32_t c = PushContext(NULL, NULL, 1, false);
-
-      // found
-      if(c == chunkIdx)
-      {
-        m_Indent--;
-        m_BufferHead = (m_Buffer + offs) - (size_t)m_ReadOffset;
-        return;
-      }
-      else
-      {
-        SkipCurrentChunk();
-        PopContext(1);
-      }
-
-      if(idx)
-        (*idx)++;
-
-    } while(!AtEnd());
-  }
+  // the chunk index loaded from the file, or empty if there isn't one
+  const vector<ChunkIndexEntry> &GetChunkIndex() const { return m_ChunkIndex; }
 
   // assumes buffer head is sitting in a chunk (ie. immediately after a pushcontext)
   void SkipCurrentChunk() { ReadBytes(m_LastChunkLen); }
@@ -293,6 +344,12 @@ public:
   Callstack::StackResolver *GetCallstackResolver() { return m_pResolver; }
   void SetCallstack(uint64_t *levels, size_t numLevels);
 
+  // capture time: find or add this callstack in the process-wide table written with each capture,
+  // so chunks only need to store its ID. Returns false if it must be written out in full instead.
+  static bool InternCallstack(const uint64_t *levels, size_t numLevels, uint32_t &id);
+  // called when a capture starts, the table only holds the stacks used within one capture
+  static void ResetCallstacks();
+
   uint64_t GetSavedMachineIdent()
   {
     Section *id = m_KnownSections[eSectionType_MachineID];
@@ -324,6 +381,8 @@ public:
 
   // Write a chunk to disk
   void Insert(Chunk *el);
+  // Write a chunk to disk ahead of any already inserted
+  void InsertFirst(Chunk *el);
 
   // serialise a fixed-size array.
   template <int Num, class T>
@@ -556,6 +615,11 @@ public:
   // If serialising in, buf must either be NULL in which case allocated
   // memory will be returned, or it must be already large enough.
   void SerialiseBuffer(const char *name, byte *&buf, size_t &len);
+
+  // as above, but when reading buf is always set to point directly at the data in the serialiser
+  // instead of taking a copy. The pointer is not aligned and is only valid until the next read
+  // from the serialiser, so it must be consumed immediately and never freed.
+  void SerialiseBufferInPlace(const char *name, byte *&buf, size_t &len);
   void AlignNextBuffer(const size_t alignment);
 
   // NOT recommended interface. Useful for specific situations if e.g. you have
@@ -572,6 +636,16 @@ public:
 
   void FlushToDisk();
 
+  // any chunks inserted that are owned elsewhere (e.g. by resource records) are replaced with
+  // temporary chunks sharing their data, so that the serialiser can be flushed after the original
+  // owners have moved on - such as on the capture writer thread.
+  void OwnChunks();
+  // copy the interned callstacks the chunks refer to, so that the next capture can reset the
+  // process-wide table while this serialiser is still waiting to be flushed. Done by FlushToDisk
+  // if it hasn't been called already.
+  void SnapshotCallstacks();
+
+  const string &GetFilename() const { return m_Filename; }
   // set a function used when serialising a text representation
   // of the chunks
   void SetChunkNameLookup(ChunkLookup lookup) { m_ChunkLookup = lookup; }
@@ -586,6 +660,20 @@ private:
   void *ReadBytes(size_t nBytes);
 
   void ReadFromFile(uint64_t bufferOffs, size_t length);
+  void FreeWindow();
+  bool IsSeekable() const;
+  // in place of a callstack's length in a chunk header, means a 32-bit ID of an interned stack
+  // follows instead of the addresses
+  enum
+  {
+    InternedCallstack = 0xff,
+  };
+
+  void LoadChunkIndex();
+  void LoadCallstacks();
+  void WriteCallstacks(FILE *f);
+
+  void SerialiseBufferData(const char *name, byte *&buf, size_t &len, bool inPlace);
 
   template <class T>
   void WriteFrom(const T &f)
@@ -659,13 +747,19 @@ private:
   size_t m_LastChunkLen;
   bool m_AlignedData;
   vector<uint64_t> m_ChunkFixups;
+  ChunkArena *m_ChunkArena;
+  bool m_ChunkArenaActive;
 
   // reading from file:
 
   struct Section
   {
     Section()
-        : type(eSectionType_Unknown), flags(eSectionFlag_None), fileoffset(0), compressedReader(NULL)
+        : type(eSectionType_Unknown),
+          flags(eSectionFlag_None),
+          fileoffset(0),
+          compressedReader(NULL),
+          blockReader(NULL)
     {
     }
     string name;
@@ -676,6 +770,7 @@ private:
     uint64_t size;
     vector<byte> data;    // some sections can be loaded entirely into memory
     CompressedFileIO *compressedReader;
+    BlockCompressedFileIO *blockReader;
   };
 
   // this lists all sections in file order
@@ -684,6 +779,21 @@ private:
   // this lists known sections, some may be NULL
   Section *m_KnownSections[eSectionType_Num];
 
+  // offsets of every chunk in the frame capture, sorted by offset
+  vector<ChunkIndexEntry> m_ChunkIndex;
+
+  // interned callstacks loaded from the file. The stack with ID m_FirstCallstackID + i has
+  // addresses m_CallstackAddrs[m_CallstackOffsets[i]] up to
+  // m_CallstackAddrs[m_CallstackOffsets[i + 1]]
+  uint32_t m_FirstCallstackID;
+  vector<uint64_t> m_CallstackAddrs;
+  vector<uint32_t> m_CallstackOffsets;
+
+  // the callstacks section contents to write, taken by SnapshotCallstacks. Empty if there are no
+  // interned stacks.
+  vector<byte> m_CallstackSection;
+  bool m_CallstacksSnapshotted;
+
   // where does our in-memory window point to in the data stream. ie. m_pBuffer[0] is
   // m_ReadOffset into the frame capture section
   uint64_t m_ReadOffset;
@@ -696,6 +806,13 @@ private:
   // the file pointer to read from
   FILE *m_ReadFileHandle;
 
+  // the read-only mapping of the file. Uncompressed frame captures are read straight out of it,
+  // with m_BufferMapped set and m_Buffer pointing into the mapping rather than an allocation of
+  // our own. Block compressed frame captures decode their blocks directly from it instead.
+  const byte *m_MappedFile;
+  uint64_t m_MappedSize;
+  bool m_BufferMapped;
+
   // writing to file
   vector<Chunk *> m_Chunks;
 
@@ -827,6 +944,12 @@ struct ScopedDeserialise
     name = (type)(inBuf);                             \
   size_t CONCAT(buflen, __LINE__) = Len;              \
   GET_SERIALISER->SerialiseBuffer(#name, name, CONCAT(buflen, __LINE__));
+#define SERIALISE_ELEMENT_BUF_INPLACE(type, name, inBuf, Len) \
+  type name = (type)NULL;                                   \
+  if(m_State >= WRITING)                                    \
+    name = (type)(inBuf);                                   \
+  size_t CONCAT(buflen, __LINE__) = Len;                    \
+  GET_SERIALISER->SerialiseBufferInPlace(#name, (byte *&)name, CONCAT(buflen, __LINE__));
 #define SERIALISE_ELEMENT_BUF_OPT(type, name, inBuf, Len, Condition)        \
   type name = (type)NULL;                                                   \
   if(Condition)                                                             \
@@ -27,6 +27,7 @@
 #include <app/renderdoc_app.h>
 #include <replay/renderdoc_replay.h>
 #include <string>
+#include "core/benchmarks.h"
 
 using std::string;
 using std::wstring;
@@ -542,6 +543,192 @@ struct ReplayCommand : public Command
   }
 };
 
+struct SaveTexturesCommand : public Command
+{
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.set_footer("<capture.rdc>");
+    parser.add<string>("out", 'o', "The directory to save the textures to.", false, ".");
+    parser.add<string>("format", 'f', "The format of the output files.", false, "png",
+                       cmdline::oneof<string>("png", "jpg", "bmp", "tga", "hdr", "exr", "dds"));
+    parser.add<uint32_t>("event", 'e',
+                         "The event to replay to before saving. Default is the end of the frame.",
+                         false, 10000000);
+    parser.add("all", 'a', "Save every texture, not only render targets and depth targets.");
+  }
+  virtual const char *Description()
+  {
+    return "Replay the log file and save its textures to disk in one batch.";
+  }
+  virtual bool IsInternalOnly() { return false; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    if(parser.rest().empty())
+    {
+      std::cerr << "Error: savetextures command requires a filename to load." << std::endl
+                << std::endl
+                << parser.usage();
+      return 0;
+    }
+
+    string filename = parser.rest()[0];
+    string outdir = parser.get<string>("out");
+    string format = parser.get<string>("format");
+    bool all = parser.exist("all");
+
+    FileType type = eFileType_PNG;
+
+    if(format == "jpg")
+      type = eFileType_JPG;
+    else if(format == "bmp")
+      type = eFileType_BMP;
+    else if(format == "tga")
+      type = eFileType_TGA;
+    else if(format == "hdr")
+      type = eFileType_HDR;
+    else if(format == "exr")
+      type = eFileType_EXR;
+    else if(format == "dds")
+      type = eFileType_DDS;
+
+    std::cout << "Replaying '" << filename << "' locally.." << std::endl;
+
+    float progress = 0.0f;
+    IReplayRenderer *renderer = NULL;
+    ReplayCreateStatus status =
+        RENDERDOC_CreateReplayRenderer(filename.c_str(), &progress, &renderer);
+
+    if(status != eReplayCreate_Success)
+    {
+      std::cerr << "Couldn't load and replay '" << filename << "'." << std::endl;
+      return 1;
+    }
+
+    renderer->SetFrameEvent(parser.get<uint32_t>("event"), true);
+
+    rdctype::array<FetchTexture> texs;
+    renderer->GetTextures(&texs);
+
+    std::vector<TextureSave> saves;
+    std::vector<string> paths;
+
+    for(int32_t i = 0; i < texs.count; i++)
+    {
+      const FetchTexture &tex = texs[i];
+
+      if(!all && (tex.creationFlags & (eTextureCreate_RTV | eTextureCreate_DSV)) == 0)
+        continue;
+
+      TextureSave save = {};
+      save.id = tex.ID;
+      save.typeHint = eCompType_None;
+      save.destType = type;
+      save.mip = 0;
+      save.comp.blackPoint = 0.0f;
+      save.comp.whitePoint = 1.0f;
+      save.sample.mapToArray = false;
+      save.sample.sampleIndex = ~0U;
+      save.slice.sliceIndex = 0;
+      save.slice.slicesAsGrid = false;
+      save.slice.sliceGridWidth = 1;
+      save.slice.cubeCruciform = false;
+      save.channelExtract = -1;
+      save.alpha = eAlphaMap_Preserve;
+      save.jpegQuality = 90;
+
+      // DDS can hold the whole texture, so save every mip and slice
+      if(type == eFileType_DDS)
+      {
+        save.mip = -1;
+        save.slice.sliceIndex = -1;
+      }
+
+      // keep names filesystem-safe, and prefix the ID so duplicate names don't collide
+      string name = tex.name.elems ? tex.name.elems : "";
+      for(size_t c = 0; c < name.size(); c++)
+      {
+        char ch = name[c];
+        if(!((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+             ch == '-' || ch == '_'))
+          name[c] = '_';
+      }
+
+      saves.push_back(save);
+      paths.push_back(outdir + "/" + std::to_string(tex.ID.id) + "_" + name + "." + format);
+    }
+
+    if(saves.empty())
+    {
+      std::cerr << "No textures to save in '" << filename << "'." << std::endl;
+      renderer->Shutdown();
+      return 0;
+    }
+
+    std::vector<const char *> pathPtrs;
+    for(size_t i = 0; i < paths.size(); i++)
+      pathPtrs.push_back(paths[i].c_str());
+
+    std::vector<bool32> results(saves.size(), false);
+
+    renderer->SaveTextures((uint32_t)saves.size(), &saves[0], &pathPtrs[0], &results[0]);
+
+    uint32_t failed = 0;
+    for(size_t i = 0; i < results.size(); i++)
+    {
+      if(!results[i])
+      {
+        std::cerr << "Couldn't save texture to '" << paths[i] << "'." << std::endl;
+        failed++;
+      }
+    }
+
+    std::cout << "Saved " << (saves.size() - failed) << " of " << saves.size() << " textures to '"
+              << outdir << "'." << std::endl;
+
+    renderer->Shutdown();
+
+    return failed > 0 ? 1 : 0;
+  }
+};
+
+struct BenchmarkCommand : public Command
+{
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.set_footer("<benchmark name>");
+    parser.add<uint32_t>("threads", 't', "The number of threads to run on.", false, 4);
+    parser.add<uint32_t>("iterations", 'i', "The number of iterations per thread.", false, 1000000);
+  }
+  virtual const char *Description() { return "Runs an internal microbenchmark."; }
+  virtual bool IsInternalOnly() { return true; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    if(parser.rest().empty())
+    {
+      std::cerr << "Error: benchmark command requires a benchmark name." << std::endl
+                << std::endl
+                << parser.usage();
+      return 1;
+    }
+
+    string name = parser.rest()[0];
+
+    rdctype::str results;
+    if(!RENDERDOC_RunBenchmark(name.c_str(), parser.get<uint32_t>("threads"),
+                               parser.get<uint32_t>("iterations"), &results))
+    {
+      std::cerr << "Couldn't run benchmark '" << name << "'" << std::endl;
+      return 1;
+    }
+
+    std::cout << results.c_str();
+
+    return 0;
+  }
+};
+
 struct CapAltBitCommand : public Command
 {
   virtual void AddOptions(cmdline::parser &parser)
@@ -678,7 +865,9 @@ int renderdoccmd(std::vector<std::string> &argv)
     add_command("inject", new InjectCommand());
     add_command("remoteserver", new RemoteServerCommand());
     add_command("replay", new ReplayCommand());
+    add_command("savetextures", new SaveTexturesCommand());
     add_command("capaltbit", new CapAltBitCommand());
+    add_command("benchmark", new BenchmarkCommand());
 
     if(argv.size() <= 1)
     {
@@ -368,6 +368,13 @@ public enum DebugMessageSource
         UnsupportedConfiguration,
     };
 
+    public enum ShaderDebugVariableSet
+    {
+        Register = 0,
+        Output,
+        IndexableTemp,
+    };
+
     public enum DebugMessageCategory
     {
         Defined = 0,
@@ -368,11 +368,13 @@ public class ReplayRenderer
 
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern bool ReplayRenderer_GetPostVSData(IntPtr real, UInt32 instID, MeshDataStage stage, IntPtr outdata);
+        [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
+        private static extern bool ReplayRenderer_GetPostVSDataForEvents(IntPtr real, UInt32 count, UInt32[] eventIDs, UInt32 instID, IntPtr outvs, IntPtr outgs);
 
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
         private static extern bool ReplayRenderer_GetBufferData(IntPtr real, ResourceId buff, UInt64 offset, UInt64 len, IntPtr outdata);
         [DllImport("renderdoc.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.Cdecl)]
-        private static extern bool ReplayRenderer_GetTextureData(IntPtr real, ResourceId tex, UInt32 arrayIdx, UInt32 mip, IntPtr outdata);
+        private static extern bool ReplayRenderer_GetTextureData(IntPtr real, ResourceId tex, UInt32 arrayIdx, UInt32 mip, ref float progress, IntPtr outdata);
 
         private IntPtr m_Real = IntPtr.Zero;
 
@@ -872,6 +874,41 @@ public MeshFormat GetPostVSData(UInt32 instID, MeshDataStage stage)
             return ret;
         }
 
+        public bool GetPostVSDataForEvents(UInt32[] eventIDs, UInt32 instID, out MeshFormat[] vsData, out MeshFormat[] gsData)
+        {
+            int count = eventIDs.Length;
+            int size = CustomMarshal.SizeOf(typeof(MeshFormat));
+
+            IntPtr vsmem = CustomMarshal.Alloc(typeof(MeshFormat), count);
+            IntPtr gsmem = CustomMarshal.Alloc(typeof(MeshFormat), count);
+
+            vsData = new MeshFormat[count];
+            gsData = new MeshFormat[count];
+
+            bool success = ReplayRenderer_GetPostVSDataForEvents(m_Real, (UInt32)count, eventIDs, instID, vsmem, gsmem);
+
+            for (int i = 0; i < count; i++)
+            {
+                if (success)
+                {
+                    vsData[i] = (MeshFormat)CustomMarshal.PtrToStructure(new IntPtr(vsmem.ToInt64() + i * size), typeof(MeshFormat), true);
+                    gsData[i] = (MeshFormat)CustomMarshal.PtrToStructure(new IntPtr(gsmem.ToInt64() + i * size), typeof(MeshFormat), true);
+                }
+                else
+                {
+                    vsData[i] = new MeshFormat();
+                    vsData[i].buf = ResourceId.Null;
+                    gsData[i] = new MeshFormat();
+                    gsData[i].buf = ResourceId.Null;
+                }
+            }
+
+            CustomMarshal.Free(vsmem);
+            CustomMarshal.Free(gsmem);
+
+            return success;
+        }
+
         public byte[] GetBufferData(ResourceId buff, UInt64 offset, UInt64 len)
         {
             IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
@@ -889,10 +926,16 @@ public byte[] GetBufferData(ResourceId buff, UInt64 offset, UInt64 len)
         }
 
         public byte[] GetTextureData(ResourceId tex, UInt32 arrayIdx, UInt32 mip)
+        {
+            float progress = 0.0f;
+            return GetTextureData(tex, arrayIdx, mip, ref progress);
+        }
+
+        public byte[] GetTextureData(ResourceId tex, UInt32 arrayIdx, UInt32 mip, ref float progress)
         {
             IntPtr mem = CustomMarshal.Alloc(typeof(templated_array));
 
-            bool success = ReplayRenderer_GetTextureData(m_Real, tex, arrayIdx, mip, mem);
+            bool success = ReplayRenderer_GetTextureData(m_Real, tex, arrayIdx, mip, ref progress, mem);
 
             byte[] ret = new byte[] { };
 
@@ -172,6 +172,28 @@ public string Row(int row)
 		{
 			return Row(row, type);
 		}
+
+        public ShaderVariable Clone()
+        {
+            ShaderVariable ret = (ShaderVariable)MemberwiseClone();
+            ret.value.uv = (UInt32[])value.uv.Clone();
+            ret.value.fv = (float[])value.fv.Clone();
+            ret.value.iv = (Int32[])value.iv.Clone();
+            ret.value.dv = (double[])value.dv.Clone();
+            return ret;
+        }
+
+        // update one 32-bit component, keeping the other views of the value union in sync
+        public void SetComponent(UInt32 component, UInt32 val)
+        {
+            value.uv[component] = val;
+            value.iv[component] = unchecked((Int32)val);
+            value.fv[component] = BitConverter.ToSingle(BitConverter.GetBytes(val), 0);
+
+            UInt32 lo = component & ~1U;
+            UInt64 bits = ((UInt64)value.uv[lo + 1] << 32) | value.uv[lo];
+            value.dv[lo / 2] = BitConverter.Int64BitsToDouble(unchecked((Int64)bits));
+        }
     };
         
     [StructLayout(LayoutKind.Sequential)]
@@ -193,6 +215,60 @@ public struct IndexableTempArray
 
         public UInt32 nextInstruction;
         public ShaderDebugStateFlags flags;
+
+        public ShaderDebugState Clone()
+        {
+            ShaderDebugState ret = (ShaderDebugState)MemberwiseClone();
+            ret.registers = Array.ConvertAll(registers, v => v.Clone());
+            ret.outputs = Array.ConvertAll(outputs, v => v.Clone());
+            ret.indexableTemps = new IndexableTempArray[indexableTemps.Length];
+            for (int i = 0; i < indexableTemps.Length; i++)
+                ret.indexableTemps[i].temps = Array.ConvertAll(indexableTemps[i].temps, v => v.Clone());
+            return ret;
+        }
+
+        public void Apply(ShaderDebugStep step)
+        {
+            nextInstruction = step.nextInstruction;
+            flags = step.flags;
+
+            foreach (var change in step.changes)
+            {
+                ShaderVariable[] vars = null;
+
+                if (change.set == ShaderDebugVariableSet.Register)
+                    vars = registers;
+                else if (change.set == ShaderDebugVariableSet.Output)
+                    vars = outputs;
+                else if (change.set == ShaderDebugVariableSet.IndexableTemp && change.arrayIndex < indexableTemps.Length)
+                    vars = indexableTemps[change.arrayIndex].temps;
+
+                if (vars == null || change.index >= vars.Length || change.component >= 16)
+                    continue;
+
+                vars[change.index].SetComponent(change.component, change.value);
+            }
+        }
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ShaderVariableChange
+    {
+        public ShaderDebugVariableSet set;
+        public UInt32 arrayIndex;
+        public UInt32 index;
+        public UInt32 component;
+        public UInt32 value;
+    };
+
+    [StructLayout(LayoutKind.Sequential)]
+    public class ShaderDebugStep
+    {
+        public UInt32 nextInstruction;
+        public ShaderDebugStateFlags flags;
+
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ShaderVariableChange[] changes;
     };
     
     [StructLayout(LayoutKind.Sequential)]
@@ -210,8 +286,43 @@ public struct CBuffer
         [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
         public CBuffer[] cbuffers;
 
+        public ShaderDebugState initialState;
+
+        [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
+        public ShaderDebugStep[] steps;
+
         [CustomMarshalAs(CustomUnmanagedType.TemplatedArray)]
-        public ShaderDebugState[] states;
+        public ShaderDebugState[] keyframes;
+
+        // keep in sync with ShaderDebugKeyframeInterval
+        private const int KeyframeInterval = 64;
+
+        // reconstruct the full state at the given step from the nearest keyframe
+        public ShaderDebugState GetState(int step)
+        {
+            if (step < 0 || step >= steps.Length)
+                return null;
+
+            int keyframe = step / KeyframeInterval;
+            int start = 0;
+
+            ShaderDebugState ret = null;
+
+            if (keyframes != null && keyframe < keyframes.Length)
+            {
+                ret = keyframes[keyframe].Clone();
+                start = keyframe * KeyframeInterval + 1;
+            }
+            else
+            {
+                ret = initialState.Clone();
+            }
+
+            for (int i = start; i <= step; i++)
+                ret.Apply(steps[i]);
+
+            return ret;
+        }
     };
     
     [StructLayout(LayoutKind.Sequential)]
@@ -550,7 +550,7 @@ private void debugToolStripMenuItem_Click(object sender, EventArgs e)
                     trace = r.DebugPixel((UInt32)pixel.X, (UInt32)pixel.Y, sample, tag.Primitive);
                 });
 
-                if (trace == null || trace.states.Length == 0)
+                if (trace == null || trace.steps.Length == 0)
                 {
                     MessageBox.Show("Error debugging pixel.", "Debug Error",
                                     MessageBoxButtons.OK, MessageBoxIcon.Error);